@@ -0,0 +1,223 @@
+// Implementation of the allocation check
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "AllocationCheck.hpp"
+#include "BufferPool.hpp"
+#include "CorpusBenchmark.hpp"
+#include "Decoder.hpp"
+
+namespace
+{
+    std::atomic<unsigned long long> g_allocationCount{0};
+}
+
+// The counting replacements of the global allocation functions, the
+// nothrow & array forms of operator new call these ones
+
+void* operator new(std::size_t size)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    void* memory = std::malloc(size == 0 ? 1 : size);
+
+    if (memory == nullptr)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace kpeg
+{
+    namespace bench
+    {
+        unsigned long long getAllocationCount()
+        {
+            return g_allocationCount.load(std::memory_order_relaxed);
+        }
+
+        namespace
+        {
+            // The allocations of one decode
+            struct DecodeAllocations
+            {
+                bool isDecoded;
+                unsigned long long allocations;
+
+                // The allocations of the output buffer of the decoded image
+                unsigned long long outputAllocations;
+            };
+
+            DecodeAllocations decodeImage(Decoder& decoder, const std::vector<UInt8>& data)
+            {
+                DecodeAllocations result = { false, 0, 0 };
+
+                // The decoder resizes the output buffer of its last image, if
+                // it has one, which is replayed on a buffer of the same shape
+                // to count the allocations of the output of this decode alone
+                std::vector<std::vector<Pixel>> lastOutput;
+                bool isReusingOutput = false;
+
+                {
+                    const PixelPtr pixels = decoder.getImage().getPixelPtr();
+
+                    if (pixels != nullptr)
+                    {
+                        isReusingOutput = true;
+                        lastOutput.reserve(pixels->capacity());
+
+                        for (auto&& row : *pixels)
+                        {
+                            lastOutput.emplace_back();
+                            lastOutput.back().reserve(row.capacity());
+                        }
+                    }
+                }
+
+                unsigned long long before = getAllocationCount();
+
+                // The images are unrelated, so none may rely on the tables of another
+                decoder.reset();
+
+                if (decoder.open(data.data(), data.size()))
+                    result.isDecoded = decoder.decodeImageFile() == Decoder::ResultCode::DECODE_DONE;
+
+                decoder.close();
+
+                result.allocations = getAllocationCount() - before;
+
+                if (!result.isDecoded)
+                    return result;
+
+                const std::size_t width = decoder.getImage().width;
+                const std::size_t height = decoder.getImage().height;
+
+                if (isReusingOutput)
+                {
+                    before = getAllocationCount();
+                    resizePixelBuffer(lastOutput, width, height, width);
+                    result.outputAllocations = getAllocationCount() - before;
+                }
+                else
+                {
+                    // Otherwise it creates a buffer, as an image of the same size does
+                    Image output;
+                    output.width = width;
+                    output.height = height;
+
+                    const std::vector<MCU> noMCUs;
+
+                    before = getAllocationCount();
+                    output.createImageFromMCUs(noMCUs, 1);
+                    result.outputAllocations = getAllocationCount() - before;
+                }
+
+                return result;
+            }
+        }
+
+        bool runAllocationCheck(const std::string& directory, const std::size_t regionSize)
+        {
+            // The images are decoded from memory, so that reading the files
+            // doesn't count
+            const std::vector<CorpusImage> images = readCorpus(directory);
+
+            if (images.empty())
+                return false;
+
+            Decoder decoder;
+
+            // The decoder's arena may start from memory of our own
+            std::vector<UInt8> region(regionSize);
+
+            if (regionSize > 0)
+                decoder.setArenaRegion(region.data(), region.size());
+
+            // The first pass grows the decoder's buffers to the largest
+            // image, the second one has to reuse them
+            std::vector<DecodeAllocations> firstPass;
+
+            for (auto&& image : images)
+                firstPass.push_back(decodeImage(decoder, image.data));
+
+            CorpusCheck check;
+            check.title = "Allocation check";
+            check.columns = {
+                { "first", 12 }, { "second", 12 }, { "output", 12 }, { "extra", 12 }, { "repeat", 12 }
+            };
+
+            check.checkImage = [&](const CorpusImage& image, std::vector<std::string>& cells)
+            {
+                const std::vector<UInt8>& data = images[image.index].data;
+
+                DecodeAllocations second = decodeImage(decoder, data);
+
+                // Decoding an image of the same size again, as when decoding
+                // a batch of same-sized images, must reuse every buffer,
+                // the output included
+                DecodeAllocations repeat = decodeImage(decoder, data);
+
+                if (!firstPass[image.index].isDecoded || !second.isDecoded || !repeat.isDecoded)
+                {
+                    std::cout << "Failed to decode \'" << image.filename << "\'" << std::endl;
+                    return false;
+                }
+
+                long long extra = (long long)second.allocations - (long long)second.outputAllocations;
+
+                cells = {
+                    std::to_string(firstPass[image.index].allocations),
+                    std::to_string(second.allocations),
+                    std::to_string(second.outputAllocations),
+                    std::to_string(extra),
+                    std::to_string(repeat.allocations)
+                };
+
+                // The output allocations are counted exactly, so a negative
+                // count means the output of the decode wasn't what was replayed
+                if (extra != 0 || repeat.allocations > 0)
+                {
+                    std::cout << "Decoding \'" << image.filename << "\' again made " << extra
+                              << " extra allocations, " << repeat.allocations << " when repeated [FAIL]" << std::endl;
+                    return false;
+                }
+
+                return true;
+            };
+
+            check.passMessage = "No allocations beyond the output buffers, none when repeated [OK]";
+            check.failMessage = "Decodes allocated beyond the output buffers, or when repeated [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+    }
+}
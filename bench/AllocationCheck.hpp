@@ -0,0 +1,35 @@
+// Allocation check
+//
+// Counts the heap allocations of the decoder with counting replacements of
+// the global operator new & delete, which are installed in the benchmark
+// executable. Decoding an image with a decoder that has already decoded the
+// corpus must not allocate anything but the image's output buffer, and
+// decoding the same image again must not allocate at all. The allocations of
+// the output buffer are those of resizing a buffer shaped like the one of the
+// decoder's last image, as the decoder does, so every other one is counted.
+
+#ifndef ALLOCATION_CHECK_HPP
+#define ALLOCATION_CHECK_HPP
+
+#include <string>
+
+namespace kpeg
+{
+    namespace bench
+    {
+        // The number of heap allocations made by the process so far
+        unsigned long long getAllocationCount();
+
+        // Decode every JPEG of a directory twice with one decoder, then
+        // each one once more right after, & print the allocations of each decode
+        // @param directory the directory of JPEG images to decode
+        // @param regionSize the size of the memory region supplied to the
+        //        decoder's arena, in bytes, 0 for none
+        // @return false if an image failed to decode, or the allocations of
+        //         a decode of the second pass weren't those of its output
+        //         buffer, or a repeated decode allocated anything
+        bool runAllocationCheck(const std::string& directory, const std::size_t regionSize);
+    }
+}
+
+#endif // ALLOCATION_CHECK_HPP
@@ -0,0 +1,119 @@
+// Benchmark harness
+//
+// Helpers shared by the benchmarks of kpeg_bench: timing a piece of work
+// over several repetitions and reporting the spread of the results, so a
+// change to a decoder stage can be measured before it ships.
+
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+namespace kpeg
+{
+    namespace bench
+    {
+        // How the result of a benchmark is expressed
+        enum class Metric
+        {
+            NANOSECONDS_PER_ITEM,   // e.g., ns/block, lower is better
+            MEGABYTES_PER_SECOND    // MB/s, higher is better
+        };
+
+        // The results of all the repetitions of a benchmark
+        struct Measurement
+        {
+            std::string name;
+            std::string unit;
+            std::vector<double> samples;
+
+            double mean() const
+            {
+                double sum = 0.0;
+                for (auto&& sample : samples)
+                    sum += sample;
+                return samples.empty() ? 0.0 : sum / samples.size();
+            }
+
+            double stddev() const
+            {
+                if (samples.size() < 2)
+                    return 0.0;
+
+                double m = mean();
+                double sum = 0.0;
+                for (auto&& sample : samples)
+                    sum += (sample - m) * (sample - m);
+                return std::sqrt(sum / (samples.size() - 1));
+            }
+
+            double best(const Metric metric) const
+            {
+                if (samples.empty())
+                    return 0.0;
+
+                return metric == Metric::MEGABYTES_PER_SECOND ?
+                    *std::max_element(samples.begin(), samples.end()) :
+                    *std::min_element(samples.begin(), samples.end());
+            }
+        };
+
+        // Keeps the results of benchmarked work alive, so that the
+        // compiler can't discard the work as unused
+        extern volatile long long g_sink;
+
+        // Time a piece of work over several repetitions, after a warm-up run
+        //
+        // @param name the name of the benchmark
+        // @param metric how each repetition's time is reported
+        // @param item what one item is, for NANOSECONDS_PER_ITEM (e.g., "block")
+        // @param repetitions the number of timed runs
+        // @param work runs the work once, returning the number of items
+        //             (or bytes, for MEGABYTES_PER_SECOND) it processed
+        template <typename Work>
+        Measurement measure(const std::string& name, const Metric metric, const std::string& item,
+                            const int repetitions, Work work)
+        {
+            Measurement result;
+            result.name = name;
+            result.unit = metric == Metric::MEGABYTES_PER_SECOND ? "MB/s" : "ns/" + item;
+
+            work();
+
+            for (auto i = 0; i < repetitions; ++i)
+            {
+                auto start = std::chrono::steady_clock::now();
+                double count = double(work());
+                double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+                if (metric == Metric::MEGABYTES_PER_SECOND)
+                    result.samples.push_back(count / ns * 1e3);
+                else
+                    result.samples.push_back(ns / count);
+            }
+
+            return result;
+        }
+
+        // Print a measurement as one row of a table
+        inline void printMeasurement(const Measurement& result, const Metric metric)
+        {
+            double m = result.mean();
+            double relative = m > 0.0 ? 100.0 * result.stddev() / m : 0.0;
+
+            std::cout << std::left << std::setw(32) << result.name << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(12) << m << " " << std::left << std::setw(10) << result.unit
+                      << std::right << " +/- " << std::setw(6) << std::setprecision(1) << relative << "%"
+                      << "   best " << std::setprecision(2) << result.best(metric)
+                      << "   (" << result.samples.size() << " runs)" << std::endl;
+        }
+    }
+}
+
+#endif // BENCHMARK_HPP
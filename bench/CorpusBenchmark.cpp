@@ -0,0 +1,1513 @@
+// Implementation of the end-to-end corpus benchmark
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "CorpusBenchmark.hpp"
+#include "CoefficientImage.hpp"
+#include "Decoder.hpp"
+#include "ImageStatistics.hpp"
+#include "LazyImage.hpp"
+#include "LosslessTransform.hpp"
+
+namespace kpeg
+{
+    namespace bench
+    {
+        namespace
+        {
+            // The outcome of decoding one image
+            struct DecodeSample
+            {
+                bool isDecoded;
+                std::size_t pixels;
+                double milliseconds;
+                unsigned long long checksum;
+            };
+
+            // The summary of a series of decodes
+            struct PassResult
+            {
+                std::size_t images;
+                double megapixelsPerSecond;
+                double p50Milliseconds;
+                double p99Milliseconds;
+            };
+
+            // Decode an image with the specified decoder, timing the whole
+            // job as a user of the library sees it: open, decode & close
+            DecodeSample decodeImage(Decoder& decoder, const std::string& filename)
+            {
+                DecodeSample sample = { false, 0, 0.0, 0 };
+
+                auto start = std::chrono::steady_clock::now();
+
+                if (decoder.open(filename))
+                    sample.isDecoded = decoder.decodeImageFile() == Decoder::ResultCode::DECODE_DONE;
+
+                decoder.close();
+
+                sample.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                if (!sample.isDecoded)
+                    return sample;
+
+                const Image& image = decoder.getImage();
+                sample.pixels = image.width * image.height;
+
+                // FNV-1a over the pixels, to compare decodes of the same image
+                sample.checksum = 0xCBF29CE484222325ULL;
+
+                for (auto&& row : *image.getPixelPtr())
+                {
+                    for (auto&& pixel : row)
+                    {
+                        for (auto c = 0; c < 3; ++c)
+                        {
+                            sample.checksum ^= UInt8(pixel.comp[c]);
+                            sample.checksum *= 0x100000001B3ULL;
+                        }
+                    }
+                }
+
+                return sample;
+            }
+
+            double percentile(std::vector<double> values, const double fraction)
+            {
+                if (values.empty())
+                    return 0.0;
+
+                std::sort(values.begin(), values.end());
+                std::size_t index = std::size_t(fraction * (values.size() - 1) + 0.5);
+                return values[std::min(index, values.size() - 1)];
+            }
+
+            PassResult summarize(const std::vector<DecodeSample>& samples)
+            {
+                PassResult result = { samples.size(), 0.0, 0.0, 0.0 };
+
+                double totalPixels = 0.0;
+                double totalMilliseconds = 0.0;
+                std::vector<double> latencies;
+
+                for (auto&& sample : samples)
+                {
+                    totalPixels += sample.pixels;
+                    totalMilliseconds += sample.milliseconds;
+                    latencies.push_back(sample.milliseconds);
+                }
+
+                if (totalMilliseconds > 0.0)
+                    result.megapixelsPerSecond = totalPixels / totalMilliseconds / 1e3;
+
+                result.p50Milliseconds = percentile(latencies, 0.50);
+                result.p99Milliseconds = percentile(latencies, 0.99);
+
+                return result;
+            }
+
+            // The peak resident set size of the process, in kilobytes
+            long getPeakRSS()
+            {
+                rusage usage;
+                getrusage(RUSAGE_SELF, &usage);
+                return usage.ru_maxrss;
+            }
+
+            void printPass(const std::string& name, const PassResult& result)
+            {
+                std::cout << std::left << std::setw(6) << name << std::right << std::fixed << std::setprecision(2)
+                          << std::setw(10) << result.megapixelsPerSecond << " MP/s"
+                          << "   p50 " << std::setw(8) << std::setprecision(3) << result.p50Milliseconds << " ms"
+                          << "   p99 " << std::setw(8) << result.p99Milliseconds << " ms"
+                          << "   (" << result.images << " decodes)" << std::endl;
+            }
+
+            void writePassJSON(std::ostream& out, const std::string& name, const PassResult& result)
+            {
+                out << "  \"" << name << "\": {\n"
+                    << "    \"decodes\": " << result.images << ",\n"
+                    << "    \"megapixels_per_second\": " << result.megapixelsPerSecond << ",\n"
+                    << "    \"p50_ms\": " << result.p50Milliseconds << ",\n"
+                    << "    \"p99_ms\": " << result.p99Milliseconds << "\n"
+                    << "  }";
+            }
+
+            // Read the throughput of a pass from the results of an earlier run
+            // @return the throughput, or a negative value if not found
+            double readBaselineThroughput(const std::string& json, const std::string& name)
+            {
+                std::size_t pass = json.find("\"" + name + "\"");
+
+                if (pass == std::string::npos)
+                    return -1.0;
+
+                const std::string key = "\"megapixels_per_second\":";
+                std::size_t value = json.find(key, pass);
+
+                if (value == std::string::npos)
+                    return -1.0;
+
+                return std::strtod(json.c_str() + value + key.size(), nullptr);
+            }
+
+            // The pixels of a decoded image, as interleaved R, G & B bytes
+            std::vector<UInt8> getPixels(const Image& image)
+            {
+                std::vector<UInt8> pixels;
+                pixels.reserve(image.width * image.height * 3);
+
+                for (auto&& row : *image.getPixelPtr())
+                    for (auto&& pixel : row)
+                        for (auto c = 0; c < 3; ++c)
+                            pixels.push_back(UInt8(pixel.comp[c]));
+
+                return pixels;
+            }
+
+            // The lowest PSNR of a scaled rendering against the box-filtered
+            // pixels of the full decode, the reduced IDCTs aren't box filters
+            const double MIN_SCALED_PSNR = 30.0;
+
+            // The furthest the statistics from DC coefficients may be from
+            // those of the full decode: the difference of each channel of the
+            // average colour, & the bits that differ in the perceptual hash,
+            // within which images are usually taken for near duplicates
+            const double MAX_AVERAGE_COLOR_ERROR = 2.0;
+            const int MAX_HASH_DISTANCE = 10;
+
+            // Decodes shorter than this may end before they're cancelled part
+            // way, they're only cancelled before they start
+            const double MIN_CANCELLED_MILLISECONDS = 20.0;
+
+            // The width of the column of the image names in the tables of the checks
+            const int IMAGE_NAME_WIDTH = 24;
+
+            // The peak signal-to-noise ratio of a sum of squared errors, in dB
+            double computePSNR(const double squaredError, const std::size_t samples)
+            {
+                if (squaredError == 0.0 || samples == 0)
+                    return INFINITY;
+
+                return 10.0 * std::log10(255.0 * 255.0 / (squaredError / samples));
+            }
+
+            double getElapsedMilliseconds(const std::chrono::steady_clock::time_point& start)
+            {
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            // A number as the cell of a table, with a fixed number of decimals
+            std::string formatNumber(const double value, const int precision = 2)
+            {
+                std::ostringstream out;
+                out << std::fixed << std::setprecision(precision) << value;
+                return out.str();
+            }
+
+            CorpusImage readImage(const std::vector<std::string>& files, const std::size_t index)
+            {
+                const std::string& filename = files[index];
+                std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+                return { index, filename, filename.substr(filename.find_last_of('/') + 1),
+                         std::vector<UInt8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()) };
+            }
+        }
+
+        std::vector<std::string> listJPEGFiles(const std::string& directory)
+        {
+            std::vector<std::string> files;
+
+            DIR* dir = opendir(directory.c_str());
+
+            if (dir == nullptr)
+                return files;
+
+            while (dirent* entry = readdir(dir))
+            {
+                std::string name = entry->d_name;
+                std::string lowerName = name;
+                std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
+
+                auto hasSuffix = [&](const std::string& suffix)
+                {
+                    return lowerName.size() > suffix.size() &&
+                           lowerName.compare(lowerName.size() - suffix.size(), suffix.size(), suffix) == 0;
+                };
+
+                if (hasSuffix(".jpg") || hasSuffix(".jpeg"))
+                    files.push_back(directory + "/" + name);
+            }
+
+            closedir(dir);
+
+            std::sort(files.begin(), files.end());
+            return files;
+        }
+
+        std::vector<CorpusImage> readCorpus(const std::string& directory)
+        {
+            std::vector<std::string> files = listJPEGFiles(directory);
+            std::vector<CorpusImage> images;
+
+            if (files.empty())
+                std::cout << "No JPEG images found in \'" << directory << "\'" << std::endl;
+
+            for (std::size_t i = 0; i < files.size(); ++i)
+                images.push_back(readImage(files, i));
+
+            return images;
+        }
+
+        bool runCorpusCheck(const std::string& directory, const CorpusCheck& check)
+        {
+            std::vector<std::string> files = listJPEGFiles(directory);
+
+            if (files.empty())
+            {
+                std::cout << "No JPEG images found in \'" << directory << "\'" << std::endl;
+                return false;
+            }
+
+            std::cout << check.title << ": " << files.size() << " images" << std::endl;
+            std::cout << std::endl;
+
+            if (!check.columns.empty())
+            {
+                std::cout << std::left << std::setw(IMAGE_NAME_WIDTH) << "image" << std::right;
+
+                for (auto&& column : check.columns)
+                    std::cout << std::setw(column.width) << column.heading;
+
+                std::cout << std::endl;
+            }
+
+            bool isPassing = true;
+            std::vector<std::string> cells;
+
+            // The images are read one at a time, so that a large corpus
+            // doesn't have to fit in memory
+            for (std::size_t i = 0; i < files.size(); ++i)
+            {
+                const CorpusImage image = readImage(files, i);
+
+                cells.clear();
+
+                if (!check.checkImage(image, cells))
+                    isPassing = false;
+
+                if (cells.empty())
+                    continue;
+
+                std::cout << std::left << std::setw(IMAGE_NAME_WIDTH) << image.name << std::right;
+
+                for (std::size_t c = 0; c < cells.size() && c < check.columns.size(); ++c)
+                    std::cout << std::setw(check.columns[c].width) << cells[c];
+
+                std::cout << std::endl;
+            }
+
+            if (check.summarize)
+            {
+                if (!check.columns.empty())
+                    std::cout << std::endl;
+
+                if (!check.summarize())
+                    isPassing = false;
+            }
+
+            std::cout << std::defaultfloat << std::endl;
+            std::cout << (isPassing ? check.passMessage : check.failMessage) << std::endl;
+
+            return isPassing;
+        }
+
+        bool runCorpusBenchmark(const CorpusOptions& options)
+        {
+            std::vector<std::string> files = listJPEGFiles(options.directory);
+
+            if (files.empty())
+            {
+                std::cout << "No JPEG images found in \'" << options.directory << "\'" << std::endl;
+                return false;
+            }
+
+            std::cout << "Corpus benchmark: " << files.size() << " images, "
+                      << options.passes << " warm passes" << std::endl;
+            std::cout << std::endl;
+
+            bool isPassing = true;
+
+            // Cold: every image gets a new decoder, as a one-shot tool would
+            std::vector<DecodeSample> coldSamples;
+
+            for (auto&& filename : files)
+            {
+                Decoder decoder;
+                coldSamples.push_back(decodeImage(decoder, filename));
+
+                if (!coldSamples.back().isDecoded)
+                {
+                    std::cout << "Failed to decode \'" << filename << "\'" << std::endl;
+                    isPassing = false;
+                }
+            }
+
+            // Warm: one decoder decodes the whole corpus, again & again
+            std::vector<DecodeSample> warmSamples;
+            Decoder decoder;
+
+            for (auto pass = 0; pass < options.passes; ++pass)
+            {
+                for (std::size_t i = 0; i < files.size(); ++i)
+                {
+                    warmSamples.push_back(decodeImage(decoder, files[i]));
+
+                    const DecodeSample& warm = warmSamples.back();
+                    const DecodeSample& cold = coldSamples[i];
+
+                    if (warm.isDecoded != cold.isDecoded || warm.checksum != cold.checksum)
+                    {
+                        std::cout << "Image \'" << files[i] << "\' decoded differently in warm pass "
+                                  << pass + 1 << std::endl;
+                        isPassing = false;
+                    }
+                }
+            }
+
+            PassResult cold = summarize(coldSamples);
+            PassResult warm = summarize(warmSamples);
+            long peakRSS = getPeakRSS();
+
+            printPass("cold", cold);
+            printPass("warm", warm);
+            std::cout << "Peak RSS: " << peakRSS << " KB" << std::endl;
+
+            if (!options.resultsFilename.empty())
+            {
+                std::ofstream results(options.resultsFilename);
+
+                results << std::fixed << std::setprecision(3);
+                results << "{\n"
+                        << "  \"images\": " << files.size() << ",\n"
+                        << "  \"passes\": " << options.passes << ",\n";
+                writePassJSON(results, "cold", cold);
+                results << ",\n";
+                writePassJSON(results, "warm", warm);
+                results << ",\n"
+                        << "  \"peak_rss_kb\": " << peakRSS << "\n"
+                        << "}\n";
+
+                if (!results.good())
+                {
+                    std::cout << "Unable to write results to \'" << options.resultsFilename << "\'" << std::endl;
+                    isPassing = false;
+                }
+                else
+                    std::cout << "Results written to \'" << options.resultsFilename << "\'" << std::endl;
+            }
+
+            if (!options.baselineFilename.empty())
+            {
+                std::ifstream baselineFile(options.baselineFilename);
+
+                if (!baselineFile.is_open())
+                {
+                    std::cout << "Unable to read baseline \'" << options.baselineFilename << "\'" << std::endl;
+                    return false;
+                }
+
+                std::stringstream baseline;
+                baseline << baselineFile.rdbuf();
+
+                std::cout << std::endl;
+
+                const std::pair<std::string, const PassResult*> passes[] = { { "cold", &cold }, { "warm", &warm } };
+
+                for (auto&& pass : passes)
+                {
+                    double baselineThroughput = readBaselineThroughput(baseline.str(), pass.first);
+
+                    if (baselineThroughput <= 0.0)
+                    {
+                        std::cout << "No " << pass.first << " throughput in the baseline" << std::endl;
+                        isPassing = false;
+                        continue;
+                    }
+
+                    double change = 100.0 * (pass.second->megapixelsPerSecond / baselineThroughput - 1.0);
+                    bool isRegression = change < -options.threshold;
+
+                    std::cout << std::left << std::setw(6) << pass.first << std::right << std::fixed << std::setprecision(2)
+                              << std::setw(10) << baselineThroughput << " MP/s baseline, "
+                              << std::showpos << change << std::noshowpos << "% "
+                              << (isRegression ? "[REGRESSION]" : "[OK]") << std::endl;
+
+                    if (isRegression)
+                        isPassing = false;
+                }
+            }
+
+            return isPassing;
+        }
+    
+        bool runIDCTComparison(const std::string& directory, const double minimumPSNR)
+        {
+            const std::pair<IDCTMode, std::string> modes[] = {
+                { IDCTMode::FLOAT, "float" },
+                { IDCTMode::ACCURATE_INTEGER, "accurate" },
+                { IDCTMode::FAST_INTEGER, "fast" }
+            };
+
+            Decoder decoder;
+
+            // The decodes of each IDCT & their errors from the float reference
+            std::vector<DecodeSample> samples[3];
+            double squaredErrors[3] = {};
+            std::size_t sampleCounts[3] = {};
+            double worstPSNR[3] = { INFINITY, INFINITY, INFINITY };
+            int maxErrors[3] = {};
+
+            CorpusCheck check;
+            check.title = "IDCT comparison";
+
+            check.checkImage = [&](const CorpusImage& image, std::vector<std::string>&)
+            {
+                bool isPassing = true;
+                std::vector<UInt8> reference;
+
+                for (std::size_t m = 0; m < 3; ++m)
+                {
+                    decoder.setIDCTMode(modes[m].first);
+                    samples[m].push_back(decodeImage(decoder, image.filename));
+
+                    if (!samples[m].back().isDecoded)
+                    {
+                        std::cout << "Failed to decode \'" << image.filename << "\' with the "
+                                  << modes[m].second << " IDCT" << std::endl;
+                        isPassing = false;
+                        continue;
+                    }
+
+                    std::vector<UInt8> pixels = getPixels(decoder.getImage());
+
+                    if (modes[m].first == IDCTMode::FLOAT)
+                    {
+                        reference = std::move(pixels);
+                        continue;
+                    }
+
+                    if (pixels.size() != reference.size())
+                        continue;
+
+                    double imageSquaredError = 0.0;
+
+                    for (std::size_t j = 0; j < pixels.size(); ++j)
+                    {
+                        int error = std::abs(int(pixels[j]) - int(reference[j]));
+                        imageSquaredError += double(error) * error;
+                        maxErrors[m] = std::max(maxErrors[m], error);
+                    }
+
+                    double imagePSNR = computePSNR(imageSquaredError, pixels.size());
+                    worstPSNR[m] = std::min(worstPSNR[m], imagePSNR);
+
+                    if (modes[m].first == IDCTMode::ACCURATE_INTEGER && imagePSNR < minimumPSNR)
+                    {
+                        std::cout << "Image \'" << image.filename << "\' is " << std::fixed << std::setprecision(2)
+                                  << imagePSNR << " dB from the float reference with the accurate IDCT" << std::endl;
+                        isPassing = false;
+                    }
+
+                    squaredErrors[m] += imageSquaredError;
+                    sampleCounts[m] += pixels.size();
+                }
+
+                return isPassing;
+            };
+
+            check.summarize = [&]
+            {
+                std::cout << std::left << std::setw(10) << "IDCT" << std::right
+                          << std::setw(12) << "MP/s"
+                          << std::setw(12) << "PSNR (dB)"
+                          << std::setw(16) << "min PSNR (dB)"
+                          << std::setw(12) << "max error" << std::endl;
+
+                for (std::size_t m = 0; m < 3; ++m)
+                {
+                    PassResult result = summarize(samples[m]);
+
+                    std::cout << std::left << std::setw(10) << modes[m].second << std::right << std::fixed << std::setprecision(2)
+                              << std::setw(12) << result.megapixelsPerSecond;
+
+                    if (modes[m].first == IDCTMode::FLOAT)
+                        std::cout << std::setw(12) << "-" << std::setw(16) << "-" << std::setw(12) << "-" << std::endl;
+                    else
+                        std::cout << std::setw(12) << computePSNR(squaredErrors[m], sampleCounts[m])
+                                  << std::setw(16) << worstPSNR[m]
+                                  << std::setw(12) << maxErrors[m] << std::endl;
+                }
+
+                return true;
+            };
+
+            check.passMessage = "The accurate IDCT matches the float reference [OK]";
+            check.failMessage = "IDCT comparison failed [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+
+        bool runCoefficientComparison(const std::string& directory)
+        {
+            Decoder decoder;
+
+            std::vector<DecodeSample> imageSamples, bufferSamples, streamSamples;
+
+            CorpusCheck check;
+            check.title = "Coefficient decoding";
+
+            check.checkImage = [&](const CorpusImage& image, std::vector<std::string>&)
+            {
+                const std::string& filename = image.filename;
+
+                DecodeSample imageSample = decodeImage(decoder, filename);
+
+                if (!imageSample.isDecoded)
+                {
+                    std::cout << "Failed to decode \'" << filename << "\'" << std::endl;
+                    return false;
+                }
+
+                std::vector<UInt8> expected = getPixels(decoder.getImage());
+
+                // The whole-image buffer, in zig-zag order
+                DecodeSample bufferSample = { false, imageSample.pixels, 0.0, 0 };
+
+                auto start = std::chrono::steady_clock::now();
+
+                decoder.reset();
+
+                if (decoder.open(filename))
+                    bufferSample.isDecoded = decoder.decodeCoefficients() == Decoder::ResultCode::DECODE_DONE;
+
+                bufferSample.milliseconds = getElapsedMilliseconds(start);
+
+                if (!bufferSample.isDecoded)
+                {
+                    std::cout << "Failed to decode the coefficients of \'" << filename << "\'" << std::endl;
+                    decoder.close();
+                    return false;
+                }
+
+                // Reconstruct the pixels from the coefficients, as the decoder
+                // would, which must give the decoded image
+                std::vector<std::vector<UInt16>> QTables = { std::vector<UInt16>(64), std::vector<UInt16>(64) };
+
+                for (auto i = 0; i < 2; ++i)
+                {
+                    std::array<UInt16, 64> table = decoder.getQuantizationTable(i);
+                    std::copy(table.begin(), table.end(), QTables[i].begin());
+                }
+
+                std::size_t blockCount = decoder.getBlocksPerLine() * decoder.getBlockRows();
+                std::vector<MCU> MCUs;
+                MCUs.reserve(blockCount);
+
+                for (std::size_t block = 0; block < blockCount; ++block)
+                {
+                    std::array<const Int16*, 3> compCoeffs = {
+                        decoder.getCoefficients(0) + block * 64,
+                        decoder.getCoefficients(1) + block * 64,
+                        decoder.getCoefficients(2) + block * 64
+                    };
+
+                    MCUs.push_back(MCU(compCoeffs, QTables));
+                }
+
+                Image reconstructed;
+                reconstructed.width = decoder.getImage().width;
+                reconstructed.height = decoder.getImage().height;
+                reconstructed.createImageFromMCUs(MCUs, decoder.getBlocksPerLine());
+
+                decoder.close();
+
+                // The blocks streamed in natural order, checked against the buffer
+                std::vector<Int16> streamed(3 * blockCount * 64);
+
+                decoder.setBlockCallback([&](const int component, const std::size_t blockIndex, const Int16* coefficients)
+                {
+                    std::copy(coefficients, coefficients + 64, streamed.begin() + (component * blockCount + blockIndex) * 64);
+                    return true;
+                });
+
+                DecodeSample streamSample = { false, imageSample.pixels, 0.0, 0 };
+
+                std::vector<Int16> buffered(decoder.getCoefficients(0), decoder.getCoefficients(0) + 3 * blockCount * 64);
+
+                start = std::chrono::steady_clock::now();
+
+                decoder.reset();
+
+                if (decoder.open(filename))
+                    streamSample.isDecoded = decoder.decodeCoefficients(CoefficientOrder::NATURAL) == Decoder::ResultCode::DECODE_DONE;
+
+                decoder.close();
+
+                streamSample.milliseconds = getElapsedMilliseconds(start);
+
+                decoder.setBlockCallback(nullptr);
+
+                for (std::size_t block = 0; block < 3 * blockCount; ++block)
+                    zigZagToNatural(&buffered[block * 64]);
+
+                bool isMatching = getPixels(reconstructed) == expected && streamSample.isDecoded && streamed == buffered;
+
+                if (!isMatching)
+                    std::cout << "Coefficients of \'" << filename << "\' don't match the decoded image [FAIL]" << std::endl;
+
+                imageSamples.push_back(imageSample);
+                bufferSamples.push_back(bufferSample);
+                streamSamples.push_back(streamSample);
+
+                return isMatching;
+            };
+
+            check.summarize = [&]
+            {
+                std::cout << std::left << std::setw(16) << "output" << std::right
+                          << std::setw(12) << "MP/s" << std::endl;
+
+                const std::pair<std::string, const std::vector<DecodeSample>*> outputs[] = {
+                    { "pixels", &imageSamples },
+                    { "coefficients", &bufferSamples },
+                    { "streamed", &streamSamples }
+                };
+
+                for (auto&& output : outputs)
+                {
+                    std::cout << std::left << std::setw(16) << output.first << std::right << std::fixed << std::setprecision(2)
+                              << std::setw(12) << summarize(*output.second).megapixelsPerSecond << std::endl;
+                }
+
+                return true;
+            };
+
+            check.passMessage = "Coefficients match the decoded images [OK]";
+            check.failMessage = "Coefficient decoding failed [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+
+        bool runHuffmanOptimization(const std::string& directory)
+        {
+            Decoder decoder;
+            LosslessTransformer transformer;
+            transformer.setOptimizeHuffmanTables(true);
+
+            std::size_t originalBytes = 0;
+            std::size_t optimizedBytes = 0;
+            std::size_t optimizedCount = 0;
+            double milliseconds = 0.0;
+
+            // The coefficients & quantization tables of an image, in zig-zag order
+            auto getCoefficients = [&](const UInt8* data, const std::size_t size, std::vector<Int16>& coefficients)
+            {
+                decoder.reset();
+
+                bool isDecoded = decoder.open(data, size) &&
+                                 decoder.decodeCoefficients() == Decoder::ResultCode::DECODE_DONE;
+
+                decoder.close();
+
+                if (!isDecoded)
+                    return false;
+
+                std::size_t blockCount = decoder.getBlocksPerLine() * decoder.getBlockRows();
+                coefficients.assign(decoder.getCoefficients(0), decoder.getCoefficients(0) + 3 * blockCount * 64);
+
+                for (auto i = 0; i < 2; ++i)
+                {
+                    std::array<UInt16, 64> table = decoder.getQuantizationTable(i);
+                    coefficients.insert(coefficients.end(), table.begin(), table.end());
+                }
+
+                return true;
+            };
+
+            std::vector<Int16> original, optimized;
+
+            CorpusCheck check;
+            check.title = "Huffman optimization";
+
+            check.checkImage = [&](const CorpusImage& image, std::vector<std::string>&)
+            {
+                const std::vector<UInt8>& data = image.data;
+
+                // Only the images the transform supports count
+                if (!getCoefficients(data.data(), data.size(), original))
+                    return true;
+
+                std::ostringstream out;
+
+                auto start = std::chrono::steady_clock::now();
+                bool isTransformed = transformer.transform(data.data(), data.size(), LosslessOperation::NONE, out);
+                milliseconds += getElapsedMilliseconds(start);
+
+                std::string result = out.str();
+
+                if (!isTransformed ||
+                    !getCoefficients(reinterpret_cast<const UInt8*>(result.data()), result.size(), optimized) ||
+                    optimized != original)
+                {
+                    std::cout << "Optimized \'" << image.filename << "\' doesn't decode to the same coefficients [FAIL]" << std::endl;
+                    return false;
+                }
+
+                originalBytes += data.size();
+                optimizedBytes += result.size();
+                optimizedCount++;
+
+                return true;
+            };
+
+            check.summarize = [&]
+            {
+                std::cout << std::left << std::setw(16) << "images" << std::right << std::setw(16) << optimizedCount << std::endl;
+                std::cout << std::left << std::setw(16) << "original bytes" << std::right << std::setw(16) << originalBytes << std::endl;
+                std::cout << std::left << std::setw(16) << "optimized bytes" << std::right << std::setw(16) << optimizedBytes << std::endl;
+
+                if (originalBytes > 0)
+                {
+                    std::cout << std::left << std::setw(16) << "saved" << std::right << std::fixed << std::setprecision(2)
+                              << std::setw(15) << 100.0 * (double(originalBytes) - double(optimizedBytes)) / originalBytes << "%" << std::endl;
+                    std::cout << std::left << std::setw(16) << "MB/s" << std::right << std::fixed << std::setprecision(2)
+                              << std::setw(16) << (milliseconds > 0.0 ? originalBytes / (milliseconds * 1000.0) : 0.0) << std::endl;
+                }
+
+                return true;
+            };
+
+            check.passMessage = "Optimized images keep their coefficients [OK]";
+            check.failMessage = "Huffman optimization failed [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+
+        bool runMultiResolutionRendering(const std::string& directory)
+        {
+            const int scales[] = { 1, 2, 4, 8 };
+
+            Decoder decoder;
+            CoefficientImage coefficients;
+            Image rendering;
+
+            double fullDecodeMilliseconds = 0.0;
+            double coefficientMilliseconds = 0.0;
+            double renderMilliseconds[4] = {};
+            double worstPSNR[4] = { INFINITY, INFINITY, INFINITY, INFINITY };
+            std::size_t sparseBytes = 0;
+            std::size_t denseBytes = 0;
+
+            CorpusCheck check;
+            check.title = "Multi-resolution rendering";
+
+            check.checkImage = [&](const CorpusImage& corpusImage, std::vector<std::string>&)
+            {
+                const std::vector<UInt8>& data = corpusImage.data;
+
+                // Without the coefficients, every size is a full decode
+                bool isDecoded = true;
+
+                for (std::size_t i = 0; i < 4 && isDecoded; ++i)
+                {
+                    decoder.reset();
+
+                    auto start = std::chrono::steady_clock::now();
+                    isDecoded = decoder.open(data.data(), data.size()) &&
+                                decoder.decodeImageFile() == Decoder::ResultCode::DECODE_DONE;
+                    fullDecodeMilliseconds += getElapsedMilliseconds(start);
+
+                    decoder.close();
+                }
+
+                const Image& image = decoder.getImage();
+                std::vector<UInt8> reference = getPixels(image);
+
+                decoder.reset();
+
+                auto start = std::chrono::steady_clock::now();
+                isDecoded = isDecoded && decoder.open(data.data(), data.size()) &&
+                            coefficients.decode(decoder) == Decoder::ResultCode::DECODE_DONE;
+                coefficientMilliseconds += getElapsedMilliseconds(start);
+
+                decoder.close();
+
+                if (!isDecoded)
+                {
+                    std::cout << "Failed to decode \'" << corpusImage.filename << "\'" << std::endl;
+                    return false;
+                }
+
+                sparseBytes += coefficients.getMemorySize();
+                denseBytes += 3 * ((image.width + 7) / 8) * ((image.height + 7) / 8) * 64 * sizeof(Int16);
+
+                bool isPassing = true;
+
+                for (std::size_t i = 0; i < 4; ++i)
+                {
+                    const std::size_t scale = scales[i];
+
+                    start = std::chrono::steady_clock::now();
+                    bool isRendered = coefficients.render(rendering, int(scale));
+                    renderMilliseconds[i] += getElapsedMilliseconds(start);
+
+                    if (!isRendered || rendering.width != (image.width + scale - 1) / scale ||
+                        rendering.height != (image.height + scale - 1) / scale)
+                    {
+                        std::cout << "Failed to render \'" << corpusImage.filename << "\' at 1/" << scale << " scale [FAIL]" << std::endl;
+                        isPassing = false;
+                        continue;
+                    }
+
+                    std::vector<UInt8> pixels = getPixels(rendering);
+
+                    if (scale == 1)
+                    {
+                        if (pixels != reference)
+                        {
+                            std::cout << "Full scale rendering of \'" << corpusImage.filename << "\' differs from the decoded image [FAIL]" << std::endl;
+                            isPassing = false;
+                        }
+
+                        continue;
+                    }
+
+                    // The average of the pixels of the full decode under each scaled pixel
+                    double squaredError = 0.0;
+
+                    for (std::size_t y = 0; y < rendering.height; ++y)
+                    {
+                        for (std::size_t x = 0; x < rendering.width; ++x)
+                        {
+                            for (auto c = 0; c < 3; ++c)
+                            {
+                                double sum = 0.0;
+                                std::size_t count = 0;
+
+                                for (std::size_t v = y * scale; v < std::min((y + 1) * scale, image.height); ++v)
+                                {
+                                    for (std::size_t u = x * scale; u < std::min((x + 1) * scale, image.width); ++u, ++count)
+                                        sum += reference[(v * image.width + u) * 3 + c];
+                                }
+
+                                double error = pixels[(y * rendering.width + x) * 3 + c] - sum / count;
+                                squaredError += error * error;
+                            }
+                        }
+                    }
+
+                    worstPSNR[i] = std::min(worstPSNR[i], computePSNR(squaredError, pixels.size()));
+                }
+
+                return isPassing;
+            };
+
+            check.summarize = [&]
+            {
+                bool isPassing = true;
+
+                std::cout << std::left << std::setw(24) << "pass" << std::right
+                          << std::setw(12) << "ms"
+                          << std::setw(16) << "min PSNR (dB)" << std::endl;
+
+                std::cout << std::left << std::setw(24) << "4 full decodes" << std::right << std::fixed << std::setprecision(2)
+                          << std::setw(12) << fullDecodeMilliseconds << std::setw(16) << "-" << std::endl;
+
+                std::cout << std::left << std::setw(24) << "decode coefficients" << std::right
+                          << std::setw(12) << coefficientMilliseconds << std::setw(16) << "-" << std::endl;
+
+                double totalMilliseconds = coefficientMilliseconds;
+
+                for (std::size_t i = 0; i < 4; ++i)
+                {
+                    totalMilliseconds += renderMilliseconds[i];
+
+                    std::cout << std::left << std::setw(24) << "render 1/" + std::to_string(scales[i]) << std::right
+                              << std::setw(12) << renderMilliseconds[i] << std::setw(16);
+
+                    if (i == 0)
+                        std::cout << "exact" << std::endl;
+                    else
+                        std::cout << worstPSNR[i] << std::endl;
+
+                    if (worstPSNR[i] < MIN_SCALED_PSNR)
+                    {
+                        std::cout << "Renderings at 1/" << scales[i] << " scale are below " << MIN_SCALED_PSNR << " dB [FAIL]" << std::endl;
+                        isPassing = false;
+                    }
+                }
+
+                std::cout << std::left << std::setw(24) << "coefficients + renders" << std::right
+                          << std::setw(12) << totalMilliseconds << std::setw(16) << "-" << std::endl;
+
+                std::cout << std::endl;
+                std::cout << "Coefficients kept in " << sparseBytes << " bytes, " << std::setprecision(1)
+                          << (denseBytes > 0 ? 100.0 * sparseBytes / denseBytes : 0.0) << "% of a dense buffer" << std::endl;
+
+                return isPassing;
+            };
+
+            check.passMessage = "Renderings match the full decodes [OK]";
+            check.failMessage = "Multi-resolution rendering failed [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+
+        bool runStatisticsComparison(const std::string& directory)
+        {
+            Decoder decoder;
+            ImageStatistics statistics;
+
+            double fullDecodeMilliseconds = 0.0;
+            double analysisMilliseconds[3] = {};
+
+            CorpusCheck check;
+            check.title = "Image statistics";
+            check.columns = {
+                { "full ms", 12 }, { "DC ms", 12 }, { "1/4 ms", 12 }, { "1/2 ms", 12 },
+                { "color err", 12 }, { "hash distances", 18 }, { "DC hash", 20 }
+            };
+
+            check.checkImage = [&](const CorpusImage& corpusImage, std::vector<std::string>& cells)
+            {
+                const std::vector<UInt8>& data = corpusImage.data;
+
+                decoder.reset();
+
+                auto start = std::chrono::steady_clock::now();
+                bool isDecoded = decoder.open(data.data(), data.size()) &&
+                                 decoder.decodeImageFile() == Decoder::ResultCode::DECODE_DONE;
+                double fullMilliseconds = getElapsedMilliseconds(start);
+
+                decoder.close();
+
+                // The statistics of the pixels of the full decode
+                const Image& image = decoder.getImage();
+                std::vector<UInt8> pixels = getPixels(image);
+                std::vector<float> luminance(image.width * image.height);
+                double colorSums[3] = {};
+
+                for (std::size_t i = 0; i < luminance.size(); ++i)
+                {
+                    const UInt8* pixel = &pixels[i * 3];
+
+                    luminance[i] = 0.299f * pixel[0] + 0.587f * pixel[1] + 0.114f * pixel[2];
+
+                    for (auto c = 0; c < 3; ++c)
+                        colorSums[c] += pixel[c];
+                }
+
+                const std::uint64_t referenceHash = ImageStatistics::computePerceptualHash(luminance, image.width, image.height);
+
+                // The hash is only checked from 32x32 samples or more, as it's
+                // resized to that & fewer samples don't hold its frequencies
+                double milliseconds[3] = {};
+                double colorError = 0.0;
+                int hashDistances[3] = {};
+                bool isHashChecked[3] = {};
+                bool isHashFar = false;
+                std::uint64_t DCHash = 0;
+
+                for (std::size_t i = 0; i < 3 && isDecoded; ++i)
+                {
+                    const int samplesPerBlock = 1 << i;
+
+                    decoder.reset();
+
+                    start = std::chrono::steady_clock::now();
+                    isDecoded = decoder.open(data.data(), data.size()) &&
+                                statistics.analyze(decoder, samplesPerBlock) == Decoder::ResultCode::DECODE_DONE;
+                    milliseconds[i] = getElapsedMilliseconds(start);
+
+                    decoder.close();
+
+                    if (!isDecoded)
+                        break;
+
+                    for (auto c = 0; c < 3; ++c)
+                        colorError = std::max(colorError, std::abs(statistics.averageColor[c] - colorSums[c] / luminance.size()));
+
+                    hashDistances[i] = ImageStatistics::getHashDistance(statistics.perceptualHash, referenceHash);
+                    isHashChecked[i] = image.width * samplesPerBlock >= 8 * 32 && image.height * samplesPerBlock >= 8 * 32;
+                    isHashFar = isHashFar || (isHashChecked[i] && hashDistances[i] > MAX_HASH_DISTANCE);
+
+                    if (i == 0)
+                        DCHash = statistics.perceptualHash;
+                }
+
+                if (!isDecoded)
+                {
+                    std::cout << "Failed to decode \'" << corpusImage.filename << "\'" << std::endl;
+                    return false;
+                }
+
+                fullDecodeMilliseconds += fullMilliseconds;
+
+                for (std::size_t i = 0; i < 3; ++i)
+                    analysisMilliseconds[i] += milliseconds[i];
+
+                cells.push_back(formatNumber(fullMilliseconds));
+
+                for (std::size_t i = 0; i < 3; ++i)
+                    cells.push_back(formatNumber(milliseconds[i]));
+
+                cells.push_back(formatNumber(colorError));
+
+                // The distances not checked are in parentheses
+                std::ostringstream distances;
+
+                for (std::size_t i = 0; i < 3; ++i)
+                {
+                    std::string distance = std::to_string(hashDistances[i]);
+                    distances << std::setw(6) << (isHashChecked[i] ? distance : "(" + distance + ")");
+                }
+
+                cells.push_back(distances.str());
+
+                std::ostringstream hash;
+                hash << std::hex << DCHash;
+                cells.push_back(hash.str());
+
+                if (colorError > MAX_AVERAGE_COLOR_ERROR || isHashFar)
+                {
+                    std::cout << "Statistics of \'" << corpusImage.filename << "\' are far from those of the full decode [FAIL]" << std::endl;
+                    return false;
+                }
+
+                return true;
+            };
+
+            check.summarize = [&]
+            {
+                std::cout << std::fixed << std::setprecision(2)
+                          << "Full decodes " << fullDecodeMilliseconds << " ms, DC statistics "
+                          << analysisMilliseconds[0] << " ms (" << std::setprecision(1)
+                          << (analysisMilliseconds[0] > 0.0 ? fullDecodeMilliseconds / analysisMilliseconds[0] : 0.0)
+                          << "x faster), at 1/4 " << std::setprecision(2) << analysisMilliseconds[1]
+                          << " ms, at 1/2 " << analysisMilliseconds[2] << " ms" << std::endl;
+
+                return true;
+            };
+
+            check.passMessage = "Statistics match the full decodes [OK]";
+            check.failMessage = "Image statistics failed [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+
+        bool runValidationCheck(const std::string& directory)
+        {
+            Decoder decoder;
+
+            double fullDecodeMilliseconds = 0.0;
+            double coefficientMilliseconds = 0.0;
+            double validationMilliseconds = 0.0;
+
+            auto validate = [&decoder](const std::vector<UInt8>& data)
+            {
+                decoder.reset();
+                decoder.open(data.data(), data.size());
+
+                ValidationResult result = decoder.validateImageFile();
+
+                decoder.close();
+
+                return result;
+            };
+
+            CorpusCheck check;
+            check.title = "Validation";
+            check.columns = {
+                { "full ms", 12 }, { "coefficients ms", 16 }, { "verify ms", 12 }, { "bit flips found", 16 }
+            };
+
+            check.checkImage = [&](const CorpusImage& image, std::vector<std::string>& cells)
+            {
+                const std::string& filename = image.filename;
+                const std::vector<UInt8>& data = image.data;
+
+                decoder.reset();
+
+                auto start = std::chrono::steady_clock::now();
+                bool isDecoded = decoder.open(data.data(), data.size()) &&
+                                 decoder.decodeImageFile() == Decoder::ResultCode::DECODE_DONE;
+                double fullMilliseconds = getElapsedMilliseconds(start);
+
+                decoder.close();
+                decoder.reset();
+
+                start = std::chrono::steady_clock::now();
+                isDecoded = isDecoded && decoder.open(data.data(), data.size()) &&
+                            decoder.decodeCoefficients() == Decoder::ResultCode::DECODE_DONE;
+                double coefficientsMilliseconds = getElapsedMilliseconds(start);
+
+                decoder.close();
+
+                start = std::chrono::steady_clock::now();
+                ValidationResult result = validate(data);
+                double verifyMilliseconds = getElapsedMilliseconds(start);
+
+                if (!isDecoded || result.error != ValidationError::NONE)
+                {
+                    std::cout << "Failed to validate \'" << filename << "\': "
+                              << getValidationErrorName(result.error) << " at byte " << result.offset << " [FAIL]" << std::endl;
+                    return false;
+                }
+
+                fullDecodeMilliseconds += fullMilliseconds;
+                coefficientMilliseconds += coefficientsMilliseconds;
+                validationMilliseconds += verifyMilliseconds;
+
+                bool isPassing = true;
+
+                // The corruptions with a known error & offset
+                struct Corruption
+                {
+                    const char* name;
+                    std::vector<UInt8> data;
+                    ValidationError error;
+                    std::size_t offset;
+                };
+
+                std::vector<Corruption> corruptions;
+
+                std::vector<UInt8> corrupted(data.begin(), data.end() - 2);
+                corruptions.push_back({ "without EOI", corrupted, ValidationError::MISSING_EOI, corrupted.size() });
+
+                corrupted = data;
+                corrupted.insert(corrupted.end(), { 0x00, 0x01, 0x02 });
+                corruptions.push_back({ "trailing data", corrupted, ValidationError::TRAILING_DATA, data.size() });
+
+                corrupted = data;
+                corrupted[1] = 0x00;
+                corruptions.push_back({ "without SOI", corrupted, ValidationError::MISSING_SOI, 0 });
+
+                for (auto&& corruption : corruptions)
+                {
+                    result = validate(corruption.data);
+
+                    if (result.error != corruption.error || result.offset != corruption.offset)
+                    {
+                        std::cout << "Copy of \'" << filename << "\' " << corruption.name << " was reported as "
+                                  << getValidationErrorName(result.error) << " at byte " << result.offset << " [FAIL]" << std::endl;
+                        isPassing = false;
+                    }
+                }
+
+                // Truncated copies fail within their data, whichever error is found first
+                for (auto&& fraction : { 0.25, 0.5, 0.75 })
+                {
+                    corrupted.assign(data.begin(), data.begin() + std::size_t(data.size() * fraction));
+                    result = validate(corrupted);
+
+                    if (result.error == ValidationError::NONE || result.offset > corrupted.size())
+                    {
+                        std::cout << "Copy of \'" << filename << "\' truncated at " << corrupted.size() << " bytes was reported as "
+                                  << getValidationErrorName(result.error) << " at byte " << result.offset << " [FAIL]" << std::endl;
+                        isPassing = false;
+                    }
+                }
+
+                // A flipped bit may still leave valid codes, so these aren't
+                // all found, but an error must be found at or after the flip,
+                // or at the marker of the segment it's in
+                const std::size_t flipCount = 16;
+                std::size_t foundCount = 0;
+
+                for (std::size_t i = 0; i < flipCount; ++i)
+                {
+                    const std::size_t offset = data.size() / 2 + i * (data.size() / 2 - 2) / flipCount;
+
+                    corrupted = data;
+                    corrupted[offset] ^= UInt8(1 << (i % 8));
+                    result = validate(corrupted);
+
+                    if (result.error == ValidationError::NONE)
+                        continue;
+
+                    foundCount++;
+
+                    const bool isSegmentError = result.error == ValidationError::INVALID_MARKER ||
+                                                result.error == ValidationError::TRUNCATED_SEGMENT ||
+                                                result.error == ValidationError::INVALID_SEGMENT;
+
+                    if (result.offset < offset && !isSegmentError)
+                    {
+                        std::cout << "Copy of \'" << filename << "\' with a bit flipped at byte " << offset << " was reported as "
+                                  << getValidationErrorName(result.error) << " at byte " << result.offset << " [FAIL]" << std::endl;
+                        isPassing = false;
+                    }
+                }
+
+                cells = {
+                    formatNumber(fullMilliseconds),
+                    formatNumber(coefficientsMilliseconds),
+                    formatNumber(verifyMilliseconds),
+                    std::to_string(foundCount) + "/" + std::to_string(flipCount)
+                };
+
+                return isPassing;
+            };
+
+            check.summarize = [&]
+            {
+                std::cout << std::fixed << std::setprecision(2)
+                          << "Full decodes " << fullDecodeMilliseconds << " ms, coefficient decodes " << coefficientMilliseconds
+                          << " ms, validation " << validationMilliseconds << " ms (" << std::setprecision(1)
+                          << (validationMilliseconds > 0.0 ? fullDecodeMilliseconds / validationMilliseconds : 0.0)
+                          << "x faster than a full decode)" << std::endl;
+
+                return true;
+            };
+
+            check.passMessage = "Corruptions are reported with their offset [OK]";
+            check.failMessage = "Validation failed [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+
+        bool runCancellationCheck(const std::string& directory)
+        {
+            Decoder decoder;
+
+            const auto noDeadline = std::chrono::steady_clock::time_point::max();
+
+            CorpusCheck check;
+            check.title = "Cancellation";
+            check.columns = { { "decode ms", 12 }, { "cancelled ms", 16 }, { "overshoot ms", 16 } };
+
+            check.checkImage = [&](const CorpusImage& image, std::vector<std::string>& cells)
+            {
+                const std::string& filename = image.filename;
+
+                DecodeSample reference = decodeImage(decoder, filename);
+
+                if (!reference.isDecoded)
+                {
+                    std::cout << "Failed to decode \'" << filename << "\' [FAIL]" << std::endl;
+                    return false;
+                }
+
+                bool isPassing = true;
+
+                // A deadline that has passed stops every kind of decode
+                // before it reads the first segment
+                decoder.setDeadline(std::chrono::steady_clock::now());
+
+                decoder.open(filename);
+                Decoder::ResultCode imageResult = decoder.decodeImageFile();
+                decoder.close();
+
+                decoder.open(filename);
+                Decoder::ResultCode coefficientResult = decoder.decodeCoefficients();
+                decoder.close();
+
+                decoder.open(filename);
+                ValidationResult validation = decoder.validateImageFile();
+                decoder.close();
+
+                decoder.setDeadline(noDeadline);
+
+                if (imageResult != Decoder::ResultCode::CANCELLED ||
+                    coefficientResult != Decoder::ResultCode::CANCELLED ||
+                    validation.error != ValidationError::CANCELLED)
+                {
+                    std::cout << "Decodes of \'" << filename << "\' past their deadline weren't cancelled [FAIL]" << std::endl;
+                    isPassing = false;
+                }
+
+                double cancelledMilliseconds = -1.0;
+                double overshootMilliseconds = -1.0;
+
+                if (reference.milliseconds >= MIN_CANCELLED_MILLISECONDS)
+                {
+                    const auto delay = std::chrono::microseconds(std::int64_t(reference.milliseconds * 250.0));
+
+                    // Cancelled by another thread a quarter of the way
+                    CancellationToken token;
+                    std::chrono::steady_clock::time_point cancelled;
+
+                    decoder.setCancellationToken(&token);
+                    decoder.open(filename);
+
+                    std::thread canceller([&token, &cancelled, delay]
+                    {
+                        std::this_thread::sleep_for(delay);
+                        cancelled = std::chrono::steady_clock::now();
+                        token.cancel();
+                    });
+
+                    imageResult = decoder.decodeImageFile();
+                    const auto stopped = std::chrono::steady_clock::now();
+
+                    canceller.join();
+                    decoder.close();
+                    decoder.setCancellationToken(nullptr);
+
+                    cancelledMilliseconds = std::chrono::duration<double, std::milli>(stopped - cancelled).count();
+
+                    // Past its deadline a quarter of the way
+                    const auto deadline = std::chrono::steady_clock::now() + delay;
+
+                    decoder.setDeadline(deadline);
+                    decoder.open(filename);
+
+                    Decoder::ResultCode deadlineResult = decoder.decodeImageFile();
+                    overshootMilliseconds = getElapsedMilliseconds(deadline);
+
+                    decoder.close();
+                    decoder.setDeadline(noDeadline);
+
+                    const double maxMilliseconds = reference.milliseconds / 4;
+
+                    if (imageResult != Decoder::ResultCode::CANCELLED || cancelledMilliseconds > maxMilliseconds ||
+                        deadlineResult != Decoder::ResultCode::CANCELLED || overshootMilliseconds > maxMilliseconds)
+                    {
+                        std::cout << "Decodes of \'" << filename << "\' didn't stop within " << maxMilliseconds << " ms [FAIL]" << std::endl;
+                        isPassing = false;
+                    }
+                }
+
+                // Nothing of a cancelled decode is left to change the next one
+                DecodeSample sample = decodeImage(decoder, filename);
+
+                if (!sample.isDecoded || sample.checksum != reference.checksum)
+                {
+                    std::cout << "Decoding \'" << filename << "\' after cancelled decodes changed its pixels [FAIL]" << std::endl;
+                    isPassing = false;
+                }
+
+                // The images too small to cancel partway only have a decode time
+                cells.push_back(formatNumber(reference.milliseconds));
+                cells.push_back(cancelledMilliseconds < 0.0 ? "-" : formatNumber(cancelledMilliseconds));
+                cells.push_back(overshootMilliseconds < 0.0 ? "-" : formatNumber(overshootMilliseconds));
+
+                return isPassing;
+            };
+
+            check.passMessage = "Decodes stop promptly once cancelled [OK]";
+            check.failMessage = "Cancellation failed [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+
+        bool runLazyDecoding(const std::string& directory)
+        {
+            Decoder decoder;
+            LazyImage lazyImage;
+
+            CorpusCheck check;
+            check.title = "Lazy decoding";
+            check.columns = { { "MCU rows", 10 }, { "full ms", 12 }, { "index ms", 12 }, { "probe ms", 12 } };
+
+            check.checkImage = [&](const CorpusImage& corpusImage, std::vector<std::string>& cells)
+            {
+                const std::string& filename = corpusImage.filename;
+                const std::vector<UInt8>& data = corpusImage.data;
+
+                decoder.reset();
+
+                auto start = std::chrono::steady_clock::now();
+                bool isDecoded = decoder.open(data.data(), data.size()) &&
+                                 decoder.decodeImageFile() == Decoder::ResultCode::DECODE_DONE;
+                double fullMilliseconds = getElapsedMilliseconds(start);
+
+                decoder.close();
+
+                if (!isDecoded)
+                    return true;
+
+                decoder.reset();
+                lazyImage.setMaxResidentRows(LazyImage::DEFAULT_MAX_RESIDENT_ROWS);
+
+                start = std::chrono::steady_clock::now();
+                bool isIndexed = decoder.open(data.data(), data.size()) &&
+                                 decoder.decodeLazyImage(lazyImage) == Decoder::ResultCode::DECODE_DONE;
+                double indexMilliseconds = getElapsedMilliseconds(start);
+
+                decoder.close();
+
+                // Only baseline images can be decoded lazily
+                if (!isIndexed)
+                    return true;
+
+                // A letterbox check reads the top rows only
+                start = std::chrono::steady_clock::now();
+                for (std::size_t y = 0; y < std::min(lazyImage.height, std::size_t(8)); ++y)
+                    lazyImage.getRow(y);
+                double probeMilliseconds = getElapsedMilliseconds(start);
+
+                cells = {
+                    std::to_string(lazyImage.getMCURowCount()),
+                    formatNumber(fullMilliseconds, 3),
+                    formatNumber(indexMilliseconds, 3),
+                    formatNumber(probeMilliseconds, 3)
+                };
+
+                bool isPassing = true;
+
+                if (lazyImage.getDecodedRowCount() != 1)
+                {
+                    std::cout << "Probing \'" << filename << "\' decoded " << lazyImage.getDecodedRowCount()
+                              << " MCU rows instead of 1 [FAIL]" << std::endl;
+                    isPassing = false;
+                }
+
+                // Reading bottom to top with a small bound evicts every row
+                const Image& image = decoder.getImage();
+                lazyImage.setMaxResidentRows(2);
+
+                for (std::size_t y = image.height; y-- > 0 && isPassing; )
+                {
+                    const Pixel* row = lazyImage.getRow(y);
+                    const std::vector<Pixel>& expected = (*image.getPixelPtr())[y];
+
+                    for (std::size_t x = 0; x < image.width && row != nullptr; ++x)
+                    {
+                        if (row[x].comp[0] != expected[x].comp[0] ||
+                            row[x].comp[1] != expected[x].comp[1] ||
+                            row[x].comp[2] != expected[x].comp[2])
+                            row = nullptr;
+                    }
+
+                    if (row == nullptr || lazyImage.getResidentRowCount() > 2)
+                    {
+                        std::cout << "Row " << y << " of \'" << filename << "\' read lazily differs from the full decode [FAIL]" << std::endl;
+                        isPassing = false;
+                    }
+                }
+
+                return isPassing;
+            };
+
+            check.passMessage = "Lazy images match the full decodes [OK]";
+            check.failMessage = "Lazy decoding failed [FAIL]";
+
+            return runCorpusCheck(directory, check);
+        }
+    }
+}
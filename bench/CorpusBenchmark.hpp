@@ -0,0 +1,200 @@
+// End-to-end corpus benchmark
+//
+// Decodes every JPEG of a directory through the public Decoder API, first
+// cold (a new decoder per image) and then warm (one decoder reused for N
+// passes over the corpus), and reports the throughput, per-image latency
+// percentiles & peak memory use. Every warm decode is checked against the
+// cold decode of the same image, so the benchmark also checks that many
+// images decode correctly in one process.
+//
+// The IDCT comparison decodes the same corpus with each IDCT implementation
+// and measures how far the integer ones are from the float reference.
+//
+// The coefficient comparison decodes the corpus to quantized DCT coefficients
+// only, both whole-image & streamed, and checks them against the pixels.
+//
+// The Huffman optimization re-encodes the corpus losslessly with Huffman
+// tables built for each image, and reports the bytes it saves.
+//
+// The multi-resolution rendering decodes the corpus to coefficients once,
+// renders every image at each scale from them, and compares the time taken
+// with that of a full decode per scale.
+//
+// The lazy decoding check decodes the corpus into lazy images, times a probe
+// of their top rows against a full decode, and checks every row they decode.
+
+#ifndef CORPUS_BENCHMARK_HPP
+#define CORPUS_BENCHMARK_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+
+namespace kpeg
+{
+    namespace bench
+    {
+        // A JPEG image of a directory
+        struct CorpusImage
+        {
+            // The position of the image in the directory, sorted by name
+            std::size_t index;
+
+            // The path of the image, & its name without the directory
+            std::string filename;
+            std::string name;
+
+            // The JFIF data of the image
+            std::vector<UInt8> data;
+        };
+
+        // A column of the table a corpus check prints, after the image's name
+        struct CorpusColumn
+        {
+            std::string heading;
+            int width;
+        };
+
+        // A check of every JPEG of a directory, see runCorpusCheck()
+        struct CorpusCheck
+        {
+            // The name of the check, printed with the number of images
+            std::string title;
+
+            // The columns of the table printed with a row per image, none
+            // for no table
+            std::vector<CorpusColumn> columns;
+
+            // Check an image, appending the cells of its row to cells, a
+            // row isn't printed if none are (e.g., the image failed to decode)
+            // @return false if the image failed the check
+            std::function<bool(const CorpusImage& image, std::vector<std::string>& cells)> checkImage;
+
+            // Print the results over all the images, after the table, if set
+            // @return false if the results fail the check
+            std::function<bool()> summarize;
+
+            // The last line printed, as the check passes or fails
+            std::string passMessage;
+            std::string failMessage;
+        };
+
+        // Settings of a corpus benchmark run
+        struct CorpusOptions
+        {
+            // The directory of JPEG images to decode
+            std::string directory;
+
+            // The number of warm passes over the corpus
+            int passes = 5;
+
+            // Where to write the results as JSON, nowhere if empty
+            std::string resultsFilename;
+
+            // Results of an earlier run to compare with, none if empty
+            std::string baselineFilename;
+
+            // The largest drop in throughput from the baseline, in percent,
+            // before the run counts as a regression
+            double threshold = 5.0;
+        };
+
+        // List the JPEG files of a directory, sorted by name
+        std::vector<std::string> listJPEGFiles(const std::string& directory);
+
+        // Read every JPEG of a directory, e.g., to decode them from memory
+        // @return the images, sorted by name, none if the directory has none
+        //         (which is printed)
+        std::vector<CorpusImage> readCorpus(const std::string& directory);
+
+        // Run a check over every JPEG of a directory: read the images one by
+        // one, check each & print its row, then the summary & whether the
+        // check passed
+        // @return false if the directory has no images, or an image or the
+        //         summary failed the check
+        bool runCorpusCheck(const std::string& directory, const CorpusCheck& check);
+
+        // Run the corpus benchmark & print the results
+        // @return false if an image failed to decode, decoded differently
+        //         when warm, or the throughput regressed from the baseline
+        bool runCorpusBenchmark(const CorpusOptions& options);
+
+        // Decode every JPEG of a directory with each IDCT implementation &
+        // print the throughput of each, and the PSNR & maximum absolute error
+        // of the integer implementations against the float reference
+        // @param directory the directory of JPEG images to decode
+        // @param minimumPSNR the lowest PSNR, in dB, of any image decoded with
+        //        the accurate integer IDCT before the run counts as a failure
+        // @return false if an image failed to decode, or was decoded with
+        //         the accurate integer IDCT below the minimum PSNR
+        bool runIDCTComparison(const std::string& directory, const double minimumPSNR);
+
+        // Decode every JPEG of a directory to pixels, to a buffer of quantized
+        // DCT coefficients & to streamed blocks of them, print the throughput
+        // of each, and check that the coefficients reconstruct the pixels
+        // @param directory the directory of JPEG images to decode
+        // @return false if an image failed to decode, or its coefficients
+        //         don't match its pixels
+        bool runCoefficientComparison(const std::string& directory);
+
+        // Re-encode every JPEG of a directory with optimized Huffman tables,
+        // print the sizes before & after, and check that the coefficients &
+        // quantization tables of every image are unchanged
+        // @param directory the directory of JPEG images to re-encode
+        // @return false if an image failed to re-encode, or its coefficients
+        //         changed
+        bool runHuffmanOptimization(const std::string& directory);
+
+        // Render every JPEG of a directory at 1/1, 1/2, 1/4 & 1/8 scale from
+        // its coefficients, decoded once, print the time taken against that
+        // of a full decode for each scale, and check the renderings against
+        // the full decode, exactly at full scale and by their PSNR against
+        // its box-filtered pixels otherwise
+        // @param directory the directory of JPEG images to render
+        // @return false if an image failed to decode, or a rendering differs
+        //         from the full decode
+        bool runMultiResolutionRendering(const std::string& directory);
+
+        // Compute the statistics of every JPEG of a directory from its DC
+        // coefficients, & from its first AC coefficients too, print the time
+        // taken against that of a full decode, and check the average colour
+        // & the perceptual hash against those of the full decode
+        // @param directory the directory of JPEG images to analyze
+        // @return false if an image failed to decode, or its statistics are
+        //         far from those of the full decode
+        bool runStatisticsComparison(const std::string& directory);
+
+        // Validate every JPEG of a directory, print the time taken against
+        // that of a full decode & of a decode to coefficients, then validate
+        // corrupted copies of it (truncated, without its EOI marker, with
+        // trailing data, without its SOI marker & with flipped bits in its
+        // scan) and check the error & the offset reported for each
+        // @param directory the directory of JPEG images to validate
+        // @return false if an image failed to validate, or a corrupted copy
+        //         was reported valid or with the wrong error
+        bool runValidationCheck(const std::string& directory);
+
+        // Decode every JPEG of a directory with a deadline that has passed,
+        // then cancel decodes of the larger ones from another thread & let
+        // others pass their deadline part way, printing how long each took
+        // to stop, and check that the decoder decodes the image as before
+        // afterwards
+        // @param directory the directory of JPEG images to decode
+        // @return false if a decode wasn't cancelled, stopped late, or a
+        //         decode after it differed
+        bool runCancellationCheck(const std::string& directory);
+
+        // Decode every baseline JPEG of a directory into a lazy image, print
+        // the time taken to index it & to read its top 8 rows against that
+        // of a full decode, then read all its rows with a bound of 2 resident
+        // MCU rows, bottom to top, and check them against the full decode
+        // @param directory the directory of JPEG images to decode
+        // @return false if an image failed to decode, or a row read lazily
+        //         differs from the full decode
+        bool runLazyDecoding(const std::string& directory);
+    }
+}
+
+#endif // CORPUS_BENCHMARK_HPP
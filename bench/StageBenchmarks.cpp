@@ -0,0 +1,342 @@
+// Micro-benchmarks of the decoder stages
+//
+// Every stage runs on fixed synthetic inputs, generated from a fixed seed,
+// so the results of two builds can be compared run for run.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "Benchmark.hpp"
+#include "StageBenchmarks.hpp"
+#include "HuffmanTree.hpp"
+#include "HuffmanCache.hpp"
+#include "StandardTables.hpp"
+#include "Transform.hpp"
+#include "Image.hpp"
+#include "MCU.hpp"
+#include "ScanData.hpp"
+
+namespace kpeg
+{
+    namespace bench
+    {
+        volatile long long g_sink = 0;
+
+        namespace
+        {
+            // Seed of the synthetic inputs
+            const unsigned SEED = 0x6B706567;
+
+            // Frame size of the image stages, in MCUs (640x480 pixels)
+            const std::size_t MCUS_PER_LINE = 80;
+            const std::size_t MCU_ROWS = 60;
+
+            // Encode random symbols of the standard luminance AC table as a
+            // scan, a string of '0' & '1' characters
+            std::string makeHuffmanScan(const std::size_t symbolCount, std::vector<int>& symbols)
+            {
+                std::vector<std::string> codes(256);
+
+                int code = 0;
+                int index = 0;
+
+                for (auto length = 1; length <= 16; ++length)
+                {
+                    for (auto i = 0; i < STD_AC_LUMINANCE_BITS[length - 1]; ++i, ++code, ++index)
+                    {
+                        std::string codeStr;
+                        for (auto bit = length - 1; bit >= 0; --bit)
+                            codeStr += ((code >> bit) & 1) ? '1' : '0';
+                        codes[STD_AC_LUMINANCE_VALUES[index]] = codeStr;
+                    }
+
+                    code <<= 1;
+                }
+
+                std::mt19937 rng(SEED);
+                std::uniform_int_distribution<int> pick(0, index - 1);
+
+                std::string scan;
+                symbols.clear();
+
+                for (std::size_t i = 0; i < symbolCount; ++i)
+                {
+                    int symbol = STD_AC_LUMINANCE_VALUES[pick(rng)];
+                    symbols.push_back(symbol);
+                    scan += codes[symbol];
+                }
+
+                return scan;
+            }
+
+            // An MCU reconstructed from random, JPEG-like coefficients: large
+            // at low frequencies, mostly zero at high ones
+            MCU makeMCU(std::mt19937& rng, const std::vector<std::vector<UInt16>>& QTables)
+            {
+                std::array<std::array<Int16, 64>, 3> coeffs;
+
+                for (auto&& comp : coeffs)
+                {
+                    for (auto i = 0; i < 64; ++i)
+                    {
+                        int range = i == 0 ? 60 : std::max(1, 16 - i / 2);
+                        comp[i] = Int16(std::uniform_int_distribution<int>(-range, range)(rng) * (i < 20));
+                    }
+                }
+
+                return MCU({ coeffs[0].data(), coeffs[1].data(), coeffs[2].data() }, QTables);
+            }
+        }
+
+        void runStageBenchmarks(const int repetitions)
+        {
+            const std::vector<std::vector<UInt16>> QTables(2, std::vector<UInt16>(64, 2));
+
+            std::cout << "Decoder stage micro-benchmarks, " << repetitions << " runs each" << std::endl;
+            std::cout << std::endl;
+
+            // Huffman decoding, with the lookup tables used by the decoder
+            // and with the original Huffman tree, for comparison
+            {
+                std::vector<int> symbols;
+                const std::string scan = makeHuffmanScan(100000, symbols);
+
+                const UInt8* bits = nullptr;
+                const UInt8* values = nullptr;
+                getStandardHuffmanTable(HT_AC, HT_Y, bits, values);
+
+                HuffmanLookupTable lookupTable = buildHuffmanLookupTable(bits, values);
+
+                // The decoder reads the scan as bytes
+                std::vector<UInt8> scanBytes((scan.size() + 7) / 8, 0);
+
+                for (std::size_t i = 0; i < scan.size(); ++i)
+                    if (scan[i] == '1')
+                        scanBytes[i / 8] |= 0x80 >> (i % 8);
+
+                auto result = measure("Huffman decode (lookup table)", Metric::NANOSECONDS_PER_ITEM, "symbol", repetitions, [&]
+                {
+                    BitReader reader;
+                    reader.setData(scanBytes.data(), scanBytes.size());
+                    long long sum = 0;
+
+                    for (std::size_t i = 0; i < symbols.size(); ++i)
+                        sum += decodeHuffmanSymbol(lookupTable, reader);
+
+                    g_sink += sum;
+                    return symbols.size();
+                });
+                printMeasurement(result, Metric::NANOSECONDS_PER_ITEM);
+
+                HuffmanTable htable;
+                for (int i = 0, symbol = 0; i < 16; symbol += bits[i++])
+                {
+                    htable[i].first = bits[i];
+                    htable[i].second.assign(values + symbol, values + symbol + bits[i]);
+                }
+
+                HuffmanTree tree(htable);
+                const std::size_t treeSymbols = 10000;
+
+                result = measure("Huffman decode (tree)", Metric::NANOSECONDS_PER_ITEM, "symbol", repetitions, [&]
+                {
+                    std::size_t k = 0;
+                    long long sum = 0;
+
+                    for (std::size_t i = 0; i < treeSymbols; ++i)
+                    {
+                        std::string bitsScanned;
+                        std::string value;
+
+                        do
+                        {
+                            bitsScanned += scan[k++];
+                            value = tree.contains(bitsScanned);
+                        } while (value.empty() && k < scan.size());
+
+                        sum += value.size();
+                    }
+
+                    g_sink += sum;
+                    return treeSymbols;
+                });
+                printMeasurement(result, Metric::NANOSECONDS_PER_ITEM);
+            }
+
+            // Scan data extraction, one byte at a time as the decoder read
+            // the scan through its stream, & with the vectorized search
+            {
+                std::mt19937 rng(SEED);
+
+                // 1 MB of random entropy-coded data, 0xFF bytes stuffed, with
+                // a restart marker every 4 KB & an EOI marker at the end
+                std::vector<UInt8> scan;
+
+                while (scan.size() < (1 << 20))
+                {
+                    UInt8 byte = UInt8(rng());
+                    scan.push_back(byte);
+
+                    if (byte == 0xFF)
+                        scan.push_back(0x00);
+
+                    if (scan.size() % 4096 == 0)
+                    {
+                        scan.push_back(0xFF);
+                        scan.push_back(UInt8(0xD0 + (scan.size() / 4096) % 8));
+                    }
+                }
+
+                scan.push_back(0xFF);
+                scan.push_back(0xD9);
+
+                std::vector<UInt8> output(scan.size());
+
+                auto result = measure("Scan extraction (bytewise)", Metric::MEGABYTES_PER_SECOND, "", repetitions, [&]
+                {
+                    std::size_t size = 0;
+
+                    for (std::size_t i = 0; i < scan.size(); ++i)
+                    {
+                        if (scan[i] != 0xFF)
+                            output[size++] = scan[i];
+                        else if (scan[i + 1] == 0x00)
+                            output[size++] = scan[i++];
+                        else if (scan[i + 1] >= 0xD0 && scan[i + 1] <= 0xD7)
+                            i++;
+                        else
+                            break;
+                    }
+
+                    g_sink += size;
+                    return scan.size();
+                });
+                printMeasurement(result, Metric::MEGABYTES_PER_SECOND);
+
+                result = measure(std::string("Scan extraction (") + getMarkerSearchInstructions() + ")", Metric::MEGABYTES_PER_SECOND, "", repetitions, [&]
+                {
+                    std::size_t size = 0;
+                    extractScanData(scan.data(), scan.data() + scan.size(), output.data(), size);
+
+                    g_sink += size;
+                    return scan.size();
+                });
+                printMeasurement(result, Metric::MEGABYTES_PER_SECOND);
+            }
+
+            // Bit string to coefficient value conversion
+            {
+                std::mt19937 rng(SEED);
+                std::vector<std::string> bitStrings;
+
+                for (auto i = 0; i < 10000; ++i)
+                {
+                    int category = std::uniform_int_distribution<int>(1, 11)(rng);
+                    std::string bitStr;
+                    for (auto bit = 0; bit < category; ++bit)
+                        bitStr += (rng() & 1) ? '1' : '0';
+                    bitStrings.push_back(bitStr);
+                }
+
+                auto result = measure("bitStringtoValue", Metric::NANOSECONDS_PER_ITEM, "value", repetitions, [&]
+                {
+                    long long sum = 0;
+                    for (auto&& bitStr : bitStrings)
+                        sum += bitStringtoValue(bitStr);
+                    g_sink += sum;
+                    return bitStrings.size();
+                });
+                printMeasurement(result, Metric::NANOSECONDS_PER_ITEM);
+            }
+
+            // The per-MCU reconstruction stages, each MCU holds 3 blocks
+            {
+                std::mt19937 rng(SEED);
+                std::vector<MCU> MCUs;
+                for (auto i = 0; i < 64; ++i)
+                    MCUs.push_back(makeMCU(rng, QTables));
+
+                const std::size_t rounds = 16;
+
+                const std::pair<IDCTMode, std::string> modes[] = {
+                    { IDCTMode::FLOAT, "float" },
+                    { IDCTMode::ACCURATE_INTEGER, "accurate" },
+                    { IDCTMode::FAST_INTEGER, "fast" }
+                };
+
+                for (auto&& mode : modes)
+                {
+                    MCU::m_IDCTMode = mode.first;
+
+                    auto result = measure("MCU::computeIDCT (" + mode.second + ")", Metric::NANOSECONDS_PER_ITEM, "block", repetitions, [&]
+                    {
+                        for (std::size_t round = 0; round < rounds; ++round)
+                            for (auto&& mcu : MCUs)
+                                mcu.computeIDCT();
+                        g_sink += MCUs[0].getAllMatrices()[0][0][0];
+                        return rounds * MCUs.size() * 3;
+                    });
+                    printMeasurement(result, Metric::NANOSECONDS_PER_ITEM);
+                }
+
+                MCU::m_IDCTMode = IDCTMode::FLOAT;
+
+                auto result = measure("MCU::performLevelShift", Metric::NANOSECONDS_PER_ITEM, "block", repetitions, [&]
+                {
+                    for (std::size_t round = 0; round < rounds; ++round)
+                        for (auto&& mcu : MCUs)
+                            mcu.performLevelShift();
+                    g_sink += MCUs[0].getAllMatrices()[0][0][0];
+                    return rounds * MCUs.size() * 3;
+                });
+                printMeasurement(result, Metric::NANOSECONDS_PER_ITEM);
+
+                // The conversion works in place, so each round runs on the
+                // output of the last, which stays a valid RGB block
+                result = measure("MCU::convertYCbCrToRGB", Metric::NANOSECONDS_PER_ITEM, "block", repetitions, [&]
+                {
+                    for (std::size_t round = 0; round < rounds; ++round)
+                        for (auto&& mcu : MCUs)
+                            mcu.convertYCbCrToRGB();
+                    g_sink += MCUs[0].getAllMatrices()[0][0][0];
+                    return rounds * MCUs.size() * 3;
+                });
+                printMeasurement(result, Metric::NANOSECONDS_PER_ITEM);
+            }
+
+            // Assembling & writing a whole 640x480 image
+            {
+                std::mt19937 rng(SEED);
+                std::vector<MCU> MCUs;
+                for (std::size_t i = 0; i < MCUS_PER_LINE * MCU_ROWS; ++i)
+                    MCUs.push_back(makeMCU(rng, QTables));
+
+                Image image;
+                image.width = MCUS_PER_LINE * 8;
+                image.height = MCU_ROWS * 8;
+
+                const std::size_t imageBytes = image.width * image.height * 3;
+
+                auto result = measure("Image::createImageFromMCUs", Metric::MEGABYTES_PER_SECOND, "", repetitions, [&]
+                {
+                    image.createImageFromMCUs(MCUs, MCUS_PER_LINE);
+                    return imageBytes;
+                });
+                printMeasurement(result, Metric::MEGABYTES_PER_SECOND);
+
+                const std::string dumpFilename = "kpeg_bench.ppm";
+
+                result = measure("Image::dumpRawData", Metric::MEGABYTES_PER_SECOND, "", repetitions, [&]
+                {
+                    image.dumpRawData(dumpFilename);
+                    return imageBytes;
+                });
+                printMeasurement(result, Metric::MEGABYTES_PER_SECOND);
+
+                std::remove(dumpFilename.c_str());
+            }
+        }
+    }
+}
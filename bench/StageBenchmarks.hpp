@@ -0,0 +1,16 @@
+// Micro-benchmarks of the decoder stages
+
+#ifndef STAGE_BENCHMARKS_HPP
+#define STAGE_BENCHMARKS_HPP
+
+namespace kpeg
+{
+    namespace bench
+    {
+        // Time each decoder stage on synthetic inputs & print the results
+        // @param repetitions the number of timed runs of each stage
+        void runStageBenchmarks(const int repetitions);
+    }
+}
+
+#endif // STAGE_BENCHMARKS_HPP
@@ -0,0 +1,271 @@
+// Implementation of the tensor output benchmark
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "TensorBenchmark.hpp"
+#include "CorpusBenchmark.hpp"
+#include "Decoder.hpp"
+#include "Tensor.hpp"
+
+namespace kpeg
+{
+    namespace bench
+    {
+        namespace
+        {
+            typedef std::vector<std::pair<const UInt8*, std::size_t>> ImageList;
+
+            // The largest difference from the multi-pass tensors, beyond the
+            // rounding of float32 & of float16 (whose samples are below 3)
+            const float MAX_FLOAT32_ERROR = 1e-4f;
+            const float MAX_FLOAT16_ERROR = 2e-3f;
+
+            float halfToFloat(const UInt16 half)
+            {
+                const std::uint32_t sign = std::uint32_t(half & 0x8000) << 16;
+                const int exponent = (half >> 10) & 0x1F;
+                const std::uint32_t mantissa = half & 0x3FF;
+
+                float magnitude;
+
+                if (exponent == 0)
+                    magnitude = std::ldexp(float(mantissa), -24);
+                else if (exponent == 31)
+                    magnitude = mantissa != 0 ? NAN : INFINITY;
+                else
+                    magnitude = std::ldexp(float(mantissa | 0x400), exponent - 25);
+
+                std::uint32_t bits;
+                std::memcpy(&bits, &magnitude, sizeof(bits));
+                bits |= sign;
+                std::memcpy(&magnitude, &bits, sizeof(bits));
+
+                return magnitude;
+            }
+
+            // The preprocessing of a data loader, one pass at a time: convert
+            // the pixels to float, normalize them, transpose them to CHW &
+            // resize each plane, with the same sampling as the fused output
+            bool decodeMultiPass(Decoder& decoder, const ImageList& images,
+                                 const TensorOptions& options, float* batch)
+            {
+                bool isPassing = true;
+                const std::size_t size = options.width;
+
+                std::vector<float> interleaved;
+                std::vector<float> planar;
+
+                for (auto&& image : images)
+                {
+                    decoder.reset();
+
+                    bool isDecoded = decoder.open(image.first, image.second) &&
+                                     decoder.decodeImageFile() == Decoder::ResultCode::DECODE_DONE;
+
+                    decoder.close();
+
+                    if (!isDecoded)
+                    {
+                        std::fill(batch, batch + 3 * size * size, 0.0f);
+                        batch += 3 * size * size;
+                        isPassing = false;
+                        continue;
+                    }
+
+                    const Image& decoded = decoder.getImage();
+                    const std::size_t width = decoded.width;
+                    const std::size_t height = decoded.height;
+
+                    // Convert
+                    interleaved.resize(width * height * 3);
+
+                    std::size_t i = 0;
+                    for (auto&& row : *decoded.getPixelPtr())
+                    {
+                        for (auto&& pixel : row)
+                        {
+                            for (int c = 0; c < 3; ++c)
+                                interleaved[i++] = float(pixel.comp[c]);
+                        }
+                    }
+
+                    // Normalize
+                    for (std::size_t j = 0; j < interleaved.size(); ++j)
+                    {
+                        int c = j % 3;
+                        interleaved[j] = (interleaved[j] / 255.0f - options.mean[c]) / options.standardDeviation[c];
+                    }
+
+                    // Transpose
+                    planar.resize(interleaved.size());
+
+                    for (std::size_t j = 0; j < width * height; ++j)
+                    {
+                        for (int c = 0; c < 3; ++c)
+                            planar[c * width * height + j] = interleaved[j * 3 + c];
+                    }
+
+                    // Resize
+                    const float xRatio = float(width) / size;
+                    const float yRatio = float(height) / size;
+
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        const float* plane = planar.data() + c * width * height;
+
+                        for (std::size_t y = 0; y < size; ++y)
+                        {
+                            float sy = std::max((y + 0.5f) * yRatio - 0.5f, 0.0f);
+                            std::size_t y0 = std::min(std::size_t(sy), height - 1);
+                            std::size_t y1 = std::min(y0 + 1, height - 1);
+                            float fy = sy - y0;
+
+                            for (std::size_t x = 0; x < size; ++x)
+                            {
+                                float sx = std::max((x + 0.5f) * xRatio - 0.5f, 0.0f);
+                                std::size_t x0 = std::min(std::size_t(sx), width - 1);
+                                std::size_t x1 = std::min(x0 + 1, width - 1);
+                                float fx = sx - x0;
+
+                                float top = plane[y0 * width + x0] + fx * (plane[y0 * width + x1] - plane[y0 * width + x0]);
+                                float bottom = plane[y1 * width + x0] + fx * (plane[y1 * width + x1] - plane[y1 * width + x0]);
+
+                                batch[(c * size + y) * size + x] = top + fy * (bottom - top);
+                            }
+                        }
+                    }
+
+                    batch += 3 * size * size;
+                }
+
+                return isPassing;
+            }
+
+            // Time a batch decode over several repetitions
+            // @return the best time, in milliseconds
+            template<typename Work>
+            double timeBatch(const int repetitions, Work work)
+            {
+                double best = INFINITY;
+
+                for (auto i = 0; i < repetitions; ++i)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    work();
+                    best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                }
+
+                return best;
+            }
+        }
+
+        bool runTensorBenchmark(const std::string& directory, const std::size_t size, const int repetitions)
+        {
+            // The images are decoded from memory, so that reading the files
+            // doesn't count
+            const std::vector<CorpusImage> corpus = readCorpus(directory);
+
+            if (corpus.empty())
+                return false;
+
+            ImageList images;
+
+            for (auto&& image : corpus)
+                images.emplace_back(image.data.data(), image.data.size());
+
+            TensorOptions options;
+            options.width = size;
+            options.height = size;
+
+            const float mean[3] = { 0.485f, 0.456f, 0.406f };
+            const float standardDeviation[3] = { 0.229f, 0.224f, 0.225f };
+
+            std::copy(mean, mean + 3, options.mean);
+            std::copy(standardDeviation, standardDeviation + 3, options.standardDeviation);
+
+            TensorOptions halfOptions = options;
+            halfOptions.type = TensorType::FLOAT16;
+
+            const std::size_t elementCount = images.size() * 3 * size * size;
+
+            std::vector<float> multiPass(elementCount);
+            std::vector<float> fused(elementCount);
+            std::vector<UInt16> fusedHalf(elementCount);
+
+            std::cout << "Tensor output: " << images.size() << " images to a " << images.size()
+                      << "x3x" << size << "x" << size << " batch" << std::endl;
+            std::cout << std::endl;
+
+            Decoder decoder;
+            bool isPassing = true;
+            std::size_t decodedCount = 0;
+
+            double multiPassTime = timeBatch(repetitions, [&]
+            {
+                isPassing = decodeMultiPass(decoder, images, options, multiPass.data());
+            });
+
+            double fusedTime = timeBatch(repetitions, [&]
+            {
+                decodedCount = decodeTensorBatch(decoder, images, options, fused.data());
+            });
+
+            double fusedHalfTime = timeBatch(repetitions, [&]
+            {
+                decodeTensorBatch(decoder, images, halfOptions, fusedHalf.data());
+            });
+
+            if (!isPassing || decodedCount != images.size())
+            {
+                std::cout << "Failed to decode " << images.size() - decodedCount << " images" << std::endl;
+                isPassing = false;
+            }
+
+            float maxError = 0.0f;
+            float maxHalfError = 0.0f;
+
+            for (std::size_t i = 0; i < elementCount; ++i)
+            {
+                maxError = std::max(maxError, std::abs(fused[i] - multiPass[i]));
+                maxHalfError = std::max(maxHalfError, std::abs(halfToFloat(fusedHalf[i]) - multiPass[i]));
+            }
+
+            std::cout << std::left << std::setw(20) << "output" << std::right
+                      << std::setw(12) << "ms/batch"
+                      << std::setw(12) << "max error" << std::endl;
+
+            std::cout << std::left << std::setw(20) << "multi-pass float32" << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(12) << multiPassTime
+                      << std::setw(12) << "-" << std::endl;
+
+            std::cout << std::left << std::setw(20) << "fused float32" << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(12) << fusedTime
+                      << std::scientific << std::setprecision(1) << std::setw(12) << maxError << std::endl;
+
+            std::cout << std::left << std::setw(20) << "fused float16" << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(12) << fusedHalfTime
+                      << std::scientific << std::setprecision(1) << std::setw(12) << maxHalfError << std::endl;
+
+            std::cout << std::defaultfloat << std::endl;
+
+            if (maxError > MAX_FLOAT32_ERROR || maxHalfError > MAX_FLOAT16_ERROR)
+            {
+                std::cout << "Fused tensors differ from the multi-pass ones [FAIL]" << std::endl;
+                isPassing = false;
+            }
+            else if (!isPassing)
+                std::cout << "Tensor output failed [FAIL]" << std::endl;
+            else
+                std::cout << "Fused tensors match the multi-pass ones [OK]" << std::endl;
+
+            return isPassing;
+        }
+    }
+}
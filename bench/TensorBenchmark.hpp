@@ -0,0 +1,31 @@
+// Tensor output benchmark
+//
+// Compares the fused tensor output of the decoder with the usual
+// preprocessing of an ML data loader, which decodes to RGB and then
+// converts to float, normalizes, transposes to CHW & resizes the image,
+// one pass over memory each. Both produce the same batch of normalized
+// tensors of a corpus, so the benchmark also checks the fused output
+// against the multi-pass one.
+
+#ifndef TENSOR_BENCHMARK_HPP
+#define TENSOR_BENCHMARK_HPP
+
+#include <string>
+
+namespace kpeg
+{
+    namespace bench
+    {
+        // Decode every JPEG of a directory into a batch of square tensors,
+        // normalized with the ImageNet mean & standard deviation, both fused
+        // & in multiple passes, and print the time of each & their difference
+        // @param directory the directory of JPEG images to decode
+        // @param size the width & height of the tensors
+        // @param repetitions the number of times each batch is decoded
+        // @return false if an image failed to decode, or the fused tensors
+        //         differ from the multi-pass ones
+        bool runTensorBenchmark(const std::string& directory, const std::size_t size, const int repetitions);
+    }
+}
+
+#endif // TENSOR_BENCHMARK_HPP
@@ -0,0 +1,126 @@
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <map>
+
+#include "Utility.hpp"
+#include "StageBenchmarks.hpp"
+#include "CorpusBenchmark.hpp"
+#include "AllocationCheck.hpp"
+#include "TensorBenchmark.hpp"
+
+
+void printHelp()
+{
+    std::cout << "===========================================" << std::endl;
+    std::cout << "   K-PEG - Benchmarks"    << std::endl;
+    std::cout << "===========================================" << std::endl;
+    std::cout << "Help\n" << std::endl;
+    std::cout << "[stages] [-r <runs>]            : Time each decoder stage on synthetic inputs" << std::endl;
+    std::cout << "corpus <dir> [-n <passes>] [-o <results.json>] [-b <baseline.json>] [-t <percent>]" << std::endl;
+    std::cout << "                                : Decode every JPEG of a directory cold, then warm for n passes," << std::endl;
+    std::cout << "                                  failing if the throughput drops more than the threshold from the baseline" << std::endl;
+    std::cout << "idct <dir> [-p <psnr>]          : Decode every JPEG of a directory with each IDCT, comparing the integer" << std::endl;
+    std::cout << "                                  ones to the float reference, failing if the accurate one is below the PSNR" << std::endl;
+    std::cout << "coefficients <dir>              : Decode every JPEG of a directory to pixels & to quantized DCT coefficients," << std::endl;
+    std::cout << "                                  failing if the coefficients don't reconstruct the pixels" << std::endl;
+    std::cout << "allocations <dir> [-a <KB>]     : Decode every JPEG of a directory twice with one decoder, failing if" << std::endl;
+    std::cout << "                                  the second pass allocates anything but the output buffers," << std::endl;
+    std::cout << "                                  optionally with a region of memory for the decoder's arena" << std::endl;
+    std::cout << "huffman <dir>                   : Re-encode every JPEG of a directory with optimized Huffman tables," << std::endl;
+    std::cout << "                                  failing if the coefficients of an image change" << std::endl;
+    std::cout << "render <dir>                    : Render every JPEG of a directory at 1/1, 1/2, 1/4 & 1/8 scale from coefficients" << std::endl;
+    std::cout << "                                  decoded once, against a full decode per scale, failing if they differ" << std::endl;
+    std::cout << "stats <dir>                     : Compute the statistics & perceptual hash of every JPEG of a directory from" << std::endl;
+    std::cout << "                                  its DC coefficients, failing if they're far from those of a full decode" << std::endl;
+    std::cout << "verify <dir>                    : Validate every JPEG of a directory & corrupted copies of it," << std::endl;
+    std::cout << "                                  failing if a corruption isn't reported with its error & offset" << std::endl;
+    std::cout << "cancel <dir>                    : Cancel decodes of every JPEG of a directory & let them pass deadlines," << std::endl;
+    std::cout << "                                  failing if one doesn't stop within a quarter of its decode time" << std::endl;
+    std::cout << "lazy <dir>                      : Decode every baseline JPEG of a directory lazily, timing a probe of" << std::endl;
+    std::cout << "                                  its top rows, failing if a row differs from the full decode" << std::endl;
+    std::cout << "tensor <dir> [-s <size>] [-r <runs>] : Decode every JPEG of a directory to a batch of normalized" << std::endl;
+    std::cout << "                                  size x size tensors, fused & in multiple passes, failing if they differ" << std::endl;
+    std::cout << "-h                              : Print this help message and exit" << std::endl;
+}
+
+int main( int argc, char** argv )
+{
+    // Logging would dominate the time of every stage, so it's left off
+    logFile.setEnabled( false );
+
+    std::string mode = "stages";
+    int repetitions = 10;
+    kpeg::bench::CorpusOptions corpusOptions;
+    double minimumPSNR = 45.0;
+    std::size_t regionSize = 0;
+    std::size_t tensorSize = 224;
+
+    // The modes run on a directory of JPEG images, with the options
+    // as they are once the arguments are read
+    const std::map<std::string, std::function<bool()>> corpusModes = {
+        { "corpus",       [&] { return kpeg::bench::runCorpusBenchmark( corpusOptions ); } },
+        { "idct",         [&] { return kpeg::bench::runIDCTComparison( corpusOptions.directory, minimumPSNR ); } },
+        { "coefficients", [&] { return kpeg::bench::runCoefficientComparison( corpusOptions.directory ); } },
+        { "allocations",  [&] { return kpeg::bench::runAllocationCheck( corpusOptions.directory, regionSize ); } },
+        { "huffman",      [&] { return kpeg::bench::runHuffmanOptimization( corpusOptions.directory ); } },
+        { "render",       [&] { return kpeg::bench::runMultiResolutionRendering( corpusOptions.directory ); } },
+        { "stats",        [&] { return kpeg::bench::runStatisticsComparison( corpusOptions.directory ); } },
+        { "verify",       [&] { return kpeg::bench::runValidationCheck( corpusOptions.directory ); } },
+        { "cancel",       [&] { return kpeg::bench::runCancellationCheck( corpusOptions.directory ); } },
+        { "lazy",         [&] { return kpeg::bench::runLazyDecoding( corpusOptions.directory ); } },
+        { "tensor",       [&] { return kpeg::bench::runTensorBenchmark( corpusOptions.directory, tensorSize, repetitions ); } }
+    };
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        std::string arg = argv[i];
+
+        if ( arg == "-h" )
+        {
+            printHelp();
+            return EXIT_SUCCESS;
+        }
+        else if ( arg == "-r" && i + 1 < argc )
+            repetitions = std::max( 1, std::stoi( argv[++i] ) );
+        else if ( arg == "-n" && i + 1 < argc )
+            corpusOptions.passes = std::max( 1, std::stoi( argv[++i] ) );
+        else if ( arg == "-o" && i + 1 < argc )
+            corpusOptions.resultsFilename = argv[++i];
+        else if ( arg == "-b" && i + 1 < argc )
+            corpusOptions.baselineFilename = argv[++i];
+        else if ( arg == "-t" && i + 1 < argc )
+            corpusOptions.threshold = std::stod( argv[++i] );
+        else if ( arg == "-a" && i + 1 < argc )
+            regionSize = std::stoul( argv[++i] ) * 1024;
+        else if ( arg == "-p" && i + 1 < argc )
+            minimumPSNR = std::stod( argv[++i] );
+        else if ( arg == "-s" && i + 1 < argc )
+            tensorSize = std::max( 1, std::stoi( argv[++i] ) );
+        else if ( i == 1 )
+            mode = arg;
+        else if ( corpusModes.count( mode ) > 0 && corpusOptions.directory.empty() )
+            corpusOptions.directory = arg;
+        else
+        {
+            std::cout << "Incorrect usage, use -h to view help" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ( mode == "stages" )
+    {
+        kpeg::bench::runStageBenchmarks( repetitions );
+        return EXIT_SUCCESS;
+    }
+
+    auto corpusMode = corpusModes.find( mode );
+
+    if ( corpusMode != corpusModes.end() && !corpusOptions.directory.empty() )
+        return corpusMode->second() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    std::cout << "Incorrect usage, use -h to view help" << std::endl;
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,149 @@
+// Arena module
+//
+// A bump allocator for memory with the lifetime of one decode: allocating
+// is an aligned pointer increment, nothing is freed on its own, and all of
+// it is released at once by reset(). The arena can start from a region of
+// memory supplied by the caller, and takes blocks from the heap once that
+// runs out. On reset, the heap blocks are merged into one block large
+// enough for everything allocated since the previous reset, so that a
+// decoder reusing its arena for similar images stops touching the heap.
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "Types.hpp"
+
+namespace kpeg
+{
+    class Arena
+    {
+        public:
+
+            // The default size of the blocks taken from the heap
+            static const std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        public:
+
+            // Initialize an arena that takes blocks of the specified size
+            // from the heap, as needed
+            explicit Arena(const std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+            // Frees the heap blocks, but not the caller's region
+            ~Arena();
+
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            // Serve allocations from the specified region first, the arena is
+            // reset. The region is not owned by the arena, and must outlive
+            // its use or the next setRegion().
+            // @param region the first byte of the region, nullptr for none
+            // @param size the number of bytes in the region
+            void setRegion(void* region, const std::size_t size);
+
+            // Allocate memory, which stays valid until the arena is reset
+            // @param size the number of bytes to allocate
+            // @param alignment the alignment of the memory, a power of two
+            void* allocate(const std::size_t size,
+                           const std::size_t alignment = alignof(std::max_align_t));
+
+            // Release everything allocated from the arena at once
+            void reset();
+
+            // The number of bytes allocated since the last reset, padding included
+            std::size_t getUsedSize() const;
+
+            // The number of bytes the arena can serve before taking another
+            // block from the heap
+            std::size_t getCapacity() const;
+
+        private:
+
+            struct Block
+            {
+                UInt8* data;
+                std::size_t size;
+
+                // Whether the block was taken from the heap, & not the caller's region
+                bool isOwned;
+            };
+
+            // The region first (if any), then the heap blocks
+            std::vector<Block> m_blocks;
+
+            // The block being allocated from & the offset of its free space
+            std::size_t m_current;
+            std::size_t m_offset;
+
+            std::size_t m_usedSize;
+            std::size_t m_blockSize;
+    };
+
+    // An allocator for standard containers that takes its memory from an
+    // arena, deallocation does nothing
+    template<typename T>
+    class ArenaAllocator
+    {
+        public:
+
+            typedef T value_type;
+
+            ArenaAllocator(Arena& arena) :
+                m_arena{&arena}
+            {
+            }
+
+            template<typename U>
+            ArenaAllocator(const ArenaAllocator<U>& other) :
+                m_arena{other.getArena()}
+            {
+            }
+
+            T* allocate(const std::size_t count)
+            {
+                return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T*, const std::size_t)
+            {
+            }
+
+            Arena* getArena() const
+            {
+                return m_arena;
+            }
+
+        private:
+
+            Arena* m_arena;
+    };
+
+    template<typename T, typename U>
+    bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+    {
+        return a.getArena() == b.getArena();
+    }
+
+    template<typename T, typename U>
+    bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+    {
+        return !(a == b);
+    }
+
+    // A vector whose elements are allocated from an arena
+    template<typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+    // Drop the elements & the memory of a vector allocated from an arena,
+    // which has to be done before the arena is reset
+    template<typename T>
+    void releaseArenaVector(ArenaVector<T>& vector)
+    {
+        ArenaVector<T>(vector.get_allocator()).swap(vector);
+    }
+}
+
+#endif // ARENA_HPP
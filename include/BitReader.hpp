@@ -0,0 +1,139 @@
+// Bit reader module
+//
+// Reads the entropy-coded data of a scan, most significant bit first, from
+// bytes that were already unstuffed (0xFF00 -> 0xFF). Up to 64 bits are
+// buffered, so the reader never allocates and most reads are a shift & a
+// mask. Bits past the end of the data read as 0.
+
+#ifndef BIT_READER_HPP
+#define BIT_READER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Types.hpp"
+
+namespace kpeg
+{
+    class BitReader
+    {
+        public:
+
+            // The most bits that can be peeked or read at once
+            static const int MAX_BITS = 32;
+
+        public:
+
+            // Default constructor, reads no data
+            BitReader() :
+                m_data{nullptr},
+                m_size{0},
+                m_nextByte{0},
+                m_buffer{0},
+                m_bitCount{0}
+            {
+            }
+
+            // Start reading the specified bytes from their first bit
+            //
+            // The data is not copied and must stay valid while it's read
+            void setData(const UInt8* data, const std::size_t size)
+            {
+                m_data = data;
+                m_size = size;
+                m_nextByte = 0;
+                m_buffer = 0;
+                m_bitCount = 0;
+            }
+
+            // Get the next count bits as an unsigned value, without consuming them
+            // @param count the number of bits, from 1 to MAX_BITS
+            std::uint32_t peekBits(const int count)
+            {
+                if (m_bitCount < count)
+                    fill();
+
+                return std::uint32_t(m_buffer >> (m_bitCount - count)) & std::uint32_t((std::uint64_t(1) << count) - 1);
+            }
+
+            // Consume the next count bits, which must have been peeked
+            void skipBits(const int count)
+            {
+                m_bitCount -= count;
+            }
+
+            // Read the next count bits as an unsigned value
+            // @param count the number of bits, from 0 to MAX_BITS
+            std::uint32_t readBits(const int count)
+            {
+                if (count == 0)
+                    return 0;
+
+                std::uint32_t value = peekBits(count);
+                skipBits(count);
+                return value;
+            }
+
+            // Skip to the next byte boundary, e.g., at the end of a restart interval
+            void alignToByte()
+            {
+                // The buffer always ends at a byte boundary
+                m_bitCount -= m_bitCount % 8;
+            }
+
+            // The index of the next bit to be read
+            std::size_t getBitPosition() const
+            {
+                return m_nextByte * 8 - m_bitCount;
+            }
+
+            // Resume reading at the specified bit of the data, e.g., one
+            // returned by getBitPosition() earlier
+            void setBitPosition(const std::size_t position)
+            {
+                m_nextByte = position / 8;
+                m_buffer = 0;
+                m_bitCount = 0;
+
+                if (position % 8 != 0)
+                {
+                    fill();
+                    skipBits(position % 8);
+                }
+            }
+
+            // Whether every bit of the data has been read
+            bool isAtEnd() const
+            {
+                return getBitPosition() >= m_size * 8;
+            }
+
+        private:
+
+            // Load whole bytes until the buffer holds more than 56 bits
+            void fill()
+            {
+                while (m_bitCount <= 56)
+                {
+                    UInt8 byte = m_nextByte < m_size ? m_data[m_nextByte] : 0;
+                    m_buffer = (m_buffer << 8) | byte;
+                    m_nextByte++;
+                    m_bitCount += 8;
+                }
+            }
+
+        private:
+
+            const UInt8* m_data;
+            std::size_t m_size;
+
+            // The index of the next byte to load into the buffer
+            std::size_t m_nextByte;
+
+            // The loaded bits that are yet to be read, in the low m_bitCount bits
+            std::uint64_t m_buffer;
+            int m_bitCount;
+    };
+}
+
+#endif // BIT_READER_HPP
@@ -0,0 +1,83 @@
+// Buffer pool module
+//
+// A thread-safe pool of pixel buffers for decoded images, so that decoding
+// many images of similar sizes reuses the same few buffers instead of
+// allocating new ones. Buffers are grouped by resolution class (the size
+// rounded up to CLASS_SIZE pixels in each direction) and reserved for the
+// largest image of their class, so any image of the class fits a buffer
+// without reallocating it. A buffer returns to the pool when the last
+// image that shares it lets go of it, even if that outlives the pool.
+
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Types.hpp"
+
+namespace kpeg
+{
+    class BufferPool
+    {
+        public:
+
+            // The granularity of the resolution classes, in pixels
+            static const std::size_t CLASS_SIZE = 256;
+
+        public:
+
+            // Initialize an empty pool
+            // @param maxFreeBuffers the most unused buffers kept per resolution
+            //        class, the others are freed when they're returned
+            explicit BufferPool(const std::size_t maxFreeBuffers = 4);
+
+            // Get a buffer of the specified size, pooled or new
+            //
+            // The pixels of a pooled buffer are left as they were, and are
+            // expected to be overwritten
+            // @param width, height the size of the image, in pixels
+            PixelPtr acquire(const std::size_t width, const std::size_t height);
+
+            // The number of buffers created by the pool so far
+            std::size_t getCreatedCount() const;
+
+            // The number of unused buffers held by the pool
+            std::size_t getFreeCount() const;
+
+        private:
+
+            typedef std::vector<std::vector<Pixel>> PixelArray;
+            typedef std::pair<std::size_t, std::size_t> ResolutionClass;
+
+            // The state shared with the buffers that are handed out, so
+            // that they can return to the pool
+            struct State
+            {
+                mutable std::mutex mutex;
+                std::map<ResolutionClass, std::vector<std::unique_ptr<PixelArray>>> freeBuffers;
+                std::size_t maxFreeBuffers;
+                std::size_t createdCount;
+            };
+
+            // Return a buffer to the pool, or free it if the pool is gone or full
+            static void release(const std::weak_ptr<State>& state, const ResolutionClass resolution, PixelArray* pixels);
+
+        private:
+
+            std::shared_ptr<State> m_state;
+    };
+
+    // Resize a pixel buffer to an image size, reusing the memory of its rows
+    // @param pixels the buffer, as rows of pixels
+    // @param width, height the size of the image, in pixels
+    // @param rowCapacity the width to reserve for the rows that are added
+    void resizePixelBuffer(std::vector<std::vector<Pixel>>& pixels,
+                           const std::size_t width, const std::size_t height,
+                           const std::size_t rowCapacity);
+}
+
+#endif // BUFFER_POOL_HPP
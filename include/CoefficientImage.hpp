@@ -0,0 +1,110 @@
+// Coefficient image module
+//
+// The quantized DCT coefficients of a decoded image, kept so that the image
+// can be rendered any number of times, at several scales or windows (e.g.,
+// the sizes an image CDN serves), with a single entropy decode: Huffman
+// decoding is the serial part of decoding, and only the IDCT & the colour
+// conversion are repeated by each rendering.
+//
+// Most coefficients of a block are zero past the first few in zig-zag order,
+// so each block keeps its coefficients up to its last non-zero one only,
+// with their count. Rendering at 1/2, 1/4 or 1/8 scale uses a reduced IDCT
+// of the lowest frequencies of each block (the DC coefficient only, at 1/8),
+// while rendering at full scale reconstructs the pixels the decoder would.
+//
+// An image is only read while rendering, so several threads can render it
+// at once (with logging off, as the log isn't synchronized).
+
+#ifndef COEFFICIENT_IMAGE_HPP
+#define COEFFICIENT_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Types.hpp"
+#include "Decoder.hpp"
+#include "Image.hpp"
+#include "Transform.hpp"
+
+namespace kpeg
+{
+    class CoefficientImage
+    {
+        public:
+
+            // Default constructor, an empty image
+            CoefficientImage();
+
+            // Decode the coefficients of the image opened by a decoder,
+            // replacing those held, see Decoder::decodeCoefficients()
+            //
+            // The decoder's block callback is used, and cleared afterwards.
+            // @param decoder a decoder with the image opened
+            // @return the result of the decode, DECODE_DONE on success
+            Decoder::ResultCode decode(Decoder& decoder);
+
+            // Select the IDCT implementation of full scale renderings, see
+            // IDCTMode, the reduced IDCTs are always in floating point
+            void setIDCTMode(const IDCTMode mode);
+
+            // Render the image, or a window of it, at a scale
+            //
+            // The window is in the pixels of the full image, and the rendered
+            // image holds every scaled pixel that overlaps it.
+            // @param image receives the rendering
+            // @param scale the denominator of the scale: 1, 2, 4 or 8
+            // @param x, y the top-left corner of the window, in pixels
+            // @param width, height the size of the window, in pixels, 0 for
+            //        the rest of the image
+            // @return false if the image is empty, the scale isn't supported
+            //         or the window is outside the image
+            bool render(Image& image, const int scale = 1,
+                        const std::size_t x = 0, const std::size_t y = 0,
+                        const std::size_t width = 0, const std::size_t height = 0) const;
+
+            // Whether coefficients were decoded, see decode()
+            bool isEmpty() const;
+
+            // The number of bytes taken by the coefficients & their counts
+            std::size_t getMemorySize() const;
+
+        public:
+
+            // Size of the full image, in pixels
+            std::size_t width;
+            std::size_t height;
+
+        private:
+
+            // Dequantize the coefficients kept for a block, in raster order
+            // @param zigZag, count the coefficients kept
+            // @param coeffs receives the 64 coefficients
+            void dequantizeBlock(const int compID, const Int16* zigZag, const int count, int* coeffs) const;
+
+        private:
+
+            std::size_t m_blocksPerLine;
+
+            // For each component: the number of coefficients kept (0 to 64)
+            // for each block in raster order, & the index of the first one
+            // of each row of blocks, the blocks of a row follow each other
+            std::vector<UInt8> m_counts[3];
+            std::vector<std::uint32_t> m_rowOffsets[3];
+
+            // The coefficients kept, in zig-zag order, block after block
+            std::vector<Int16> m_coefficients[3];
+
+            // The quantization tables of the luminance & of the chrominance,
+            // in zig-zag order, as the MCUs take them
+            std::vector<std::vector<UInt16>> m_QTables;
+
+            // The same with the scale factors of the IDCT in use folded in,
+            // which the MCUs of full scale renderings are de-quantized with
+            std::vector<std::vector<UInt16>> m_dequantizationTables;
+
+            IDCTMode m_IDCTMode;
+    };
+}
+
+#endif // COEFFICIENT_IMAGE_HPP
@@ -1,123 +1,752 @@
-// A simple abstraction for the decoder of a JPEG decoder
-// Decoder module is the implementation of a 8-bit Sequential
-// Baseline DCT, grayscale/RGB encoder with no subsampling 
-
-#ifndef DECODER_HPP
-#define DECODER_HPP
-
-#include <fstream>
-#include <vector>
-#include <utility>
-#include <bitset>
-
-#include "Types.hpp"
-#include "Image.hpp"
-#include "HuffmanTree.hpp"
-#include "MCU.hpp"
-
-namespace kpeg
-{
-    class Decoder
-    {
-        public:
-
-            // The result of a decode operation
-            enum ResultCode
-            {
-                SUCCESS,
-                TERMINATE,
-                ERROR,
-                DECODE_INCOMPLETE,
-                DECODE_DONE
-            };
-            
-        public:
-            
-            // Default constructor
-            Decoder();
-            
-            // Initialize decoder with info about image file
-            Decoder(const std::string& filename);
-            
-            // Destructor
-            ~Decoder();
-            
-            // Open a JFIF image file for decoding
-            bool open(const std::string& filename);
-            
-            // Decode the image in the JFIF file
-            ResultCode decodeImageFile();
-
-            // Write raw, uncompressed image data to disk in PPM format
-            bool dumpRawData();
-
-            // Close the JFIF file
-            void close();
-                        
-        private:
-
-            // Parse the info of the specified segment in the JFIF file
-            ResultCode parseSegmentInfo(const UInt8 byte);
-            
-            // Parse the JFIF segment at the very beginning of the JFIF file
-            void parseAPP0Segment();
-
-            // Parse the comment in the JFIF file
-            void parseCOMSegment();
-            
-            // Parse the quantization tables specified in the JFIF file
-            void parseDQTSegment();
-            
-            // Parse the Start of File segment
-            ResultCode parseSOF0Segment();
-            
-            // Parse the Huffman tables specified in the JFIF file
-            void parseDHTSegment();
-            
-            // Parse the start of scan segment in the JFIF file
-            void parseSOSSegment();
-            
-            // Parse the actual compressed image data stored in the JFIF file
-            void scanImageData();
-            
-            // Convert bytes of the form XXFF00YY to just XXFFYY
-            void byteStuffScanData();
-            
-            // Decode the RLE-Huffman encoded image pixel data
-            //
-            // This function goes bit by bit over the image scan data
-            // and decodes it using the provided DC and AC Huffman tables
-            // for luminance (Y) and chrominance (Cb & Cr)
-            void decodeScanData();
-            
-        private:
-            
-            // void displayHuffmanCodes();
-            
-        private:
-            
-            std::string m_filename;
-            
-            std::ifstream m_imageFile;
-            
-            Image m_image;
-            
-            std::vector<std::vector<UInt16>> m_QTables;
-            
-            // For i=0..3:
-            //    HT_i is array of size=16, where j-th element is < count-j-bits, symbol-list >
-            //
-            HuffmanTable m_huffmanTable[2][2];
-            
-            // std::vector< std::pair<int, int> > mDHTsScanned;
-            
-            HuffmanTree m_huffmanTree[2][2];
-            
-            // Image scan data
-            std::string m_scanData;
-            
-            std::vector<MCU> m_MCU;
-    };
-}
-
-#endif // DECODER_HPP
+// A simple abstraction for the decoder of a JPEG decoder
+// Decoder module is the implementation of a 8-bit Sequential
+// Baseline & Progressive DCT, grayscale/RGB encoder with no subsampling 
+
+#ifndef DECODER_HPP
+#define DECODER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <array>
+#include <utility>
+#include <bitset>
+#include <functional>
+
+#include "Types.hpp"
+#include "Image.hpp"
+#include "Arena.hpp"
+#include "BitReader.hpp"
+#include "BufferPool.hpp"
+#include "HuffmanCache.hpp"
+#include "MCU.hpp"
+#include "ScanIndex.hpp"
+#include "Tensor.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    class LazyImage;
+    
+    // The kind of thumbnail embedded in a JFIF file
+    enum class ThumbnailType
+    {
+        NONE,
+        
+        // Uncompressed RGB, in the JFIF APP0 segment or a JFXX extension
+        JFIF_RGB,
+        
+        // A JPEG image, in a JFXX extension
+        JFIF_JPEG,
+        
+        // A JPEG image, in the second IFD of the EXIF APP1 segment
+        EXIF_JPEG
+    };
+    
+    // Why a JFIF file failed validation, see Decoder::validateImageFile()
+    enum class ValidationError
+    {
+        NONE,
+        
+        // The image could not be read, e.g., it wasn't opened
+        UNREADABLE,
+        
+        // The data doesn't start with the Start of Image marker
+        MISSING_SOI,
+        
+        // A byte other than a marker where a marker was expected
+        INVALID_MARKER,
+        
+        // A segment runs past the end of the data
+        TRUNCATED_SEGMENT,
+        
+        // A segment's contents are invalid, or don't match its length
+        INVALID_SEGMENT,
+        
+        // A valid feature the decoder doesn't support (e.g., chroma
+        // subsampling, arithmetic coding or 16-bit quantization tables)
+        UNSUPPORTED,
+        
+        // A scan precedes the frame
+        MISSING_FRAME,
+        
+        // A scan needs a quantization table that wasn't defined
+        MISSING_TABLE,
+        
+        // The image ends without a scan
+        MISSING_SCAN,
+        
+        // The scan data holds a code that's in none of its Huffman tables
+        INVALID_HUFFMAN_CODE,
+        
+        // A code runs past the coefficients of its block (or band), or its
+        // coefficient is larger than 8-bit samples allow
+        INVALID_COEFFICIENT,
+        
+        // The scan data ends before its last block
+        TRUNCATED_SCAN,
+        
+        // A restart marker is missing, extra, out of sequence, or doesn't
+        // end the data of its restart interval
+        INVALID_RESTART_MARKER,
+        
+        // Bytes of scan data follow the last block of a scan or interval
+        EXTRANEOUS_SCAN_DATA,
+        
+        // The data ends without the End of Image marker
+        MISSING_EOI,
+        
+        // Bytes follow the End of Image marker
+        TRAILING_DATA,
+        
+        // Validation was cancelled, or its deadline passed, before an error
+        // was found, see Decoder::setCancellationToken()
+        CANCELLED
+    };
+    
+    // The outcome of validating a JFIF file
+    struct ValidationResult
+    {
+        // The first error found, NONE if the file is valid
+        ValidationError error;
+        
+        // The offset in the JFIF data of the byte the error was found at:
+        // the marker of an invalid segment, the byte holding the first bit
+        // of an invalid code, or the end of truncated data
+        std::size_t offset;
+    };
+    
+    // Get the name of a validation error, e.g., "TRUNCATED_SCAN"
+    const char* getValidationErrorName(const ValidationError error);
+    
+    // A flag that stops the decodes watching it, see
+    // Decoder::setCancellationToken(), which may be set from any thread
+    // (e.g., when the client that requested a decode disconnects)
+    class CancellationToken
+    {
+        public:
+            
+            // Default constructor, not cancelled
+            CancellationToken() :
+                m_isCancelled{false}
+            {
+            }
+            
+            // Stop the decodes watching the token, at their next MCU row
+            void cancel()
+            {
+                m_isCancelled.store(true, std::memory_order_relaxed);
+            }
+            
+            bool isCancelled() const
+            {
+                return m_isCancelled.load(std::memory_order_relaxed);
+            }
+            
+        private:
+            
+            std::atomic<bool> m_isCancelled;
+    };
+    
+    class Decoder
+    {
+        public:
+
+            // The result of a decode operation
+            enum ResultCode
+            {
+                SUCCESS,
+                TERMINATE,
+                ERROR,
+                DECODE_INCOMPLETE,
+                DECODE_DONE,
+                
+                // The decode was cancelled, or its deadline passed, see
+                // setCancellationToken() & setDeadline()
+                CANCELLED
+            };
+            
+            // Callback invoked with a rendered preview of a progressive image
+            // after each of its scans has been decoded. Returning false from the
+            // callback stops decoding, leaving the last preview as the image.
+            //
+            // @param preview the image rendered from the coefficients decoded so far
+            // @param scanNumber the number of scans decoded so far, starting from 1
+            typedef std::function<bool(const Image& preview, const int scanNumber)> ScanCallback;
+            
+            // Callback invoked with each block of quantized DCT coefficients
+            // by decodeCoefficients(). Returning false from the callback stops
+            // decoding.
+            //
+            // @param component the index of the component, in SOF order
+            // @param blockIndex the index of the block, in raster order over
+            //        the blocks of the frame (see getBlocksPerLine())
+            // @param coefficients the 64 coefficients, in the requested order
+            typedef std::function<bool(const int component, const std::size_t blockIndex,
+                                       const Int16* coefficients)> BlockCallback;
+            
+        public:
+            
+            // Default constructor
+            Decoder();
+            
+            // Initialize decoder with info about image file
+            Decoder(const std::string& filename);
+            
+            // Destructor
+            ~Decoder();
+            
+            // Open a JFIF image file for decoding
+            //
+            // The decoder may be reused: opening another file discards the
+            // state of the previous image & releases its data, but keeps the
+            // decoder's memory (see setArenaRegion()) and the tables it
+            // defined, for abbreviated streams that rely on them. Call
+            // reset() first for an unrelated image.
+            bool open(const std::string& filename);
+            
+            // Open JFIF image data held in memory for decoding
+            //
+            // The data is not copied and must stay valid until the decoder
+            // is closed or opens another image
+            // @param data the first byte of the JFIF data
+            // @param size the number of bytes of JFIF data
+            bool open(const UInt8* data, const std::size_t size);
+            
+            // Supply the memory for the data the decoder keeps for one image
+            // (e.g., the file data, the scan data, the coefficients & the MCUs)
+            //
+            // That data is allocated from the decoder's arena, and released
+            // at once when the next image is opened. The arena takes memory
+            // from the region first, and from the heap once it runs out. The
+            // region must outlive the decoder, or the next setArenaRegion().
+            // This has to be set before the image is opened.
+            //
+            // @param region the first byte of the region, nullptr for none
+            // @param size the number of bytes in the region
+            void setArenaRegion(void* region, const std::size_t size);
+            
+            // Return the decoder to the state of a new one, so it can decode
+            // an unrelated image: the image's state, the crop window, the
+            // comment & the quantization tables are discarded, and the standard
+            // Huffman tables are restored. The settings (IDCT mode, callback,
+            // arena region & buffer pool) are kept, as is the memory of the
+            // arena & the image, so that decoding many images of the same size
+            // in a loop doesn't reallocate.
+            void reset();
+            
+            // Take the pixel buffers of the decoded images from a pool, e.g.,
+            // one shared by several decoders, nullptr to stop
+            //
+            // Without a pool, the decoder reuses the buffer of its image when
+            // nothing else shares it, and allocates a new one otherwise.
+            void setBufferPool(const std::shared_ptr<BufferPool>& pool);
+            
+            // Restrict decoding to a rectangular window of the image, this
+            // has to be set after the image is opened
+            //
+            // Blocks outside the window are still entropy decoded, to keep the
+            // DC predictors and the bit position in the scan correct, but they
+            // are never dequantized, transformed or stored. The decoded image
+            // is sized to the window only.
+            //
+            // @param x, y the top-left corner of the window, in pixels
+            // @param width, height the size of the window, in pixels
+            void setCropRegion(const std::size_t x, const std::size_t y,
+                               const std::size_t width, const std::size_t height);
+            
+            // Start decoding the scan of a baseline image at the checkpoint of
+            // the index above the crop region, instead of at its first bit,
+            // this has to be set after the image is opened, see ScanIndex
+            //
+            // An index built for another image is ignored. The index is not
+            // copied and must stay valid until the image is decoded.
+            // @param index the index of the image, nullptr for none
+            void setScanIndex(const ScanIndex* index);
+            
+            // Set the callback that receives a preview of a progressive
+            // image after each scan, see ScanCallback
+            void setScanCallback(const ScanCallback& callback);
+            
+            // Write the decoded image to a tensor instead of the image, see
+            // TensorOptions, this has to be set after the image is opened
+            //
+            // The tensor is written straight from the reconstructed blocks,
+            // and getImage() (or the preview of a progressive image) is left
+            // as it was.
+            //
+            // @param output the tensor, getTensorSize() bytes for the size of
+            //        the image (or of the crop window), nullptr to stop
+            // @param options the layout of the tensor
+            void setTensorOutput(void* output, const TensorOptions& options = TensorOptions());
+            
+            // Select the IDCT implementation, see IDCTMode: the float
+            // reference (the default), or one of the faster integer ones
+            void setIDCTMode(const IDCTMode mode);
+            
+            // Apply the EXIF orientation of the images as their pixels are
+            // placed, so that the decoded images (and the previews of
+            // progressive images) are upright, see getOrientation()
+            //
+            // A crop window is still in the coordinates of the frame. The
+            // orientation doesn't apply to tensor output.
+            void setApplyOrientation(const bool isApplying);
+            
+            // Refuse frames of more pixels than a limit, before anything is
+            // allocated for them, e.g., for untrusted images whose frame
+            // header could claim up to 65535x65535 pixels
+            //
+            // A frame over the limit ends the decode with TERMINATE.
+            // @param count the most pixels of a frame, unlimited by default
+            void setMaxPixels(const std::size_t count);
+            
+            // Stop decoding once a token is cancelled, checked before each
+            // segment & each MCU row of a scan (or of the rendering of a
+            // progressive image), nullptr for none
+            //
+            // A cancelled decode returns CANCELLED, and closes the image and
+            // releases its data as resetImageState() does, so the decoder is
+            // ready for the next image. The token is not copied and must stay
+            // valid while it's set.
+            void setCancellationToken(const CancellationToken* token);
+            
+            // Stop decoding once a point in time passes, checked as the
+            // cancellation token is, see setCancellationToken()
+            // @param deadline the point in time, time_point::max() for none
+            void setDeadline(const std::chrono::steady_clock::time_point& deadline);
+            
+            // Get the EXIF orientation of the image, NORMAL if it has none,
+            // once the image is decoded (or its thumbnail located)
+            Orientation getOrientation() const;
+            
+            // Decode the image in the JFIF file
+            ResultCode decodeImageFile();
+            
+            // Decode the quantized DCT coefficients of the image in the JFIF
+            // file, without reconstructing any pixels (no dequantization,
+            // IDCT or colour conversion) and ignoring the crop region
+            //
+            // With a block callback (see setBlockCallback()), the blocks of a
+            // baseline image are handed out as they're decoded and never
+            // stored, while those of a progressive image are handed out after
+            // its last scan. Otherwise they're kept for getCoefficients().
+            //
+            // @param order the order of the coefficients of each block
+            ResultCode decodeCoefficients(const CoefficientOrder order = CoefficientOrder::ZIGZAG);
+            
+            // Index the scan of the baseline image in the JFIF file, with one
+            // decoding pass that reconstructs no pixels, see ScanIndex
+            // @param index receives the index
+            // @param rowInterval the number of MCU rows between checkpoints
+            ResultCode buildScanIndex(ScanIndex& index, const std::size_t rowInterval = 1);
+            
+            // Check that the JFIF file would decode, without decoding it
+            //
+            // Every segment is parsed & checked against its length, and the
+            // scans are entropy decoded to their end, checking their codes,
+            // the coefficients of each block, the restart markers & the end
+            // of their data, but nothing is dequantized, transformed or
+            // colour converted, and no image is created. The End of Image
+            // marker must end the data. The crop region, the scan callback
+            // & the block callback are ignored.
+            // @return the first error found, with its offset in the JFIF data
+            ValidationResult validateImageFile();
+            
+            // Decode the image in the JFIF file into an image whose pixels are
+            // reconstructed as they're read, see LazyImage
+            //
+            // The scan is entropy decoded once, to place the checkpoints of
+            // the MCU rows, and is kept by the image, which doesn't need the
+            // decoder afterwards. Only baseline images can be decoded lazily,
+            // and the crop region & the orientation are ignored.
+            // @param image receives the image, its cache bound is kept
+            ResultCode decodeLazyImage(LazyImage& image);
+            
+            // Set the callback that receives the blocks decoded by
+            // decodeCoefficients(), see BlockCallback
+            void setBlockCallback(const BlockCallback& callback);
+            
+            // Get the coefficients decoded by decodeCoefficients() for one
+            // component, 64 per block, laid out as the blocks of the frame
+            // @return the first coefficient, nullptr if they weren't kept
+            const Int16* getCoefficients(const int component) const;
+            
+            // The size of the frame being decoded, in pixels
+            std::size_t getFrameWidth() const;
+            std::size_t getFrameHeight() const;
+            
+            // The number of MCUs between restart markers, 0 if the image has none
+            std::size_t getRestartInterval() const;
+            
+            // The number of blocks in each row & column of a component
+            std::size_t getBlocksPerLine() const;
+            std::size_t getBlockRows() const;
+            
+            // Get the quantization table of a component, as defined by the
+            // image, all zeros if it's not defined
+            // @param component the index of the component, in SOF order
+            // @param order the order of the table's entries
+            std::array<UInt16, 64> getQuantizationTable(const int component,
+                                                        const CoefficientOrder order = CoefficientOrder::ZIGZAG) const;
+
+            // Locate the thumbnail embedded in the image opened, parsing only
+            // the segments that precede the frame, so that the scan of the
+            // image is never read
+            //
+            // The image can still be decoded afterwards, which also locates
+            // the thumbnail. When the image has several, the first one is kept.
+            // @return the type of the thumbnail, NONE if the image has none
+            ThumbnailType findThumbnail();
+            
+            // Get the type of the thumbnail located, see findThumbnail()
+            ThumbnailType getThumbnailType() const;
+            
+            // Get the JFIF data of a JPEG thumbnail, which lies within the
+            // data of the image, e.g., to serve it without decoding it
+            // @param size receives the number of bytes of the thumbnail
+            // @return the first byte of the thumbnail, nullptr if it isn't a
+            //         JPEG image or the image is closed
+            const UInt8* getThumbnailData(std::size_t& size) const;
+            
+            // Decode the thumbnail located, a JPEG thumbnail with a decoder
+            // of its own, this has to be done before the image is closed
+            // @param thumbnail receives the thumbnail
+            // @return false if there's no thumbnail, or it could not be decoded
+            bool decodeThumbnail(Image& thumbnail) const;
+            
+            // Get the decoded image
+            const Image& getImage() const;
+            
+            // Write raw, uncompressed image data to disk in PPM format
+            bool dumpRawData();
+            
+            // Write raw, uncompressed image data to the specified file in PPM format
+            bool dumpRawData(const std::string& filename);
+
+            // Close the JFIF file
+            void close();
+                        
+        private:
+
+            // Discard the state of the previous image & release its memory
+            void resetImageState();
+            
+            // Whether the cancellation token was cancelled or the deadline
+            // passed, which holds until the next decode once it's found
+            bool isDecodeCancelled();
+            
+            // Parse the info of the specified segment in the JFIF file
+            ResultCode parseSegmentInfo(const UInt8 byte);
+            
+            // Parse the JFIF segment at the very beginning of the JFIF file,
+            // or a JFXX extension segment, locating their thumbnail
+            void parseAPP0Segment();
+            
+            // Parse the EXIF segment, locating its thumbnail
+            void parseAPP1Segment();
+            
+            // Keep the location of a thumbnail, unless one was located before
+            // @param offset, size the location of its data in the JFIF data
+            // @param width, height its size in pixels, if it's uncompressed
+            void locateThumbnail(const ThumbnailType type, const std::size_t offset, const std::size_t size,
+                                 const std::size_t width, const std::size_t height);
+            
+            // Skip a segment the decoder has no use for, e.g., an application
+            // segment, by its length
+            void skipSegment();
+
+            // Parse the comment in the JFIF file
+            void parseCOMSegment();
+            
+            // Parse the quantization tables specified in the JFIF file
+            void parseDQTSegment();
+            
+            // Parse the Start of File segment
+            ResultCode parseSOF0Segment();
+            
+            // Parse the Start of File segment of a progressive image
+            // and allocate its coefficient buffer
+            ResultCode parseSOF2Segment();
+            
+            // Parse the Huffman tables specified in the JFIF file
+            // @return ERROR if a table is invalid or the data ends within it,
+            //         in which case it isn't cached nor used
+            ResultCode parseDHTSegment();
+            
+            // Parse the restart interval of the scans
+            void parseDRISegment();
+            
+            // Parse the start of scan segment in the JFIF file
+            ResultCode parseSOSSegment();
+            
+            // Parse the actual compressed image data stored in the JFIF file,
+            // converting bytes of the form XXFF00YY to just XXFFYY
+            void scanImageData();
+            
+            // Decode the RLE-Huffman encoded image pixel data
+            //
+            // This function goes over the image scan data and decodes
+            // it using the provided DC and AC Huffman tables for
+            // luminance (Y) and chrominance (Cb & Cr). Once the decoder's
+            // buffers have grown to the size of the image, it allocates
+            // nothing per MCU.
+            //
+            // @return false if the scan data is empty or holds an invalid
+            //         Huffman code, or if the decode was cancelled, in which
+            //         case only some of the MCUs are decoded
+            bool decodeScanData();
+            
+            // Decode one scan of a progressive image into the coefficient buffer
+            //
+            // Depending on the scan parameters, the scan either carries the first
+            // bits or a refinement bit of the DC coefficients (spectral selection
+            // 0..0), or of a band of AC coefficients of a single component.
+            void decodeProgressiveScan();
+            
+            // Decode the first bits of the DC coefficient of a block (progressive)
+            void decodeDCFirst(Int16* coeffs, const HuffmanLookupTable& htable, const int compIndex);
+            
+            // Decode the refinement bit of the DC coefficient of a block (progressive)
+            void decodeDCRefine(Int16* coeffs);
+            
+            // Decode the first bits of a band of AC coefficients of a block (progressive)
+            void decodeACFirst(Int16* coeffs, const HuffmanLookupTable& htable);
+            
+            // Decode the refinement bits of a band of AC coefficients of a block (progressive)
+            void decodeACRefine(Int16* coeffs, const HuffmanLookupTable& htable);
+            
+            // Decode the Huffman code at the next bit of the scan data
+            // @return the symbol, or -1 if no valid code is found
+            int decodeHuffmanSymbol(const HuffmanLookupTable& htable);
+            
+            // Read the next count bits of the scan data as an unsigned value
+            int readBits(const int count);
+            
+            // Read the next category bits of the scan data as a signed coefficient value
+            int receiveExtend(const int category);
+            
+            // Decode the scan of a baseline image into blocks of quantized
+            // coefficients, see decodeCoefficients()
+            // @return false if decoding was stopped by the block callback
+            bool decodeScanCoefficients();
+            
+            // Decode the Huffman codes of one block of a baseline scan
+            // @param coeffs receives the 64 coefficients, in zig-zag order
+            // @return false if an invalid code was found
+            bool decodeBlockCoefficients(Int16* coeffs, const int compIndex);
+            
+            // Entropy decode the scan of a baseline image, recording a
+            // checkpoint every index.rowInterval MCU rows
+            // @return false if an invalid Huffman code was found
+            bool indexScanData(ScanIndex& index);
+            
+            // Entropy decode the scan of a baseline image without keeping
+            // anything, checking it for validateImageFile()
+            // @return false if the scan is invalid
+            bool validateScanData();
+            
+            // Check the Huffman codes of one block of a baseline scan
+            // @return false if a code or a coefficient is invalid
+            bool validateBlock(const int compIndex);
+            
+            // Check the restart marker that ends a restart interval of the
+            // scan being validated, & skip to the next interval
+            // @param interval the number of intervals before the marker
+            // @return false if the marker isn't where the interval ends
+            bool validateRestartMarker(const std::size_t interval);
+            
+            // Check that the scan being validated ends with its last block
+            // @param unitCount the number of MCUs (or blocks) of the scan
+            // @return false if its data is truncated or has bytes to spare
+            bool validateScanEnd(const std::size_t unitCount);
+            
+            // Check the parameters of the scan being parsed, & that the frame
+            // & the tables it uses were defined, for validateImageFile()
+            // @param length the length of the SOS segment
+            // @return false if the scan can't be decoded
+            bool validateScanHeader(const UInt16 length);
+            
+            // Keep the first error found by validateImageFile()
+            // @param offset the offset of the error in the JFIF data
+            void reportValidationError(const ValidationError error, const std::size_t offset);
+            
+            // Report an invalid Huffman code at the next bit of the scan, or
+            // the end of the scan data if every bit was read
+            void reportInvalidCode();
+            
+            // Get the offset in the JFIF data of a byte of the scan data,
+            // accounting for the stuffed bytes & the restart markers removed
+            std::size_t getScanByteOffset(const std::size_t index) const;
+            
+            // Reorder a block of coefficients as requested & hand it to the block callback
+            // @return false if decoding was stopped by the block callback
+            bool outputBlockCoefficients(const int compIndex, const std::size_t blockIndex, Int16* coeffs);
+            
+            // Reconstruct the image (or the crop region of it) from the
+            // coefficient buffer of a progressive image
+            void renderProgressiveImage();
+            
+            // Create the image (or the tensor) from the decoded MCUs, which
+            // cover the crop region
+            // @return false if too few MCUs were decoded to cover it
+            bool createImageFromMCUs();
+            
+        private:
+            
+            // void displayHuffmanCodes();
+            
+        private:
+            
+            std::string m_filename;
+            
+            // The memory of the data kept for the current image, the
+            // containers below that use it are released before it's reset
+            Arena m_arena;
+            
+            // The JFIF data of the image, when read from a file
+            ArenaVector<char> m_fileData;
+            
+            // Stream over the JFIF data being decoded
+            utils::MemoryBuffer m_imageBuffer;
+            std::istream m_imageStream;
+            
+            Image m_image;
+            
+            std::vector<std::vector<UInt16>> m_QTables;
+            
+            // The quantization tables the MCUs are de-quantized with, for the IDCT in use
+            std::vector<std::vector<UInt16>> m_dequantizationTables;
+            
+            // The decoding tables of the Huffman tables in use, indexed by
+            // [HT_DC/HT_AC][table #], shared through the HuffmanCache
+            HuffmanCache::TablePtr m_huffmanTable[2][2];
+            
+            // Image scan data, unstuffed & without restart markers, and
+            // the reader of its bits
+            ArenaVector<UInt8> m_scanData;
+            BitReader m_bitReader;
+            
+            // The run-length coding of the MCU being decoded, reused by
+            // every MCU of every image, so it's sized once for the largest
+            // block and kept with the decoder instead of the arena
+            std::array<std::vector<int>, 3> m_RLE;
+            
+            // The text of the last comment segment, its buffer is reused
+            std::string m_comment;
+            
+            // The thumbnail located, as the offset & the size of its data in
+            // the JFIF data, and its size in pixels if it's uncompressed
+            ThumbnailType m_thumbnailType;
+            std::size_t m_thumbnailOffset;
+            std::size_t m_thumbnailSize;
+            std::size_t m_thumbnailWidth;
+            std::size_t m_thumbnailHeight;
+            
+            ArenaVector<MCU> m_MCU;
+            
+            // Dimensions of the frame, as specified in the SOF-0 segment
+            std::size_t m_frameWidth;
+            std::size_t m_frameHeight;
+            
+            // The window of the frame to decode, see setCropRegion()
+            bool m_isCropped;
+            std::size_t m_cropX;
+            std::size_t m_cropY;
+            std::size_t m_cropWidth;
+            std::size_t m_cropHeight;
+            
+            // Component IDs, & the quantization tables they select, in the
+            // order listed in the SOF segment
+            UInt8 m_componentIDs[3];
+            UInt8 m_componentQTables[3];
+            
+            // Whether the frame is progressive DCT (SOF-2)
+            bool m_isProgressive;
+            
+            // The quantized DCT coefficients of the whole progressive image, in
+            // zig-zag order, laid out as [component][block][64]. Allocated once
+            // per image as every scan refines the coefficients of all blocks.
+            // Also holds the coefficients kept by decodeCoefficients(), in
+            // the requested order.
+            ArenaVector<Int16> m_coefficients;
+            
+            // Parameters of the current scan: the indices of the components in
+            // the scan and their Huffman tables, the spectral selection & the
+            // successive approximation bit positions
+            int m_scanCompCount;
+            int m_scanComponents[3];
+            int m_scanDCTable[3];
+            int m_scanACTable[3];
+            int m_spectralStart;
+            int m_spectralEnd;
+            int m_approxHigh;
+            int m_approxLow;
+            
+            // The number of MCUs between restart markers, 0 if the image has none
+            std::size_t m_restartInterval;
+            
+            // DC predictors & the remaining end-of-band run of a progressive scan
+            int m_DCPredictor[3];
+            int m_EOBRun;
+            
+            // Number of scans decoded so far
+            int m_scanCount;
+            
+            ScanCallback m_scanCallback;
+            
+            // The state of decodeCoefficients()
+            bool m_isDecodingCoefficients;
+            CoefficientOrder m_coefficientOrder;
+            BlockCallback m_blockCallback;
+            
+            // The state of validateImageFile(): the first error found & the
+            // offset of the segment being parsed
+            bool m_isValidating;
+            ValidationResult m_validationResult;
+            std::size_t m_segmentOffset;
+            
+            // Where the scan data was found in the JFIF data, for validation:
+            // its offset, the scan data index of each byte that follows bytes
+            // removed from it with the number removed so far (a stuffed zero
+            // is 1 byte, a restart marker 2), & the index & the number (0 to
+            // 7) of each restart marker
+            std::size_t m_scanDataOffset;
+            std::vector<std::pair<std::size_t, std::size_t>> m_removedBytes;
+            std::vector<std::pair<std::size_t, int>> m_restartMarkers;
+            
+            // The offset of the End of Image marker, if it was found
+            bool m_isEOIFound;
+            std::size_t m_EOIOffset;
+            
+            // What stops a decode early, see setCancellationToken() &
+            // setDeadline(), & whether it did
+            const CancellationToken* m_cancellationToken;
+            std::chrono::steady_clock::time_point m_deadline;
+            bool m_isCancelled;
+            
+            // The index being built by buildScanIndex() or decodeLazyImage(), if any
+            ScanIndex* m_scanIndexOutput;
+            
+            // The index to start decoding the scan from, see setScanIndex()
+            const ScanIndex* m_scanIndex;
+            
+            IDCTMode m_IDCTMode;
+            
+            // The EXIF orientation of the image, & whether it's applied
+            Orientation m_orientation;
+            bool m_isApplyingOrientation;
+            
+            // The most pixels of a frame, see setMaxPixels()
+            std::size_t m_maxPixels;
+            
+            // The pool of the image's pixel buffers, if any
+            std::shared_ptr<BufferPool> m_bufferPool;
+            
+            // The tensor written instead of the image, see setTensorOutput()
+            void* m_tensorOutput;
+            TensorOptions m_tensorOptions;
+    };
+}
+
+#endif // DECODER_HPP
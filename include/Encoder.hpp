@@ -0,0 +1,254 @@
+// Baseline encoder module
+//
+// A sequential baseline DCT encoder, used to generate JPEG corpora for
+// benchmarks & tests on machines without any: forward DCT, quantization
+// with the Annex K tables scaled to a quality, Huffman coding with the
+// Annex K tables (or with tables optimized for the image, when encoding
+// coefficients) & a JFIF marker writer. The image is read a band of
+// MCU rows at a time from an ImageSource (a PPM file, or a generated
+// pattern), so images of any size are encoded in bounded memory.
+
+#ifndef ENCODER_HPP
+#define ENCODER_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <functional>
+
+#include "Types.hpp"
+
+namespace kpeg
+{
+    // A source of RGB pixels to encode, read from top to bottom
+    class ImageSource
+    {
+        public:
+
+            virtual ~ImageSource() {}
+
+            // Size of the image, in pixels
+            virtual std::size_t getWidth() const = 0;
+            virtual std::size_t getHeight() const = 0;
+
+            // Read the next rows of the image, as interleaved R, G & B bytes
+            // @param rows the buffer to fill, of rowCount * width * 3 bytes
+            // @param rowCount the number of rows to read
+            // @return false if the rows could not be read
+            virtual bool readRows(UInt8* rows, const std::size_t rowCount) = 0;
+    };
+
+    // An image source that reads a binary (P6) PPM file, a row at a time
+    class PPMSource : public ImageSource
+    {
+        public:
+
+            // Open a PPM file & read its header
+            // @param filename the location of the PPM file on the disk
+            PPMSource(const std::string& filename);
+
+            // Whether the file was opened and has a valid 8-bit PPM header
+            bool isValid() const;
+
+            std::size_t getWidth() const override;
+            std::size_t getHeight() const override;
+            bool readRows(UInt8* rows, const std::size_t rowCount) override;
+
+        private:
+
+            std::ifstream m_file;
+            std::size_t m_width;
+            std::size_t m_height;
+            bool m_isValid;
+    };
+
+    // An image source that generates a deterministic test pattern
+    //
+    // The pattern mixes smooth gradients with shapes & noise: the entropy
+    // sets the strength of the noise & the density of the shapes, from 0
+    // (smooth, compresses well) to 100 (noise, compresses poorly). The same
+    // size, entropy & seed always give the same pixels, on any machine.
+    class PatternSource : public ImageSource
+    {
+        public:
+
+            // @param width, height the size of the image, in pixels
+            // @param entropy the amount of detail, from 0 to 100
+            // @param seed the seed of the pseudo-random detail
+            PatternSource(const std::size_t width, const std::size_t height,
+                          const int entropy, const std::uint32_t seed);
+
+            std::size_t getWidth() const override;
+            std::size_t getHeight() const override;
+            bool readRows(UInt8* rows, const std::size_t rowCount) override;
+
+        private:
+
+            // Next value of the pseudo-random generator (xorshift32)
+            std::uint32_t nextRandom();
+
+            // Hash a grid cell to the pseudo-random properties of its shape
+            std::uint32_t hashCell(const std::size_t cellX, const std::size_t cellY) const;
+
+        private:
+
+            std::size_t m_width;
+            std::size_t m_height;
+            int m_entropy;
+            std::uint32_t m_seed;
+            std::uint32_t m_state;
+
+            // The next row to generate
+            std::size_t m_row;
+
+            // Size of the grid cells that hold the shapes, in pixels
+            std::size_t m_cellSize;
+    };
+
+    class Encoder
+    {
+        public:
+
+            // Chroma subsampling of the encoded image
+            enum Sampling
+            {
+                YUV444,     // no subsampling
+                YUV422,     // chroma halved horizontally
+                YUV420      // chroma halved horizontally & vertically
+            };
+
+            // Supplies the quantized DCT coefficients of a block to encode
+            // @param compID the component of the block: 0 (Y), 1 (Cb) or 2 (Cr)
+            // @param blockX, blockY the position of the block in the grid of blocks
+            // @param zzOrder receives the 64 coefficients, in zig-zag order
+            typedef std::function<void(const int compID, const std::size_t blockX, const std::size_t blockY,
+                                       int* zzOrder)> BlockSource;
+
+            // Settings of the encoder
+            struct Settings
+            {
+                // Scales the Annex K quantization tables, from 1 (smallest
+                // file) to 100 (best image), 50 uses the tables unchanged
+                int quality = 75;
+
+                Sampling sampling = YUV444;
+
+                // The number of MCUs between restart markers, 0 for none
+                std::size_t restartInterval = 0;
+
+                // Whether encodeCoefficients() builds optimal Huffman tables
+                // for the image (Annex K.2) instead of using the Annex K ones,
+                // which takes a second pass over the blocks
+                bool optimizeHuffmanTables = false;
+            };
+
+        public:
+
+            // Default constructor, uses the default settings
+            Encoder();
+
+            // Initialize the encoder with the specified settings
+            Encoder(const Settings& settings);
+
+            // Encode an image as a baseline JFIF file
+            // @param source the pixels of the image
+            // @param filename the location of the JFIF file on the disk
+            // @return false if the source could not be read or the file written
+            bool encode(ImageSource& source, const std::string& filename);
+
+            // Encode an image as a baseline JFIF stream
+            // @param source the pixels of the image
+            // @param out the stream that receives the JFIF data
+            // @return false if the source could not be read or the stream written
+            bool encode(ImageSource& source, std::ostream& out);
+
+            // Entropy code blocks of quantized DCT coefficients as a baseline
+            // JFIF stream without subsampling, e.g., to transform a JPEG image
+            // without decoding its pixels. The quality & sampling settings
+            // don't apply.
+            // @param width, height the size of the image, in pixels
+            // @param QTables the luminance & chrominance quantization tables
+            //        of the coefficients, in zig-zag order
+            // @param getBlock supplies the blocks, in the order they're encoded
+            // @param out the stream that receives the JFIF data
+            // @return false if the stream could not be written
+            bool encodeCoefficients(const std::size_t width, const std::size_t height,
+                                    const UInt16 (&QTables)[2][64],
+                                    const BlockSource& getBlock, std::ostream& out);
+
+        private:
+
+            // Write the markers & table segments that precede the scan data
+            void writeHeaders(std::ostream& out, const std::size_t width, const std::size_t height,
+                              const Sampling sampling, const UInt16 (&QTables)[2][64]);
+
+            // Use the standard Huffman tables (Annex K.3)
+            void setStandardHuffmanTables();
+
+            // Build the optimal Huffman tables for the counted symbols
+            void setOptimalHuffmanTables();
+
+            // Derive the code & the length of every symbol from the code
+            // counts & the symbols of the Huffman tables
+            void setHuffmanCodes();
+
+            // Transform, quantize & entropy code a block of level-shifted samples
+            // @param samples the 8x8 samples of the block, in raster order
+            // @param compID the component of the block: 0 (Y), 1 (Cb) or 2 (Cr)
+            void encodeBlock(const float* samples, const int compID);
+
+            // Entropy code a block of quantized coefficients, in zig-zag order
+            void encodeCoefficientBlock(const int* zzOrder, const int compID);
+
+            // Append the Huffman code of a symbol to the scan data, or only
+            // count the symbol while gathering statistics
+            // @param type HT_DC or HT_AC
+            // @param table HT_Y or HT_CbCr
+            void writeSymbol(const int type, const int table, const int symbol);
+
+            // Write a restart marker if one is due before the specified MCU
+            void writeRestartMarker(const std::size_t MCUIndex, std::size_t& restartCount);
+
+            // Append the low count bits of a value to the scan data, stuffing a
+            // zero byte after every 0xFF byte
+            void writeBits(const std::uint32_t value, const int count);
+
+            // Pad the scan data to a byte boundary with 1 bits
+            void flushBits();
+
+        private:
+
+            Settings m_settings;
+
+            // The quantization tables, luminance & chrominance, in zig-zag order
+            UInt16 m_QTables[2][64];
+
+            // The zig-zag order index of each coefficient of a block, in raster order
+            int m_zzOrder[64];
+
+            // The Huffman tables as written to the DHT segment, the number of
+            // codes of each length from 1 to 16 bits & the symbols, indexed
+            // by [HT_DC/HT_AC][HT_Y/HT_CbCr]
+            UInt8 m_huffmanBits[2][2][16];
+            std::vector<UInt8> m_huffmanValues[2][2];
+
+            // The Huffman code & its length of every symbol, indexed by
+            // [HT_DC/HT_AC][HT_Y/HT_CbCr][symbol]
+            std::uint16_t m_huffmanCodes[2][2][256];
+            UInt8 m_huffmanLengths[2][2][256];
+
+            // The number of times each symbol is coded, gathered by a first
+            // pass over the blocks that writes nothing
+            bool m_isCountingSymbols;
+            std::uint32_t m_symbolCounts[2][2][256];
+
+            // The state of the entropy coder
+            int m_DCPredictor[3];
+            std::uint32_t m_bitBuffer;
+            int m_bitCount;
+            std::vector<UInt8> m_scanData;
+    };
+}
+
+#endif // ENCODER_HPP
@@ -0,0 +1,172 @@
+// Huffman lookup table module
+//
+// The decoding tables built from the Huffman tables of a JFIF stream. A few
+// tables (the Annex K defaults, those of common cameras & encoders) are
+// used by almost every image, so the decoding tables are built once and
+// shared by all decoders through a process-wide cache, keyed by the raw
+// contents of the DHT table. The Annex K tables are built at compile time.
+
+#ifndef HUFFMAN_CACHE_HPP
+#define HUFFMAN_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Types.hpp"
+#include "BitReader.hpp"
+
+namespace kpeg
+{
+    // An immutable table for decoding the symbols of a Huffman table
+    //
+    // Codes of up to LOOKUP_BITS bits, which cover most of the symbols in
+    // practice, are resolved by a single lookup of the next LOOKUP_BITS bits
+    // of the scan. Longer codes are resolved bit by bit with the canonical
+    // code ranges of ITU-T.81 (09/92) F.2.2.3.
+    struct HuffmanLookupTable
+    {
+        // The number of bits resolved by a single lookup
+        static constexpr int LOOKUP_BITS = 9;
+
+        // For each LOOKUP_BITS-bit prefix of the scan: (code length << 8) | symbol,
+        // or 0 if the code at the prefix is longer than LOOKUP_BITS bits
+        UInt16 lookup[1 << LOOKUP_BITS];
+
+        // For each code length, the largest code of that length (-1 if none),
+        // and the offset from a code of that length to the index of its symbol
+        int maxCode[17];
+        int valueOffset[17];
+
+        // The symbols, in the order of their codes
+        UInt8 values[256];
+    };
+
+    // Build the decoding table of a Huffman table
+    //
+    // Codes that don't fit their length, and symbols beyond the 256 that a
+    // table may define, are ignored.
+    // @param counts the number of codes of each length from 1 to 16 bits
+    // @param symbols the symbols, in the order of their codes
+    constexpr HuffmanLookupTable buildHuffmanLookupTable(const UInt8* counts, const UInt8* symbols)
+    {
+        HuffmanLookupTable table{};
+
+        int code = 0;
+        int index = 0;
+
+        for (int length = 1; length <= 16; ++length)
+        {
+            table.valueOffset[length] = index - code;
+            table.maxCode[length] = -1;
+
+            for (int i = 0; i < counts[length - 1] && index < 256 && code < (1 << length); ++i)
+            {
+                table.values[index] = symbols[index];
+                table.maxCode[length] = code;
+
+                // Every prefix that starts with a short code resolves to it
+                if (length <= HuffmanLookupTable::LOOKUP_BITS)
+                {
+                    int shift = HuffmanLookupTable::LOOKUP_BITS - length;
+
+                    for (int fill = 0; fill < (1 << shift); ++fill)
+                        table.lookup[(code << shift) | fill] = UInt16((length << 8) | symbols[index]);
+                }
+
+                index++;
+                code++;
+            }
+
+            code <<= 1;
+        }
+
+        return table;
+    }
+
+    // Decode the Huffman code at the next bit of the scan data
+    // @param htable the decoding table of the Huffman table in use
+    // @param reader the scan data, advanced past the code
+    // @return the symbol, or -1 if no valid code is found
+    int decodeHuffmanSymbol(const HuffmanLookupTable& htable, BitReader& reader);
+
+    // Read the next category bits of the scan data as a signed coefficient value
+    inline int receiveExtend(const int category, BitReader& reader)
+    {
+        if (category == 0)
+            return 0;
+
+        // Values with a leading 0 bit are negative (F.2.2.1, EXTEND)
+        int value = reader.readBits(category);
+
+        if (value < (1 << (category - 1)))
+            value -= (1 << category) - 1;
+
+        return value;
+    }
+
+    // Decode the Huffman codes of one block of a baseline scan
+    // @param DCTable, ACTable the decoding tables of the block's component
+    // @param reader the scan data, advanced past the block
+    // @param DCPredictor the DC coefficient of the component's previous
+    //        block, updated to that of this block
+    // @param coeffs receives the 64 coefficients, in zig-zag order
+    // @return false if an invalid code was found
+    bool decodeBaselineBlock(const HuffmanLookupTable& DCTable, const HuffmanLookupTable& ACTable,
+                             BitReader& reader, int& DCPredictor, Int16* coeffs);
+
+    // Process-wide, thread-safe cache of Huffman decoding tables
+    class HuffmanCache
+    {
+        public:
+
+            // A shared, immutable decoding table
+            typedef std::shared_ptr<const HuffmanLookupTable> TablePtr;
+
+            // The most tables kept in the cache, so that streams with
+            // ever-changing tables can't grow it without bound
+            static const std::size_t MAX_TABLES = 1024;
+
+        public:
+
+            // Get the cache shared by all decoders
+            static HuffmanCache& getInstance();
+
+            // Get the decoding table for the contents of a DHT table, building
+            // it only if no table with the same contents was seen before
+            // @param data the 16 code counts of the table, followed by its symbols
+            // @param size the number of bytes of the table contents
+            TablePtr getTable(const UInt8* data, const std::size_t size);
+
+            // Get the decoding table of a standard Huffman table (Annex K.3)
+            // @param type HT_DC or HT_AC
+            // @param number HT_Y or HT_CbCr
+            static TablePtr getStandardTable(const int type, const int number);
+
+        private:
+
+            // Default constructor, the cache starts with the standard tables
+            HuffmanCache();
+
+            // Hash the contents of a DHT table (FNV-1a)
+            static std::uint64_t hashTable(const UInt8* data, const std::size_t size);
+
+        private:
+
+            // A cached table & the DHT contents it was built from, to tell
+            // tables apart whose hashes collide
+            struct Entry
+            {
+                std::vector<UInt8> contents;
+                TablePtr table;
+            };
+
+            std::unordered_map<std::uint64_t, std::vector<Entry>> m_tables;
+            std::size_t m_tableCount;
+            std::mutex m_mutex;
+    };
+}
+
+#endif // HUFFMAN_CACHE_HPP
@@ -1,54 +1,114 @@
-// Image module
-// Abstraction representing a raw uncompressed image
-
-#ifndef IMAGE_HPP
-#define IMAGE_HPP
-
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <array>
-#include <memory>
-
-#include "Types.hpp"
-#include "MCU.hpp"
-
-namespace kpeg
-{    
-    // Image is an abstraction for a raw, uncompressed image
-    // A raw, uncompressed image is nothing but a 2D array of pixels
-    class Image
-    {
-        public:
-            
-            // Default constructor
-            Image();
-            
-            // Create an image from a list of MCUs
-            //
-            // @param MCUs list of minimum coded units that can be converted to an image
-            void createImageFromMCUs(const std::vector<MCU>& MCUs);
-            
-            // Write the raw, uncompressed image data to specified file on the disk.
-            //
-            // The data written is in PPM format
-            //
-            // @param filename the location in the disk to write the image data
-            // @return true if succeeds in writing, else false
-            const bool dumpRawData(const std::string& filename);
-            
-        public:
-            
-            // Width of the image
-            std::size_t width;
-
-            // Height of the image
-            std::size_t height;
-
-        private:
-            // The 2D pixel array with discrete range
-            PixelPtr m_pixelPtr;
-    };
-}
-
-#endif // IMAGE_HPP
+// Image module
+// Abstraction representing a raw uncompressed image
+
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <array>
+#include <memory>
+
+#include "Types.hpp"
+#include "MCU.hpp"
+
+namespace kpeg
+{    
+    // The orientations of the EXIF Orientation tag, with the same values:
+    // how the pixels of the frame are transformed to display the image
+    // upright, the rotations are clockwise
+    enum class Orientation
+    {
+        NORMAL = 1,
+        FLIP_HORIZONTAL,
+        ROTATE_180,
+        FLIP_VERTICAL,
+        TRANSPOSE,      // across the top-left to bottom-right diagonal
+        ROTATE_90,
+        TRANSVERSE,     // across the top-right to bottom-left diagonal
+        ROTATE_270
+    };
+    
+    // Image is an abstraction for a raw, uncompressed image
+    // A raw, uncompressed image is nothing but a 2D array of pixels
+    class Image
+    {
+        public:
+            
+            // Default constructor
+            Image();
+            
+            // Create an image from a list of MCUs
+            //
+            // The MCUs cover a rectangular region of the frame in raster order,
+            // and the image may start anywhere inside the first MCU (e.g., when
+            // only a crop region of the frame is decoded).
+            //
+            // @param MCUs list of minimum coded units that can be converted to an image
+            // @param MCUsPerLine number of MCUs in each row of the list
+            // @param xOffset horizontal position of the image's first pixel in the first MCU
+            // @param yOffset vertical position of the image's first pixel in the first MCU
+            void createImageFromMCUs(const std::vector<MCU>& MCUs,
+                                     const std::size_t MCUsPerLine,
+                                     const std::size_t xOffset = 0,
+                                     const std::size_t yOffset = 0);
+            
+            // Create an image from an array of MCUs, see above
+            //
+            // The pixels are written to the specified buffer if any, else to the
+            // image's current buffer when nothing else shares it, so that an
+            // image recreated at the same size doesn't reallocate its pixels.
+            //
+            // The pixels of each block are written straight to their place
+            // in the image once it's oriented as specified, when the width
+            // & the height of the image (those of the region of the frame)
+            // are swapped for the orientations that transpose it.
+            //
+            // @param MCUs the first of the MCUs
+            // @param MCUCount the number of MCUs in the array
+            // @param pixels the buffer for the pixels, e.g., from a BufferPool
+            // @param orientation the orientation to apply to the pixels
+            void createImageFromMCUs(const MCU* MCUs,
+                                     const std::size_t MCUCount,
+                                     const std::size_t MCUsPerLine,
+                                     const std::size_t xOffset,
+                                     const std::size_t yOffset,
+                                     const PixelPtr& pixels = nullptr,
+                                     const Orientation orientation = Orientation::NORMAL);
+            
+            // Create an image from interleaved RGB samples, e.g., the
+            // uncompressed thumbnail of a JFIF file
+            // @param RGB the samples, 3 bytes for each pixel in raster order
+            // @param imageWidth, imageHeight the size of the image, in pixels
+            void createImageFromRGB(const UInt8* RGB,
+                                    const std::size_t imageWidth,
+                                    const std::size_t imageHeight);
+            
+            // Write the raw, uncompressed image data to specified file on the disk.
+            //
+            // The data written is in PPM format
+            //
+            // @param filename the location in the disk to write the image data
+            // @return true if succeeds in writing, else false
+            const bool dumpRawData(const std::string& filename) const;
+            
+            // Get the pixels of the image
+            // @return a pointer to the 2D pixel array, nullptr if the image isn't created yet
+            const PixelPtr getPixelPtr() const;
+            
+        public:
+            
+            // Width of the image
+            std::size_t width;
+
+            // Height of the image
+            std::size_t height;
+
+        private:
+            // The 2D pixel array with discrete range
+            PixelPtr m_pixelPtr;
+    };
+}
+
+#endif // IMAGE_HPP
@@ -0,0 +1,90 @@
+// Image statistics module
+//
+// Statistics of an image for triage (e.g., deduplicating & moderating
+// uploads) computed from its DC coefficients, without decoding it: the DC
+// coefficient of a block is 8 times the average of its samples, so the DC
+// coefficients alone are the image at 1/8 scale, and with the few lowest
+// AC coefficients of each block a reduced IDCT gives it at 1/4 or 1/2. The
+// scan is still entropy decoded (see Decoder::decodeCoefficients()), but
+// no block is transformed or colour converted in full, and only the few
+// coefficients used are kept.
+//
+// The perceptual hash is the usual DCT hash: the luminance is resized to
+// 32x32 & transformed, and each bit tells whether one of the 8x8 lowest
+// frequencies (but those of the first row & column) is above their median.
+// Similar images have hashes a few bits apart, see getHashDistance().
+
+#ifndef IMAGE_STATISTICS_HPP
+#define IMAGE_STATISTICS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Types.hpp"
+#include "Decoder.hpp"
+
+namespace kpeg
+{
+    class ImageStatistics
+    {
+        public:
+
+            // Default constructor, no statistics
+            ImageStatistics();
+
+            // Compute the statistics of the image opened by a decoder,
+            // replacing those held
+            //
+            // The decoder's block callback is used, and cleared afterwards.
+            // @param decoder a decoder with the image opened
+            // @param samplesPerBlock the samples taken in each row & column
+            //        of a block: 1 for the DC coefficient only, 2 or 4 to also
+            //        use the 3 or 15 lowest AC coefficients, e.g., for images
+            //        smaller than 256 pixels, hashed from fewer than 32x32
+            //        samples with the DC coefficients only
+            // @return the result of the decode, DECODE_DONE on success
+            Decoder::ResultCode analyze(Decoder& decoder, const int samplesPerBlock = 1);
+
+            // Whether statistics were computed, see analyze()
+            bool isEmpty() const;
+
+            // Compute the perceptual hash of a plane of luminance samples
+            // (e.g., that of a fully decoded image, to compare with)
+            // @param luminance the samples, row after row
+            // @param width, height the size of the plane, in samples
+            static std::uint64_t computePerceptualHash(const std::vector<float>& luminance,
+                                                       const std::size_t width, const std::size_t height);
+
+            // The number of bits that differ between two perceptual hashes,
+            // from 0 for the same image to 64
+            static int getHashDistance(const std::uint64_t hash, const std::uint64_t otherHash);
+
+        public:
+
+            // Size of the image, in pixels
+            std::size_t width;
+            std::size_t height;
+
+            // The average red, green & blue of the pixels
+            std::array<double, 3> averageColor;
+
+            // The number of pixels of each luminance, as sampled
+            std::array<std::size_t, 256> luminanceHistogram;
+
+            // The perceptual hash of the image, see computePerceptualHash()
+            std::uint64_t perceptualHash;
+
+        private:
+
+            // The coefficients kept for each component, the samplesPerBlock x
+            // samplesPerBlock lowest frequencies of each block, block after block
+            std::vector<Int16> m_coefficients[3];
+
+            // The luminance samples of the image, for its hash
+            std::vector<float> m_luminance;
+    };
+}
+
+#endif // IMAGE_STATISTICS_HPP
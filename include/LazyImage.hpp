@@ -0,0 +1,139 @@
+// Lazy image module
+//
+// An image whose pixels are reconstructed on demand, one row of MCUs at a
+// time, for consumers that only read a few regions of large images (e.g.,
+// the top rows of a letterbox check, or a few tiles). It holds the scan of
+// a baseline image, still compressed, and a checkpoint at the start of each
+// MCU row: the position in the scan & the DC predictors there. A row is
+// entropy decoded from its checkpoint, dequantized & transformed the first
+// time one of its pixels is read, and kept in a cache whose size is bounded
+// by evicting the rows read least recently. The memory & the time taken
+// scale with the rows read, not with the size of the image.
+//
+// The image is created by Decoder::decodeLazyImage(), which entropy decodes
+// the scan once, without reconstructing anything, to place the checkpoints.
+
+#ifndef LAZY_IMAGE_HPP
+#define LAZY_IMAGE_HPP
+
+#include <cstddef>
+#include <list>
+#include <vector>
+
+#include "Types.hpp"
+#include "HuffmanCache.hpp"
+#include "ScanIndex.hpp"
+#include "Transform.hpp"
+
+namespace kpeg
+{
+    class LazyImage
+    {
+        public:
+
+            // The number of MCU rows kept decoded by default
+            static const std::size_t DEFAULT_MAX_RESIDENT_ROWS = 16;
+
+        public:
+
+            // Default constructor, an empty image
+            LazyImage();
+
+            // The image refers to its own rows, so it can't be copied
+            LazyImage(const LazyImage&) = delete;
+            LazyImage& operator=(const LazyImage&) = delete;
+
+            // Set the most MCU rows (8 rows of pixels each) kept decoded at
+            // once, at least 1, evicting the rows read least recently if
+            // there are more already
+            void setMaxResidentRows(const std::size_t count);
+
+            // Get a pixel of the image, decoding its MCU row if it isn't resident
+            // @return the pixel, black if it's outside the image or its row
+            //         could not be decoded
+            Pixel getPixel(const std::size_t x, const std::size_t y);
+
+            // Get a row of pixels of the image, decoding its MCU row if it
+            // isn't resident
+            // @return the width pixels of the row, valid until another MCU
+            //         row is decoded, nullptr if the row is outside the image
+            //         or could not be decoded
+            const Pixel* getRow(const std::size_t y);
+
+            // Whether the image was created, see Decoder::decodeLazyImage()
+            bool isEmpty() const;
+
+            // The number of MCU rows decoded so far, counting the rows decoded
+            // again after they were evicted
+            std::size_t getDecodedRowCount() const;
+
+            // The number of MCU rows currently decoded & cached
+            std::size_t getResidentRowCount() const;
+
+            // The number of MCU rows of the image
+            std::size_t getMCURowCount() const;
+
+            // Release the decoded rows, the image stays readable
+            void releaseRows();
+
+        public:
+
+            // Size of the image, in pixels
+            std::size_t width;
+            std::size_t height;
+
+        private:
+
+            friend class Decoder;
+
+            // A decoded MCU row, 8 rows of width pixels
+            struct ResidentRow
+            {
+                std::size_t MCURow;
+                std::vector<Pixel> pixels;
+            };
+
+            typedef std::list<ResidentRow> ResidentRowList;
+
+            // Discard the image, before the decoder creates another one
+            void clear();
+
+            // Get an MCU row, decoding it into the row read least recently
+            // if it isn't resident (or a new one, below the bound)
+            // @return the row, nullptr if it could not be decoded
+            const ResidentRow* getMCURow(const std::size_t MCURow);
+
+            // Entropy decode an MCU row from its checkpoint & reconstruct its pixels
+            // @return false if an invalid Huffman code was found
+            bool decodeMCURow(const std::size_t MCURow, Pixel* pixels) const;
+
+        private:
+
+            // The scan, unstuffed & without restart markers
+            std::vector<UInt8> m_scanData;
+
+            // The decoding tables & the quantization tables of each component,
+            // the latter with the scale factors of the IDCT in use folded in
+            HuffmanCache::TablePtr m_DCTables[3];
+            HuffmanCache::TablePtr m_ACTables[3];
+            std::vector<std::vector<UInt16>> m_QTables;
+
+            // The number of MCUs between restart markers, 0 if the image has none
+            std::size_t m_restartInterval;
+
+            IDCTMode m_IDCTMode;
+
+            // The checkpoints of the scan, one for each MCU row
+            ScanIndex m_index;
+
+            // The decoded MCU rows, the one read most recently first, & the
+            // position of each MCU row in the list, end() if it isn't resident
+            ResidentRowList m_residentRows;
+            std::vector<ResidentRowList::iterator> m_rowPositions;
+            std::size_t m_maxResidentRows;
+
+            std::size_t m_decodedRowCount;
+    };
+}
+
+#endif // LAZY_IMAGE_HPP
@@ -0,0 +1,101 @@
+// Lossless transform module
+//
+// Rotates, flips & crops JPEG images without decoding their pixels: the
+// quantized DCT coefficients are entropy decoded, the blocks are moved
+// (and their coefficients transposed & sign-flipped, which mirrors the
+// samples of a block), and the result is entropy coded again as a baseline
+// JPEG with the same quantization tables. There's no IDCT, forward DCT or
+// requantization, so the image loses nothing.
+//
+// The entropy coding can also use Huffman tables optimized for the image,
+// instead of the generic Annex K ones, which makes most images smaller
+// without changing a coefficient, with or without a rotation or a flip.
+//
+// Only whole blocks can be moved, so a partial block at an edge that would
+// end up anywhere but the right or bottom edge is trimmed (as jpegtran's
+// -trim does), and crop regions start on a block boundary.
+
+#ifndef LOSSLESS_TRANSFORM_HPP
+#define LOSSLESS_TRANSFORM_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+#include "Decoder.hpp"
+#include "Encoder.hpp"
+
+namespace kpeg
+{
+    // The lossless transforms, the rotations are clockwise
+    enum class LosslessOperation
+    {
+        NONE,
+        FLIP_HORIZONTAL,
+        FLIP_VERTICAL,
+        TRANSPOSE,          // across the top-left to bottom-right diagonal
+        TRANSVERSE,         // across the top-right to bottom-left diagonal
+        ROTATE_90,
+        ROTATE_180,
+        ROTATE_270
+    };
+
+    // Parse the name of an operation: none, flip-h, flip-v, transpose,
+    // transverse, 90, 180 or 270
+    // @return false if the name is unknown
+    bool parseLosslessOperation(const std::string& name, LosslessOperation& operation);
+
+    class LosslessTransformer
+    {
+        public:
+
+            // Default constructor, transforms the whole image
+            LosslessTransformer();
+
+            // Keep only a window of the transformed image
+            //
+            // The window is in the coordinates of the transformed image, and
+            // its top-left corner is moved to the block boundary above & to
+            // the left of it, growing the window
+            // @param x, y the top-left corner of the window, in pixels
+            // @param width, height the size of the window, in pixels
+            void setCropRegion(const std::size_t x, const std::size_t y,
+                               const std::size_t width, const std::size_t height);
+
+            // Entropy code the transformed images with Huffman tables built
+            // for each image, instead of the standard tables
+            void setOptimizeHuffmanTables(const bool isOptimizing);
+
+            // Transform a JPEG image
+            // @param data the first byte of the JFIF data of the image
+            // @param size the number of bytes of JFIF data
+            // @param operation the rotation or flip to apply
+            // @param out the stream that receives the transformed JPEG image
+            // @return false if the image could not be decoded, or the
+            //         stream written
+            bool transform(const UInt8* data, const std::size_t size,
+                           const LosslessOperation operation, std::ostream& out);
+
+            // Transform a JPEG file, see above
+            // @param inputFilename, outputFilename the locations of the
+            //        original & the transformed images on the disk
+            bool transform(const std::string& inputFilename, const std::string& outputFilename,
+                           const LosslessOperation operation);
+
+        private:
+
+            // Decodes the coefficients of the images, its memory is reused
+            Decoder m_decoder;
+
+            bool m_isOptimizingHuffmanTables;
+
+            bool m_isCropped;
+            std::size_t m_cropX;
+            std::size_t m_cropY;
+            std::size_t m_cropWidth;
+            std::size_t m_cropHeight;
+    };
+}
+
+#endif // LOSSLESS_TRANSFORM_HPP
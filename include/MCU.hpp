@@ -1,94 +1,136 @@
-/* 
-Minimum Coded Unit (MCU) module
-
-Represents an abstraction for a MCU. An MCU is a block of 8x8 pixels.
-This abstracts away the conversion of the decoded RLE-Huffman encoded pixel values
-to corresponding matrices of 8x8 size. It actually contains three 8x8 matrices to
-represent the lumninance (Y) and chrominance (Cb & Cr) components.
- 
-The MCU object expects as input the RLE-Huffman encoded vector (obtained after
-the Huffman decoding is done).
-*/
-
-
-#ifndef MCU_HPP // only if MCU_HPP is defined then the code in #ifndef and #endif will be taken for consideration
-#define MCU_HPP
-
-#include <array>
-#include <vector>
-#include <utility>
-
-#include "Types.hpp" // types module for aliases
-#include "Transform.hpp" // transform module for zizzag and matrice indices transformation
-
-namespace kpeg
-{
-    // alias for a 8x8 pixel block with integral values for its channels
-    typedef std::array<std::array<std::array<int, 8>, 8>, 3> CompMatrices;
-    
-    // alias for a 8x8 matrix with integral elements
-    typedef std::array< std::array< int, 8 >, 8 > Matrix8x8;
-    
-    class MCU
-    {
-        public:
-            
-            // The total number of MCUs in the image
-            static int m_MCUCount;
-            
-            // The quantization table used for de-quantization
-            static std::vector<std::vector<UInt16>> m_QTables;
-
-        public:
-            
-            // Default constructor
-            MCU();
-            
-            // Parameterized constructor
-            // Initialze the MCU with run-length encoding per
-            // channel and the quantization tables to use
-            // parameter compRLE: the run-length encoding for the MCU
-            // parameter QTables: the quantization tables to be used for encoding the MCU
-            MCU(const std::array<std::vector<int>, 3>& compRLE,
-                const std::vector<std::vector<UInt16>>& QTables);
-            
-            // Create the MCU from the specified run-length encoding and quantization tables
-            // parameter compRLE: the run-length encoding for the MCU
-            // parameter QTables: the quantization tables to be used for encoding the MCU
-            void constructMCU(const std::array<std::vector<int>, 3>& compRLE,
-                              const std::vector<std::vector<UInt16>>& QTables);
-            
-            // Get the pixel arrays for the pixels under this MCU.
-            // Since there are three channels per MCU, three pixel arrays will be returned.
-            const CompMatrices& getAllMatrices() const;
-        
-        private:
-            
-            // Inverse discrete cosine transform (IDCT)
-            // The 8x8 matrices for each component has to be converted
-            // back from frequency to spaital domain.
-            void computeIDCT();
-            
-            // Level shift the pixel data to center it within the pixel value range
-            void performLevelShift();
-            
-            // Convert the MCU's underlying pixels from the Y-Cb-Cr color model to RGB color model
-            void convertYCbCrToRGB();
-            
-        private:
-            
-            // The pixel arrays for the three channels in the MCU
-            CompMatrices m_block;
-
-            // The order of the MCU in the image
-            int m_order;
-            
-            // The differences in the DC coefficients per channel
-            static int m_DCDiff[3];
-            
-            // For storing the IDCT coefficients before level shifting
-            std::array<std::array<std::array<float, 8>, 8>, 3> m_IDCTCoeffs;
-    };
-}
-
-#endif // MCU_HPP
+/* 
+Minimum Coded Unit (MCU) module
+
+Represents an abstraction for a MCU. An MCU is a block of 8x8 pixels.
+This abstracts away the conversion of the decoded RLE-Huffman encoded pixel values
+to corresponding matrices of 8x8 size. It actually contains three 8x8 matrices to
+represent the lumninance (Y) and chrominance (Cb & Cr) components.
+ 
+The MCU object expects as input the RLE-Huffman encoded vector (obtained after
+the Huffman decoding is done).
+*/
+
+
+#ifndef MCU_HPP // only if MCU_HPP is defined then the code in #ifndef and #endif will be taken for consideration
+#define MCU_HPP
+
+#include <array>
+#include <vector>
+#include <utility>
+
+#include "Types.hpp" // types module for aliases
+#include "Transform.hpp" // transform module for zizzag and matrice indices transformation
+
+namespace kpeg
+{
+    // alias for a 8x8 pixel block with integral values for its channels
+    typedef std::array<std::array<std::array<int, 8>, 8>, 3> CompMatrices;
+    
+    // alias for a 8x8 matrix with integral elements
+    typedef std::array< std::array< int, 8 >, 8 > Matrix8x8;
+    
+    class MCU
+    {
+        public:
+            
+            // The total number of MCUs in the image
+            //
+            // NOTE: The state shared by the MCUs of an image is kept per thread,
+            // so that decoders running on different threads don't interfere
+            static thread_local int m_MCUCount;
+            
+            // The IDCT implementation used by computeIDCT()
+            static thread_local IDCTMode m_IDCTMode;
+
+        public:
+            
+            // Default constructor
+            MCU();
+            
+            // Parameterized constructor
+            // Initialze the MCU with run-length encoding per
+            // channel and the quantization tables to use
+            // parameter compRLE: the run-length encoding for the MCU
+            // parameter QTables: the quantization tables to be used for encoding the MCU
+            MCU(const std::array<std::vector<int>, 3>& compRLE,
+                const std::vector<std::vector<UInt16>>& QTables);
+            
+            // Parameterized constructor
+            // Initialze the MCU with the quantized DCT coefficients per channel
+            // (e.g., from the coefficient buffer of a progressive image)
+            // parameter compCoeffs: the 64 coefficients of each channel, in zig-zag order,
+            //                       with the DC coefficients already predicted
+            // parameter QTables: the quantization tables to be used for encoding the MCU
+            MCU(const std::array<const Int16*, 3>& compCoeffs,
+                const std::vector<std::vector<UInt16>>& QTables);
+            
+            // Create the MCU from the specified run-length encoding and quantization tables
+            // parameter compRLE: the run-length encoding for the MCU
+            // parameter QTables: the quantization tables to be used for encoding the MCU
+            void constructMCU(const std::array<std::vector<int>, 3>& compRLE,
+                              const std::vector<std::vector<UInt16>>& QTables);
+            
+            // Create the MCU from the specified coefficients and quantization tables
+            // parameter compCoeffs: the 64 coefficients of each channel, in zig-zag order
+            // parameter QTables: the quantization tables to be used for encoding the MCU
+            void constructMCU(const std::array<const Int16*, 3>& compCoeffs,
+                              const std::vector<std::vector<UInt16>>& QTables);
+            
+            // Get the pixel arrays for the pixels under this MCU.
+            // Since there are three channels per MCU, three pixel arrays will be returned.
+            const CompMatrices& getAllMatrices() const;
+            
+            // Account for the DC differences of an MCU that is not reconstructed
+            // (e.g., one outside a crop region), so the DC coefficients of the
+            // following MCUs are still predicted correctly
+            // parameter compRLE: the run-length encoding for the skipped MCU
+            static void updateDCPredictors(const std::array<std::vector<int>, 3>& compRLE);
+            
+            // Reset the DC predictors & the MCU count at the start of a new
+            // image, or of a restart interval
+            static void resetDCPredictors();
+            
+            // Set the DC predictors, to resume decoding in the middle of a
+            // scan (e.g., from a ScanCheckpoint)
+            // parameter DCPredictors: the DC coefficients of the last blocks of the channels
+            static void setDCPredictors(const int DCPredictors[3]);
+            
+            // The reconstruction stages, in the order constructMCU() runs them,
+            // each of which can also be run (e.g., timed) on its own
+            
+            // Inverse discrete cosine transform (IDCT)
+            // The 8x8 matrices for each component has to be converted
+            // back from frequency to spaital domain, with the
+            // implementation selected by m_IDCTMode.
+            void computeIDCT();
+            
+            // Level shift the pixel data to center it within the pixel value range
+            void performLevelShift();
+            
+            // Convert the MCU's underlying pixels from the Y-Cb-Cr color model to RGB color model
+            void convertYCbCrToRGB();
+        
+        private:
+            
+            // De-quantize the zig-zag ordered coefficients of a channel
+            // and store them in the channel's 8x8 matrix
+            void dequantize(const int compID, std::array<int, 64>& zzOrder,
+                            const std::vector<std::vector<UInt16>>& QTables);
+            
+        private:
+            
+            // The pixel arrays for the three channels in the MCU
+            CompMatrices m_block;
+
+            // The order of the MCU in the image
+            int m_order;
+            
+            // The differences in the DC coefficients per channel
+            static thread_local int m_DCDiff[3];
+            
+            // For storing the IDCT coefficients before level shifting
+            std::array<std::array<std::array<float, 8>, 8>, 3> m_IDCTCoeffs;
+    };
+}
+
+#endif // MCU_HPP
@@ -0,0 +1,121 @@
+// Motion-JPEG module
+//
+// A Motion-JPEG stream is a plain concatenation of JFIF frames (SOI...EOI).
+// Camera streams are often abbreviated: frames may leave out the Huffman
+// tables, relying on the standard ones, or the quantization tables, relying
+// on the ones of a previous frame. This module splits such a stream into
+// frames and decodes several of them concurrently, handing them out in order.
+
+#ifndef MJPEG_HPP
+#define MJPEG_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "Types.hpp"
+#include "Image.hpp"
+#include "Decoder.hpp"
+#include "BufferPool.hpp"
+
+namespace kpeg
+{
+    // The location of a frame in a Motion-JPEG stream
+    struct MJPEGFrame
+    {
+        // Offset of the frame's SOI marker in the stream
+        std::size_t offset;
+
+        // Size of the frame in bytes, up to and including its EOI marker
+        std::size_t size;
+
+        // Whether the frame defines its own quantization & Huffman tables
+        bool hasDQT;
+        bool hasDHT;
+    };
+
+    // Split a Motion-JPEG stream into its frames
+    //
+    // The marker segments of each frame are skipped by their length, so only
+    // the entropy-coded data is searched for the EOI marker.
+    // @param data the first byte of the stream
+    // @param size the number of bytes in the stream
+    // @return the frames found in the stream, in order
+    std::vector<MJPEGFrame> splitMJPEGFrames(const UInt8* data, const std::size_t size);
+
+    class MJPEGDecoder
+    {
+        public:
+
+            // Callback that receives the decoded frames, in stream order
+            // @param frame the decoded image, empty if the frame failed to decode
+            // @param frameNumber the index of the frame in the stream, from 0
+            // @param result the result of decoding the frame
+            typedef std::function<void(const Image& frame, const std::size_t frameNumber,
+                                       const Decoder::ResultCode result)> FrameCallback;
+
+        public:
+
+            // Start the workers that decode frames concurrently
+            // @param workerCount the number of frames decoded at the same time
+            MJPEGDecoder(const std::size_t workerCount);
+
+            // Stop the workers
+            ~MJPEGDecoder();
+
+            // Decode all the frames of a Motion-JPEG stream
+            // @param data the first byte of the stream
+            // @param size the number of bytes in the stream
+            // @param callback receives every frame, in stream order
+            // @return the number of frames decoded successfully
+            std::size_t decodeStream(const UInt8* data, const std::size_t size,
+                                     const FrameCallback& callback);
+
+        private:
+
+            // A frame waiting for, or decoded by, a worker
+            struct FrameJob
+            {
+                std::size_t number;
+
+                // The frame's JFIF data, either in the stream itself or, for an
+                // abbreviated frame, in a copy with the missing tables inserted
+                const UInt8* data;
+                std::size_t size;
+                std::vector<UInt8> completedData;
+
+                bool isDone;
+                Image image;
+                Decoder::ResultCode result;
+            };
+
+            // Take frames from the queue and decode them, until the decoder stops
+            void workerLoop();
+
+        private:
+
+            std::vector<std::thread> m_workers;
+
+            // The pixel buffers of the frames, shared by the workers as the
+            // frames are released by another thread than decoded them, and
+            // keeping enough free buffers for all the frames in flight
+            std::shared_ptr<BufferPool> m_bufferPool;
+
+            // Frames in stream order, from the next one to hand out
+            std::deque<std::shared_ptr<FrameJob>> m_pending;
+
+            // Frames waiting for a worker
+            std::deque<std::shared_ptr<FrameJob>> m_queue;
+
+            std::mutex m_mutex;
+            std::condition_variable m_frameQueued;
+            std::condition_variable m_frameDone;
+            bool m_isStopping;
+    };
+}
+
+#endif // MJPEG_HPP
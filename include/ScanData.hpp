@@ -0,0 +1,62 @@
+// Scan data module
+//
+// The entropy-coded data of a scan follows its SOS segment, up to the next
+// marker that isn't a restart marker. A 0xFF data byte is followed by a
+// stuffed zero byte (0xFF00) so that it isn't taken for a marker, and a
+// restart marker (0xFFD0 to 0xFFD7) ends each restart interval. Extracting
+// the scan data drops both, so that the bit reader sees the entropy-coded
+// bits only.
+//
+// 0xFF bytes are rare in entropy-coded data, so the data is searched for
+// them 32 bytes at a time with AVX2 when the processor has it, else 16 at
+// a time with SSE2 on x86, else with std::memchr(), and the bytes between
+// them are copied in bulk.
+
+#ifndef SCAN_DATA_HPP
+#define SCAN_DATA_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "Types.hpp"
+
+namespace kpeg
+{
+    // A stuffed zero byte or a restart marker removed from scan data
+    struct ScanMarker
+    {
+        // The offset of the marker's 0xFF byte from the first byte of the
+        // scan data, in the JFIF data
+        std::size_t inputOffset;
+
+        // The number of bytes of extracted scan data before the marker
+        std::size_t outputOffset;
+
+        // The byte after 0xFF: 0x00 for a stuffed byte, else the restart marker
+        UInt8 marker;
+    };
+
+    // Find the first 0xFF byte of a block of data
+    // @param first, last the block of data
+    // @return a pointer to the byte, last if there's none
+    const UInt8* findMarkerByte(const UInt8* first, const UInt8* last);
+
+    // Extract the entropy-coded data of a scan, up to the marker ending it
+    // @param first, last the JFIF data, from the first byte of the scan data
+    // @param output where the data is written, with room for last - first
+    //        bytes, as the data extracted is never larger than the data read
+    // @param outputSize set to the number of bytes written
+    // @param markers if not null, the stuffed bytes & restart markers
+    //        removed are appended to it, e.g., to locate errors in the data
+    // @return a pointer to the 0xFF byte of the marker ending the scan (e.g.,
+    //         EOI, or the next scan's DHT or SOS), last if the data ends first
+    const UInt8* extractScanData(const UInt8* first, const UInt8* last,
+                                 UInt8* output, std::size_t& outputSize,
+                                 std::vector<ScanMarker>* markers = nullptr);
+
+    // The instructions findMarkerByte() uses on this processor: "AVX2",
+    // "SSE2" or "scalar"
+    const char* getMarkerSearchInstructions();
+}
+
+#endif // SCAN_DATA_HPP
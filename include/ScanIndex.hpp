@@ -0,0 +1,82 @@
+// Scan index module
+//
+// Entropy decoding a baseline scan is strictly sequential: the Huffman codes
+// have no boundaries to resume from, and every DC coefficient is coded as
+// the difference from the previous one of its component. A scan index holds
+// a checkpoint every few MCU rows, the position of the row's first bit in
+// the scan & the DC predictors there, so that decoding a region of an image
+// can start at the checkpoint above it instead of at the first bit of the
+// scan. The index is built by one decoding pass (see
+// Decoder::buildScanIndex()), and can be kept next to the image in a small
+// sidecar file, for images that are read in parts again & again.
+
+#ifndef SCAN_INDEX_HPP
+#define SCAN_INDEX_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+
+namespace kpeg
+{
+    // A position in a baseline scan that decoding can resume from
+    struct ScanCheckpoint
+    {
+        // The MCU row that starts at the checkpoint
+        std::size_t MCURow;
+
+        // The index of the row's first bit in the scan, unstuffed & without
+        // restart markers, after the restart marker before the row if any
+        std::size_t bitPosition;
+
+        // The DC coefficients of the components' last blocks before the row
+        int DCPredictors[3];
+    };
+
+    class ScanIndex
+    {
+        public:
+
+            // Default constructor, an empty index
+            ScanIndex();
+
+            // Whether the index was built for a scan, as far as its frame &
+            // scan data tell
+            // @param width, height the size of the frame, in pixels
+            // @param restartInterval the number of MCUs between restart markers
+            // @param scanSize the number of bytes of the unstuffed scan
+            bool matches(const std::size_t width, const std::size_t height,
+                         const std::size_t restartInterval, const std::size_t scanSize) const;
+
+            // Get the checkpoint to decode an MCU row from, the last one at
+            // or above the row
+            // @return the checkpoint, nullptr if there's none
+            const ScanCheckpoint* findCheckpoint(const std::size_t MCURow) const;
+
+            // Write the index to a file, e.g., <image>.kix next to the image
+            // @return false if the file could not be written
+            bool write(const std::string& filename) const;
+
+            // Read an index written by write()
+            // @return false if the file could not be read, or isn't an index
+            bool read(const std::string& filename);
+
+        public:
+
+            // What the index was built for, see matches()
+            std::size_t frameWidth;
+            std::size_t frameHeight;
+            std::size_t restartInterval;
+            std::size_t scanSize;
+
+            // The number of MCU rows between checkpoints
+            std::size_t rowInterval;
+
+            // The checkpoints, in the order of their rows
+            std::vector<ScanCheckpoint> checkpoints;
+    };
+}
+
+#endif // SCAN_INDEX_HPP
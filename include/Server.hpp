@@ -0,0 +1,178 @@
+// Decode service module
+//
+// A long-running decode service that keeps a warm process, so jobs don't
+// pay for process startup and cold allocations. Jobs are read as text
+// commands, one per line, from standard input or from the clients of a
+// Unix domain socket:
+//
+//   decode <input.jpg> <output.ppm> [crop <x> <y> <w> <h>] [deadline <ms>]
+//   decode-buffer <size> <output.ppm> [crop <x> <y> <w> <h>] [deadline <ms>]
+//   ping
+//   quit
+//   shutdown
+//
+// 'decode-buffer' is followed by <size> bytes of JFIF data. An output of
+// '-' decodes without writing the image. Each job is answered with one line:
+//
+//   <job#> OK <width>x<height> <decode-ms> <total-ms>
+//   <job#> ERROR <reason> <decode-ms> <total-ms>
+//
+// where job numbers count the jobs of a connection from 1. Jobs run
+// concurrently on a pool of workers, each of which keeps its decoder &
+// buffers across jobs, so replies may arrive out of order.
+//
+// A job whose deadline passes, counted from when it was received, stops
+// decoding at its next MCU row and is answered 'ERROR deadline-exceeded'.
+// Once a client can't be replied to, its remaining jobs are cancelled.
+//
+// The service is meant for untrusted input: a 'decode-buffer' job larger
+// than the service's limit is answered 'ERROR request-too-large' before
+// any of it is read, ending its connection, and an image whose frame has
+// more pixels than the limit is answered 'ERROR unsupported' before its
+// pixels are allocated. The jobs & the bytes of JFIF data queued are
+// bounded for each connection & for the whole service, a connection over
+// its share isn't read from until its jobs are done. The clients of the
+// socket may only read & write the files under the service's root, and
+// are answered 'ERROR forbidden' for any other path, see ServiceLimits.
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Decoder.hpp"
+
+namespace kpeg
+{
+    // The largest jobs a decode service accepts, & how many it holds
+    //
+    // A job is admitted beyond the queued limits when nothing else is
+    // queued, so that a single job of the largest size always is.
+    struct ServiceLimits
+    {
+        // The most bytes of JFIF data sent with a 'decode-buffer' job
+        std::size_t maxRequestSize = 256 * 1024 * 1024;
+
+        // The most pixels of the frame of a decoded image
+        std::size_t maxPixels = 100 * 1000 * 1000;
+
+        // The most jobs & bytes of JFIF data queued or decoding for one
+        // connection, before it's no longer read from
+        std::size_t maxConnectionJobs = 64;
+        std::size_t maxConnectionBytes = 512 * 1024 * 1024;
+
+        // The most jobs & bytes of JFIF data queued or decoding in all
+        std::size_t maxQueuedJobs = 1024;
+        std::size_t maxQueuedBytes = 1024 * 1024 * 1024;
+
+        // The directory of the files the jobs of socket clients may read
+        // & write, their relative paths are under it; if it's empty, they
+        // may only send 'decode-buffer' jobs that write no image ('-')
+        std::string rootDirectory;
+    };
+
+    class DecodeServer
+    {
+        public:
+
+            // Start the worker pool of the service
+            // @param workerCount the number of jobs decoded concurrently
+            // @param limits the largest jobs accepted
+            DecodeServer(const std::size_t workerCount, const ServiceLimits& limits = ServiceLimits());
+
+            // Stop the worker pool, waiting for the pending jobs
+            ~DecodeServer();
+
+            // Serve the jobs read from a stream, until its end or a 'quit' command
+            // @param inFd the file descriptor to read jobs from
+            // @param outFd the file descriptor to write replies to
+            void serveStream(const int inFd, const int outFd);
+
+            // Serve the jobs of every client of a Unix domain socket, until
+            // a client sends a 'shutdown' command
+            // @param socketPath the location of the socket in the file system
+            // @return false if the socket could not be set up, else true
+            bool serveSocket(const std::string& socketPath);
+
+        private:
+
+            // A client of the service, or the standard input & output
+            struct Connection;
+
+            // A decode job waiting for a worker
+            struct Job;
+
+            // Read & dispatch the jobs of a connection until it ends
+            // @return true if the connection asked to shut the service down
+            bool handleConnection(const std::shared_ptr<Connection>& connection);
+
+            // Wait until a job fits within the limits of the queued jobs, & count it
+            // @param size the bytes of JFIF data sent with the job
+            void admitJob(Connection& connection, const std::size_t size);
+
+            // Stop counting a job admitted, once it's done
+            void releaseJob(Connection& connection, const std::size_t size);
+
+            // Resolve the path of a file a socket client's job reads or
+            // writes, which has to be under the service's root
+            // @param path the path sent with the job, relative to the root if it isn't absolute
+            // @param isOutput whether the job writes the file, which may not exist yet
+            // @param resolved set to the absolute path of the file
+            // @return false if the file is outside the root, else true
+            bool resolveClientPath(const std::string& path, const bool isOutput, std::string& resolved) const;
+
+            // Take jobs from the queue and decode them, until the service stops
+            void workerLoop();
+
+            // Decode a job with the worker's decoder and reply to its connection
+            void runJob(Job& job, Decoder& decoder);
+
+            // Decode a job & write its image, for runJob()
+            // @return the status of the job's reply, e.g., "OK 640x480"
+            std::string decodeJob(Job& job, Decoder& decoder);
+
+            // Get a scratch buffer for JFIF data from the pool, or a new one
+            std::vector<UInt8> acquireBuffer();
+
+            // Return a buffer to the pool, keeping its capacity for the next job
+            void releaseBuffer(std::vector<UInt8>&& buffer);
+
+        private:
+
+            ServiceLimits m_limits;
+
+            std::vector<std::thread> m_workers;
+
+            std::deque<std::unique_ptr<Job>> m_jobs;
+            std::mutex m_jobMutex;
+            std::condition_variable m_jobAvailable;
+            bool m_isStopping;
+
+            // The jobs admitted & not yet done, & their bytes, guarded by m_jobMutex
+            std::size_t m_queuedJobs;
+            std::size_t m_queuedBytes;
+            std::condition_variable m_jobReleased;
+
+            std::vector<std::vector<UInt8>> m_bufferPool;
+            std::mutex m_bufferMutex;
+
+            // File descriptors of the socket & its connected clients
+            int m_listenFd;
+            std::vector<int> m_clientFds;
+            std::mutex m_clientMutex;
+    };
+
+    // Send the jobs read from standard input to a running decode service,
+    // and print its replies to standard output
+    // @param socketPath the location of the service's socket in the file system
+    // @return false if the service could not be reached, else true
+    bool runDecodeClient(const std::string& socketPath);
+}
+
+#endif // SERVER_HPP
@@ -0,0 +1,170 @@
+// Standard tables module
+//
+// The example tables of ITU-T.81 (09/92) Annex K, which most encoders use
+// unchanged, or scaled to a quality for the quantization tables. Streams
+// that omit the Huffman tables (e.g., Motion-JPEG frames from cameras)
+// rely on the decoder to supply the Annex K.3 ones.
+
+#ifndef STANDARD_TABLES_HPP
+#define STANDARD_TABLES_HPP
+
+#include <vector>
+
+#include "Types.hpp"
+#include "Markers.hpp"
+
+namespace kpeg
+{
+    // Annex K.1, Table K.1: luminance quantization table, in raster order
+    constexpr UInt8 STD_LUMINANCE_QUANT_TABLE[64] = {
+        16, 11, 10, 16,  24,  40,  51,  61,
+        12, 12, 14, 19,  26,  58,  60,  55,
+        14, 13, 16, 24,  40,  57,  69,  56,
+        14, 17, 22, 29,  51,  87,  80,  62,
+        18, 22, 37, 56,  68, 109, 103,  77,
+        24, 35, 55, 64,  81, 104, 113,  92,
+        49, 64, 78, 87, 103, 121, 120, 101,
+        72, 92, 95, 98, 112, 100, 103,  99
+    };
+
+    // Annex K.1, Table K.2: chrominance quantization table, in raster order
+    constexpr UInt8 STD_CHROMINANCE_QUANT_TABLE[64] = {
+        17, 18, 24, 47, 99, 99, 99, 99,
+        18, 21, 26, 66, 99, 99, 99, 99,
+        24, 26, 56, 99, 99, 99, 99, 99,
+        47, 66, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99
+    };
+
+    // Annex K.3, Table K.3: luminance DC coefficient differences
+    // The number of codes of each length from 1 to 16 bits, then the symbols
+    constexpr UInt8 STD_DC_LUMINANCE_BITS[16] = {
+        0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0
+    };
+    constexpr UInt8 STD_DC_LUMINANCE_VALUES[12] = {
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11
+    };
+
+    // Annex K.3, Table K.4: chrominance DC coefficient differences
+    constexpr UInt8 STD_DC_CHROMINANCE_BITS[16] = {
+        0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0
+    };
+    constexpr UInt8 STD_DC_CHROMINANCE_VALUES[12] = {
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11
+    };
+
+    // Annex K.3, Table K.5: luminance AC coefficients
+    constexpr UInt8 STD_AC_LUMINANCE_BITS[16] = {
+        0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D
+    };
+    constexpr UInt8 STD_AC_LUMINANCE_VALUES[162] = {
+        0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12,
+        0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+        0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08,
+        0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+        0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16,
+        0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+        0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+        0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+        0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+        0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+        0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+        0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98,
+        0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+        0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6,
+        0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+        0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4,
+        0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+        0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA,
+        0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+        0xF9, 0xFA
+    };
+
+    // Annex K.3, Table K.6: chrominance AC coefficients
+    constexpr UInt8 STD_AC_CHROMINANCE_BITS[16] = {
+        0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77
+    };
+    constexpr UInt8 STD_AC_CHROMINANCE_VALUES[162] = {
+        0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21,
+        0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+        0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+        0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+        0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34,
+        0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+        0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38,
+        0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+        0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+        0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+        0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+        0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+        0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96,
+        0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+        0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4,
+        0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+        0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2,
+        0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+        0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9,
+        0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+        0xF9, 0xFA
+    };
+
+    // Get the code counts & symbols of a standard Huffman table
+    // @param type HT_DC or HT_AC
+    // @param number HT_Y or HT_CbCr
+    // @param bits receives the address of the 16 code counts
+    // @param values receives the address of the symbols
+    inline void getStandardHuffmanTable( const int type, const int number,
+                                         const UInt8*& bits, const UInt8*& values )
+    {
+        if ( type == HT_DC )
+        {
+            bits = number == HT_Y ? STD_DC_LUMINANCE_BITS : STD_DC_CHROMINANCE_BITS;
+            values = number == HT_Y ? STD_DC_LUMINANCE_VALUES : STD_DC_CHROMINANCE_VALUES;
+        }
+        else
+        {
+            bits = number == HT_Y ? STD_AC_LUMINANCE_BITS : STD_AC_CHROMINANCE_BITS;
+            values = number == HT_Y ? STD_AC_LUMINANCE_VALUES : STD_AC_CHROMINANCE_VALUES;
+        }
+    }
+
+    // Build a DHT segment, marker included, that defines all four standard Huffman tables
+    inline std::vector<UInt8> makeStandardDHTSegment()
+    {
+        std::vector<UInt8> segment = { JFIF_BYTE_FF, JFIF_DHT, 0x00, 0x00 };
+
+        for ( auto type = 0; type < 2; ++type )
+        {
+            for ( auto number = 0; number < 2; ++number )
+            {
+                const UInt8* bits = nullptr;
+                const UInt8* values = nullptr;
+                getStandardHuffmanTable( type, number, bits, values );
+
+                segment.push_back( UInt8( ( type << 4 ) | number ) );
+
+                int symbolCount = 0;
+                for ( auto i = 0; i < 16; ++i )
+                {
+                    segment.push_back( bits[i] );
+                    symbolCount += bits[i];
+                }
+
+                segment.insert( segment.end(), values, values + symbolCount );
+            }
+        }
+
+        // The segment length counts itself, but not the marker
+        std::size_t length = segment.size() - 2;
+        segment[2] = UInt8( length >> 8 );
+        segment[3] = UInt8( length & 0xFF );
+
+        return segment;
+    }
+}
+
+#endif // STANDARD_TABLES_HPP
@@ -0,0 +1,100 @@
+// Tensor module
+//
+// Writes decoded images as the input tensors of a neural network: planar
+// (CHW) float32 or float16 channels, normalized by a mean & a standard
+// deviation per channel, and resized to a target size. The tensor is
+// produced in a single pass over the reconstructed blocks of the image,
+// instead of converting, normalizing, transposing & resizing the pixels
+// of the image one pass at a time.
+
+#ifndef TENSOR_HPP
+#define TENSOR_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Types.hpp"
+#include "MCU.hpp"
+
+namespace kpeg
+{
+    class Decoder;
+
+    // The type of the elements of a tensor
+    enum class TensorType
+    {
+        FLOAT32,
+
+        // IEEE 754 half precision, stored as UInt16
+        FLOAT16
+    };
+
+    // The layout & the normalization of a tensor
+    struct TensorOptions
+    {
+        // Default options: float32 at the size of the image, with the
+        // samples scaled to [0, 1]
+        TensorOptions();
+
+        // Size of the tensor, 0 for the size of the image (or of the crop
+        // window), otherwise the image is resized with bilinear filtering
+        std::size_t width;
+        std::size_t height;
+
+        // The normalization of each RGB channel, applied to the samples
+        // scaled to [0, 1]: (sample / 255 - mean) / standardDeviation
+        float mean[3];
+        float standardDeviation[3];
+
+        TensorType type;
+    };
+
+    // The number of bytes of the tensor of one image
+    // @param options the layout of the tensor
+    // @param imageWidth, imageHeight the size of the image, used when the
+    //        options don't specify a size
+    std::size_t getTensorSize(const TensorOptions& options,
+                              const std::size_t imageWidth,
+                              const std::size_t imageHeight);
+
+    // Convert a float to half precision, rounding to the nearest value
+    UInt16 floatToHalf(const float value);
+
+    // Write the tensor of an image from its MCUs, which are laid out as for
+    // Image::createImageFromMCUs()
+    // @param MCUs the first of the MCUs
+    // @param MCUCount the number of MCUs in the array
+    // @param MCUsPerLine number of MCUs in each row of the list
+    // @param xOffset, yOffset position of the image's first pixel in the first MCU
+    // @param imageWidth, imageHeight the size of the image, in pixels
+    // @param options the layout of the tensor
+    // @param output the tensor, getTensorSize() bytes
+    // @return false if the MCUs don't cover the image, when nothing is written
+    bool writeTensorFromMCUs(const MCU* MCUs,
+                             const std::size_t MCUCount,
+                             const std::size_t MCUsPerLine,
+                             const std::size_t xOffset,
+                             const std::size_t yOffset,
+                             const std::size_t imageWidth,
+                             const std::size_t imageHeight,
+                             const TensorOptions& options,
+                             void* output);
+
+    // Decode JPEG images held in memory into the consecutive tensors of a
+    // batch (NCHW), which options must give a size, as every image takes
+    // the same getTensorSize() bytes of the batch
+    //
+    // The tensor of an image that fails to decode is filled with zeros.
+    // @param decoder the decoder to use, it's reset before every image
+    // @param images the JFIF data & its size, for each image
+    // @param options the layout of the tensors
+    // @param batch the batch, images.size() tensors
+    // @return the number of images decoded successfully
+    std::size_t decodeTensorBatch(Decoder& decoder,
+                                  const std::vector<std::pair<const UInt8*, std::size_t>>& images,
+                                  const TensorOptions& options,
+                                  void* batch);
+}
+
+#endif // TENSOR_HPP
@@ -1,49 +1,105 @@
-/*
-Transform module
-* Contains various functions for transforming pieces of compressed image data between different forms, and their helper functions
-
-We will define two helper functions to convert between matrix indices and their corresponding zig-zag order:
-
-* matIndicesToZZOrder: converts a matrix index, (i,j), to its corresponding order, k, in zig-zag ordering
-* zzOrderToMatIndices: converts a zig-zag order, k, to it’s corresponding matrix index, (i,j)
-
-We will also have two functions that will be used in the decoder
-
-* bitStringToValue: convert a bit string representation to its corresponding value
-* getValueCategory: get the category of a value
-*/
-
-#ifndef TRANSFORM_HPP // if TRANSFORM_HPP is defined, then the code inside #ifndef and #endif is taken for compilation
-#define TRANSFORM_HPP
-
-#include <string>
-#include <utility>
-
-#include "Types.hpp" // Importing the Types module which contains aliases and types
-
-namespace kpeg {
-    // Convert a zig-zag order index to its corresponding matrix indices
-    // INPUT: zzIndex: the index in the zig-zag order
-    // OUTPUT: returns the matrix indices corresponding to the zig-zag order
-    const std::pair<const int, const int> zzOrderToMatIndices(const int zzindex);
-
-    // Convert matrix indices to its corresponding zig-zag order index
-
-    // INPUT: the parameters are the matrix indices
-    // OUTPUT: returns the zig-zag index corresponding to the matrix indices
-    const int matIndicesToZZOrder(const int row, const int column);
-
-    // Convert a bit strig to it's corresponding value
-    
-    // INPUT: bitStr: the bit string
-    // OUTPUT: returns the value corresponding to the bit string
-    const Int16 bitStringtoValue(const std::string& bitStr);
-
-    /// Get the category of a value
-    
-    // INPUT: value: the whose category has to be determined
-    // OUTPUT: returns the category of the specified value
-    const Int16 getValueCategory(const Int16 value);
-}
-
-#endif // TRANSFORM_HPP
+/*
+Transform module
+* Contains various functions for transforming pieces of compressed image data between different forms, and their helper functions
+
+We will define two helper functions to convert between matrix indices and their corresponding zig-zag order:
+
+* matIndicesToZZOrder: converts a matrix index, (i,j), to its corresponding order, k, in zig-zag ordering
+* zzOrderToMatIndices: converts a zig-zag order, k, to it’s corresponding matrix index, (i,j)
+
+We will also have two functions that will be used in the decoder
+
+* bitStringToValue: convert a bit string representation to its corresponding value
+* getValueCategory: get the category of a value
+
+And the inverse DCT, in three implementations that trade accuracy for speed:
+
+* getDequantizationTables: get the tables that de-quantize the coefficients for an implementation
+* inverseDCT: compute the 2D IDCT of an 8x8 block with the specified implementation
+* inverseDCTScaled: compute a reduced IDCT of an 8x8 block, to a 4x4, 2x2 or 1x1 block
+*/
+
+#ifndef TRANSFORM_HPP // if TRANSFORM_HPP is defined, then the code inside #ifndef and #endif is taken for compilation
+#define TRANSFORM_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Types.hpp" // Importing the Types module which contains aliases and types
+
+namespace kpeg {
+    // Convert a zig-zag order index to its corresponding matrix indices
+    // INPUT: zzIndex: the index in the zig-zag order
+    // OUTPUT: returns the matrix indices corresponding to the zig-zag order
+    const std::pair<const int, const int> zzOrderToMatIndices(const int zzindex);
+
+    // Convert matrix indices to its corresponding zig-zag order index
+
+    // INPUT: the parameters are the matrix indices
+    // OUTPUT: returns the zig-zag index corresponding to the matrix indices
+    const int matIndicesToZZOrder(const int row, const int column);
+
+    // Convert a bit strig to it's corresponding value
+    
+    // INPUT: bitStr: the bit string
+    // OUTPUT: returns the value corresponding to the bit string
+    const Int16 bitStringtoValue(const std::string& bitStr);
+
+    /// Get the category of a value
+    
+    // INPUT: value: the whose category has to be determined
+    // OUTPUT: returns the category of the specified value
+    const Int16 getValueCategory(const Int16 value);
+
+    // The order of the 64 coefficients of a block
+    enum class CoefficientOrder
+    {
+        ZIGZAG,     // the order of the JPEG stream & the quantization tables
+        NATURAL     // raster order (row = vertical frequency)
+    };
+
+    // Reorder the coefficients of a block from zig-zag to natural order
+
+    // INPUT: block: the 64 coefficients, reordered in place
+    void zigZagToNatural(Int16* block);
+
+    // The implementations of the inverse DCT
+    enum class IDCTMode
+    {
+        FLOAT,              // the floating point reference, straight from the IDCT's definition
+        ACCURATE_INTEGER,   // separable, fixed point with 13 fractional bits (Loeffler-Ligtenberg-Moschytz)
+        FAST_INTEGER        // separable, fixed point with 8 fractional bits (Arai-Agui-Nakajima), least accurate
+    };
+
+    // Get the tables that de-quantize the coefficients for an IDCT implementation,
+    // the quantization tables themselves except for FAST_INTEGER, whose scale
+    // factors are folded into them (as the IJG's "ifast" IDCT does), so that
+    // they're applied once per table rather than once per coefficient
+
+    // INPUT: QTables: the quantization tables, of 8-bit steps in zig-zag order
+    //        tables: receives the de-quantization tables, in zig-zag order
+    //        mode: the implementation the coefficients are de-quantized for
+    void getDequantizationTables(const std::vector<std::vector<UInt16>>& QTables,
+                                 std::vector<std::vector<UInt16>>& tables, const IDCTMode mode);
+
+    // Compute the 2D inverse DCT of an 8x8 block
+
+    // INPUT: coeffs: the 64 coefficients, de-quantized with the tables of
+    //                getDequantizationTables() for the mode, in raster order (row = vertical frequency)
+    //        samples: receives the 64 samples, in raster order, not yet level shifted
+    //        mode: the implementation to use
+    void inverseDCT(const int* coeffs, float* samples, const IDCTMode mode);
+
+    // Compute a reduced 2D inverse DCT of an 8x8 block, a size x size block
+    // of samples from its size x size lowest frequencies only, as when the
+    // block is decoded at 1/2, 1/4 or 1/8 scale (each sample stands for the
+    // average of 8/size x 8/size samples of the full block)
+
+    // INPUT: coeffs: the 64 de-quantized coefficients, in raster order (row = vertical frequency)
+    //        samples: receives the size x size samples, in raster order, not yet level shifted
+    //        size: 4, 2 or 1 (the DC coefficient only)
+    void inverseDCTScaled(const int* coeffs, float* samples, const int size);
+}
+
+#endif // TRANSFORM_HPP
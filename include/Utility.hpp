@@ -1,68 +1,180 @@
-// Common utilities module
-
-#ifndef UTILITY_HPP
-#define UTILITY_HPP
-
-#include <string>
-#include <cctype>
-#include <fstream>
-
-extern std::ofstream logFile;
-
-namespace kpeg
-{
-    namespace utils
-    {
-        // String helpers
-        // Check whether a character is valid in the context of JFIF file names
-        // @param ch character whose validity to test
-        // @return true if character is valid, else false
-        inline const bool isValidChar(const char ch)
-        {
-            return isprint(ch) || ch != '/' || ch != '\\';
-        }
-        // Check whether a file name is valid
-        // @param filename the file name whose validity to check
-        // @return true if the file name is valid, else false
-        inline const bool isValidFilename(const std::string& filename)
-        {
-            // First make sure the filename contains only valid characters
-            for (auto&& c : filename)
-                if (!isValidChar(c))
-                    return false;
-            // Check if the correct extension is present in the file name
-            std::size_t extPos = filename.find(".jpg");
-            
-            if (extPos == std::string::npos)
-                extPos = filename.find(".jpeg");
-            
-            else if (extPos + 4 == filename.size())
-                return true;
-            
-            if (extPos == std::string::npos)
-                return false;
-            
-            return false;
-        }
-        
-        // Check whether a character is a whitespace
-        // @param ch the character to check for whitespace
-        // @return true if character is whitespace, else return false
-        inline const bool isWhiteSpace(const char ch)
-        {
-            return iscntrl(ch) || isblank(ch) || isspace(ch);
-        }
-        // Check whether a string consists entirely of whitespaces
-        // @param str string under test
-        // @return true if the specified string consists entirely of whitespaces, else false
-        inline const bool isStringWhiteSpace( const std::string& str )
-        {
-            for ( auto&& c : str )
-                if ( !isWhiteSpace(c) )
-                    return false;
-            return true;
-        }
-    }
-}
-
-#endif // UTILITY_HPP
+// Common utilities module
+
+#ifndef UTILITY_HPP
+#define UTILITY_HPP
+
+#include <string>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <streambuf>
+
+namespace kpeg
+{
+    namespace utils
+    {
+        // Log helpers
+        // The log of the library, written to a file by the threads that
+        // enable it. Logging is off for every thread until it's enabled, and
+        // nothing is formatted for a thread that didn't enable it, so that
+        // concurrent decoders (e.g., the workers of a decode service) never
+        // touch the log. Each thread formats its lines on its own, and only
+        // writes them whole to the file, which is opened on the first line.
+        class LogStream
+        {
+            public:
+                
+                // @param filename the file the log is written to
+                LogStream( const std::string& filename );
+                
+                // Enable or disable logging for the calling thread only
+                void setEnabled( const bool isEnabled );
+                
+                bool isEnabled() const;
+                
+                // Format a value into the calling thread's line, if it logs
+                template <typename T>
+                LogStream& operator<<( const T& value )
+                {
+                    if ( isEnabled() )
+                        getLine() << value;
+                    
+                    return *this;
+                }
+                
+                // Apply a manipulator to the calling thread's line, if it
+                // logs, std::endl & std::flush write the line to the file
+                LogStream& operator<<( std::ostream& ( *manipulator )( std::ostream& ) );
+                LogStream& operator<<( std::ios_base& ( *manipulator )( std::ios_base& ) );
+                
+            private:
+                
+                // The line being formatted by the calling thread
+                std::ostringstream& getLine();
+                
+            private:
+                
+                std::string m_filename;
+                std::ofstream m_file;
+                std::mutex m_fileMutex;
+        };
+    }
+}
+
+extern kpeg::utils::LogStream logFile;
+
+namespace kpeg
+{
+    namespace utils
+    {
+        // String helpers
+        // Check whether a character is valid in the context of JFIF file names
+        // @param ch character whose validity to test
+        // @return true if character is valid, else false
+        inline const bool isValidChar(const char ch)
+        {
+            return isprint(ch) || ch != '/' || ch != '\\';
+        }
+        // Check whether a file name is valid
+        // @param filename the file name whose validity to check
+        // @return true if the file name is valid, else false
+        inline const bool isValidFilename(const std::string& filename)
+        {
+            // First make sure the filename contains only valid characters
+            for (auto&& c : filename)
+                if (!isValidChar(c))
+                    return false;
+            // Check if the correct extension is present in the file name
+            std::size_t extPos = filename.find(".jpg");
+            
+            if (extPos == std::string::npos)
+                extPos = filename.find(".jpeg");
+            
+            else if (extPos + 4 == filename.size())
+                return true;
+            
+            if (extPos == std::string::npos)
+                return false;
+            
+            return false;
+        }
+        
+        // Check whether a character is a whitespace
+        // @param ch the character to check for whitespace
+        // @return true if character is whitespace, else return false
+        inline const bool isWhiteSpace(const char ch)
+        {
+            return iscntrl(ch) || isblank(ch) || isspace(ch);
+        }
+        // Check whether a string consists entirely of whitespaces
+        // @param str string under test
+        // @return true if the specified string consists entirely of whitespaces, else false
+        inline const bool isStringWhiteSpace( const std::string& str )
+        {
+            for ( auto&& c : str )
+                if ( !isWhiteSpace(c) )
+                    return false;
+            return true;
+        }
+        
+        // Stream helpers
+        // A read-only stream buffer over a block of memory, so that in-memory
+        // JFIF data can be parsed with the same std::istream operations as a file.
+        // The memory is not copied, and must outlive the stream buffer's use.
+        class MemoryBuffer : public std::streambuf
+        {
+            public:
+                
+                // Set the block of memory to read from
+                // @param data the first byte of the block
+                // @param size the number of bytes in the block
+                void setBuffer( const char* data, const std::size_t size )
+                {
+                    char* begin = const_cast<char*>( data );
+                    setg( begin, begin, begin + size );
+                }
+                
+                // Get the block of memory being read, e.g., to reach data
+                // that's located by parsing it without copying it
+                const char* getData() const
+                {
+                    return eback();
+                }
+                
+                std::size_t getSize() const
+                {
+                    return std::size_t( egptr() - eback() );
+                }
+                
+            protected:
+                
+                pos_type seekoff( off_type off, std::ios_base::seekdir dir,
+                                  std::ios_base::openmode which = std::ios_base::in ) override
+                {
+                    char* target = nullptr;
+                    
+                    if ( dir == std::ios_base::beg )
+                        target = eback() + off;
+                    else if ( dir == std::ios_base::cur )
+                        target = gptr() + off;
+                    else
+                        target = egptr() + off;
+                    
+                    if ( !( which & std::ios_base::in ) || target < eback() || target > egptr() )
+                        return pos_type( off_type( -1 ) );
+                    
+                    setg( eback(), target, egptr() );
+                    return pos_type( target - eback() );
+                }
+                
+                pos_type seekpos( pos_type pos,
+                                  std::ios_base::openmode which = std::ios_base::in ) override
+                {
+                    return seekoff( off_type( pos ), std::ios_base::beg, which );
+                }
+        };
+    }
+}
+
+#endif // UTILITY_HPP
@@ -1,79 +1,662 @@
-#include <cmath>
-
-#include "Utility.hpp"
-#include "Decoder.hpp"
-
-
-void printHelp()
-{
-    std::cout << "===========================================" << std::endl;
-    std::cout << "   K-PEG - Simple JPEG Decoder"    << std::endl;
-    std::cout << "===========================================" << std::endl;
-    std::cout << "Help\n" << std::endl;
-    std::cout << "<filename.jpg>                  : Decompress a JPEG image to a PPM image" << std::endl;
-    std::cout << "-h                              : Print this help message and exit" << std::endl;
-}
-
-void decodeJPEG(const std::string& filename)
-{
-    if ( !kpeg::utils::isValidFilename( filename ) )
-    {
-        std::cout << "Invalid input file name passed." << std::endl;
-        return;
-    }
-    
-    std::cout << "Decoding..." << std::endl;
-    
-    kpeg::Decoder decoder;
-    
-    decoder.open( filename );
-    if ( decoder.decodeImageFile() == kpeg::Decoder::ResultCode::DECODE_DONE )
-    {
-        decoder.dumpRawData();
-    }
-    
-    decoder.close();
-
-    std::cout << "Generated file: " << filename.substr(0, filename.length() - 3 ) << ".ppm" << std::endl;
-    std::cout << "Complete! Check log file \'kpeg.log\' for details." << std::endl;
-}
-
-int handleInput(int argc, char** argv)
-{
-    if ( argc < 2 )
-    {
-        std::cout << "No arguments provided." << std::endl;
-        return EXIT_FAILURE;
-    }
-    
-    if ( argc == 2 && (std::string)argv[1] == "-h" )
-    {
-        printHelp();
-        return EXIT_SUCCESS;
-    }
-    else if ( argc == 2 )
-    {
-        decodeJPEG( argv[1] );
-        return EXIT_SUCCESS;
-    }
-    
-    std::cout << "Incorrect usage, use -h to view help" << std::endl;
-    return EXIT_FAILURE;
-}
-
-int main( int argc, char** argv )
-{
-    try
-    {
-        logFile << "lilbKPEG - A simple JPEG library" << std::endl;
-        
-        return handleInput(argc, argv);
-    }
-    catch( std::exception& e )
-    {
-        std::cout << "Exceptions Occurred:-" << std::endl;
-        std::cout << "What: " << e.what() << std::endl;
-    }
-    
-    return EXIT_SUCCESS;
-}
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <unistd.h>
+
+#include "Utility.hpp"
+#include "Decoder.hpp"
+#include "CoefficientImage.hpp"
+#include "ImageStatistics.hpp"
+#include "Server.hpp"
+#include "MJPEG.hpp"
+#include "Encoder.hpp"
+#include "LosslessTransform.hpp"
+
+
+void printHelp()
+{
+    std::cout << "===========================================" << std::endl;
+    std::cout << "   K-PEG - Simple JPEG Decoder"    << std::endl;
+    std::cout << "===========================================" << std::endl;
+    std::cout << "Help\n" << std::endl;
+    std::cout << "<filename.jpg>                  : Decompress a JPEG image to a PPM image" << std::endl;
+    std::cout << "-c <x> <y> <w> <h> <filename.jpg> : Decompress only the specified window of a JPEG image," << std::endl;
+    std::cout << "                                  starting from its scan index <filename>.kix if there's one" << std::endl;
+    std::cout << "-ix [-n <rows>] <filename.jpg>  : Write the scan index <filename>.kix of a baseline JPEG image, with a" << std::endl;
+    std::cout << "                                  checkpoint every <rows> MCU rows (default 1) for decoding windows quickly" << std::endl;
+    std::cout << "-o <filename.jpg>               : Decompress a JPEG image upright, applying its EXIF orientation" << std::endl;
+    std::cout << "-p <filename.jpg>               : Decompress a progressive JPEG image, writing a preview after each scan" << std::endl;
+    std::cout << "-rs <filename.jpg>              : Decompress a JPEG image at 1/1, 1/2, 1/4 & 1/8 scale with one entropy decode," << std::endl;
+    std::cout << "                                  writing <filename>.<n>.ppm for each 1/n scale" << std::endl;
+    std::cout << "-st [-n <samples>] <filename.jpg> : Print the average colour, luminance histogram & perceptual hash of a JPEG" << std::endl;
+    std::cout << "                                  image from <samples>^2 (1, 4 or 16) coefficients per block (default 1, DC only)" << std::endl;
+    std::cout << "--verify <filename.jpg>...      : Check that JPEG images would decode, without decoding them, printing" << std::endl;
+    std::cout << "                                  the first error found in each & its byte offset" << std::endl;
+    std::cout << "-th <filename.jpg>              : Extract the JFIF or EXIF thumbnail of a JPEG image, without decoding the image" << std::endl;
+    std::cout << "-s [-j <workers>] [<socket>]    : Run as a decode service, reading jobs from a Unix domain socket (or stdin)" << std::endl;
+    std::cout << "   [--max-request <bytes>]      : Refuse decode-buffer jobs of more bytes (256 MB by default)" << std::endl;
+    std::cout << "   [--max-pixels <count>]       : Refuse images of more pixels (100 MP by default)" << std::endl;
+    std::cout << "   [--max-queued <bytes>]       : Stop reading jobs while more bytes of them are queued (1 GB by default)" << std::endl;
+    std::cout << "   [--root <dir>]               : Let socket clients read & write files under the directory only" << std::endl;
+    std::cout << "                                  (none by default, when only decode-buffer jobs writing '-' are accepted)" << std::endl;
+    std::cout << "-sc <socket>                    : Send jobs read from stdin to a running decode service" << std::endl;
+    std::cout << "-m [-j <workers>] <stream.mjpeg> [<prefix>] : Decompress a Motion-JPEG stream, writing <prefix>.<frame>.ppm" << std::endl;
+    std::cout << "-e [-q <quality>] [-s 444|422|420] [-r <restart>] <input.ppm> <output.jpg>" << std::endl;
+    std::cout << "                                : Compress a PPM image to a baseline JPEG image" << std::endl;
+    std::cout << "-e [...] -g <w> <h> [-n <entropy>] [-d <seed>] [-b <count>] <output.jpg>" << std::endl;
+    std::cout << "                                : Compress a generated test pattern, or <count> of them as <output>.<n>.jpg" << std::endl;
+    std::cout << "-t <operation> [-c <x> <y> <w> <h>] [-o] <input.jpg> <output.jpg>" << std::endl;
+    std::cout << "                                : Rotate (90|180|270), flip (flip-h|flip-v|transpose|transverse) or crop a JPEG image losslessly," << std::endl;
+    std::cout << "                                  -o optimizes its Huffman tables, '-t none -o' only recompresses the image" << std::endl;
+    std::cout << "-h                              : Print this help message and exit" << std::endl;
+}
+
+void decodeJPEG(const std::string& filename, const bool crop = false,
+                const std::size_t x = 0, const std::size_t y = 0,
+                const std::size_t w = 0, const std::size_t h = 0,
+                const bool isUpright = false)
+{
+    if ( !kpeg::utils::isValidFilename( filename ) )
+    {
+        std::cout << "Invalid input file name passed." << std::endl;
+        return;
+    }
+    
+    std::cout << "Decoding..." << std::endl;
+    
+    kpeg::Decoder decoder;
+    kpeg::ScanIndex index;
+    
+    decoder.open( filename );
+    
+    if ( crop )
+    {
+        decoder.setCropRegion( x, y, w, h );
+        
+        // The scan index written by -ix, if any, skips the rows above the window
+        std::string indexFilename = filename.substr( 0, filename.find_last_of( '.' ) ) + ".kix";
+        
+        if ( std::ifstream( indexFilename ).good() && index.read( indexFilename ) )
+            decoder.setScanIndex( &index );
+    }
+    
+    decoder.setApplyOrientation( isUpright );
+    
+    if ( decoder.decodeImageFile() == kpeg::Decoder::ResultCode::DECODE_DONE )
+    {
+        decoder.dumpRawData();
+    }
+    
+    decoder.close();
+
+    std::cout << "Generated file: " << filename.substr(0, filename.length() - 3 ) << ".ppm" << std::endl;
+    std::cout << "Complete! Check log file \'kpeg.log\' for details." << std::endl;
+}
+
+void decodeProgressiveJPEG(const std::string& filename)
+{
+    if ( !kpeg::utils::isValidFilename( filename ) )
+    {
+        std::cout << "Invalid input file name passed." << std::endl;
+        return;
+    }
+    
+    std::cout << "Decoding..." << std::endl;
+    
+    std::string basename = filename.substr(0, filename.find_last_of('.'));
+    
+    kpeg::Decoder decoder;
+    
+    decoder.open( filename );
+    decoder.setScanCallback( [&]( const kpeg::Image& preview, const int scanNumber )
+    {
+        std::string previewFilename = basename + ".scan" + std::to_string( scanNumber ) + ".ppm";
+        preview.dumpRawData( previewFilename );
+        std::cout << "Generated preview: " << previewFilename << std::endl;
+        return true;
+    });
+    
+    if ( decoder.decodeImageFile() == kpeg::Decoder::ResultCode::DECODE_DONE )
+    {
+        decoder.dumpRawData();
+    }
+    
+    decoder.close();
+    
+    std::cout << "Generated file: " << basename << ".ppm" << std::endl;
+    std::cout << "Complete! Check log file \'kpeg.log\' for details." << std::endl;
+}
+
+int extractThumbnail(const std::string& filename)
+{
+    std::string basename = filename.substr(0, filename.find_last_of('.'));
+    
+    kpeg::Decoder decoder;
+    
+    if ( !decoder.open( filename ) || decoder.findThumbnail() == kpeg::ThumbnailType::NONE )
+    {
+        std::cout << "No thumbnail found in '" << filename << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    kpeg::Image thumbnail;
+    
+    if ( decoder.decodeThumbnail( thumbnail ) )
+    {
+        thumbnail.dumpRawData( basename + ".thumb.ppm" );
+        std::cout << "Generated file: " << basename << ".thumb.ppm" << std::endl;
+        return EXIT_SUCCESS;
+    }
+    
+    // A JPEG thumbnail the decoder doesn't support (e.g., a subsampled
+    // one) is written out as it is
+    std::size_t size = 0;
+    const kpeg::UInt8* data = decoder.getThumbnailData( size );
+    
+    if ( data == nullptr )
+    {
+        std::cout << "Unable to decode the thumbnail of '" << filename << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::ofstream thumbnailFile( basename + ".thumb.jpg", std::ios::out | std::ios::binary );
+    thumbnailFile.write( reinterpret_cast<const char*>( data ), size );
+    
+    std::cout << "Generated file: " << basename << ".thumb.jpg" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int renderScaledJPEG(const std::string& filename)
+{
+    std::string basename = filename.substr(0, filename.find_last_of('.'));
+    
+    kpeg::Decoder decoder;
+    kpeg::CoefficientImage coefficients;
+    
+    bool isDecoded = decoder.open( filename ) &&
+                     coefficients.decode( decoder ) == kpeg::Decoder::ResultCode::DECODE_DONE;
+    
+    decoder.close();
+    
+    if ( !isDecoded )
+    {
+        std::cout << "Unable to decode '" << filename << "', check log file 'kpeg.log' for details." << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    kpeg::Image image;
+    
+    for ( int scale = 1; scale <= 8; scale *= 2 )
+    {
+        std::string scaledFilename = basename + "." + std::to_string( scale ) + ".ppm";
+        
+        if ( coefficients.render( image, scale ) && image.dumpRawData( scaledFilename ) )
+            std::cout << "Generated file: " << scaledFilename << " (" << image.width << "x" << image.height << ")" << std::endl;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+int analyzeJPEG(int argc, char** argv)
+{
+    int samplesPerBlock = 1;
+    std::vector<std::string> paths;
+    
+    for ( int i = 2; i < argc; ++i )
+    {
+        std::string arg = argv[i];
+        
+        if ( arg == "-n" && i + 1 < argc )
+            samplesPerBlock = std::stoi( argv[++i] );
+        else
+            paths.push_back( arg );
+    }
+    
+    if ( paths.size() != 1 )
+    {
+        std::cout << "Incorrect usage, use -h to view help" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    kpeg::Decoder decoder;
+    kpeg::ImageStatistics statistics;
+    
+    bool isAnalyzed = decoder.open( paths[0] ) &&
+                      statistics.analyze( decoder, samplesPerBlock ) == kpeg::Decoder::ResultCode::DECODE_DONE;
+    
+    decoder.close();
+    
+    if ( !isAnalyzed )
+    {
+        std::cout << "Unable to analyze '" << paths[0] << "', check log file 'kpeg.log' for details." << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::cout << "Size: " << statistics.width << "x" << statistics.height << std::endl;
+    std::cout << "Average colour: " << std::fixed << std::setprecision( 1 )
+              << statistics.averageColor[0] << " " << statistics.averageColor[1] << " "
+              << statistics.averageColor[2] << std::defaultfloat << std::endl;
+    std::cout << "Perceptual hash: " << std::hex << std::setw( 16 ) << std::setfill( '0' )
+              << statistics.perceptualHash << std::dec << std::setfill( ' ' ) << std::endl;
+    
+    // The histogram, 16 levels of luminance per line
+    std::cout << "Luminance histogram:" << std::endl;
+    
+    for ( std::size_t level = 0; level < 256; level += 16 )
+    {
+        std::size_t count = 0;
+        
+        for ( std::size_t i = level; i < level + 16; ++i )
+            count += statistics.luminanceHistogram[i];
+        
+        std::cout << std::setw( 5 ) << level << "-" << std::setw( 3 ) << level + 15 << " : " << count << std::endl;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+int verifyJPEGs(int argc, char** argv)
+{
+    if ( argc < 3 )
+    {
+        std::cout << "Incorrect usage, use -h to view help" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    // One decoder checks every image, the tables of one don't apply to the next
+    kpeg::Decoder decoder;
+    int invalidCount = 0;
+    
+    for ( int i = 2; i < argc; ++i )
+    {
+        decoder.reset();
+        
+        kpeg::ValidationResult result = { kpeg::ValidationError::UNREADABLE, 0 };
+        
+        if ( decoder.open( argv[i] ) )
+            result = decoder.validateImageFile();
+        
+        decoder.close();
+        
+        if ( result.error == kpeg::ValidationError::NONE )
+            std::cout << argv[i] << ": OK" << std::endl;
+        else
+        {
+            std::cout << argv[i] << ": " << kpeg::getValidationErrorName( result.error )
+                      << " at byte " << result.offset << std::endl;
+            invalidCount++;
+        }
+    }
+    
+    return invalidCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Logging every MCU would dominate the time of a warm decode, so it's off
+// for the services, whose workers' threads never log anyway
+void disableLogging()
+{
+    logFile.setEnabled( false );
+}
+
+int runDecodeService(int argc, char** argv)
+{
+    std::size_t workerCount = std::max( 1u, std::thread::hardware_concurrency() );
+    std::string socketPath = "";
+    kpeg::ServiceLimits limits;
+    
+    for ( int i = 2; i < argc; ++i )
+    {
+        if ( (std::string)argv[i] == "-j" && i + 1 < argc )
+            workerCount = std::stoul( argv[++i] );
+        else if ( (std::string)argv[i] == "--max-request" && i + 1 < argc )
+            limits.maxRequestSize = std::stoull( argv[++i] );
+        else if ( (std::string)argv[i] == "--max-pixels" && i + 1 < argc )
+            limits.maxPixels = std::stoull( argv[++i] );
+        else if ( (std::string)argv[i] == "--max-queued" && i + 1 < argc )
+            limits.maxQueuedBytes = std::stoull( argv[++i] );
+        else if ( (std::string)argv[i] == "--root" && i + 1 < argc )
+            limits.rootDirectory = argv[++i];
+        else
+            socketPath = argv[i];
+    }
+    
+    disableLogging();
+    
+    kpeg::DecodeServer server( workerCount, limits );
+    
+    if ( socketPath.empty() )
+    {
+        server.serveStream( STDIN_FILENO, STDOUT_FILENO );
+        return EXIT_SUCCESS;
+    }
+    
+    std::cerr << "Decode service listening on \'" << socketPath << "\' with " << workerCount << " workers" << std::endl;
+    
+    return server.serveSocket( socketPath ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int decodeMJPEG(int argc, char** argv)
+{
+    std::size_t workerCount = std::max( 1u, std::thread::hardware_concurrency() );
+    std::vector<std::string> paths;
+    
+    for ( int i = 2; i < argc; ++i )
+    {
+        if ( (std::string)argv[i] == "-j" && i + 1 < argc )
+            workerCount = std::stoul( argv[++i] );
+        else
+            paths.push_back( argv[i] );
+    }
+    
+    if ( paths.empty() || paths.size() > 2 )
+    {
+        std::cout << "Incorrect usage, use -h to view help" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::ifstream streamFile( paths[0], std::ios::in | std::ios::binary );
+    
+    if ( !streamFile.is_open() )
+    {
+        std::cout << "Unable to open stream file: " << paths[0] << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::vector<kpeg::UInt8> stream( ( std::istreambuf_iterator<char>( streamFile ) ),
+                                     std::istreambuf_iterator<char>() );
+    
+    std::string prefix = paths.size() == 2 ? paths[1] : "";
+    std::size_t frameCount = 0;
+    
+    disableLogging();
+    
+    std::cout << "Decoding with " << workerCount << " workers..." << std::endl;
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    kpeg::MJPEGDecoder decoder( workerCount );
+    std::size_t decodedCount = decoder.decodeStream( stream.data(), stream.size(),
+        [&]( const kpeg::Image& frame, const std::size_t frameNumber, const kpeg::Decoder::ResultCode result )
+        {
+            frameCount++;
+            
+            if ( result != kpeg::Decoder::ResultCode::DECODE_DONE )
+                std::cout << "Failed to decode frame " << frameNumber << std::endl;
+            else if ( !prefix.empty() )
+                frame.dumpRawData( prefix + "." + std::to_string( frameNumber ) + ".ppm" );
+        });
+    
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    
+    std::cout << "Decoded " << decodedCount << " of " << frameCount << " frames in "
+              << seconds << " s (" << ( seconds > 0 ? decodedCount / seconds : 0.0 ) << " frames/s)" << std::endl;
+    
+    return decodedCount == frameCount ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int encodeJPEG(int argc, char** argv)
+{
+    kpeg::Encoder::Settings settings;
+    std::vector<std::string> paths;
+    std::size_t width = 0, height = 0, count = 1;
+    int entropy = 50;
+    std::uint32_t seed = 1;
+    
+    for ( int i = 2; i < argc; ++i )
+    {
+        std::string arg = argv[i];
+        
+        if ( arg == "-q" && i + 1 < argc )
+            settings.quality = std::stoi( argv[++i] );
+        else if ( arg == "-s" && i + 1 < argc )
+        {
+            std::string sampling = argv[++i];
+            settings.sampling = sampling == "420" ? kpeg::Encoder::YUV420 :
+                                sampling == "422" ? kpeg::Encoder::YUV422 : kpeg::Encoder::YUV444;
+        }
+        else if ( arg == "-r" && i + 1 < argc )
+            settings.restartInterval = std::stoul( argv[++i] );
+        else if ( arg == "-g" && i + 2 < argc )
+        {
+            width = std::stoul( argv[++i] );
+            height = std::stoul( argv[++i] );
+        }
+        else if ( arg == "-n" && i + 1 < argc )
+            entropy = std::stoi( argv[++i] );
+        else if ( arg == "-d" && i + 1 < argc )
+            seed = std::stoul( argv[++i] );
+        else if ( arg == "-b" && i + 1 < argc )
+            count = std::max( 1ul, std::stoul( argv[++i] ) );
+        else
+            paths.push_back( arg );
+    }
+    
+    bool isPattern = width > 0 && height > 0;
+    
+    if ( paths.size() != ( isPattern ? 1u : 2u ) )
+    {
+        std::cout << "Incorrect usage, use -h to view help" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    kpeg::Encoder encoder( settings );
+    
+    if ( !isPattern )
+    {
+        kpeg::PPMSource source( paths[0] );
+        
+        if ( !source.isValid() || !encoder.encode( source, paths[1] ) )
+        {
+            std::cout << "Unable to encode '" << paths[0] << "', check log file 'kpeg.log' for details." << std::endl;
+            return EXIT_FAILURE;
+        }
+        
+        std::cout << "Generated file: " << paths[1] << std::endl;
+        return EXIT_SUCCESS;
+    }
+    
+    // A batch of patterns gets consecutive seeds, so every image differs
+    std::string output = paths[0];
+    std::string basename = output.substr( 0, output.find_last_of( '.' ) );
+    
+    disableLogging();
+    
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        std::string filename = count == 1 ? output : basename + "." + std::to_string( i ) + ".jpg";
+        kpeg::PatternSource source( width, height, entropy, seed + std::uint32_t( i ) );
+        
+        if ( !encoder.encode( source, filename ) )
+        {
+            std::cout << "Unable to encode '" << filename << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    
+    std::cout << "Generated " << count << ( count == 1 ? " file: " + output : " files: " + basename + ".<n>.jpg" ) << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int transformJPEG(int argc, char** argv)
+{
+    kpeg::LosslessTransformer transformer;
+    std::vector<std::string> paths;
+    kpeg::LosslessOperation operation = kpeg::LosslessOperation::NONE;
+    bool isValid = argc > 2 && kpeg::parseLosslessOperation( argv[2], operation );
+    
+    for ( int i = 3; i < argc; ++i )
+    {
+        std::string arg = argv[i];
+        
+        if ( arg == "-c" && i + 4 < argc )
+        {
+            std::size_t x = std::stoul( argv[++i] );
+            std::size_t y = std::stoul( argv[++i] );
+            std::size_t w = std::stoul( argv[++i] );
+            std::size_t h = std::stoul( argv[++i] );
+            
+            transformer.setCropRegion( x, y, w, h );
+        }
+        else if ( arg == "-o" )
+            transformer.setOptimizeHuffmanTables( true );
+        else
+            paths.push_back( arg );
+    }
+    
+    if ( !isValid || paths.size() != 2 )
+    {
+        std::cout << "Incorrect usage, use -h to view help" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    if ( !transformer.transform( paths[0], paths[1], operation ) )
+    {
+        std::cout << "Unable to transform '" << paths[0] << "', check log file 'kpeg.log' for details." << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::cout << "Generated file: " << paths[1] << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int indexJPEG(int argc, char** argv)
+{
+    std::size_t rowInterval = 1;
+    std::vector<std::string> paths;
+    
+    for ( int i = 2; i < argc; ++i )
+    {
+        std::string arg = argv[i];
+        
+        if ( arg == "-n" && i + 1 < argc )
+            rowInterval = std::max( 1ul, std::stoul( argv[++i] ) );
+        else
+            paths.push_back( arg );
+    }
+    
+    if ( paths.size() != 1 )
+    {
+        std::cout << "Incorrect usage, use -h to view help" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::string indexFilename = paths[0].substr( 0, paths[0].find_last_of( '.' ) ) + ".kix";
+    
+    kpeg::Decoder decoder;
+    kpeg::ScanIndex index;
+    
+    bool isIndexed = decoder.open( paths[0] ) &&
+                     decoder.buildScanIndex( index, rowInterval ) == kpeg::Decoder::ResultCode::DECODE_DONE;
+    
+    decoder.close();
+    
+    if ( !isIndexed || !index.write( indexFilename ) )
+    {
+        std::cout << "Unable to index '" << paths[0] << "', check log file 'kpeg.log' for details." << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::cout << "Generated file: " << indexFilename << " (" << index.checkpoints.size() << " checkpoints)" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int handleInput(int argc, char** argv)
+{
+    if ( argc < 2 )
+    {
+        std::cout << "No arguments provided." << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    if ( argc == 2 && (std::string)argv[1] == "-h" )
+    {
+        printHelp();
+        return EXIT_SUCCESS;
+    }
+    else if ( argc == 2 )
+    {
+        decodeJPEG( argv[1] );
+        return EXIT_SUCCESS;
+    }
+    else if ( (std::string)argv[1] == "-s" )
+    {
+        return runDecodeService( argc, argv );
+    }
+    else if ( (std::string)argv[1] == "-e" )
+    {
+        return encodeJPEG( argc, argv );
+    }
+    else if ( (std::string)argv[1] == "-t" )
+    {
+        return transformJPEG( argc, argv );
+    }
+    else if ( (std::string)argv[1] == "-ix" )
+    {
+        return indexJPEG( argc, argv );
+    }
+    else if ( (std::string)argv[1] == "--verify" )
+    {
+        return verifyJPEGs( argc, argv );
+    }
+    else if ( (std::string)argv[1] == "-st" )
+    {
+        return analyzeJPEG( argc, argv );
+    }
+    else if ( (std::string)argv[1] == "-m" )
+    {
+        return decodeMJPEG( argc, argv );
+    }
+    else if ( argc == 3 && (std::string)argv[1] == "-sc" )
+    {
+        return kpeg::runDecodeClient( argv[2] ) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if ( argc == 3 && (std::string)argv[1] == "-o" )
+    {
+        decodeJPEG( argv[2], false, 0, 0, 0, 0, true );
+        return EXIT_SUCCESS;
+    }
+    else if ( argc == 3 && (std::string)argv[1] == "-th" )
+    {
+        return extractThumbnail( argv[2] );
+    }
+    else if ( argc == 3 && (std::string)argv[1] == "-rs" )
+    {
+        return renderScaledJPEG( argv[2] );
+    }
+    else if ( argc == 3 && (std::string)argv[1] == "-p" )
+    {
+        decodeProgressiveJPEG( argv[2] );
+        return EXIT_SUCCESS;
+    }
+    else if ( argc == 7 && (std::string)argv[1] == "-c" )
+    {
+        decodeJPEG( argv[6], true,
+                    std::stoul( argv[2] ), std::stoul( argv[3] ),
+                    std::stoul( argv[4] ), std::stoul( argv[5] ) );
+        return EXIT_SUCCESS;
+    }
+    
+    std::cout << "Incorrect usage, use -h to view help" << std::endl;
+    return EXIT_FAILURE;
+}
+
+int main( int argc, char** argv )
+{
+    try
+    {
+        // The decodes of the command line log from its thread
+        logFile.setEnabled( true );
+        logFile << "lilbKPEG - A simple JPEG library" << std::endl;
+        
+        return handleInput(argc, argv);
+    }
+    catch( std::exception& e )
+    {
+        std::cout << "Exceptions Occurred:-" << std::endl;
+        std::cout << "What: " << e.what() << std::endl;
+    }
+    
+    return EXIT_SUCCESS;
+}
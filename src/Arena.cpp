@@ -0,0 +1,127 @@
+// Implementation of the arena module
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Arena.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    const std::size_t Arena::DEFAULT_BLOCK_SIZE;
+
+    Arena::Arena(const std::size_t blockSize) :
+        m_current{0},
+        m_offset{0},
+        m_usedSize{0},
+        m_blockSize{std::max<std::size_t>(blockSize, 1)}
+    {
+    }
+
+    Arena::~Arena()
+    {
+        for (auto&& block : m_blocks)
+        {
+            if (block.isOwned)
+                delete[] block.data;
+        }
+    }
+
+    void Arena::setRegion(void* region, const std::size_t size)
+    {
+        if (!m_blocks.empty() && !m_blocks.front().isOwned)
+            m_blocks.erase(m_blocks.begin());
+
+        if (region != nullptr && size > 0)
+            m_blocks.insert(m_blocks.begin(), { static_cast<UInt8*>(region), size, false });
+
+        m_current = 0;
+        m_offset = 0;
+        m_usedSize = 0;
+
+        logFile << "Arena region set to " << std::dec << size << " bytes" << std::endl;
+    }
+
+    void* Arena::allocate(const std::size_t size, const std::size_t alignment)
+    {
+        // Try the current block, then the blocks left over from before the last reset
+        for ( ; m_current < m_blocks.size(); ++m_current, m_offset = 0)
+        {
+            const Block& block = m_blocks[m_current];
+
+            std::uintptr_t address = reinterpret_cast<std::uintptr_t>(block.data) + m_offset;
+            std::size_t padding = (alignment - address % alignment) % alignment;
+
+            if (m_offset + padding + size <= block.size)
+            {
+                m_offset += padding + size;
+                m_usedSize += padding + size;
+                return block.data + m_offset - size;
+            }
+        }
+
+        // Take a new block from the heap, large enough for an oversized allocation
+        std::size_t blockSize = std::max(m_blockSize, size + alignment);
+        m_blocks.push_back({ new UInt8[blockSize], blockSize, true });
+
+        logFile << "Arena took a block of " << std::dec << blockSize << " bytes from the heap" << std::endl;
+
+        return allocate(size, alignment);
+    }
+
+    void Arena::reset()
+    {
+        // Merge the heap blocks, so that as much memory fits in a single block
+        // the next time, instead of being split by block boundaries
+        std::size_t ownedCount = 0;
+        std::size_t ownedSize = 0;
+
+        for (auto&& block : m_blocks)
+        {
+            if (block.isOwned)
+            {
+                ownedCount++;
+                ownedSize += block.size;
+            }
+        }
+
+        if (ownedCount > 1)
+        {
+            for (auto&& block : m_blocks)
+            {
+                if (block.isOwned)
+                    delete[] block.data;
+            }
+
+            auto firstOwned = std::remove_if(m_blocks.begin(), m_blocks.end(), [](const Block& block)
+            {
+                return block.isOwned;
+            });
+
+            m_blocks.erase(firstOwned, m_blocks.end());
+            m_blocks.push_back({ new UInt8[ownedSize], ownedSize, true });
+
+            logFile << "Arena merged " << std::dec << ownedCount << " heap blocks into one of "
+                    << ownedSize << " bytes" << std::endl;
+        }
+
+        m_current = 0;
+        m_offset = 0;
+        m_usedSize = 0;
+    }
+
+    std::size_t Arena::getUsedSize() const
+    {
+        return m_usedSize;
+    }
+
+    std::size_t Arena::getCapacity() const
+    {
+        std::size_t capacity = 0;
+
+        for (auto&& block : m_blocks)
+            capacity += block.size;
+
+        return capacity;
+    }
+}
@@ -0,0 +1,109 @@
+// Implementation of the buffer pool module
+
+#include <algorithm>
+
+#include "BufferPool.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    const std::size_t BufferPool::CLASS_SIZE;
+
+    void resizePixelBuffer(std::vector<std::vector<Pixel>>& pixels,
+                           const std::size_t width, const std::size_t height,
+                           const std::size_t rowCapacity)
+    {
+        // Rows beyond the height are dropped, so only shrink the buffer when
+        // the image is smaller, and keep the memory of the rows otherwise
+        pixels.resize(height);
+
+        for (auto&& row : pixels)
+        {
+            if (row.capacity() < width)
+                row.reserve(std::max(width, rowCapacity));
+
+            row.resize(width);
+        }
+    }
+
+    BufferPool::BufferPool(const std::size_t maxFreeBuffers) :
+        m_state{std::make_shared<State>()}
+    {
+        m_state->maxFreeBuffers = maxFreeBuffers;
+        m_state->createdCount = 0;
+    }
+
+    PixelPtr BufferPool::acquire(const std::size_t width, const std::size_t height)
+    {
+        ResolutionClass resolution((width + CLASS_SIZE - 1) / CLASS_SIZE,
+                                   (height + CLASS_SIZE - 1) / CLASS_SIZE);
+
+        std::unique_ptr<PixelArray> pixels;
+
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+
+            auto& freeBuffers = m_state->freeBuffers[resolution];
+
+            if (!freeBuffers.empty())
+            {
+                pixels = std::move(freeBuffers.back());
+                freeBuffers.pop_back();
+            }
+            else
+                m_state->createdCount++;
+        }
+
+        // A new buffer is reserved for the largest image of its class
+        if (!pixels)
+        {
+            pixels.reset(new PixelArray());
+            pixels->reserve(resolution.second * CLASS_SIZE);
+
+            logFile << "Created pixel buffer for resolution class "
+                    << std::dec << resolution.first * CLASS_SIZE << "x" << resolution.second * CLASS_SIZE << std::endl;
+        }
+
+        resizePixelBuffer(*pixels, width, height, resolution.first * CLASS_SIZE);
+
+        std::weak_ptr<State> state = m_state;
+
+        return PixelPtr(pixels.release(), [state, resolution](PixelArray* released)
+        {
+            release(state, resolution, released);
+        });
+    }
+
+    std::size_t BufferPool::getCreatedCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->createdCount;
+    }
+
+    std::size_t BufferPool::getFreeCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        std::size_t count = 0;
+
+        for (auto&& freeBuffers : m_state->freeBuffers)
+            count += freeBuffers.second.size();
+
+        return count;
+    }
+
+    void BufferPool::release(const std::weak_ptr<State>& state, const ResolutionClass resolution, PixelArray* pixels)
+    {
+        std::unique_ptr<PixelArray> buffer(pixels);
+
+        if (std::shared_ptr<State> pool = state.lock())
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+
+            auto& freeBuffers = pool->freeBuffers[resolution];
+
+            if (freeBuffers.size() < pool->maxFreeBuffers)
+                freeBuffers.push_back(std::move(buffer));
+        }
+    }
+}
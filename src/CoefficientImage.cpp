@@ -0,0 +1,279 @@
+// Implementation of the coefficient image module
+
+#include <algorithm>
+#include <cmath>
+
+#include "CoefficientImage.hpp"
+#include "MCU.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        // Level shift & convert a sample of a reduced IDCT to RGB, as
+        // MCU::performLevelShift() & MCU::convertYCbCrToRGB() do
+        void convertToRGB(const float samples[3], int RGB[3])
+        {
+            float Y = std::round(samples[0]) + 128;
+            float Cb = std::round(samples[1]) + 128;
+            float Cr = std::round(samples[2]) + 128;
+
+            RGB[0] = (int)std::floor(Y + 1.402 * (1.0 * Cr - 128.0));
+            RGB[1] = (int)std::floor(Y - 0.344136 * (1.0 * Cb - 128.0) - 0.714136 * (1.0 * Cr - 128.0));
+            RGB[2] = (int)std::floor(Y + 1.772 * (1.0 * Cb - 128.0));
+
+            for (auto c = 0; c < 3; ++c)
+                RGB[c] = std::max(0, std::min(RGB[c], 255));
+        }
+    }
+
+    CoefficientImage::CoefficientImage() :
+        width{0},
+        height{0},
+        m_blocksPerLine{0},
+        m_IDCTMode{IDCTMode::FLOAT}
+    {
+    }
+
+    Decoder::ResultCode CoefficientImage::decode(Decoder& decoder)
+    {
+        width = 0;
+        height = 0;
+        m_QTables.clear();
+        m_dequantizationTables.clear();
+
+        for (auto compID = 0; compID < 3; ++compID)
+        {
+            m_counts[compID].clear();
+            m_rowOffsets[compID].clear();
+            m_coefficients[compID].clear();
+        }
+
+        // The blocks of each component are handed out in raster order, by
+        // both baseline & progressive images
+        decoder.setBlockCallback([this, &decoder](const int component, const std::size_t blockIndex, const Int16* coeffs)
+        {
+            if (component < 0 || component > 2 || blockIndex != m_counts[component].size())
+                return false;
+
+            int count = 64;
+
+            while (count > 0 && coeffs[count - 1] == 0)
+                count--;
+
+            if (blockIndex % decoder.getBlocksPerLine() == 0)
+                m_rowOffsets[component].push_back(std::uint32_t(m_coefficients[component].size()));
+
+            m_counts[component].push_back(UInt8(count));
+            m_coefficients[component].insert(m_coefficients[component].end(), coeffs, coeffs + count);
+
+            return true;
+        });
+
+        Decoder::ResultCode status = decoder.decodeCoefficients(CoefficientOrder::ZIGZAG);
+
+        decoder.setBlockCallback(nullptr);
+
+        const std::size_t blockCount = decoder.getBlocksPerLine() * decoder.getBlockRows();
+
+        if (status == Decoder::ResultCode::DECODE_DONE &&
+            (m_counts[0].size() != blockCount || m_counts[1].size() != blockCount || m_counts[2].size() != blockCount))
+        {
+            logFile << "[ FATAL ] The coefficients of some blocks are missing" << std::endl;
+            status = Decoder::ResultCode::ERROR;
+        }
+
+        if (status != Decoder::ResultCode::DECODE_DONE)
+        {
+            for (auto compID = 0; compID < 3; ++compID)
+                m_counts[compID].clear();
+
+            return status;
+        }
+
+        width = decoder.getFrameWidth();
+        height = decoder.getFrameHeight();
+        m_blocksPerLine = decoder.getBlocksPerLine();
+
+        for (auto table = 0; table < 2; ++table)
+        {
+            std::array<UInt16, 64> QTable = decoder.getQuantizationTable(table);
+            m_QTables.emplace_back(QTable.begin(), QTable.end());
+        }
+
+        getDequantizationTables(m_QTables, m_dequantizationTables, m_IDCTMode);
+
+        logFile << "Kept the coefficients of " << std::dec << blockCount << " blocks in "
+                << getMemorySize() << " bytes" << std::endl;
+
+        return status;
+    }
+
+    void CoefficientImage::setIDCTMode(const IDCTMode mode)
+    {
+        m_IDCTMode = mode;
+        getDequantizationTables(m_QTables, m_dequantizationTables, m_IDCTMode);
+    }
+
+    bool CoefficientImage::render(Image& image, const int scale,
+                                  const std::size_t x, const std::size_t y,
+                                  const std::size_t width, const std::size_t height) const
+    {
+        if (isEmpty() || (scale != 1 && scale != 2 && scale != 4 && scale != 8) ||
+            x >= this->width || y >= this->height)
+        {
+            logFile << "[ FATAL ] Unable to render the coefficients at 1/" << scale << " scale" << std::endl;
+            return false;
+        }
+
+        const std::size_t windowWidth = width == 0 ? this->width - x : std::min(width, this->width - x);
+        const std::size_t windowHeight = height == 0 ? this->height - y : std::min(height, this->height - y);
+
+        // The window & the blocks, in scaled pixels
+        const std::size_t size = 8 / scale;
+        const std::size_t left = x / scale;
+        const std::size_t top = y / scale;
+        const std::size_t right = (x + windowWidth + scale - 1) / scale;
+        const std::size_t bottom = (y + windowHeight + scale - 1) / scale;
+        const std::size_t outputWidth = right - left;
+
+        logFile << "Rendering " << std::dec << outputWidth << "x" << bottom - top
+                << " image from coefficients at 1/" << scale << " scale..." << std::endl;
+
+        std::vector<UInt8> RGB(outputWidth * (bottom - top) * 3);
+
+        MCU::m_IDCTMode = m_IDCTMode;
+
+        MCU block;
+        int pixels[3][8][8];
+
+        for (std::size_t blockY = top / size; blockY * size < bottom; ++blockY)
+        {
+            const std::size_t firstBlock = blockY * m_blocksPerLine;
+
+            // The coefficients of the first block of the window in the row
+            const Int16* zigZag[3];
+
+            for (auto compID = 0; compID < 3; ++compID)
+            {
+                zigZag[compID] = m_coefficients[compID].data() + m_rowOffsets[compID][blockY];
+
+                for (std::size_t blockX = 0; blockX < left / size; ++blockX)
+                    zigZag[compID] += m_counts[compID][firstBlock + blockX];
+            }
+
+            for (std::size_t blockX = left / size; blockX * size < right; ++blockX)
+            {
+                int counts[3];
+
+                for (auto compID = 0; compID < 3; ++compID)
+                    counts[compID] = m_counts[compID][firstBlock + blockX];
+
+                if (scale == 1)
+                {
+                    // The pixels the decoder would reconstruct
+                    Int16 blocks[3][64];
+
+                    for (auto compID = 0; compID < 3; ++compID)
+                        std::fill(std::copy(zigZag[compID], zigZag[compID] + counts[compID], blocks[compID]), blocks[compID] + 64, 0);
+
+                    block.constructMCU({ { blocks[0], blocks[1], blocks[2] } }, m_dequantizationTables);
+
+                    const CompMatrices& samples = block.getAllMatrices();
+
+                    for (auto c = 0; c < 3; ++c)
+                    {
+                        for (auto v = 0; v < 8; ++v)
+                            std::copy(samples[c][v].begin(), samples[c][v].end(), pixels[c][v]);
+                    }
+                }
+                else
+                {
+                    int coeffs[64];
+                    float samples[3][16];
+
+                    for (auto compID = 0; compID < 3; ++compID)
+                    {
+                        dequantizeBlock(compID, zigZag[compID], counts[compID], coeffs);
+                        inverseDCTScaled(coeffs, samples[compID], int(size));
+                    }
+
+                    for (std::size_t i = 0; i < size * size; ++i)
+                    {
+                        const float sample[3] = { samples[0][i], samples[1][i], samples[2][i] };
+                        int pixel[3];
+
+                        convertToRGB(sample, pixel);
+
+                        for (auto c = 0; c < 3; ++c)
+                            pixels[c][i / size][i % size] = pixel[c];
+                    }
+                }
+
+                for (auto compID = 0; compID < 3; ++compID)
+                    zigZag[compID] += counts[compID];
+
+                // The samples of the block inside the window
+                for (std::size_t v = 0; v < size; ++v)
+                {
+                    const std::size_t outputY = blockY * size + v;
+
+                    if (outputY < top || outputY >= bottom)
+                        continue;
+
+                    for (std::size_t u = 0; u < size; ++u)
+                    {
+                        const std::size_t outputX = blockX * size + u;
+
+                        if (outputX < left || outputX >= right)
+                            continue;
+
+                        UInt8* pixel = &RGB[((outputY - top) * outputWidth + outputX - left) * 3];
+
+                        for (auto c = 0; c < 3; ++c)
+                            pixel[c] = UInt8(pixels[c][v][u]);
+                    }
+                }
+            }
+        }
+
+        image.createImageFromRGB(RGB.data(), outputWidth, bottom - top);
+
+        logFile << "Finished rendering image from coefficients [OK]" << std::endl;
+
+        return true;
+    }
+
+    bool CoefficientImage::isEmpty() const
+    {
+        return m_counts[0].empty();
+    }
+
+    std::size_t CoefficientImage::getMemorySize() const
+    {
+        std::size_t size = 0;
+
+        for (auto compID = 0; compID < 3; ++compID)
+        {
+            size += m_counts[compID].size() * sizeof(UInt8) +
+                    m_rowOffsets[compID].size() * sizeof(std::uint32_t) +
+                    m_coefficients[compID].size() * sizeof(Int16);
+        }
+
+        return size;
+    }
+
+    void CoefficientImage::dequantizeBlock(const int compID, const Int16* zigZag, const int count, int* coeffs) const
+    {
+        const std::vector<UInt16>& QTable = m_QTables[compID == 0 ? 0 : 1];
+
+        std::fill(coeffs, coeffs + 64, 0);
+
+        for (auto i = 0; i < count; ++i)
+        {
+            auto coords = zzOrderToMatIndices(i);
+            coeffs[coords.first * 8 + coords.second] = zigZag[i] * QTable[i];
+        }
+    }
+}
@@ -1,769 +1,2578 @@
-// Implementation of the decoder
-
-#include <arpa/inet.h> // htons
-#include <iomanip>
-#include <sstream>
-
-#include "Decoder.hpp"
-#include "Markers.hpp"
-#include "Utility.hpp"
-
-namespace kpeg
-{
-    Decoder::Decoder()
-    {
-        logFile << "Created \'Decoder object\'." << std::endl;
-    }
-            
-    Decoder::Decoder(const std::string& filename)
-    {
-        logFile << "Created \'Decoder object\'." << std::endl;
-    }
-    
-    Decoder::~Decoder()
-    {
-        close();
-        logFile << "Destroyed \'Decoder object\'." << std::endl;
-    }
-    
-    bool Decoder::open(const std::string& filename)
-    {
-        m_imageFile.open(filename, std::ios::in | std::ios::binary);
-        
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable to open image: \'" + filename + "\'" << std::endl;
-            return false;
-        }
-        
-        logFile << "Opened JPEG image: \'" + filename + "\'" << std::endl;
-        
-        m_filename = filename;
-        
-        return true;
-    }
-    
-    void Decoder::close()
-    {
-        m_imageFile.close();
-        logFile << "Closed image file: \'" + m_filename + "\'" << std::endl;
-    }
-    
-    Decoder::ResultCode Decoder::parseSegmentInfo(const UInt8 byte)
-    {
-        if (byte == JFIF_BYTE_0 || byte == JFIF_BYTE_FF)
-            return ERROR;
-        
-        switch(byte)
-        {
-            case JFIF_SOI  : logFile  << "Found segment, Start of Image (FFD8)" << std::endl; return ResultCode::SUCCESS;
-            case JFIF_APP0 : logFile  << "Found segment, JPEG/JFIF Image Marker segment (APP0)" << std::endl; parseAPP0Segment(); return ResultCode::SUCCESS;
-            case JFIF_COM  : logFile  << "Found segment, Comment(FFFE)" << std::endl; parseCOMSegment(); return ResultCode::SUCCESS;
-            case JFIF_DQT  : logFile  << "Found segment, Define Quantization Table (FFDB)" << std::endl; parseDQTSegment(); return ResultCode::SUCCESS;
-            case JFIF_SOF0 : logFile  << "Found segment, Start of Frame 0: Baseline DCT (FFC0)" << std::endl; return parseSOF0Segment();
-            case JFIF_SOF1 : logFile << "Found segment, Start of Frame 1: Extended Sequential DCT (FFC1), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF2 : logFile << "Found segment, Start of Frame 2: Progressive DCT (FFC2), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF3 : logFile << "Found segment, Start of Frame 3: Lossless Sequential (FFC3), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF5 : logFile << "Found segment, Start of Frame 5: Differential Sequential DCT (FFC5), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF6 : logFile << "Found segment, Start of Frame 6: Differential Progressive DCT (FFC6), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF7 : logFile << "Found segment, Start of Frame 7: Differential lossless (Sequential) (FFC7), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF9 : logFile << "Found segment, Start of Frame 9: Extended Sequential DCT, Arithmetic Coding (FFC9), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF10: logFile << "Found segment, Start of Frame 10: Progressive DCT, Arithmetic Coding (FFCA), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF11: logFile << "Found segment, Start of Frame 11: Lossless (Sequential), Arithmetic Coding (FFCB), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF13: logFile << "Found segment, Start of Frame 13: Differentical Sequential DCT, Arithmetic Coding (FFCD), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF14: logFile << "Found segment, Start of Frame 14: Differentical Progressive DCT, Arithmetic Coding (FFCE), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_SOF15: logFile << "Found segment, Start of Frame 15: Differentical Lossless (Sequential), Arithmetic Coding (FFCF), Not supported" << std::endl; return ResultCode::TERMINATE;
-            case JFIF_DHT  : logFile  << "Found segment, Define Huffman Table (FFC4)" << std::endl; parseDHTSegment(); return ResultCode::SUCCESS;
-            case JFIF_SOS  : logFile  << "Found segment, Start of Scan (FFDA)" << std::endl; parseSOSSegment(); return ResultCode::SUCCESS;
-        }
-        
-        return ResultCode::SUCCESS;
-    }
-    
-    bool Decoder::dumpRawData()
-    {
-        std::size_t extPos = m_filename.find(".jpg");
-        
-        if (extPos == std::string::npos)
-            extPos = m_filename.find(".jpeg");
-        
-        std::string targetFilename = m_filename.substr(0, extPos) + ".ppm";
-        m_image.dumpRawData(targetFilename);
-        
-        return true;
-    }
-    
-    Decoder::ResultCode Decoder::decodeImageFile()
-    {
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
-            return ResultCode::ERROR;
-        }
-        
-        logFile << "Started decoding process..." << std::endl;
-        
-        UInt8 byte;
-        ResultCode status = ResultCode::DECODE_DONE;
-        
-        while (m_imageFile >> std::noskipws >> byte)
-        {
-            if (byte == JFIF_BYTE_FF)
-            {
-                m_imageFile >> std::noskipws >> byte;
-                
-                ResultCode code = parseSegmentInfo(byte);
-                
-                if (code == ResultCode::SUCCESS)
-                    continue;
-                else if (code == ResultCode::TERMINATE)
-                {
-                    status = ResultCode::TERMINATE;
-                    break;
-                }
-                else if (code == ResultCode::DECODE_INCOMPLETE)
-                {
-                    status = ResultCode::DECODE_INCOMPLETE;
-                    break;
-                }
-            }
-            else
-            {
-                logFile << "[ FATAL ] Invalid JFIF file! Terminating..." << std::endl;
-                status = ResultCode::ERROR;
-                break;
-            }
-        }
-        
-        if (status == ResultCode::DECODE_DONE)
-        {
-            decodeScanData();
-            m_image.createImageFromMCUs(m_MCU);
-            logFile << "Finished decoding process [OK]." << std::endl;
-        }
-        else if (status == ResultCode::TERMINATE)
-        {
-            logFile << "Terminated decoding process [NOT-OK]." << std::endl;
-        }
-        
-        else if (status == ResultCode::DECODE_INCOMPLETE)
-        {
-            logFile << "Decoding process incomplete [NOT-OK]." << std::endl;
-        }
-        
-        return status;
-    }
-    
-    void Decoder::parseAPP0Segment()
-    {
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
-            return;
-        }
-        
-        logFile << "Parsing JPEG/JFIF marker segment (APP-0)..." << std::endl;
-        
-        UInt16 lenByte = 0;
-        UInt8 byte = 0;
-        
-        m_imageFile.read(reinterpret_cast<char *>(&lenByte), 2);
-        lenByte = htons(lenByte);
-        std::size_t curPos = m_imageFile.tellg();
-        
-        logFile << "JFIF Application marker segment length: " << lenByte << std::endl;
-        
-        // Skip the 'JFIF\0' bytes
-        m_imageFile.seekg(5, std::ios_base::cur);
-        
-        UInt8 majVersionByte, minVersionByte;
-        m_imageFile >> std::noskipws >> majVersionByte >> minVersionByte;
-        
-        logFile << "JFIF version: " << (int)majVersionByte << "." << (int)(minVersionByte >> 4) << (int)(minVersionByte & 0x0F) << std::endl;
-        
-        std::string majorVersion = std::to_string(majVersionByte);
-        std::string minorVersion = std::to_string((int)(minVersionByte >> 4));
-        minorVersion +=  std::to_string((int)(minVersionByte & 0x0F));
-        
-        UInt8 densityByte;
-        m_imageFile >> std::noskipws >> densityByte;
-        
-        std::string densityUnit = "";
-        switch(densityByte)
-        {
-            case 0x00: densityUnit = "Pixel Aspect Ratio"; break;
-            case 0x01: densityUnit = "Pixels per inch (DPI)"; break;
-            case 0x02: densityUnit = "Pixels per centimeter"; break;
-        }
-        
-        logFile << "Image density unit: " << densityUnit << std::endl;
-        
-        UInt16 xDensity = 0, yDensity = 0;
-        
-        m_imageFile.read(reinterpret_cast<char *>(&xDensity), 2);
-        m_imageFile.read(reinterpret_cast<char *>(&yDensity), 2);
-        
-        xDensity = htons(xDensity);
-        yDensity = htons(yDensity);
-        
-        logFile << "Horizontal image density: " << xDensity << std::endl;
-        logFile << "Vertical image density: " << yDensity << std::endl;
-        
-        // Ignore the image thumbnail data
-        UInt8 xThumb = 0, yThumb = 0;
-        m_imageFile >> std::noskipws >> xThumb >> yThumb;        
-        m_imageFile.seekg(3 * xThumb * yThumb, std::ios_base::cur);
-        
-        logFile << "Finished parsing JPEG/JFIF marker segment (APP-0) [OK]" << std::endl;
-    }
-    
-    void Decoder::parseDQTSegment()
-    {
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
-            return;
-        }
-        
-        logFile << "Parsing quantization table segment..." << std::endl;
-        
-        UInt16 lenByte = 0;
-        UInt8 PqTq;
-        UInt8 Qi;
-        
-        m_imageFile.read(reinterpret_cast<char *>(&lenByte), 2);
-        lenByte = htons(lenByte);
-        logFile << "Quantization table segment length: " << (int)lenByte << std::endl;
-        
-        lenByte -= 2;
-        
-        for (int qt = 0; qt < int(lenByte) / 65; ++qt)
-        {
-            m_imageFile >> std::noskipws >> PqTq;
-            
-            int precision = PqTq >> 4; // Precision is always 8-bit for baseline DCT
-            int QTtable = PqTq & 0x0F; // Quantization table number (0-3)
-            
-            logFile << "Quantization Table Number: " << QTtable << std::endl;
-            logFile << "Quantization Table #" << QTtable << " precision: " << (precision == 0 ? "8-bit" : "16-bit") << std::endl;
-            
-            m_QTables.push_back({});
-            
-            // Populate quantization table #QTtable            
-            for (auto i = 0; i < 64; ++i)
-            {
-                m_imageFile >> std::noskipws >> Qi;
-                m_QTables[QTtable].push_back((UInt16)Qi);
-            }
-        }
-        
-        logFile << "Finished parsing quantization table segment [OK]" << std::endl;
-    }
-    
-    Decoder::ResultCode Decoder::parseSOF0Segment()
-    {
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
-            return ResultCode::ERROR;
-        }
-        
-        logFile << "Parsing SOF-0 segment..." << std::endl;
-        
-        UInt16 lenByte, imgHeight, imgWidth;
-        UInt8 precision, compCount;
-        
-        m_imageFile.read(reinterpret_cast<char *>(&lenByte), 2);
-        lenByte = htons(lenByte);
-        
-        logFile << "SOF-0 segment length: " << (int)lenByte << std::endl;
-        
-        m_imageFile >> std::noskipws >> precision;
-        logFile << "SOF-0 segment data precision: " << (int)precision << std::endl;
-        
-        m_imageFile.read(reinterpret_cast<char *>(&imgHeight), 2);
-        m_imageFile.read(reinterpret_cast<char *>(&imgWidth), 2);
-        
-        imgHeight = htons(imgHeight);
-        imgWidth = htons(imgWidth);
-        
-        logFile << "Image height: " << (int)imgHeight << std::endl;
-        logFile << "Image width: " << (int)imgWidth << std::endl;
-        
-        m_imageFile >> std::noskipws >> compCount;
-        
-        logFile << "No. of components: " << (int)compCount << std::endl;
-        
-        UInt8 compID = 0, sampFactor = 0, QTNo = 0;
-        
-        bool isNonSampled = true;
-        
-        for (auto i = 0; i < 3; ++i)
-        {
-            m_imageFile >> std::noskipws >> compID >> sampFactor >> QTNo;
-            
-            logFile << "Component ID: " << (int)compID << std::endl;
-            logFile << "Sampling Factor, Horizontal: " << int(sampFactor >> 4) << ", Vertical: " << int(sampFactor & 0x0F) << std::endl;
-            logFile << "Quantization table no.: " << (int)QTNo << std::endl;
-            
-            if ((sampFactor >> 4) != 1 || (sampFactor & 0x0F) != 1)
-                isNonSampled = false;
-        }
-        
-        if (!isNonSampled)
-        {
-            logFile << "Chroma subsampling not yet supported!" << std::endl;
-            logFile << "Chroma subsampling is not 4:4:4, terminating..." << std::endl;
-            return ResultCode::TERMINATE;
-        }
-        
-        logFile << "Finished parsing SOF-0 segment [OK]" << std::endl;        
-        m_image.width = imgWidth;
-        m_image.height = imgHeight;
-        
-        return ResultCode::SUCCESS;
-    }
-    
-    void Decoder::parseDHTSegment()
-    {   
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
-            return;
-        }
-        
-        logFile << "Parsing Huffman table segment..." << std::endl;
-        
-        UInt16 len;
-        m_imageFile.read(reinterpret_cast<char *>(&len), 2);
-        len = htons(len);
-        
-        logFile << "Huffman table length: " << (int)len << std::endl;
-        
-        int segmentEnd = (int)m_imageFile.tellg() + len - 2;
-        
-        while (m_imageFile.tellg() < segmentEnd)
-        {
-            UInt8 htinfo;
-            m_imageFile >> std::noskipws >> htinfo;
-            
-            int HTType = int((htinfo & 0x10) >> 4);
-            int HTNumber = int(htinfo & 0x0F);
-            
-            logFile << "Huffman table type: " << HTType << std::endl;
-            logFile << "Huffman table #: " << HTNumber << std::endl;
-            
-            int totalSymbolCount = 0;
-            UInt8 symbolCount;
-            
-            for (auto i = 1; i <= 16; ++i)
-            {
-                m_imageFile >> std::noskipws >> symbolCount;
-                m_huffmanTable[HTType][HTNumber][i-1].first = (int)symbolCount;
-                totalSymbolCount += (int)symbolCount;
-            }
-            
-            // Load the symbols
-            int syms = 0;
-            for (auto i = 0; syms < totalSymbolCount; )
-            {
-                // Read the next symbol, and add it to the
-                // proper slot in the Huffman table.
-                //
-                // Depndending upon the symbol count, say n, for the current
-                // symbol length, insert the next n symbols in the symbol
-                // list to it's proper spot in the Huffman table. This means,
-                // if symbol counts for symbols of lengths 1, 2 and 3 are 0,
-                // 5 and 2 respectively, the symbol list will contain 7
-                // symbols, out of which the first 5 are symbols with length
-                // 2, and the remaining 2 are of length 3.
-                UInt8 code;
-                m_imageFile >> std::noskipws >> code;
-                
-                if (m_huffmanTable[HTType][HTNumber][i].first == 0)
-                {
-                    while (m_huffmanTable[HTType][HTNumber][++i].first == 0);
-                }
-                
-                m_huffmanTable[HTType][HTNumber][i].second.push_back(code);
-                syms++;
-                
-                if (m_huffmanTable[HTType][HTNumber][i].first == m_huffmanTable[HTType][HTNumber][i].second.size())
-                    i++;
-            }
-            
-            logFile << "Printing symbols for Huffman table (" << HTType << "," << HTNumber << ")..." << std::endl;
-            
-            int totalCodes = 0;
-            for (auto i = 0; i < 16; ++i)
-            {
-                std::string codeStr = "";
-                for (auto&& symbol : m_huffmanTable[HTType][HTNumber][i].second)
-                {
-                    std::stringstream ss;
-                    ss << "0x" << std::hex << std::setfill('0') << std::setw(2) << std::setprecision(16) << (int)symbol;
-                    codeStr += ss.str() + " ";
-                    totalCodes++;
-                }
-                
-                logFile << "Code length: " << i+1
-                                        << ", Symbol count: " << m_huffmanTable[HTType][HTNumber][i].second.size()
-                                        << ", Symbols: " << codeStr << std::endl;
-            }
-            
-            logFile << "Total Huffman codes for Huffman table(Type:" << HTType << ",#:" << HTNumber << "): " << totalCodes << std::endl;
-            
-            m_huffmanTree[HTType][HTNumber].constructHuffmanTree(m_huffmanTable[HTType][HTNumber]);
-            auto htree = m_huffmanTree[HTType][HTNumber].getTree();
-            logFile << "Huffman codes:-" << std::endl;
-            inOrder(htree);
-        }
-        
-        logFile << "Finished parsing Huffman table segment [OK]" << std::endl;
-    }
-    
-    void Decoder::parseSOSSegment()
-    {
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
-            return;
-        }
-        
-        logFile << "Parsing SOS segment..." << std::endl;
-        
-        UInt16 len;
-        
-        m_imageFile.read(reinterpret_cast<char *>(&len), 2);
-        len = htons(len);
-        
-        logFile << "SOS segment length: " << len << std::endl;
-        
-        UInt8 compCount; // Number of components
-        UInt16 compInfo; // Component ID and Huffman table used
-        
-        m_imageFile >> std::noskipws >> compCount;
-        
-        if (compCount < 1 || compCount > 4)
-        {
-            logFile << "Invalid component count in image scan: " << (int)compCount << ", terminating decoding process..." << std::endl;
-            return;
-        }
-        
-        logFile << "Number of components in scan data: " << (int)compCount << std::endl;
-        
-        for (auto i = 0; i < compCount; ++i)
-        {
-            m_imageFile.read(reinterpret_cast<char *>(&compInfo), 2);
-            compInfo = htons(compInfo);
-            
-            UInt8 cID = compInfo >> 8; // 1st byte denotes component ID 
-            
-            // 2nd byte denotes the Huffman table used:
-            // Bits 7 to 4: DC Table #(0 to 3)
-            // Bits 3 to 0: AC Table #(0 to 3)
-            UInt8 DCTableNum = (compInfo & 0x00f0) >> 4;
-            UInt8 ACTableNum = (compInfo & 0x000f);
-            
-            logFile << "Component ID: " << (int)cID << ", DC Table #: " << (int)DCTableNum << ", AC Table #: " << (int)ACTableNum << std::endl;
-        }
-        
-        // Skip the next three bytes
-        for (auto i = 0; i < 3; ++i)
-        {
-            UInt8 byte;
-            m_imageFile >> std::noskipws >> byte;
-        }
-        
-        logFile << "Finished parsing SOS segment [OK]" << std::endl;
-        
-        scanImageData();
-    }
-    
-    void Decoder::scanImageData()
-    {
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
-            return;
-        }
-        
-        logFile << "Scanning image data..." << std::endl;
-        
-        UInt8 byte;
-        
-        while (m_imageFile >> std::noskipws >> byte)
-        {
-            if (byte == JFIF_BYTE_FF)
-            {
-                UInt8 prevByte = byte;
-                
-                m_imageFile >> std::noskipws >> byte;
-                
-                if (byte == JFIF_EOI)
-                {
-                    logFile << "Found segment, End of Image (FFD9)" << std::endl;
-                    return;
-                }
-                
-                std::bitset<8> bits1(prevByte);
-                logFile << "0x" << std::hex << std::setfill('0') << std::setw(2)
-                                          << std::setprecision(8) << (int)prevByte
-                                          << ", Bits: " << bits1 << std::endl;
-                                          
-                m_scanData.append(bits1.to_string());
-            }
-            
-            std::bitset<8> bits(byte);
-            logFile << "0x" << std::hex << std::setfill('0') << std::setw(2)
-                                      << std::setprecision(8) << (int)byte
-                                      << ", Bits: " << bits << std::endl;
-            
-            m_scanData.append(bits.to_string());
-        }
-        
-        logFile << "Finished scanning image data [OK]" << std::endl;
-    }
-    
-    void Decoder::parseCOMSegment()
-    {
-        if (!m_imageFile.is_open() || !m_imageFile.good())
-        {
-            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
-            return;
-        }
-        
-        logFile << "Parsing comment segment..." << std::endl;
-        
-        UInt16 lenByte = 0;
-        UInt8 byte = 0;
-        std::string comment;
-        
-        m_imageFile.read(reinterpret_cast<char *>(&lenByte), 2);
-        lenByte = htons(lenByte);
-        std::size_t curPos = m_imageFile.tellg();
-        
-        logFile << "Comment segment length: " << lenByte << std::endl;
-        
-        for (auto i = 0; i < lenByte - 2; ++i)
-        {
-            m_imageFile >> std::noskipws >> byte;
-            
-            if (byte == JFIF_BYTE_FF)
-            {
-                logFile << "Unexpected start of marker at offest: " << curPos + i << std::endl;
-                logFile << "Comment segment content: " << comment << std::endl;
-                return;
-            }
-            
-            comment.push_back(static_cast<char>(byte));
-        }
-        
-        logFile << "Comment segment content: " << comment << std::endl;
-        logFile << "Finished parsing comment segment [OK]" << std::endl;
-    }
-    
-    void Decoder::byteStuffScanData()
-    {
-        if (m_scanData.empty())
-        {
-            logFile << " [ FATAL ] Invalid image scan data" << std::endl;
-            return;
-        }
-        
-        logFile << "Byte stuffing image scan data..." << std::endl;
-        
-        for (unsigned i = 0; i <= m_scanData.size() - 8; i += 8)
-        {
-            std::string byte = m_scanData.substr(i, 8);
-            
-            if (byte == "11111111")
-            {
-                if (i + 8 < m_scanData.size() - 8)
-                {
-                    std::string nextByte = m_scanData.substr(i + 8, 8);
-                    
-                    if (nextByte == "00000000")
-                    {
-                        m_scanData.erase(i + 8, 8);
-                    }
-                    else continue;
-                }
-                else
-                    continue;
-            }
-        }
-        
-        logFile << "Finished byte stuffing image scan data [OK]" << std::endl;
-    }
-    
-    void Decoder::decodeScanData()
-    {
-        if (m_scanData.empty())
-        {
-            logFile << " [ FATAL ] Invalid image scan data" << std::endl;
-            return;
-        }
-        
-        byteStuffScanData();
-        
-        logFile << "Decoding image scan data..." << std::endl;
-        
-        const char* component[] = { "Y (Luminance)", "Cb (Chrominance)", "Cr (Chrominance)" };
-        const char* type[] = { "DC", "AC" };        
-        
-        int MCUCount = (m_image.width * m_image.height) / 64;
-        
-        m_MCU.clear();
-        logFile << "MCU count: " << MCUCount << std::endl;
-        
-        int k = 0; // The index of the next bit to be scanned
-        
-        for (auto i = 0; i < MCUCount; ++i)
-        {
-            logFile << "Decoding MCU-" << i + 1 << "..." << std::endl;
-            
-            // The run-length coding after decoding the Huffman data
-            std::array<std::vector<int>, 3> RLE;            
-            
-            // For each component Y, Cb & Cr, decode 1 DC
-            // coefficient and then decode 63 AC coefficients.
-            //
-            // NOTE:
-            // Since a signnificant portion of a RLE for a
-            // component contains a trail of 0s, AC coefficients
-            // are decoded till, either an EOB (End of block) is
-            // encountered or 63 AC coefficients have been decoded.
-            
-            for (auto compID = 0; compID < 3; ++compID)
-            {
-                std::string bitsScanned = ""; // Initially no bits are scanned
-                
-                // Firstly, decode the DC coefficient
-                logFile << "Decoding MCU-" << i + 1 << ": " << component[compID] << "/" << type[HT_DC] << std::endl;
-                
-                int HuffTableID = compID == 0 ? 0 : 1;
-                
-                while (1)
-                {       
-                    bitsScanned += m_scanData[k];
-                    auto value = m_huffmanTree[HT_DC][HuffTableID].contains(bitsScanned);
-                    
-                    if (!utils::isStringWhiteSpace(value))
-                    {
-                        if (value != "EOB")
-                        {   
-                            int zeroCount = UInt8(std::stoi(value)) >> 4 ;
-                            int category = UInt8(std::stoi(value)) & 0x0F;
-                            int DCCoeff = bitStringtoValue(m_scanData.substr(k + 1, category));
-                            
-                            k += category + 1;
-                            bitsScanned = "";
-                            
-                            RLE[compID].push_back(zeroCount);
-                            RLE[compID].push_back(DCCoeff);
-                            
-                            break;
-                        }
-                        
-                        else
-                        {
-                            bitsScanned = "";
-                            k++;
-                            
-                            RLE[compID].push_back(0);
-                            RLE[compID].push_back(0);
-                            
-                            break;
-                        }
-                    }
-                    else
-                        k++;
-                }
-                
-                // Then decode the AC coefficients
-                logFile << "Decoding MCU-" << i + 1 << ": " << component[compID] << "/" << type[HT_AC] << std::endl;
-                bitsScanned = "";
-                int ACCodesCount = 0;
-                                
-                while (1)
-                {   
-                    // If 63 AC codes have been encountered, this block is done, move onto next block                    
-                    if (ACCodesCount  == 63)
-                    {
-                        break;
-                    }
-                    
-                    // Append the k-th bit to the bits scanned so far
-                    bitsScanned += m_scanData[k];
-                    auto value = m_huffmanTree[HT_AC][HuffTableID].contains(bitsScanned);
-                    
-                    if (!utils::isStringWhiteSpace(value))
-                    {
-                        if (value != "EOB")
-                        {
-                            int zeroCount = UInt8(std::stoi(value)) >> 4 ;
-                            int category = UInt8(std::stoi(value)) & 0x0F;
-                            int ACCoeff = bitStringtoValue(m_scanData.substr(k + 1, category));
-                            
-                            k += category + 1;
-                            bitsScanned = "";
-                            
-                            RLE[compID].push_back(zeroCount);
-                            RLE[compID].push_back(ACCoeff);
-                            
-                            ACCodesCount += zeroCount + 1;
-                        }
-                        
-                        else
-                        {
-                            bitsScanned = "";
-                            k++;
-                            
-                            RLE[compID].push_back(0);
-                            RLE[compID].push_back(0);
-                            
-                            break;
-                        }
-                    }
-                    
-                    else
-                        k++;
-                }
-                
-                // If both the DC and AC coefficients are EOB, truncate to (0,0)
-                if (RLE[compID].size() == 2)
-                {
-                    bool allZeros = true;
-                    
-                    for (auto&& rVal : RLE[compID])
-                    {
-                        if (rVal != 0)
-                        {
-                            allZeros = false;
-                            break;
-                        }
-                    }
-                    
-                    // Remove the extra (0,0) pair
-                    if (allZeros)
-                    {
-                        RLE[compID].pop_back();
-                        RLE[compID].pop_back();
-                    }
-                }
-            }
-            
-            // Construct the MCU block from the RLE &
-            // quantization tables to a 8x8 matrix
-            m_MCU.push_back(MCU(RLE, m_QTables));
-            
-            logFile << "Finished decoding MCU-" << i + 1 << " [OK]" << std::endl;
-        }
-        
-        // The remaining bits, if any, in the scan data are discarded as
-        // they're added byte align the scan data.
-        
-        logFile << "Finished decoding image scan data [OK]" << std::endl;
-    }
-}
+// Implementation of the decoder
+
+#include <arpa/inet.h> // htons
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "Decoder.hpp"
+#include "LazyImage.hpp"
+#include "Markers.hpp"
+#include "ScanData.hpp"
+#include "StandardTables.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        // Reads the values of TIFF data (e.g., the EXIF metadata), in the
+        // byte order given by its header, checking every read against its size
+        class TIFFReader
+        {
+            public:
+                
+                TIFFReader(const UInt8* data, const std::size_t size) :
+                    m_data{data},
+                    m_size{size},
+                    m_isBigEndian{size >= 2 && data[0] == 'M' && data[1] == 'M'}
+                {
+                }
+                
+                bool readUInt16(const std::size_t offset, UInt16& value) const
+                {
+                    if (offset + 2 > m_size)
+                        return false;
+                    
+                    const UInt8* bytes = m_data + offset;
+                    value = m_isBigEndian ? UInt16((bytes[0] << 8) | bytes[1]) : UInt16((bytes[1] << 8) | bytes[0]);
+                    return true;
+                }
+                
+                bool readUInt32(const std::size_t offset, std::uint32_t& value) const
+                {
+                    UInt16 first, second;
+                    
+                    if (!readUInt16(offset, first) || !readUInt16(offset + 2, second))
+                        return false;
+                    
+                    value = m_isBigEndian ? (std::uint32_t(first) << 16) | second : (std::uint32_t(second) << 16) | first;
+                    return true;
+                }
+                
+                // Find an entry of an image file directory (IFD)
+                // @param IFDOffset the offset of the directory
+                // @param tag the tag of the entry
+                // @param valueOffset receives the offset of the entry's value
+                // @return false if the directory has no such entry
+                bool findEntry(const std::size_t IFDOffset, const UInt16 tag, std::size_t& valueOffset) const
+                {
+                    UInt16 entryCount = 0;
+                    
+                    if (!readUInt16(IFDOffset, entryCount))
+                        return false;
+                    
+                    for (std::size_t i = 0; i < entryCount; ++i)
+                    {
+                        UInt16 entryTag = 0;
+                        std::size_t entryOffset = IFDOffset + 2 + i * 12;
+                        
+                        if (!readUInt16(entryOffset, entryTag))
+                            return false;
+                        
+                        if (entryTag == tag)
+                        {
+                            valueOffset = entryOffset + 8;
+                            return true;
+                        }
+                    }
+                    
+                    return false;
+                }
+                
+                // Get the offset of the directory that follows another one
+                // @return false if it's the last directory
+                bool getNextIFD(const std::size_t IFDOffset, std::size_t& nextOffset) const
+                {
+                    UInt16 entryCount = 0;
+                    std::uint32_t offset = 0;
+                    
+                    if (!readUInt16(IFDOffset, entryCount) || !readUInt32(IFDOffset + 2 + entryCount * 12, offset))
+                        return false;
+                    
+                    nextOffset = offset;
+                    return offset != 0;
+                }
+                
+            private:
+                
+                const UInt8* m_data;
+                std::size_t m_size;
+                bool m_isBigEndian;
+        };
+        
+        // Whether a marker starts a segment with a length, the markers
+        // that stand alone are SOI, EOI, the restart markers & TEM
+        bool hasSegmentLength(const UInt8 marker)
+        {
+            return marker != JFIF_SOI && marker != JFIF_EOI && marker != 0x01 &&
+                   !(marker >= JFIF_RST0 && marker <= JFIF_RST7);
+        }
+    }
+    
+    const char* getValidationErrorName(const ValidationError error)
+    {
+        switch (error)
+        {
+            case ValidationError::NONE                   : return "NONE";
+            case ValidationError::UNREADABLE             : return "UNREADABLE";
+            case ValidationError::MISSING_SOI            : return "MISSING_SOI";
+            case ValidationError::INVALID_MARKER         : return "INVALID_MARKER";
+            case ValidationError::TRUNCATED_SEGMENT      : return "TRUNCATED_SEGMENT";
+            case ValidationError::INVALID_SEGMENT        : return "INVALID_SEGMENT";
+            case ValidationError::UNSUPPORTED            : return "UNSUPPORTED";
+            case ValidationError::MISSING_FRAME          : return "MISSING_FRAME";
+            case ValidationError::MISSING_TABLE          : return "MISSING_TABLE";
+            case ValidationError::MISSING_SCAN           : return "MISSING_SCAN";
+            case ValidationError::INVALID_HUFFMAN_CODE   : return "INVALID_HUFFMAN_CODE";
+            case ValidationError::INVALID_COEFFICIENT    : return "INVALID_COEFFICIENT";
+            case ValidationError::TRUNCATED_SCAN         : return "TRUNCATED_SCAN";
+            case ValidationError::INVALID_RESTART_MARKER : return "INVALID_RESTART_MARKER";
+            case ValidationError::EXTRANEOUS_SCAN_DATA   : return "EXTRANEOUS_SCAN_DATA";
+            case ValidationError::MISSING_EOI            : return "MISSING_EOI";
+            case ValidationError::TRAILING_DATA          : return "TRAILING_DATA";
+            case ValidationError::CANCELLED              : return "CANCELLED";
+        }
+        
+        return "UNKNOWN";
+    }
+    
+    Decoder::Decoder() :
+        m_fileData{ArenaAllocator<char>(m_arena)},
+        m_imageStream{&m_imageBuffer},
+        m_scanData{ArenaAllocator<UInt8>(m_arena)},
+        m_thumbnailType{ThumbnailType::NONE},
+        m_thumbnailOffset{0},
+        m_thumbnailSize{0},
+        m_thumbnailWidth{0},
+        m_thumbnailHeight{0},
+        m_MCU{ArenaAllocator<MCU>(m_arena)},
+        m_frameWidth{0},
+        m_frameHeight{0},
+        m_isCropped{false},
+        m_cropX{0},
+        m_cropY{0},
+        m_cropWidth{0},
+        m_cropHeight{0},
+        m_componentIDs{1, 2, 3},
+        m_componentQTables{0, 1, 1},
+        m_isProgressive{false},
+        m_coefficients{ArenaAllocator<Int16>(m_arena)},
+        m_scanCompCount{0},
+        m_scanComponents{0, 1, 2},
+        m_scanDCTable{0, 1, 1},
+        m_scanACTable{0, 1, 1},
+        m_spectralStart{0},
+        m_spectralEnd{63},
+        m_approxHigh{0},
+        m_approxLow{0},
+        m_restartInterval{0},
+        m_DCPredictor{0, 0, 0},
+        m_EOBRun{0},
+        m_scanCount{0},
+        m_isDecodingCoefficients{false},
+        m_coefficientOrder{CoefficientOrder::ZIGZAG},
+        m_isValidating{false},
+        m_validationResult{ValidationError::NONE, 0},
+        m_segmentOffset{0},
+        m_scanDataOffset{0},
+        m_isEOIFound{false},
+        m_EOIOffset{0},
+        m_cancellationToken{nullptr},
+        m_deadline{std::chrono::steady_clock::time_point::max()},
+        m_isCancelled{false},
+        m_scanIndexOutput{nullptr},
+        m_scanIndex{nullptr},
+        m_IDCTMode{IDCTMode::FLOAT},
+        m_orientation{Orientation::NORMAL},
+        m_isApplyingOrientation{false},
+        m_maxPixels{std::numeric_limits<std::size_t>::max()},
+        m_bufferPool{nullptr},
+        m_tensorOutput{nullptr}
+    {
+        // No JFIF data to read until a file or buffer is opened
+        m_imageStream.setstate(std::ios::failbit);
+        
+        // A block has at most 64 run-length pairs
+        for (auto&& compRLE : m_RLE)
+            compRLE.reserve(128);
+        
+        // Streams that don't define Huffman tables use the standard ones
+        for (auto type = 0; type < 2; ++type)
+        {
+            for (auto number = 0; number < 2; ++number)
+            {
+                m_huffmanTable[type][number] = HuffmanCache::getStandardTable(type, number);
+            }
+        }
+        
+        logFile << "Created \'Decoder object\'." << std::endl;
+    }
+            
+    Decoder::Decoder(const std::string& filename) :
+        Decoder()
+    {
+    }
+    
+    Decoder::~Decoder()
+    {
+        close();
+        logFile << "Destroyed \'Decoder object\'." << std::endl;
+    }
+    
+    bool Decoder::open(const std::string& filename)
+    {
+        std::ifstream imageFile(filename, std::ios::in | std::ios::binary);
+        
+        if (!imageFile.is_open() || !imageFile.good())
+        {
+            logFile << "Unable to open image: \'" + filename + "\'" << std::endl;
+            return false;
+        }
+        
+        // The file data is kept for the image, in the arena
+        resetImageState();
+        
+        // Read the whole file
+        imageFile.seekg(0, std::ios::end);
+        std::size_t fileSize = imageFile.tellg();
+        imageFile.seekg(0, std::ios::beg);
+        
+        m_fileData.resize(fileSize);
+        imageFile.read(m_fileData.data(), fileSize);
+        
+        if (!imageFile.good())
+        {
+            logFile << "Unable to read image: \'" + filename + "\'" << std::endl;
+            return false;
+        }
+        
+        m_filename = filename;
+        m_scanData.reserve(fileSize);
+        m_imageBuffer.setBuffer(m_fileData.data(), fileSize);
+        m_imageStream.clear();
+        
+        logFile << "Opened JPEG image: \'" << filename << "\'" << std::endl;
+        
+        return true;
+    }
+    
+    bool Decoder::open(const UInt8* data, const std::size_t size)
+    {
+        resetImageState();
+        
+        // The scan data is never larger than the JFIF data
+        m_scanData.reserve(size);
+        m_imageBuffer.setBuffer(reinterpret_cast<const char*>(data), size);
+        m_imageStream.clear();
+        
+        logFile << "Opened JPEG image buffer of " << size << " bytes" << std::endl;
+        
+        return true;
+    }
+    
+    void Decoder::resetImageState()
+    {
+        // Forget everything about the previously decoded image, except for
+        // the quantization & Huffman tables, which abbreviated streams
+        // (e.g., Motion-JPEG frames) expect the decoder to keep
+        m_filename = "";
+        m_frameWidth = 0;
+        m_frameHeight = 0;
+        m_isCropped = false;
+        m_isProgressive = false;
+        m_restartInterval = 0;
+        m_scanCount = 0;
+        m_tensorOutput = nullptr;
+        m_scanIndex = nullptr;
+        m_orientation = Orientation::NORMAL;
+        m_thumbnailType = ThumbnailType::NONE;
+        m_thumbnailOffset = 0;
+        m_thumbnailSize = 0;
+        m_thumbnailWidth = 0;
+        m_thumbnailHeight = 0;
+        m_scanDataOffset = 0;
+        m_removedBytes.clear();
+        m_restartMarkers.clear();
+        m_isEOIFound = false;
+        m_EOIOffset = 0;
+        MCU::resetDCPredictors();
+        
+        // The data of the image is released all at once, the stream may
+        // still point into the file data until the next buffer is set
+        m_imageBuffer.setBuffer(nullptr, 0);
+        m_bitReader.setData(nullptr, 0);
+        
+        releaseArenaVector(m_fileData);
+        releaseArenaVector(m_scanData);
+        releaseArenaVector(m_MCU);
+        releaseArenaVector(m_coefficients);
+        
+        m_arena.reset();
+    }
+    
+    bool Decoder::isDecodeCancelled()
+    {
+        if (m_isCancelled)
+            return true;
+        
+        if (m_cancellationToken != nullptr && m_cancellationToken->isCancelled())
+        {
+            logFile << "[ FATAL ] Decoding was cancelled" << std::endl;
+            m_isCancelled = true;
+        }
+        else if (m_deadline != std::chrono::steady_clock::time_point::max() &&
+                 std::chrono::steady_clock::now() >= m_deadline)
+        {
+            logFile << "[ FATAL ] The deadline of the decode has passed" << std::endl;
+            m_isCancelled = true;
+        }
+        
+        return m_isCancelled;
+    }
+    
+    void Decoder::setArenaRegion(void* region, const std::size_t size)
+    {
+        resetImageState();
+        m_arena.setRegion(region, size);
+    }
+    
+    void Decoder::reset()
+    {
+        resetImageState();
+        
+        m_cropX = 0;
+        m_cropY = 0;
+        m_cropWidth = 0;
+        m_cropHeight = 0;
+        m_comment.clear();
+        
+        // Keep the memory of the tables, a table that was not defined is empty
+        for (auto&& QTable : m_QTables)
+            QTable.clear();
+        
+        for (auto type = 0; type < 2; ++type)
+        {
+            for (auto number = 0; number < 2; ++number)
+            {
+                m_huffmanTable[type][number] = HuffmanCache::getStandardTable(type, number);
+            }
+        }
+        
+        logFile << "Decoder reset" << std::endl;
+    }
+    
+    void Decoder::setBufferPool(const std::shared_ptr<BufferPool>& pool)
+    {
+        m_bufferPool = pool;
+    }
+    
+    void Decoder::close()
+    {
+        m_imageBuffer.setBuffer(nullptr, 0);
+        m_imageStream.setstate(std::ios::failbit);
+        logFile << "Closed image file: \'" << m_filename << "\'" << std::endl;
+    }
+    
+    Decoder::ResultCode Decoder::parseSegmentInfo(const UInt8 byte)
+    {
+        if (byte == JFIF_BYTE_0 || byte == JFIF_BYTE_FF)
+            return ERROR;
+        
+        switch(byte)
+        {
+            case JFIF_SOI  : logFile  << "Found segment, Start of Image (FFD8)" << std::endl; return ResultCode::SUCCESS;
+            case JFIF_APP0 : logFile  << "Found segment, JPEG/JFIF Image Marker segment (APP0)" << std::endl; parseAPP0Segment(); return ResultCode::SUCCESS;
+            case JFIF_APP1 : logFile  << "Found segment, EXIF metadata (APP1)" << std::endl; parseAPP1Segment(); return ResultCode::SUCCESS;
+            case JFIF_COM  : logFile  << "Found segment, Comment(FFFE)" << std::endl; parseCOMSegment(); return ResultCode::SUCCESS;
+            case JFIF_DQT  : logFile  << "Found segment, Define Quantization Table (FFDB)" << std::endl; parseDQTSegment(); return ResultCode::SUCCESS;
+            case JFIF_SOF0 : logFile  << "Found segment, Start of Frame 0: Baseline DCT (FFC0)" << std::endl; return parseSOF0Segment();
+            case JFIF_SOF1 : logFile << "Found segment, Start of Frame 1: Extended Sequential DCT (FFC1), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF2 : logFile << "Found segment, Start of Frame 2: Progressive DCT (FFC2)" << std::endl; return parseSOF2Segment();
+            case JFIF_SOF3 : logFile << "Found segment, Start of Frame 3: Lossless Sequential (FFC3), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF5 : logFile << "Found segment, Start of Frame 5: Differential Sequential DCT (FFC5), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF6 : logFile << "Found segment, Start of Frame 6: Differential Progressive DCT (FFC6), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF7 : logFile << "Found segment, Start of Frame 7: Differential lossless (Sequential) (FFC7), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF9 : logFile << "Found segment, Start of Frame 9: Extended Sequential DCT, Arithmetic Coding (FFC9), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF10: logFile << "Found segment, Start of Frame 10: Progressive DCT, Arithmetic Coding (FFCA), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF11: logFile << "Found segment, Start of Frame 11: Lossless (Sequential), Arithmetic Coding (FFCB), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF13: logFile << "Found segment, Start of Frame 13: Differentical Sequential DCT, Arithmetic Coding (FFCD), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF14: logFile << "Found segment, Start of Frame 14: Differentical Progressive DCT, Arithmetic Coding (FFCE), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_SOF15: logFile << "Found segment, Start of Frame 15: Differentical Lossless (Sequential), Arithmetic Coding (FFCF), Not supported" << std::endl; return ResultCode::TERMINATE;
+            case JFIF_DHT  : logFile  << "Found segment, Define Huffman Table (FFC4)" << std::endl; return parseDHTSegment();
+            case JFIF_SOS  : logFile  << "Found segment, Start of Scan (FFDA)" << std::endl; return parseSOSSegment();
+            case JFIF_DRI  : logFile  << "Found segment, Define Restart Interval (FFDD)" << std::endl; parseDRISegment(); return ResultCode::SUCCESS;
+        }
+        
+        // The other application segments are skipped whole
+        if (byte > JFIF_APP1 && byte <= JFIF_APP15)
+        {
+            logFile << "Found segment, Application Segment " << std::dec << int(byte - JFIF_APP0) << " (FF" << std::hex << int(byte) << std::dec << "), Skipped" << std::endl;
+            skipSegment();
+        }
+        
+        return ResultCode::SUCCESS;
+    }
+    
+    void Decoder::setCropRegion(const std::size_t x, const std::size_t y,
+                                const std::size_t width, const std::size_t height)
+    {
+        m_isCropped = true;
+        m_cropX = x;
+        m_cropY = y;
+        m_cropWidth = width;
+        m_cropHeight = height;
+        
+        logFile << "Crop region set to: (" << x << "," << y << "), " << width << "x" << height << std::endl;
+    }
+    
+    void Decoder::setCancellationToken(const CancellationToken* token)
+    {
+        m_cancellationToken = token;
+    }
+    
+    void Decoder::setDeadline(const std::chrono::steady_clock::time_point& deadline)
+    {
+        m_deadline = deadline;
+    }
+    
+    void Decoder::setScanIndex(const ScanIndex* index)
+    {
+        m_scanIndex = index;
+    }
+    
+    void Decoder::setScanCallback(const ScanCallback& callback)
+    {
+        m_scanCallback = callback;
+    }
+    
+    void Decoder::setTensorOutput(void* output, const TensorOptions& options)
+    {
+        m_tensorOutput = output;
+        m_tensorOptions = options;
+    }
+    
+    void Decoder::setIDCTMode(const IDCTMode mode)
+    {
+        m_IDCTMode = mode;
+    }
+    
+    void Decoder::setApplyOrientation(const bool isApplying)
+    {
+        m_isApplyingOrientation = isApplying;
+    }
+    
+    void Decoder::setMaxPixels(const std::size_t count)
+    {
+        m_maxPixels = count;
+    }
+    
+    Orientation Decoder::getOrientation() const
+    {
+        return m_orientation;
+    }
+    
+    ThumbnailType Decoder::findThumbnail()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return ThumbnailType::NONE;
+        }
+        
+        logFile << "Locating thumbnail..." << std::endl;
+        
+        UInt8 byte;
+        
+        while (m_imageStream >> std::noskipws >> byte)
+        {
+            if (byte != JFIF_BYTE_FF)
+            {
+                logFile << "[ FATAL ] Invalid JFIF file! Terminating..." << std::endl;
+                break;
+            }
+            
+            m_imageStream >> std::noskipws >> byte;
+            
+            // The thumbnails are in the segments that precede the frame
+            if (byte == JFIF_SOI)
+                continue;
+            else if (byte == JFIF_APP0)
+                parseAPP0Segment();
+            else if (byte == JFIF_APP1)
+                parseAPP1Segment();
+            else if ((byte >= JFIF_SOF0 && byte <= JFIF_SOF15 && byte != JFIF_DHT) || byte == JFIF_SOS || byte == JFIF_EOI)
+                break;
+            else
+                skipSegment();
+        }
+        
+        // The image can still be decoded
+        m_imageStream.clear();
+        m_imageStream.seekg(0, std::ios_base::beg);
+        
+        return m_thumbnailType;
+    }
+    
+    ThumbnailType Decoder::getThumbnailType() const
+    {
+        return m_thumbnailType;
+    }
+    
+    const UInt8* Decoder::getThumbnailData(std::size_t& size) const
+    {
+        size = 0;
+        
+        if ((m_thumbnailType != ThumbnailType::JFIF_JPEG && m_thumbnailType != ThumbnailType::EXIF_JPEG) ||
+            m_imageBuffer.getData() == nullptr)
+            return nullptr;
+        
+        size = m_thumbnailSize;
+        return reinterpret_cast<const UInt8*>(m_imageBuffer.getData()) + m_thumbnailOffset;
+    }
+    
+    bool Decoder::decodeThumbnail(Image& thumbnail) const
+    {
+        const UInt8* data = reinterpret_cast<const UInt8*>(m_imageBuffer.getData());
+        
+        if (m_thumbnailType == ThumbnailType::NONE || data == nullptr)
+        {
+            logFile << "No thumbnail to decode" << std::endl;
+            return false;
+        }
+        
+        if (m_thumbnailType == ThumbnailType::JFIF_RGB)
+        {
+            thumbnail.createImageFromRGB(data + m_thumbnailOffset, m_thumbnailWidth, m_thumbnailHeight);
+            return true;
+        }
+        
+        Decoder decoder;
+        
+        if (!decoder.open(data + m_thumbnailOffset, m_thumbnailSize) ||
+            decoder.decodeImageFile() != ResultCode::DECODE_DONE)
+        {
+            logFile << "Unable to decode thumbnail" << std::endl;
+            return false;
+        }
+        
+        thumbnail = decoder.getImage();
+        
+        return true;
+    }
+    
+    const Image& Decoder::getImage() const
+    {
+        return m_image;
+    }
+    
+    bool Decoder::dumpRawData()
+    {
+        std::size_t extPos = m_filename.find(".jpg");
+        
+        if (extPos == std::string::npos)
+            extPos = m_filename.find(".jpeg");
+        
+        std::string targetFilename = m_filename.substr(0, extPos) + ".ppm";
+        m_image.dumpRawData(targetFilename);
+        
+        return true;
+    }
+    
+    bool Decoder::dumpRawData(const std::string& filename)
+    {
+        return m_image.dumpRawData(filename);
+    }
+    
+    Decoder::ResultCode Decoder::decodeImageFile()
+    {
+        m_isCancelled = false;
+        
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            reportValidationError(ValidationError::UNREADABLE, 0);
+            return ResultCode::ERROR;
+        }
+        
+        logFile << "Started decoding process..." << std::endl;
+        
+        UInt8 byte;
+        ResultCode status = ResultCode::DECODE_DONE;
+        
+        while (m_imageStream >> std::noskipws >> byte)
+        {
+            m_segmentOffset = std::size_t(m_imageStream.tellg()) - 1;
+            
+            if (isDecodeCancelled())
+            {
+                status = ResultCode::CANCELLED;
+                break;
+            }
+            
+            if (m_isValidating && m_segmentOffset == 0 &&
+                (byte != JFIF_BYTE_FF || m_imageStream.peek() != JFIF_SOI))
+            {
+                logFile << "[ FATAL ] The image doesn't start with a SOI marker" << std::endl;
+                reportValidationError(ValidationError::MISSING_SOI, 0);
+                status = ResultCode::ERROR;
+                break;
+            }
+            
+            if (byte == JFIF_BYTE_FF)
+            {
+                m_imageStream >> std::noskipws >> byte;
+                
+                // Nothing may follow the End of Image marker of a valid image
+                if (byte == JFIF_EOI)
+                {
+                    m_isEOIFound = true;
+                    m_EOIOffset = m_segmentOffset;
+                    
+                    if (m_isValidating)
+                        break;
+                }
+                
+                // The length of a segment must lie within the data, & its
+                // parser must read the whole segment
+                std::size_t segmentEnd = 0;
+                
+                if (m_isValidating && hasSegmentLength(byte))
+                {
+                    const UInt8* data = reinterpret_cast<const UInt8*>(m_imageBuffer.getData());
+                    const std::size_t lengthOffset = m_segmentOffset + 2;
+                    
+                    if (lengthOffset + 2 > m_imageBuffer.getSize())
+                        reportValidationError(ValidationError::TRUNCATED_SEGMENT, m_segmentOffset);
+                    else
+                    {
+                        segmentEnd = lengthOffset + ((data[lengthOffset] << 8) | data[lengthOffset + 1]);
+                        
+                        if (segmentEnd < lengthOffset + 2)
+                            reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset);
+                        else if (segmentEnd > m_imageBuffer.getSize())
+                            reportValidationError(ValidationError::TRUNCATED_SEGMENT, m_segmentOffset);
+                    }
+                    
+                    if (m_validationResult.error != ValidationError::NONE)
+                    {
+                        logFile << "[ FATAL ] Invalid length of segment FF" << std::hex << int(byte) << std::dec
+                                << " at offset " << m_segmentOffset << std::endl;
+                        status = ResultCode::ERROR;
+                        break;
+                    }
+                }
+                
+                ResultCode code = parseSegmentInfo(byte);
+                
+                if (code == ResultCode::SUCCESS && segmentEnd != 0 && byte != JFIF_SOS &&
+                    std::size_t(m_imageStream.tellg()) != segmentEnd)
+                {
+                    logFile << "[ FATAL ] Segment FF" << std::hex << int(byte) << std::dec << " at offset "
+                            << m_segmentOffset << " doesn't match its length" << std::endl;
+                    reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset);
+                    code = ResultCode::ERROR;
+                }
+                
+                // The parsers may find errors that don't stop a decode
+                if (code == ResultCode::SUCCESS && m_isValidating && m_validationResult.error != ValidationError::NONE)
+                    code = ResultCode::ERROR;
+                
+                // The scan data of a baseline image runs up to its EOI marker
+                if (code == ResultCode::SUCCESS && m_isValidating && m_isEOIFound)
+                    break;
+                
+                if (code == ResultCode::SUCCESS)
+                    continue;
+                else if (code == ResultCode::TERMINATE)
+                {
+                    status = ResultCode::TERMINATE;
+                    break;
+                }
+                else if (code == ResultCode::DECODE_INCOMPLETE)
+                {
+                    status = ResultCode::DECODE_INCOMPLETE;
+                    break;
+                }
+                else if (code == ResultCode::ERROR)
+                {
+                    status = ResultCode::ERROR;
+                    break;
+                }
+                else if (code == ResultCode::CANCELLED)
+                {
+                    status = ResultCode::CANCELLED;
+                    break;
+                }
+            }
+            else
+            {
+                logFile << "[ FATAL ] Invalid JFIF file! Terminating..." << std::endl;
+                reportValidationError(ValidationError::INVALID_MARKER, m_segmentOffset);
+                status = ResultCode::ERROR;
+                break;
+            }
+        }
+        
+        if (status == ResultCode::DECODE_DONE && m_isValidating)
+        {
+            // The scans of a progressive image were checked as they were found
+            if (!m_isProgressive && m_scanCount > 0 && !validateScanData())
+                status = ResultCode::ERROR;
+            else
+                logFile << "Finished validating image scan data" << std::endl;
+        }
+        else if (status == ResultCode::DECODE_DONE && m_isDecodingCoefficients)
+        {
+            // The coefficients of a progressive image are complete after its
+            // last scan, those of a baseline image are decoded now
+            bool isComplete = true;
+            
+            if (m_isProgressive)
+            {
+                std::size_t blockCount = getBlocksPerLine() * getBlockRows();
+                
+                for (std::size_t i = 0; i < 3 * blockCount && isComplete; ++i)
+                    isComplete = outputBlockCoefficients(i / blockCount, i % blockCount, &m_coefficients[i * 64]);
+            }
+            else
+                isComplete = decodeScanCoefficients();
+            
+            if (!isComplete)
+            {
+                logFile << "Decoding stopped by block callback" << std::endl;
+                status = ResultCode::DECODE_INCOMPLETE;
+            }
+            else if (!m_isCancelled)
+                logFile << "Finished decoding coefficients [OK]." << std::endl;
+        }
+        else if (status == ResultCode::DECODE_DONE && m_scanIndexOutput != nullptr)
+        {
+            if (m_isProgressive)
+            {
+                logFile << "[ FATAL ] Only the scan of a baseline image can be indexed" << std::endl;
+                status = ResultCode::ERROR;
+            }
+            else if (!indexScanData(*m_scanIndexOutput))
+                status = ResultCode::ERROR;
+            else
+                logFile << "Finished indexing image scan data [OK]." << std::endl;
+        }
+        else if (status == ResultCode::DECODE_DONE)
+        {
+            // The scans of a progressive image are decoded as they're found, only
+            // the pixels are left to reconstruct (unless the scan callback did so)
+            if (m_isProgressive)
+            {
+                if (!m_scanCallback)
+                    renderProgressiveImage();
+            }
+            else
+            {
+                // A corrupt scan fails the decode, rather than leaving the
+                // MCUs it didn't reach out of the image
+                if ((!decodeScanData() || !createImageFromMCUs()) && !m_isCancelled)
+                    status = ResultCode::ERROR;
+            }
+            
+            if (status == ResultCode::ERROR)
+                logFile << "Decoding process failed, invalid image scan data [NOT-OK]." << std::endl;
+            else if (!m_isCancelled)
+                logFile << "Finished decoding process [OK]." << std::endl;
+        }
+        else if (status == ResultCode::TERMINATE)
+        {
+            logFile << "Terminated decoding process [NOT-OK]." << std::endl;
+        }
+        
+        else if (status == ResultCode::DECODE_INCOMPLETE)
+        {
+            logFile << "Decoding process incomplete [NOT-OK]." << std::endl;
+        }
+        
+        // A cancelled decode may have stopped in any stage, whatever it
+        // decoded is released at once
+        if (m_isCancelled)
+        {
+            logFile << "Decoding process cancelled [NOT-OK]." << std::endl;
+            resetImageState();
+            status = ResultCode::CANCELLED;
+        }
+        
+        return status;
+    }
+    
+    Decoder::ResultCode Decoder::decodeCoefficients(const CoefficientOrder order)
+    {
+        m_isDecodingCoefficients = true;
+        m_coefficientOrder = order;
+        
+        ResultCode status = decodeImageFile();
+        
+        m_isDecodingCoefficients = false;
+        
+        return status;
+    }
+    
+    ValidationResult Decoder::validateImageFile()
+    {
+        m_isValidating = true;
+        m_validationResult = ValidationResult{ValidationError::NONE, 0};
+        m_segmentOffset = 0;
+        
+        ResultCode status = decodeImageFile();
+        
+        m_isValidating = false;
+        
+        // Once the scans are checked, the end of the image is
+        if (status == ResultCode::DECODE_DONE)
+        {
+            if (m_scanCount == 0)
+                reportValidationError(ValidationError::MISSING_SCAN, m_isEOIFound ? m_EOIOffset : m_imageBuffer.getSize());
+            else if (!m_isEOIFound)
+                reportValidationError(ValidationError::MISSING_EOI, m_imageBuffer.getSize());
+            else if (m_EOIOffset + 2 < m_imageBuffer.getSize())
+                reportValidationError(ValidationError::TRAILING_DATA, m_EOIOffset + 2);
+        }
+        
+        // Errors the checks above don't describe end the decoding process
+        // at the segment being parsed
+        else if (m_validationResult.error == ValidationError::NONE)
+        {
+            reportValidationError(status == ResultCode::TERMINATE ? ValidationError::UNSUPPORTED :
+                                  status == ResultCode::CANCELLED ? ValidationError::CANCELLED : ValidationError::INVALID_SEGMENT,
+                                  m_segmentOffset);
+        }
+        
+        if (m_validationResult.error == ValidationError::NONE)
+            logFile << "Finished validating image [OK]." << std::endl;
+        else
+        {
+            logFile << "Validation failed: " << getValidationErrorName(m_validationResult.error)
+                    << " at offset " << std::dec << m_validationResult.offset << " [NOT-OK]." << std::endl;
+        }
+        
+        return m_validationResult;
+    }
+    
+    Decoder::ResultCode Decoder::buildScanIndex(ScanIndex& index, const std::size_t rowInterval)
+    {
+        index = ScanIndex();
+        index.rowInterval = std::max(rowInterval, std::size_t(1));
+        m_scanIndexOutput = &index;
+        
+        ResultCode status = decodeImageFile();
+        
+        m_scanIndexOutput = nullptr;
+        
+        return status;
+    }
+    
+    Decoder::ResultCode Decoder::decodeLazyImage(LazyImage& image)
+    {
+        image.clear();
+        
+        // The image keeps a checkpoint for every MCU row
+        ResultCode status = buildScanIndex(image.m_index, 1);
+        
+        if (status != ResultCode::DECODE_DONE)
+        {
+            image.clear();
+            return status;
+        }
+        
+        image.width = m_frameWidth;
+        image.height = m_frameHeight;
+        image.m_scanData.assign(m_scanData.begin(), m_scanData.end());
+        getDequantizationTables(m_QTables, image.m_QTables, m_IDCTMode);
+        image.m_restartInterval = m_restartInterval;
+        image.m_IDCTMode = m_IDCTMode;
+        image.m_rowPositions.assign(image.m_index.checkpoints.size(), image.m_residentRows.end());
+        
+        for (auto compID = 0; compID < 3; ++compID)
+        {
+            image.m_DCTables[compID] = m_huffmanTable[HT_DC][m_scanDCTable[compID]];
+            image.m_ACTables[compID] = m_huffmanTable[HT_AC][m_scanACTable[compID]];
+        }
+        
+        return status;
+    }
+    
+    void Decoder::setBlockCallback(const BlockCallback& callback)
+    {
+        m_blockCallback = callback;
+    }
+    
+    const Int16* Decoder::getCoefficients(const int component) const
+    {
+        std::size_t blockCount = getBlocksPerLine() * getBlockRows();
+        
+        if (component < 0 || component > 2 || m_coefficients.size() < 3 * blockCount * 64)
+            return nullptr;
+        
+        return m_coefficients.data() + component * blockCount * 64;
+    }
+    
+    std::size_t Decoder::getFrameWidth() const
+    {
+        return m_frameWidth;
+    }
+    
+    std::size_t Decoder::getFrameHeight() const
+    {
+        return m_frameHeight;
+    }
+    
+    std::size_t Decoder::getRestartInterval() const
+    {
+        return m_restartInterval;
+    }
+    
+    std::size_t Decoder::getBlocksPerLine() const
+    {
+        return (m_frameWidth + 7) / 8;
+    }
+    
+    std::size_t Decoder::getBlockRows() const
+    {
+        return (m_frameHeight + 7) / 8;
+    }
+    
+    std::array<UInt16, 64> Decoder::getQuantizationTable(const int component, const CoefficientOrder order) const
+    {
+        std::array<UInt16, 64> table;
+        table.fill(0);
+        
+        if (component < 0 || component > 2)
+            return table;
+        
+        std::size_t QTable = m_componentQTables[component];
+        
+        if (QTable >= m_QTables.size() || m_QTables[QTable].size() != 64)
+            return table;
+        
+        // The tables are defined in zig-zag order
+        for (auto i = 0; i < 64; ++i)
+        {
+            std::size_t index = i;
+            
+            if (order == CoefficientOrder::NATURAL)
+                index = zzOrderToMatIndices(i).first * 8 + zzOrderToMatIndices(i).second;
+            
+            table[index] = m_QTables[QTable][i];
+        }
+        
+        return table;
+    }
+    
+    void Decoder::parseAPP0Segment()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return;
+        }
+        
+        logFile << "Parsing JPEG/JFIF marker segment (APP-0)..." << std::endl;
+        
+        UInt16 lenByte = 0;
+        
+        m_imageStream.read(reinterpret_cast<char *>(&lenByte), 2);
+        lenByte = htons(lenByte);
+        std::size_t curPos = m_imageStream.tellg();
+        std::size_t segmentEnd = curPos + lenByte - 2;
+        
+        logFile << "JFIF Application marker segment length: " << lenByte << std::endl;
+        
+        // The 'JFIF\0' bytes, or 'JFXX\0' for an extension segment
+        char identifier[5] = {};
+        m_imageStream.read(identifier, 5);
+        
+        if (std::memcmp(identifier, "JFXX", 5) == 0)
+        {
+            UInt8 extensionCode = 0;
+            m_imageStream >> std::noskipws >> extensionCode;
+            
+            logFile << "JFIF extension code: " << std::hex << (int)extensionCode << std::dec << std::endl;
+            
+            if (extensionCode == 0x10 && m_imageStream.good())
+            {
+                std::size_t offset = m_imageStream.tellg();
+                
+                if (offset < segmentEnd)
+                    locateThumbnail(ThumbnailType::JFIF_JPEG, offset, segmentEnd - offset, 0, 0);
+            }
+            else if (extensionCode == 0x13)
+            {
+                UInt8 xThumb = 0, yThumb = 0;
+                m_imageStream >> std::noskipws >> xThumb >> yThumb;
+                
+                std::size_t offset = m_imageStream.tellg();
+                
+                if (m_imageStream.good() && offset + std::size_t(3) * xThumb * yThumb <= segmentEnd)
+                    locateThumbnail(ThumbnailType::JFIF_RGB, offset, std::size_t(3) * xThumb * yThumb, xThumb, yThumb);
+            }
+            else
+                logFile << "Palette thumbnails are not supported" << std::endl;
+        }
+        else
+        {
+            UInt8 majVersionByte, minVersionByte;
+            m_imageStream >> std::noskipws >> majVersionByte >> minVersionByte;
+            
+            logFile << "JFIF version: " << (int)majVersionByte << "." << (int)(minVersionByte >> 4) << (int)(minVersionByte & 0x0F) << std::endl;
+            
+            UInt8 densityByte;
+            m_imageStream >> std::noskipws >> densityByte;
+            
+            const char* densityUnit = "";
+            switch(densityByte)
+            {
+                case 0x00: densityUnit = "Pixel Aspect Ratio"; break;
+                case 0x01: densityUnit = "Pixels per inch (DPI)"; break;
+                case 0x02: densityUnit = "Pixels per centimeter"; break;
+            }
+            
+            logFile << "Image density unit: " << densityUnit << std::endl;
+            
+            UInt16 xDensity = 0, yDensity = 0;
+            
+            m_imageStream.read(reinterpret_cast<char *>(&xDensity), 2);
+            m_imageStream.read(reinterpret_cast<char *>(&yDensity), 2);
+            
+            xDensity = htons(xDensity);
+            yDensity = htons(yDensity);
+            
+            logFile << "Horizontal image density: " << xDensity << std::endl;
+            logFile << "Vertical image density: " << yDensity << std::endl;
+            
+            // The uncompressed thumbnail, if any, is located but not read
+            UInt8 xThumb = 0, yThumb = 0;
+            m_imageStream >> std::noskipws >> xThumb >> yThumb;
+            
+            std::size_t offset = m_imageStream.tellg();
+            
+            if (m_imageStream.good() && offset + std::size_t(3) * xThumb * yThumb <= segmentEnd)
+                locateThumbnail(ThumbnailType::JFIF_RGB, offset, std::size_t(3) * xThumb * yThumb, xThumb, yThumb);
+        }
+        
+        m_imageStream.seekg(segmentEnd, std::ios_base::beg);
+        
+        logFile << "Finished parsing JPEG/JFIF marker segment (APP-0) [OK]" << std::endl;
+    }
+    
+    void Decoder::parseAPP1Segment()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return;
+        }
+        
+        logFile << "Parsing EXIF segment (APP-1)..." << std::endl;
+        
+        UInt16 lenByte = 0;
+        
+        m_imageStream.read(reinterpret_cast<char *>(&lenByte), 2);
+        lenByte = htons(lenByte);
+        std::size_t curPos = m_imageStream.tellg();
+        std::size_t segmentEnd = curPos + lenByte - 2;
+        
+        logFile << "EXIF segment length: " << lenByte << std::endl;
+        
+        // The segment is parsed where it lies in the JFIF data: the 'Exif\0\0'
+        // bytes, then TIFF data whose offsets count from its header
+        const UInt8* data = reinterpret_cast<const UInt8*>(m_imageBuffer.getData());
+        
+        if (m_imageStream.good() && segmentEnd <= m_imageBuffer.getSize() && lenByte >= 2 + 6 + 8 &&
+            std::memcmp(data + curPos, "Exif\0\0", 6) == 0)
+        {
+            const std::size_t TIFFStart = curPos + 6;
+            TIFFReader TIFF(data + TIFFStart, segmentEnd - TIFFStart);
+            
+            // The orientation of the image is in the first IFD, and the
+            // thumbnail is described by the second one
+            std::uint32_t IFD0 = 0, thumbnailOffset = 0, thumbnailLength = 0;
+            std::size_t IFD1 = 0, orientationEntry = 0, offsetEntry = 0, lengthEntry = 0;
+            UInt16 orientation = 0;
+            
+            if (TIFF.readUInt32(4, IFD0) && TIFF.findEntry(IFD0, 0x0112, orientationEntry) &&
+                TIFF.readUInt16(orientationEntry, orientation) && orientation >= 1 && orientation <= 8)
+            {
+                m_orientation = Orientation(orientation);
+                logFile << "EXIF orientation: " << orientation << std::endl;
+            }
+            
+            if (TIFF.readUInt32(4, IFD0) && TIFF.getNextIFD(IFD0, IFD1) &&
+                TIFF.findEntry(IFD1, 0x0201, offsetEntry) && TIFF.findEntry(IFD1, 0x0202, lengthEntry) &&
+                TIFF.readUInt32(offsetEntry, thumbnailOffset) && TIFF.readUInt32(lengthEntry, thumbnailLength) &&
+                std::size_t(thumbnailOffset) + thumbnailLength <= segmentEnd - TIFFStart)
+                locateThumbnail(ThumbnailType::EXIF_JPEG, TIFFStart + thumbnailOffset, thumbnailLength, 0, 0);
+            else
+                logFile << "EXIF segment has no JPEG thumbnail" << std::endl;
+        }
+        else
+            logFile << "APP-1 segment isn't EXIF metadata, skipped" << std::endl;
+        
+        m_imageStream.seekg(segmentEnd, std::ios_base::beg);
+        
+        logFile << "Finished parsing EXIF segment (APP-1) [OK]" << std::endl;
+    }
+    
+    void Decoder::locateThumbnail(const ThumbnailType type, const std::size_t offset, const std::size_t size,
+                                  const std::size_t width, const std::size_t height)
+    {
+        if (size == 0 || offset + size > m_imageBuffer.getSize() || m_thumbnailType != ThumbnailType::NONE)
+            return;
+        
+        m_thumbnailType = type;
+        m_thumbnailOffset = offset;
+        m_thumbnailSize = size;
+        m_thumbnailWidth = width;
+        m_thumbnailHeight = height;
+        
+        logFile << "Thumbnail of " << std::dec << size << " bytes at offset " << offset << std::endl;
+    }
+    
+    void Decoder::skipSegment()
+    {
+        UInt16 lenByte = 0;
+        
+        m_imageStream.read(reinterpret_cast<char *>(&lenByte), 2);
+        lenByte = htons(lenByte);
+        
+        if (lenByte > 2)
+            m_imageStream.seekg(lenByte - 2, std::ios_base::cur);
+    }
+    
+    void Decoder::parseDQTSegment()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return;
+        }
+        
+        logFile << "Parsing quantization table segment..." << std::endl;
+        
+        UInt16 lenByte = 0;
+        UInt8 PqTq;
+        UInt8 Qi;
+        
+        m_imageStream.read(reinterpret_cast<char *>(&lenByte), 2);
+        lenByte = htons(lenByte);
+        logFile << "Quantization table segment length: " << (int)lenByte << std::endl;
+        
+        lenByte -= 2;
+        
+        for (int qt = 0; qt < int(lenByte) / 65; ++qt)
+        {
+            m_imageStream >> std::noskipws >> PqTq;
+            
+            int precision = PqTq >> 4; // Precision is always 8-bit for baseline DCT
+            int QTtable = PqTq & 0x0F; // Quantization table number (0-3)
+            
+            logFile << "Quantization Table Number: " << QTtable << std::endl;
+            logFile << "Quantization Table #" << QTtable << " precision: " << (precision == 0 ? "8-bit" : "16-bit") << std::endl;
+            
+            if (precision > 1 || QTtable > 3)
+                reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset);
+            else if (precision != 0)
+                reportValidationError(ValidationError::UNSUPPORTED, m_segmentOffset);
+            
+            // A table may be redefined, e.g., by the next frame of a Motion-JPEG stream
+            if (m_QTables.size() <= (std::size_t)QTtable)
+                m_QTables.resize(QTtable + 1);
+            
+            m_QTables[QTtable].clear();
+            
+            // Populate quantization table #QTtable            
+            for (auto i = 0; i < 64; ++i)
+            {
+                m_imageStream >> std::noskipws >> Qi;
+                m_QTables[QTtable].push_back((UInt16)Qi);
+            }
+        }
+        
+        logFile << "Finished parsing quantization table segment [OK]" << std::endl;
+    }
+    
+    Decoder::ResultCode Decoder::parseSOF0Segment()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return ResultCode::ERROR;
+        }
+        
+        logFile << "Parsing SOF-0 segment..." << std::endl;
+        
+        UInt16 lenByte, imgHeight, imgWidth;
+        UInt8 precision, compCount;
+        
+        m_imageStream.read(reinterpret_cast<char *>(&lenByte), 2);
+        lenByte = htons(lenByte);
+        
+        logFile << "SOF-0 segment length: " << (int)lenByte << std::endl;
+        
+        m_imageStream >> std::noskipws >> precision;
+        logFile << "SOF-0 segment data precision: " << (int)precision << std::endl;
+        
+        m_imageStream.read(reinterpret_cast<char *>(&imgHeight), 2);
+        m_imageStream.read(reinterpret_cast<char *>(&imgWidth), 2);
+        
+        imgHeight = htons(imgHeight);
+        imgWidth = htons(imgWidth);
+        
+        logFile << "Image height: " << (int)imgHeight << std::endl;
+        logFile << "Image width: " << (int)imgWidth << std::endl;
+        
+        m_imageStream >> std::noskipws >> compCount;
+        
+        logFile << "No. of components: " << (int)compCount << std::endl;
+        
+        // The frames the decoder supports, 8-bit with 3 components, and a
+        // height defined by the frame rather than by a DNL segment
+        if (m_isValidating && (imgWidth == 0 || compCount == 0 || (precision != 8 && precision != 12)))
+        {
+            reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset);
+            return ResultCode::ERROR;
+        }
+        
+        if (m_isValidating && (precision != 8 || compCount != 3 || imgHeight == 0))
+        {
+            logFile << "Only 8-bit frames of 3 components with a height are supported, terminating..." << std::endl;
+            reportValidationError(ValidationError::UNSUPPORTED, m_segmentOffset);
+            return ResultCode::TERMINATE;
+        }
+        
+        if (std::size_t(imgWidth) * imgHeight > m_maxPixels)
+        {
+            logFile << "[ FATAL ] The frame has more than " << m_maxPixels << " pixels, terminating..." << std::endl;
+            reportValidationError(ValidationError::UNSUPPORTED, m_segmentOffset);
+            return ResultCode::TERMINATE;
+        }
+        
+        UInt8 compID = 0, sampFactor = 0, QTNo = 0;
+        
+        bool isNonSampled = true;
+        
+        for (auto i = 0; i < 3; ++i)
+        {
+            m_imageStream >> std::noskipws >> compID >> sampFactor >> QTNo;
+            m_componentIDs[i] = compID;
+            m_componentQTables[i] = QTNo;
+            
+            logFile << "Component ID: " << (int)compID << std::endl;
+            logFile << "Sampling Factor, Horizontal: " << int(sampFactor >> 4) << ", Vertical: " << int(sampFactor & 0x0F) << std::endl;
+            logFile << "Quantization table no.: " << (int)QTNo << std::endl;
+            
+            if ((sampFactor >> 4) != 1 || (sampFactor & 0x0F) != 1)
+                isNonSampled = false;
+        }
+        
+        if (!isNonSampled)
+        {
+            logFile << "Chroma subsampling not yet supported!" << std::endl;
+            logFile << "Chroma subsampling is not 4:4:4, terminating..." << std::endl;
+            return ResultCode::TERMINATE;
+        }
+        
+        logFile << "Finished parsing SOF-0 segment [OK]" << std::endl;        
+        m_frameWidth = imgWidth;
+        m_frameHeight = imgHeight;
+        
+        // Clip the crop window to the frame, by default the whole frame is decoded
+        if (!m_isCropped)
+        {
+            m_cropX = 0;
+            m_cropY = 0;
+            m_cropWidth = m_frameWidth;
+            m_cropHeight = m_frameHeight;
+        }
+        else
+        {
+            m_cropX = std::min(m_cropX, m_frameWidth);
+            m_cropY = std::min(m_cropY, m_frameHeight);
+            m_cropWidth = std::min(m_cropWidth, m_frameWidth - m_cropX);
+            m_cropHeight = std::min(m_cropHeight, m_frameHeight - m_cropY);
+        }
+        
+        if (m_cropWidth == 0 || m_cropHeight == 0)
+        {
+            logFile << "[ FATAL ] Crop region lies outside the image! Terminating..." << std::endl;
+            return ResultCode::ERROR;
+        }
+        
+        return ResultCode::SUCCESS;
+    }
+    
+    Decoder::ResultCode Decoder::parseSOF2Segment()
+    {
+        m_isProgressive = true;
+        
+        // The SOF-2 segment has the same layout as the SOF-0 segment
+        ResultCode status = parseSOF0Segment();
+        
+        if (status != ResultCode::SUCCESS)
+            return status;
+        
+        // Every scan refines the coefficients of all the blocks, so they're
+        // kept for the whole image, one 8x8 block per component per MCU
+        std::size_t blockCount = ((m_frameWidth + 7) / 8) * ((m_frameHeight + 7) / 8);
+        m_coefficients.assign(3 * blockCount * 64, 0);
+        m_scanCount = 0;
+        
+        logFile << "Allocated coefficient buffer for " << blockCount << " blocks per component" << std::endl;
+        
+        return ResultCode::SUCCESS;
+    }
+    
+    Decoder::ResultCode Decoder::parseDHTSegment()
+    {   
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return ResultCode::ERROR;
+        }
+        
+        logFile << "Parsing Huffman table segment..." << std::endl;
+        
+        UInt16 len;
+        m_imageStream.read(reinterpret_cast<char *>(&len), 2);
+        len = htons(len);
+        
+        logFile << "Huffman table length: " << (int)len << std::endl;
+        
+        int segmentEnd = (int)m_imageStream.tellg() + len - 2;
+        
+        while (m_imageStream.tellg() < segmentEnd)
+        {
+            UInt8 htinfo;
+            m_imageStream >> std::noskipws >> htinfo;
+            
+            int HTType = int((htinfo & 0x10) >> 4);
+            int HTNumber = int(htinfo & 0x0F);
+            
+            logFile << "Huffman table type: " << HTType << std::endl;
+            logFile << "Huffman table #: " << HTNumber << std::endl;
+            
+            if (HTNumber > 1)
+            {
+                logFile << "Huffman tables other than #0 & #1 not supported, skipping..." << std::endl;
+                m_imageStream.seekg(segmentEnd, std::ios_base::beg);
+                break;
+            }
+            
+            // The table contents, the 16 code counts followed by the symbols,
+            // are the key of the decoding table in the cache
+            UInt8 contents[16 + 256];
+            
+            int totalSymbolCount = 0;
+            
+            m_imageStream.read(reinterpret_cast<char *>(contents), 16);
+            
+            for (auto i = 0; i < 16; ++i)
+                totalSymbolCount += contents[i];
+            
+            if (!m_imageStream.good())
+            {
+                logFile << "[ FATAL ] Huffman table truncated, possibly corrupt JFIF data stream!" << std::endl;
+                reportValidationError(ValidationError::TRUNCATED_SEGMENT, m_segmentOffset);
+                return ResultCode::ERROR;
+            }
+            
+            if (totalSymbolCount > 256)
+            {
+                logFile << "[ FATAL ] Invalid Huffman table, possibly corrupt JFIF data stream!" << std::endl;
+                reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset);
+                return ResultCode::ERROR;
+            }
+            
+            // Load the symbols, the first counts[0] symbols have codes of
+            // length 1, the next counts[1] of length 2, and so on
+            m_imageStream.read(reinterpret_cast<char *>(contents + 16), totalSymbolCount);
+            
+            // The symbols of a truncated table must not reach the cache,
+            // which other decoders share
+            if (m_imageStream.gcount() != totalSymbolCount || !m_imageStream.good())
+            {
+                logFile << "[ FATAL ] Huffman table truncated, possibly corrupt JFIF data stream!" << std::endl;
+                reportValidationError(ValidationError::TRUNCATED_SEGMENT, m_segmentOffset);
+                return ResultCode::ERROR;
+            }
+            
+            logFile << "Printing symbols for Huffman table (" << HTType << "," << HTNumber << ")..." << std::endl;
+            
+            int totalCodes = 0;
+            for (auto i = 0; i < 16; ++i)
+            {
+                logFile << "Code length: " << i+1
+                                        << ", Symbol count: " << (int)contents[i]
+                                        << ", Symbols: ";
+                
+                for (auto j = 0; j < contents[i]; ++j)
+                {
+                    logFile << "0x" << std::hex << std::setfill('0') << std::setw(2) << (int)contents[16 + totalCodes] << std::dec << " ";
+                    totalCodes++;
+                }
+                
+                logFile << std::endl;
+            }
+            
+            logFile << "Total Huffman codes for Huffman table(Type:" << HTType << ",#:" << HTNumber << "): " << totalCodes << std::endl;
+            
+            // Most images use one of a handful of tables, whose decoding
+            // tables are only built the first time they're seen
+            m_huffmanTable[HTType][HTNumber] = HuffmanCache::getInstance().getTable(contents, 16 + totalSymbolCount);
+        }
+        
+        logFile << "Finished parsing Huffman table segment [OK]" << std::endl;
+        
+        return ResultCode::SUCCESS;
+    }
+    
+    void Decoder::parseDRISegment()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return;
+        }
+        
+        logFile << "Parsing restart interval segment..." << std::endl;
+        
+        UInt16 len, interval;
+        m_imageStream.read(reinterpret_cast<char *>(&len), 2);
+        m_imageStream.read(reinterpret_cast<char *>(&interval), 2);
+        
+        m_restartInterval = htons(interval);
+        
+        logFile << "Restart interval: " << std::dec << m_restartInterval << " MCUs" << std::endl;
+        logFile << "Finished parsing restart interval segment [OK]" << std::endl;
+    }
+    
+    Decoder::ResultCode Decoder::parseSOSSegment()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return ResultCode::ERROR;
+        }
+        
+        logFile << "Parsing SOS segment..." << std::endl;
+        
+        UInt16 len;
+        
+        m_imageStream.read(reinterpret_cast<char *>(&len), 2);
+        len = htons(len);
+        
+        logFile << "SOS segment length: " << len << std::endl;
+        
+        UInt8 compCount; // Number of components
+        UInt16 compInfo; // Component ID and Huffman table used
+        
+        m_imageStream >> std::noskipws >> compCount;
+        
+        // A scan has at least one of the frame's three components
+        if (compCount < 1 || compCount > 3)
+        {
+            logFile << "[ FATAL ] Invalid component count in image scan: " << (int)compCount << std::endl;
+            reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset + 4);
+            return ResultCode::ERROR;
+        }
+        
+        m_scanCompCount = compCount;
+        
+        logFile << "Number of components in scan data: " << (int)compCount << std::endl;
+        
+        for (auto i = 0; i < compCount; ++i)
+        {
+            m_imageStream.read(reinterpret_cast<char *>(&compInfo), 2);
+            compInfo = htons(compInfo);
+            
+            UInt8 cID = compInfo >> 8; // 1st byte denotes component ID 
+            
+            // 2nd byte denotes the Huffman table used:
+            // Bits 7 to 4: DC Table #(0 to 3)
+            // Bits 3 to 0: AC Table #(0 to 3)
+            UInt8 DCTableNum = (compInfo & 0x00f0) >> 4;
+            UInt8 ACTableNum = (compInfo & 0x000f);
+            
+            logFile << "Component ID: " << (int)cID << ", DC Table #: " << (int)DCTableNum << ", AC Table #: " << (int)ACTableNum << std::endl;
+            
+            // Baseline scans may only use tables #0 & #1, the others tables #0 to #3
+            if (DCTableNum > 3 || ACTableNum > 3 || (!m_isProgressive && (DCTableNum > 1 || ACTableNum > 1)))
+            {
+                logFile << "[ FATAL ] Invalid Huffman table # in image scan" << std::endl;
+                reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset + 6 + 2 * i);
+                return ResultCode::ERROR;
+            }
+            
+            if (DCTableNum > 1 || ACTableNum > 1)
+            {
+                logFile << "Huffman tables other than #0 & #1 not supported, terminating decoding process..." << std::endl;
+                reportValidationError(ValidationError::UNSUPPORTED, m_segmentOffset + 6 + 2 * i);
+                return ResultCode::TERMINATE;
+            }
+            
+            // Map the component ID to its position in the frame
+            auto c = 0;
+            while (c < 3 && m_componentIDs[c] != cID)
+                ++c;
+            
+            if (c == 3)
+            {
+                logFile << "[ FATAL ] Component ID " << (int)cID << " isn't in the frame" << std::endl;
+                reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset + 5 + 2 * i);
+                return ResultCode::ERROR;
+            }
+            
+            m_scanComponents[i] = c;
+            
+            m_scanDCTable[i] = DCTableNum;
+            m_scanACTable[i] = ACTableNum;
+        }
+        
+        // Spectral selection & successive approximation, these
+        // are fixed to 0, 63, 0, 0 for baseline images
+        UInt8 Ss, Se, AhAl;
+        m_imageStream >> std::noskipws >> Ss >> Se >> AhAl;
+        
+        m_spectralStart = Ss;
+        m_spectralEnd = Se;
+        m_approxHigh = AhAl >> 4;
+        m_approxLow = AhAl & 0x0F;
+        
+        logFile << "Spectral selection: " << (int)Ss << "-" << (int)Se
+                << ", Successive approximation: " << m_approxHigh << "," << m_approxLow << std::endl;
+        
+        if (m_isValidating && !validateScanHeader(len))
+            return ResultCode::ERROR;
+        
+        logFile << "Finished parsing SOS segment [OK]" << std::endl;
+        
+        scanImageData();
+        m_scanCount++;
+        
+        if (!m_isProgressive)
+            return ResultCode::SUCCESS;
+        
+        // Scans of a progressive image are decoded right away, as the
+        // next scan may redefine the Huffman tables
+        decodeProgressiveScan();
+        m_scanData.clear();
+        
+        if (m_isCancelled)
+            return ResultCode::CANCELLED;
+        
+        if (m_isValidating && m_validationResult.error != ValidationError::NONE)
+            return ResultCode::ERROR;
+        
+        // Nothing is rendered when only the coefficients are decoded or validated
+        if (m_scanCallback && !m_isDecodingCoefficients && !m_isValidating)
+        {
+            renderProgressiveImage();
+            
+            if (m_isCancelled)
+                return ResultCode::CANCELLED;
+            
+            if (!m_scanCallback(m_image, m_scanCount))
+            {
+                logFile << "Decoding stopped by scan callback after scan #" << m_scanCount << std::endl;
+                return ResultCode::DECODE_INCOMPLETE;
+            }
+        }
+        
+        return ResultCode::SUCCESS;
+    }
+    
+    void Decoder::scanImageData()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return;
+        }
+        
+        logFile << "Scanning image data..." << std::endl;
+        
+        // The scan data is extracted from the JFIF data in place, rather than
+        // read through the stream byte by byte
+        const UInt8* data = reinterpret_cast<const UInt8*>(m_imageBuffer.getData());
+        const std::size_t start = std::size_t(m_imageStream.tellg());
+        const std::size_t base = m_scanData.size();
+        
+        // Validation locates the scan data in the JFIF data, see getScanByteOffset()
+        std::vector<ScanMarker> markers;
+        
+        if (m_isValidating)
+        {
+            m_scanDataOffset = start;
+            m_removedBytes.clear();
+            m_restartMarkers.clear();
+        }
+        
+        std::size_t size = 0;
+        m_scanData.resize(base + m_imageBuffer.getSize() - start);
+        
+        const UInt8* end = extractScanData(data + start, data + m_imageBuffer.getSize(),
+                                           m_scanData.data() + base, size,
+                                           m_isValidating ? &markers : nullptr);
+        
+        m_scanData.resize(base + size);
+        
+        const std::size_t endOffset = std::size_t(end - data);
+        
+        // A stuffed zero is 1 byte removed, a restart marker 2
+        for (auto&& marker : markers)
+        {
+            const std::size_t removed = marker.inputOffset + 2 - marker.outputOffset;
+            
+            if (marker.marker == JFIF_BYTE_0)
+                m_removedBytes.emplace_back(base + marker.outputOffset + 1, removed - 1);
+            else
+            {
+                m_removedBytes.emplace_back(base + marker.outputOffset, removed);
+                m_restartMarkers.emplace_back(base + marker.outputOffset, marker.marker - JFIF_RST0);
+            }
+        }
+        
+        logFile << "Extracted " << std::dec << size << " bytes of scan data from "
+                << endOffset - start << " bytes with " << getMarkerSearchInstructions() << " search" << std::endl;
+        
+        if (endOffset + 1 < m_imageBuffer.getSize() && end[1] == JFIF_EOI)
+        {
+            logFile << "Found segment, End of Image (FFD9)" << std::endl;
+            m_isEOIFound = true;
+            m_EOIOffset = endOffset;
+            m_imageStream.seekg(endOffset + 2, std::ios_base::beg);
+            return;
+        }
+        
+        // Any other marker ends the scan data (e.g., the next scan of a
+        // progressive image), leave it for the segment parser
+        m_imageStream.seekg(endOffset, std::ios_base::beg);
+        
+        if (endOffset + 1 < m_imageBuffer.getSize())
+            logFile << "Found marker 0xFF" << std::hex << (int)end[1] << std::dec << " at end of scan data" << std::endl;
+        else
+            logFile << "Finished scanning image data [OK]" << std::endl;
+    }
+    
+    void Decoder::parseCOMSegment()
+    {
+        if (!m_imageStream.good())
+        {
+            logFile << "Unable scan image file: \'" + m_filename + "\'" << std::endl;
+            return;
+        }
+        
+        logFile << "Parsing comment segment..." << std::endl;
+        
+        UInt16 lenByte = 0;
+        UInt8 byte = 0;
+        std::string& comment = m_comment;
+        comment.clear();
+        
+        m_imageStream.read(reinterpret_cast<char *>(&lenByte), 2);
+        lenByte = htons(lenByte);
+        std::size_t curPos = m_imageStream.tellg();
+        
+        logFile << "Comment segment length: " << lenByte << std::endl;
+        
+        for (auto i = 0; i < lenByte - 2; ++i)
+        {
+            m_imageStream >> std::noskipws >> byte;
+            
+            if (byte == JFIF_BYTE_FF)
+            {
+                logFile << "Unexpected start of marker at offest: " << curPos + i << std::endl;
+                logFile << "Comment segment content: " << comment << std::endl;
+                return;
+            }
+            
+            comment.push_back(static_cast<char>(byte));
+        }
+        
+        logFile << "Comment segment content: " << comment << std::endl;
+        logFile << "Finished parsing comment segment [OK]" << std::endl;
+    }
+    
+    bool Decoder::decodeScanData()
+    {
+        if (m_scanData.empty())
+        {
+            logFile << " [ FATAL ] Invalid image scan data" << std::endl;
+            return false;
+        }
+        
+        logFile << "Decoding image scan data..." << std::endl;
+        
+        MCU::m_IDCTMode = m_IDCTMode;
+        getDequantizationTables(m_QTables, m_dequantizationTables, m_IDCTMode);
+        
+        const char* component[] = { "Y (Luminance)", "Cb (Chrominance)", "Cr (Chrominance)" };
+        const char* type[] = { "DC", "AC" };        
+        
+        // The frame is covered by a grid of 8x8 MCUs, partial MCUs at
+        // the right & bottom edges included
+        int MCUsPerLine = (m_frameWidth + 7) / 8;
+        int MCURows = (m_frameHeight + 7) / 8;
+        int MCUCount = MCUsPerLine * MCURows;
+        
+        m_MCU.clear();
+        m_MCU.reserve(MCUCount);
+        logFile << "MCU count: " << MCUCount << std::endl;
+        
+        // The range of MCUs that intersect the crop window
+        int firstMCUCol = m_cropX / 8;
+        int lastMCUCol = (m_cropX + m_cropWidth - 1) / 8;
+        int firstMCURow = m_cropY / 8;
+        int lastMCURow = (m_cropY + m_cropHeight - 1) / 8;
+        
+        logFile << "Decoding MCU columns " << firstMCUCol << "-" << lastMCUCol
+                << ", rows " << firstMCURow << "-" << lastMCURow << std::endl;
+        
+        m_bitReader.setData(m_scanData.data(), m_scanData.size());
+        
+        // The MCU rows above the crop window are skipped up to the
+        // checkpoint of the scan index above it, if there's one
+        int firstMCU = 0;
+        
+        if (m_scanIndex != nullptr && !m_scanIndex->matches(m_frameWidth, m_frameHeight, m_restartInterval, m_scanData.size()))
+            logFile << "Ignoring a scan index that was built for another image" << std::endl;
+        else if (m_scanIndex != nullptr)
+        {
+            const ScanCheckpoint* checkpoint = m_scanIndex->findCheckpoint(firstMCURow);
+            
+            if (checkpoint != nullptr)
+            {
+                firstMCU = checkpoint->MCURow * MCUsPerLine;
+                m_bitReader.setBitPosition(checkpoint->bitPosition);
+                MCU::setDCPredictors(checkpoint->DCPredictors);
+                
+                logFile << "Starting at MCU row " << checkpoint->MCURow << " from the scan index" << std::endl;
+            }
+        }
+        
+        // MCU rows entirely below the crop window are never decoded
+        for (auto i = firstMCU; i < (lastMCURow + 1) * MCUsPerLine; ++i)
+        {
+            int MCURow = i / MCUsPerLine;
+            int MCUCol = i % MCUsPerLine;
+            
+            if (MCUCol == 0 && isDecodeCancelled())
+                return false;
+            
+            // Each restart interval starts at a byte boundary, with fresh DC
+            // predictors, a checkpoint is past the restart marker of its MCU
+            if (m_restartInterval > 0 && i > firstMCU && i % m_restartInterval == 0)
+            {
+                m_bitReader.alignToByte();
+                MCU::resetDCPredictors();
+            }
+            
+            logFile << "Decoding MCU-" << i + 1 << "..." << std::endl;
+            
+            // The run-length coding after decoding the Huffman data
+            auto& RLE = m_RLE;
+            
+            for (auto&& compRLE : RLE)
+                compRLE.clear();
+            
+            // For each component Y, Cb & Cr, decode 1 DC
+            // coefficient and then decode 63 AC coefficients.
+            //
+            // NOTE:
+            // Since a signnificant portion of a RLE for a
+            // component contains a trail of 0s, AC coefficients
+            // are decoded till, either an EOB (End of block) is
+            // encountered or 63 AC coefficients have been decoded.
+            
+            for (auto compID = 0; compID < 3; ++compID)
+            {
+                // Firstly, decode the DC coefficient
+                logFile << "Decoding MCU-" << i + 1 << ": " << component[compID] << "/" << type[HT_DC] << std::endl;
+                
+                // The DC symbol is the category of the DC difference, which
+                // always takes the first RLE pair, even when it's 0
+                int category = decodeHuffmanSymbol(*m_huffmanTable[HT_DC][m_scanDCTable[compID]]);
+                
+                if (category < 0)
+                {
+                    logFile << "[ FATAL ] Invalid DC Huffman code, possibly corrupt JFIF data stream!" << std::endl;
+                    return false;
+                }
+                
+                RLE[compID].push_back(0);
+                RLE[compID].push_back(receiveExtend(category));
+                
+                // Then decode the AC coefficients
+                logFile << "Decoding MCU-" << i + 1 << ": " << component[compID] << "/" << type[HT_AC] << std::endl;
+                
+                for (auto ACCodesCount = 0; ACCodesCount < 63; )
+                {
+                    int value = decodeHuffmanSymbol(*m_huffmanTable[HT_AC][m_scanACTable[compID]]);
+                    
+                    if (value < 0)
+                    {
+                        logFile << "[ FATAL ] Invalid AC Huffman code, possibly corrupt JFIF data stream!" << std::endl;
+                        return false;
+                    }
+                    
+                    // EOB, the rest of the block is zero
+                    if (value == 0x00)
+                    {
+                        RLE[compID].push_back(0);
+                        RLE[compID].push_back(0);
+                        break;
+                    }
+                    
+                    int zeroCount = value >> 4;
+                    int ACCoeff = receiveExtend(value & 0x0F);
+                    
+                    RLE[compID].push_back(zeroCount);
+                    RLE[compID].push_back(ACCoeff);
+                    
+                    ACCodesCount += zeroCount + 1;
+                }
+            }
+            
+            // MCUs outside the crop window only advance the DC predictors
+            if (MCURow < firstMCURow || MCUCol < firstMCUCol || MCUCol > lastMCUCol)
+            {
+                MCU::updateDCPredictors(RLE);
+                logFile << "Skipped MCU-" << i + 1 << ", outside the crop region" << std::endl;
+                continue;
+            }
+            
+            // Construct the MCU block from the RLE &
+            // quantization tables to a 8x8 matrix
+            m_MCU.push_back(MCU(RLE, m_dequantizationTables));
+            
+            logFile << "Finished decoding MCU-" << i + 1 << " [OK]" << std::endl;
+        }
+        
+        // The remaining bits, if any, in the scan data are discarded as
+        // they're added byte align the scan data.
+        
+        logFile << "Finished decoding image scan data [OK]" << std::endl;
+        
+        return true;
+    }
+    
+    bool Decoder::decodeScanCoefficients()
+    {
+        if (m_scanData.empty())
+        {
+            logFile << " [ FATAL ] Invalid image scan data" << std::endl;
+            return true;
+        }
+        
+        logFile << "Decoding image scan coefficients..." << std::endl;
+        
+        std::size_t blockCount = getBlocksPerLine() * getBlockRows();
+        
+        // Streamed blocks are decoded one at a time, into the same memory
+        Int16 block[64];
+        
+        if (!m_blockCallback)
+            m_coefficients.assign(3 * blockCount * 64, 0);
+        
+        m_bitReader.setData(m_scanData.data(), m_scanData.size());
+        std::fill(m_DCPredictor, m_DCPredictor + 3, 0);
+        
+        // With no subsampling, every MCU holds one block of each component,
+        // a cancelled decode is told apart from a complete one by its caller
+        for (std::size_t i = 0; i < blockCount; ++i)
+        {
+            if (i % getBlocksPerLine() == 0 && isDecodeCancelled())
+                return true;
+            
+            if (m_restartInterval > 0 && i > 0 && i % m_restartInterval == 0)
+            {
+                m_bitReader.alignToByte();
+                std::fill(m_DCPredictor, m_DCPredictor + 3, 0);
+            }
+            
+            for (auto compID = 0; compID < 3; ++compID)
+            {
+                Int16* coeffs = m_blockCallback ? block : &m_coefficients[(compID * blockCount + i) * 64];
+                
+                if (!decodeBlockCoefficients(coeffs, compID))
+                    return true;
+                
+                if (!outputBlockCoefficients(compID, i, coeffs))
+                    return false;
+            }
+        }
+        
+        logFile << "Finished decoding image scan coefficients [OK]" << std::endl;
+        
+        return true;
+    }
+    
+    bool Decoder::decodeBlockCoefficients(Int16* coeffs, const int compIndex)
+    {
+        if (!decodeBaselineBlock(*m_huffmanTable[HT_DC][m_scanDCTable[compIndex]],
+                                 *m_huffmanTable[HT_AC][m_scanACTable[compIndex]],
+                                 m_bitReader, m_DCPredictor[compIndex], coeffs))
+        {
+            logFile << "[ FATAL ] Invalid Huffman code, possibly corrupt JFIF data stream!" << std::endl;
+            return false;
+        }
+        
+        return true;
+    }
+    
+    bool Decoder::indexScanData(ScanIndex& index)
+    {
+        if (m_scanData.empty())
+        {
+            logFile << " [ FATAL ] Invalid image scan data" << std::endl;
+            return false;
+        }
+        
+        logFile << "Indexing image scan data every " << std::dec << index.rowInterval << " MCU rows..." << std::endl;
+        
+        const std::size_t MCUsPerLine = getBlocksPerLine();
+        const std::size_t MCURows = getBlockRows();
+        
+        // The blocks are only entropy decoded, into the same memory
+        Int16 block[64];
+        
+        index.frameWidth = m_frameWidth;
+        index.frameHeight = m_frameHeight;
+        index.restartInterval = m_restartInterval;
+        index.scanSize = m_scanData.size();
+        index.checkpoints.clear();
+        index.checkpoints.reserve((MCURows + index.rowInterval - 1) / index.rowInterval);
+        
+        m_bitReader.setData(m_scanData.data(), m_scanData.size());
+        std::fill(m_DCPredictor, m_DCPredictor + 3, 0);
+        
+        // The rows after the last checkpoint don't need to be decoded
+        const std::size_t lastMCURow = (MCURows - 1) / index.rowInterval * index.rowInterval;
+        
+        for (std::size_t i = 0; i <= lastMCURow * MCUsPerLine; ++i)
+        {
+            if (i % MCUsPerLine == 0 && isDecodeCancelled())
+                return false;
+            
+            if (m_restartInterval > 0 && i > 0 && i % m_restartInterval == 0)
+            {
+                m_bitReader.alignToByte();
+                std::fill(m_DCPredictor, m_DCPredictor + 3, 0);
+            }
+            
+            if (i % MCUsPerLine == 0 && (i / MCUsPerLine) % index.rowInterval == 0)
+            {
+                ScanCheckpoint checkpoint;
+                checkpoint.MCURow = i / MCUsPerLine;
+                checkpoint.bitPosition = m_bitReader.getBitPosition();
+                std::copy(m_DCPredictor, m_DCPredictor + 3, checkpoint.DCPredictors);
+                
+                index.checkpoints.push_back(checkpoint);
+                
+                if (checkpoint.MCURow == lastMCURow)
+                    break;
+            }
+            
+            for (auto compID = 0; compID < 3; ++compID)
+            {
+                if (!decodeBlockCoefficients(block, compID))
+                    return false;
+            }
+        }
+        
+        logFile << "Indexed " << index.checkpoints.size() << " of " << MCURows << " MCU rows, "
+                << m_scanData.size() << " bytes of scan data [OK]" << std::endl;
+        
+        return true;
+    }
+    
+    bool Decoder::validateScanData()
+    {
+        if (m_scanData.empty())
+        {
+            logFile << " [ FATAL ] Invalid image scan data" << std::endl;
+            reportValidationError(ValidationError::TRUNCATED_SCAN, m_scanDataOffset);
+            return false;
+        }
+        
+        logFile << "Validating image scan data..." << std::endl;
+        
+        const std::size_t MCUCount = getBlocksPerLine() * getBlockRows();
+        
+        m_bitReader.setData(m_scanData.data(), m_scanData.size());
+        std::fill(m_DCPredictor, m_DCPredictor + 3, 0);
+        
+        for (std::size_t i = 0; i < MCUCount; ++i)
+        {
+            if (i % getBlocksPerLine() == 0 && isDecodeCancelled())
+                return false;
+            
+            if (m_restartInterval > 0 && i > 0 && i % m_restartInterval == 0)
+            {
+                m_bitReader.alignToByte();
+                std::fill(m_DCPredictor, m_DCPredictor + 3, 0);
+                
+                if (!validateRestartMarker(i / m_restartInterval))
+                    return false;
+            }
+            
+            for (auto compID = 0; compID < 3; ++compID)
+            {
+                if (!validateBlock(compID))
+                    return false;
+            }
+            
+            // Bits past the end of the data read as 0, so a truncated scan
+            // may still hold valid codes
+            if (m_bitReader.getBitPosition() > m_scanData.size() * 8)
+            {
+                reportValidationError(ValidationError::TRUNCATED_SCAN, getScanByteOffset(m_scanData.size()));
+                return false;
+            }
+        }
+        
+        return validateScanEnd(MCUCount);
+    }
+    
+    bool Decoder::validateBlock(const int compIndex)
+    {
+        const HuffmanLookupTable& DCTable = *m_huffmanTable[HT_DC][m_scanDCTable[compIndex]];
+        const HuffmanLookupTable& ACTable = *m_huffmanTable[HT_AC][m_scanACTable[compIndex]];
+        
+        std::size_t position = m_bitReader.getBitPosition();
+        int category = decodeHuffmanSymbol(DCTable);
+        
+        if (category < 0)
+        {
+            reportInvalidCode();
+            return false;
+        }
+        
+        // The differences of 8-bit samples take at most 11 bits, & the DC
+        // coefficients themselves lie within 11 bits
+        m_DCPredictor[compIndex] += receiveExtend(category);
+        
+        if (category > 11 || m_DCPredictor[compIndex] < -2048 || m_DCPredictor[compIndex] > 2047)
+        {
+            reportValidationError(ValidationError::INVALID_COEFFICIENT, getScanByteOffset(position / 8));
+            return false;
+        }
+        
+        for (auto k = 1; k < 64; )
+        {
+            position = m_bitReader.getBitPosition();
+            int value = decodeHuffmanSymbol(ACTable);
+            
+            if (value < 0)
+            {
+                reportInvalidCode();
+                return false;
+            }
+            
+            // EOB, the rest of the block is zero
+            if (value == 0x00)
+                break;
+            
+            // A run of zeros, then a coefficient of at most 10 bits (ZRL,
+            // 0xF0, is 16 zeros), which must all lie within the block
+            int zeroCount = value >> 4;
+            int size = value & 0x0F;
+            
+            if (size > 10 || (size == 0 && zeroCount != 15) || k + zeroCount > 63)
+            {
+                reportValidationError(ValidationError::INVALID_COEFFICIENT, getScanByteOffset(position / 8));
+                return false;
+            }
+            
+            receiveExtend(size);
+            k += zeroCount + 1;
+        }
+        
+        return true;
+    }
+    
+    bool Decoder::validateRestartMarker(const std::size_t interval)
+    {
+        // The reader was aligned to the end of the interval's last byte
+        const std::size_t end = m_bitReader.getBitPosition() / 8;
+        
+        if (interval > m_restartMarkers.size())
+        {
+            if (end >= m_scanData.size())
+                reportValidationError(ValidationError::TRUNCATED_SCAN, getScanByteOffset(m_scanData.size()));
+            else
+                reportValidationError(ValidationError::INVALID_RESTART_MARKER, getScanByteOffset(end));
+            
+            return false;
+        }
+        
+        // The markers cycle from RST0 to RST7
+        const std::pair<std::size_t, int>& marker = m_restartMarkers[interval - 1];
+        const std::size_t markerOffset = getScanByteOffset(marker.first) - 2;
+        
+        if (marker.second != int((interval - 1) % 8))
+            reportValidationError(ValidationError::INVALID_RESTART_MARKER, markerOffset);
+        else if (end < marker.first)
+            reportValidationError(ValidationError::EXTRANEOUS_SCAN_DATA, getScanByteOffset(end));
+        else if (end > marker.first)
+            reportValidationError(ValidationError::TRUNCATED_SCAN, markerOffset);
+        
+        if (m_validationResult.error != ValidationError::NONE)
+        {
+            logFile << "[ FATAL ] Restart interval #" << std::dec << interval << " doesn't end at its restart marker" << std::endl;
+            return false;
+        }
+        
+        return true;
+    }
+    
+    bool Decoder::validateScanEnd(const std::size_t unitCount)
+    {
+        const std::size_t end = (m_bitReader.getBitPosition() + 7) / 8;
+        const std::size_t restartCount = m_restartInterval > 0 ? (unitCount - 1) / m_restartInterval : 0;
+        
+        if (end > m_scanData.size())
+            reportValidationError(ValidationError::TRUNCATED_SCAN, getScanByteOffset(m_scanData.size()));
+        else if (m_restartMarkers.size() > restartCount)
+            reportValidationError(ValidationError::INVALID_RESTART_MARKER, getScanByteOffset(m_restartMarkers[restartCount].first) - 2);
+        else if (end < m_scanData.size())
+            reportValidationError(ValidationError::EXTRANEOUS_SCAN_DATA, getScanByteOffset(end));
+        
+        if (m_validationResult.error != ValidationError::NONE)
+        {
+            logFile << "[ FATAL ] The scan data doesn't end with the last block of the scan" << std::endl;
+            return false;
+        }
+        
+        return true;
+    }
+    
+    bool Decoder::validateScanHeader(const UInt16 length)
+    {
+        if (m_frameWidth == 0)
+        {
+            logFile << "[ FATAL ] Scan found before the frame" << std::endl;
+            reportValidationError(ValidationError::MISSING_FRAME, m_segmentOffset);
+            return false;
+        }
+        
+        // The component IDs & tables were checked as they were parsed
+        bool isValid = length == 6 + 2 * m_scanCompCount;
+        
+        // A baseline scan has all the coefficients at full precision, a
+        // progressive one a band of the DC or of the AC coefficients of one component
+        if (!m_isProgressive)
+            isValid = isValid && m_spectralStart == 0 && m_spectralEnd == 63 && m_approxHigh == 0 && m_approxLow == 0;
+        else
+        {
+            isValid = isValid && m_spectralStart <= m_spectralEnd && m_spectralEnd <= 63 &&
+                      (m_spectralStart == 0) == (m_spectralEnd == 0) &&
+                      (m_spectralStart == 0 || m_scanCompCount == 1) && m_approxLow <= 13;
+        }
+        
+        if (!isValid)
+        {
+            logFile << "[ FATAL ] Invalid scan parameters" << std::endl;
+            reportValidationError(ValidationError::INVALID_SEGMENT, m_segmentOffset);
+            return false;
+        }
+        
+        // A baseline image is decoded from a single scan of all the components
+        if (!m_isProgressive && (m_scanCompCount != 3 || m_scanCount > 0))
+        {
+            logFile << "Only baseline images with a single interleaved scan are supported" << std::endl;
+            reportValidationError(ValidationError::UNSUPPORTED, m_segmentOffset);
+            return false;
+        }
+        
+        // The tables of the components, & those the MCUs take for the
+        // luminance & the chrominance
+        for (auto compID = 0; compID < 3; ++compID)
+        {
+            std::size_t QTable = m_componentQTables[compID];
+            
+            if (QTable >= m_QTables.size() || m_QTables[QTable].size() != 64 ||
+                m_QTables.size() < 2 || m_QTables[compID == 0 ? 0 : 1].size() != 64)
+            {
+                logFile << "[ FATAL ] Quantization table #" << QTable << " isn't defined" << std::endl;
+                reportValidationError(ValidationError::MISSING_TABLE, m_segmentOffset);
+                return false;
+            }
+        }
+        
+        return true;
+    }
+    
+    void Decoder::reportValidationError(const ValidationError error, const std::size_t offset)
+    {
+        if (m_validationResult.error != ValidationError::NONE)
+            return;
+        
+        m_validationResult.error = error;
+        m_validationResult.offset = offset;
+    }
+    
+    void Decoder::reportInvalidCode()
+    {
+        if (m_bitReader.isAtEnd())
+            reportValidationError(ValidationError::TRUNCATED_SCAN, getScanByteOffset(m_scanData.size()));
+        else
+            reportValidationError(ValidationError::INVALID_HUFFMAN_CODE, getScanByteOffset(m_bitReader.getBitPosition() / 8));
+    }
+    
+    std::size_t Decoder::getScanByteOffset(const std::size_t index) const
+    {
+        // The last bytes removed before the byte
+        auto next = std::upper_bound(m_removedBytes.begin(), m_removedBytes.end(), index,
+                                     [](const std::size_t scanIndex, const std::pair<std::size_t, std::size_t>& removed)
+                                     {
+                                         return scanIndex < removed.first;
+                                     });
+        
+        return m_scanDataOffset + index + (next == m_removedBytes.begin() ? 0 : (next - 1)->second);
+    }
+    
+    bool Decoder::outputBlockCoefficients(const int compIndex, const std::size_t blockIndex, Int16* coeffs)
+    {
+        if (m_coefficientOrder == CoefficientOrder::NATURAL)
+            zigZagToNatural(coeffs);
+        
+        if (m_blockCallback)
+            return m_blockCallback(compIndex, blockIndex, coeffs);
+        
+        return true;
+    }
+    
+    void Decoder::decodeProgressiveScan()
+    {
+        if (m_scanData.empty())
+        {
+            logFile << " [ FATAL ] Invalid image scan data" << std::endl;
+            return;
+        }
+        
+        logFile << "Decoding progressive scan #" << m_scanCount << "..." << std::endl;
+        
+        // With no subsampling, interleaved & non-interleaved scans
+        // both visit the blocks of a component in raster order
+        int blocksPerLine = (m_frameWidth + 7) / 8;
+        int blockCount = blocksPerLine * ((m_frameHeight + 7) / 8);
+        
+        m_bitReader.setData(m_scanData.data(), m_scanData.size());
+        
+        m_EOBRun = 0;
+        std::fill(m_DCPredictor, m_DCPredictor + 3, 0);
+        
+        for (auto block = 0; block < blockCount; ++block)
+        {
+            // Validation stops at the first error
+            if (m_isValidating && m_validationResult.error != ValidationError::NONE)
+                return;
+            
+            if (block % blocksPerLine == 0 && isDecodeCancelled())
+                return;
+            
+            // Each restart interval starts at a byte boundary, with fresh
+            // DC predictors & no end-of-band run
+            if (m_restartInterval > 0 && block > 0 && block % m_restartInterval == 0)
+            {
+                m_bitReader.alignToByte();
+                m_EOBRun = 0;
+                std::fill(m_DCPredictor, m_DCPredictor + 3, 0);
+                
+                if (m_isValidating && !validateRestartMarker(block / m_restartInterval))
+                    return;
+            }
+            
+            for (auto i = 0; i < m_scanCompCount; ++i)
+            {
+                int compIndex = m_scanComponents[i];
+                Int16* coeffs = &m_coefficients[(compIndex * blockCount + block) * 64];
+                
+                if (m_spectralStart == 0)
+                {
+                    if (m_approxHigh == 0)
+                        decodeDCFirst(coeffs, *m_huffmanTable[HT_DC][m_scanDCTable[i]], compIndex);
+                    else
+                        decodeDCRefine(coeffs);
+                }
+                else
+                {
+                    if (m_approxHigh == 0)
+                        decodeACFirst(coeffs, *m_huffmanTable[HT_AC][m_scanACTable[i]]);
+                    else
+                        decodeACRefine(coeffs, *m_huffmanTable[HT_AC][m_scanACTable[i]]);
+                }
+            }
+        }
+        
+        if (m_isValidating && (m_validationResult.error != ValidationError::NONE || !validateScanEnd(blockCount)))
+            return;
+        
+        logFile << "Finished decoding progressive scan #" << m_scanCount << " [OK]" << std::endl;
+    }
+    
+    void Decoder::decodeDCFirst(Int16* coeffs, const HuffmanLookupTable& htable, const int compIndex)
+    {
+        int category = decodeHuffmanSymbol(htable);
+        
+        if (category < 0)
+        {
+            logFile << "[ FATAL ] Invalid DC Huffman code, possibly corrupt JFIF data stream!" << std::endl;
+            reportInvalidCode();
+            return;
+        }
+        
+        m_DCPredictor[compIndex] += receiveExtend(category);
+        coeffs[0] = m_DCPredictor[compIndex] * (1 << m_approxLow);
+    }
+    
+    void Decoder::decodeDCRefine(Int16* coeffs)
+    {
+        if (readBits(1))
+            coeffs[0] |= (1 << m_approxLow);
+    }
+    
+    void Decoder::decodeACFirst(Int16* coeffs, const HuffmanLookupTable& htable)
+    {
+        // This block lies within a run of blocks with an empty band
+        if (m_EOBRun > 0)
+        {
+            m_EOBRun--;
+            return;
+        }
+        
+        for (auto z = m_spectralStart; z <= m_spectralEnd; )
+        {
+            int value = decodeHuffmanSymbol(htable);
+            
+            if (value < 0)
+            {
+                logFile << "[ FATAL ] Invalid AC Huffman code, possibly corrupt JFIF data stream!" << std::endl;
+                reportInvalidCode();
+                return;
+            }
+            
+            int zeroCount = value >> 4;
+            int category = value & 0x0F;
+            
+            if (category == 0)
+            {
+                // EOBn, this and the next (2^n + extra bits - 1) blocks end here
+                if (zeroCount < 15)
+                {
+                    m_EOBRun = (1 << zeroCount) - 1;
+                    if (zeroCount > 0)
+                        m_EOBRun += readBits(zeroCount);
+                    break;
+                }
+                
+                // ZRL, a run of 16 zeros
+                z += 16;
+                continue;
+            }
+            
+            z += zeroCount;
+            
+            if (z > m_spectralEnd && m_isValidating)
+            {
+                reportValidationError(ValidationError::INVALID_COEFFICIENT, getScanByteOffset(m_bitReader.getBitPosition() / 8));
+                return;
+            }
+            
+            if (z > 63)
+                break;
+            
+            coeffs[z] = receiveExtend(category) * (1 << m_approxLow);
+            z++;
+        }
+    }
+    
+    void Decoder::decodeACRefine(Int16* coeffs, const HuffmanLookupTable& htable)
+    {
+        const int positive = 1 << m_approxLow;
+        const int negative = -positive;
+        
+        int z = m_spectralStart;
+        
+        if (m_EOBRun == 0)
+        {
+            while (z <= m_spectralEnd)
+            {
+                int value = decodeHuffmanSymbol(htable);
+                
+                if (value < 0)
+                {
+                    logFile << "[ FATAL ] Invalid AC Huffman code, possibly corrupt JFIF data stream!" << std::endl;
+                    reportInvalidCode();
+                    return;
+                }
+                
+                int zeroCount = value >> 4;
+                int category = value & 0x0F;
+                int newCoeff = 0;
+                
+                // A newly non-zero coefficient is always +/-1 at this bit position
+                if (category != 0)
+                    newCoeff = readBits(1) ? positive : negative;
+                
+                // EOBn, the remaining band of this block only has refinement bits
+                else if (zeroCount != 15)
+                {
+                    m_EOBRun = 1 << zeroCount;
+                    if (zeroCount > 0)
+                        m_EOBRun += readBits(zeroCount);
+                    break;
+                }
+                
+                // Skip zeroCount coefficients with a zero history, while refining
+                // the coefficients that are already non-zero along the way
+                while (z <= m_spectralEnd)
+                {
+                    if (coeffs[z] != 0)
+                    {
+                        if (readBits(1) && (coeffs[z] & positive) == 0)
+                            coeffs[z] += coeffs[z] >= 0 ? positive : negative;
+                    }
+                    else
+                    {
+                        if (zeroCount == 0)
+                            break;
+                        zeroCount--;
+                    }
+                    
+                    z++;
+                }
+                
+                if (newCoeff != 0 && z <= m_spectralEnd)
+                    coeffs[z] = newCoeff;
+                
+                z++;
+            }
+        }
+        
+        // Within a run of blocks with no new coefficients, only refine
+        if (m_EOBRun > 0)
+        {
+            for ( ; z <= m_spectralEnd; ++z)
+            {
+                if (coeffs[z] != 0)
+                {
+                    if (readBits(1) && (coeffs[z] & positive) == 0)
+                        coeffs[z] += coeffs[z] >= 0 ? positive : negative;
+                }
+            }
+            
+            m_EOBRun--;
+        }
+    }
+    
+    int Decoder::decodeHuffmanSymbol(const HuffmanLookupTable& htable)
+    {
+        return kpeg::decodeHuffmanSymbol(htable, m_bitReader);
+    }
+    
+    int Decoder::readBits(const int count)
+    {
+        return m_bitReader.readBits(count);
+    }
+    
+    int Decoder::receiveExtend(const int category)
+    {
+        return kpeg::receiveExtend(category, m_bitReader);
+    }
+    
+    void Decoder::renderProgressiveImage()
+    {
+        logFile << "Rendering progressive image from coefficients..." << std::endl;
+        
+        MCU::m_IDCTMode = m_IDCTMode;
+        getDequantizationTables(m_QTables, m_dequantizationTables, m_IDCTMode);
+        
+        int MCUsPerLine = (m_frameWidth + 7) / 8;
+        int blockCount = MCUsPerLine * ((m_frameHeight + 7) / 8);
+        
+        m_MCU.clear();
+        m_MCU.reserve(((m_cropX + m_cropWidth - 1) / 8 - m_cropX / 8 + 1) * ((m_cropY + m_cropHeight - 1) / 8 - m_cropY / 8 + 1));
+        
+        for (std::size_t row = m_cropY / 8; row <= (m_cropY + m_cropHeight - 1) / 8; ++row)
+        {
+            if (isDecodeCancelled())
+                return;
+            
+            for (std::size_t col = m_cropX / 8; col <= (m_cropX + m_cropWidth - 1) / 8; ++col)
+            {
+                int block = row * MCUsPerLine + col;
+                
+                std::array<const Int16*, 3> compCoeffs = {
+                    &m_coefficients[(0 * blockCount + block) * 64],
+                    &m_coefficients[(1 * blockCount + block) * 64],
+                    &m_coefficients[(2 * blockCount + block) * 64]
+                };
+                
+                m_MCU.push_back(MCU(compCoeffs, m_dequantizationTables));
+            }
+        }
+        
+        createImageFromMCUs();
+        
+        logFile << "Finished rendering progressive image [OK]" << std::endl;
+    }
+    
+    bool Decoder::createImageFromMCUs()
+    {
+        // The image only covers the crop window, which starts somewhere
+        // inside the first decoded MCU
+        const std::size_t MCUsPerLine = (m_cropX + m_cropWidth - 1) / 8 - m_cropX / 8 + 1;
+        const std::size_t MCURows = (m_cropY + m_cropHeight - 1) / 8 - m_cropY / 8 + 1;
+        
+        if (m_tensorOutput != nullptr)
+        {
+            return writeTensorFromMCUs(m_MCU.data(),
+                                       m_MCU.size(),
+                                       MCUsPerLine,
+                                       m_cropX % 8,
+                                       m_cropY % 8,
+                                       m_cropWidth,
+                                       m_cropHeight,
+                                       m_tensorOptions,
+                                       m_tensorOutput);
+        }
+        
+        // The MCUs of a scan that stopped partway don't cover the window,
+        // & the pixels of a reused buffer they'd leave are another image's
+        if (m_MCU.size() < MCUsPerLine * MCURows)
+        {
+            logFile << "[ FATAL ] Only " << m_MCU.size() << " of the " << MCUsPerLine * MCURows
+                    << " MCUs of the image were decoded" << std::endl;
+            return false;
+        }
+        
+        // The orientation is applied as the pixels are placed, which
+        // swaps the width & the height of the transposed orientations
+        const Orientation orientation = m_isApplyingOrientation ? m_orientation : Orientation::NORMAL;
+        const bool isTransposed = orientation >= Orientation::TRANSPOSE;
+        
+        m_image.width = m_cropWidth;
+        m_image.height = m_cropHeight;
+        m_image.createImageFromMCUs(m_MCU.data(),
+                                    m_MCU.size(),
+                                    MCUsPerLine,
+                                    m_cropX % 8,
+                                    m_cropY % 8,
+                                    m_bufferPool != nullptr ? m_bufferPool->acquire(isTransposed ? m_cropHeight : m_cropWidth,
+                                                                                    isTransposed ? m_cropWidth : m_cropHeight) : nullptr,
+                                    orientation);
+        
+        return true;
+    }
+}
@@ -0,0 +1,889 @@
+// Implementation of the baseline encoder module
+
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+
+#include "Encoder.hpp"
+#include "Markers.hpp"
+#include "StandardTables.hpp"
+#include "Transform.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        // Write a 16-bit value, most significant byte first
+        void writeUInt16(std::ostream& out, const std::size_t value)
+        {
+            out.put(char((value >> 8) & 0xFF));
+            out.put(char(value & 0xFF));
+        }
+
+        void writeMarker(std::ostream& out, const UInt16 marker)
+        {
+            out.put(char(JFIF_BYTE_FF));
+            out.put(char(marker));
+        }
+
+        // The number of bits of the magnitude of a value, its DC/AC category
+        int getCategory(int value)
+        {
+            value = std::abs(value);
+
+            int category = 0;
+            while (value > 0)
+            {
+                value >>= 1;
+                category++;
+            }
+
+            return category;
+        }
+
+        // The 8-point DCT basis, scaled so the 2D transform is separable:
+        // basis[u][x] = C(u) / 2 * cos((2x + 1) * u * pi / 16)
+        struct DCTBasis
+        {
+            DCTBasis()
+            {
+                for (auto u = 0; u < 8; ++u)
+                    for (auto x = 0; x < 8; ++x)
+                        basis[u][x] = float((u == 0 ? 1.0 / std::sqrt(2.0) : 1.0) / 2.0 *
+                                            std::cos((2 * x + 1) * u * M_PI / 16.0));
+            }
+
+            float basis[8][8];
+        };
+
+        const DCTBasis DCT_BASIS;
+
+        // Build the Huffman table with the shortest code for the symbol
+        // counts, as Annex K.2 does: a reserved symbol that's counted once
+        // gets the code of only 1 bits, which isn't allowed, and the codes
+        // longer than 16 bits are moved up the tree
+        // @param counts the number of times each of the 256 symbols is coded
+        // @param bits receives the number of codes of each length from 1 to 16 bits
+        // @param values receives the symbols, in order of code length
+        void buildOptimalHuffmanTable(const std::uint32_t* counts, UInt8* bits, std::vector<UInt8>& values)
+        {
+            // Figure K.1, the code sizes of a Huffman code for the counts
+            std::uint64_t frequencies[257];
+            int codeSizes[257];
+            int others[257];
+
+            for (auto i = 0; i < 256; ++i)
+                frequencies[i] = counts[i];
+
+            frequencies[256] = 1;
+            std::fill(codeSizes, codeSizes + 257, 0);
+            std::fill(others, others + 257, -1);
+
+            while (true)
+            {
+                // The least frequent symbols, the higher one on a tie
+                int first = -1;
+                int second = -1;
+
+                for (auto i = 0; i < 257; ++i)
+                {
+                    if (frequencies[i] != 0 && (first < 0 || frequencies[i] <= frequencies[first]))
+                        first = i;
+                }
+
+                for (auto i = 0; i < 257; ++i)
+                {
+                    if (frequencies[i] != 0 && i != first && (second < 0 || frequencies[i] <= frequencies[second]))
+                        second = i;
+                }
+
+                if (second < 0)
+                    break;
+
+                // Merge the branches of both symbols, one level down
+                frequencies[first] += frequencies[second];
+                frequencies[second] = 0;
+
+                codeSizes[first]++;
+                while (others[first] >= 0)
+                {
+                    first = others[first];
+                    codeSizes[first]++;
+                }
+
+                others[first] = second;
+
+                codeSizes[second]++;
+                while (others[second] >= 0)
+                {
+                    second = others[second];
+                    codeSizes[second]++;
+                }
+            }
+
+            // Figure K.2, the number of codes of each size, which can exceed
+            // 16 bits, though never 32 with at most 257 symbols
+            int sizeCounts[33] = {};
+
+            for (auto i = 0; i < 257; ++i)
+            {
+                if (codeSizes[i] > 0)
+                    sizeCounts[std::min(codeSizes[i], 32)]++;
+            }
+
+            // Figure K.3, a pair of the longest codes is replaced by a code
+            // one bit shorter, and a shorter code grows by a bit to prefix
+            // a second code that's one bit longer
+            for (auto size = 32; size > 16; --size)
+            {
+                while (sizeCounts[size] > 0)
+                {
+                    int shorter = size - 2;
+                    while (sizeCounts[shorter] == 0)
+                        shorter--;
+
+                    sizeCounts[size] -= 2;
+                    sizeCounts[size - 1]++;
+                    sizeCounts[shorter + 1] += 2;
+                    sizeCounts[shorter]--;
+                }
+            }
+
+            // Drop the reserved symbol, which has the longest code
+            auto longest = 16;
+            while (sizeCounts[longest] == 0)
+                longest--;
+            sizeCounts[longest]--;
+
+            for (auto size = 1; size <= 16; ++size)
+                bits[size - 1] = UInt8(sizeCounts[size]);
+
+            // Figure K.4, the symbols sorted by code size, the reserved symbol
+            // being last
+            values.clear();
+
+            for (auto size = 1; size <= 32; ++size)
+            {
+                for (auto i = 0; i < 256; ++i)
+                {
+                    if (codeSizes[i] == size)
+                        values.push_back(UInt8(i));
+                }
+            }
+        }
+    }
+
+    // PPMSource class
+
+    PPMSource::PPMSource(const std::string& filename) :
+        m_file{filename, std::ios::in | std::ios::binary},
+        m_width{0},
+        m_height{0},
+        m_isValid{false}
+    {
+        if (!m_file.is_open())
+        {
+            logFile << "Unable to open PPM image: \'" + filename + "\'" << std::endl;
+            return;
+        }
+
+        // Read the next number of the header, skipping whitespace & comments
+        auto readNumber = [this](std::size_t& value)
+        {
+            int ch = m_file.get();
+
+            while (ch != EOF && (std::isspace(ch) || ch == '#'))
+            {
+                if (ch == '#')
+                    while (ch != EOF && ch != '\n')
+                        ch = m_file.get();
+                ch = m_file.get();
+            }
+
+            if (!std::isdigit(ch))
+                return false;
+
+            value = 0;
+            while (std::isdigit(ch))
+            {
+                value = value * 10 + (ch - '0');
+                ch = m_file.get();
+            }
+
+            // A single whitespace character ends the number
+            return ch != EOF;
+        };
+
+        char magic[2] = { 0, 0 };
+        m_file.read(magic, 2);
+
+        std::size_t maxValue = 0;
+
+        if (magic[0] != 'P' || magic[1] != '6' ||
+            !readNumber(m_width) || !readNumber(m_height) || !readNumber(maxValue) ||
+            maxValue != 255 || m_width == 0 || m_height == 0)
+        {
+            logFile << "Not an 8-bit binary PPM image: \'" + filename + "\'" << std::endl;
+            return;
+        }
+
+        m_isValid = true;
+
+        logFile << "Opened PPM image: \'" + filename + "\', " << m_width << "x" << m_height << std::endl;
+    }
+
+    bool PPMSource::isValid() const
+    {
+        return m_isValid;
+    }
+
+    std::size_t PPMSource::getWidth() const
+    {
+        return m_width;
+    }
+
+    std::size_t PPMSource::getHeight() const
+    {
+        return m_height;
+    }
+
+    bool PPMSource::readRows(UInt8* rows, const std::size_t rowCount)
+    {
+        if (!m_isValid)
+            return false;
+
+        m_file.read(reinterpret_cast<char*>(rows), rowCount * m_width * 3);
+        return m_file.good();
+    }
+
+    // PatternSource class
+
+    PatternSource::PatternSource(const std::size_t width, const std::size_t height,
+                                 const int entropy, const std::uint32_t seed) :
+        m_width{width},
+        m_height{height},
+        m_entropy{std::max(0, std::min(entropy, 100))},
+        m_seed{seed},
+        m_state{seed ? seed : 0x9E3779B9},
+        m_row{0},
+        m_cellSize{std::size_t(64 - m_entropy / 2)}
+    {
+    }
+
+    std::size_t PatternSource::getWidth() const
+    {
+        return m_width;
+    }
+
+    std::size_t PatternSource::getHeight() const
+    {
+        return m_height;
+    }
+
+    std::uint32_t PatternSource::nextRandom()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    std::uint32_t PatternSource::hashCell(const std::size_t cellX, const std::size_t cellY) const
+    {
+        std::uint32_t hash = m_seed ^ 0x811C9DC5;
+        hash = (hash ^ std::uint32_t(cellX)) * 0x01000193;
+        hash = (hash ^ std::uint32_t(cellY)) * 0x01000193;
+        hash ^= hash >> 15;
+        hash *= 0x2C1B3C6D;
+        hash ^= hash >> 12;
+        return hash;
+    }
+
+    bool PatternSource::readRows(UInt8* rows, const std::size_t rowCount)
+    {
+        const int noiseAmplitude = m_entropy * 128 / 100;
+        const std::size_t radius = m_cellSize * 3 / 8;
+
+        for (std::size_t i = 0; i < rowCount; ++i, ++m_row)
+        {
+            if (m_row >= m_height)
+                return false;
+
+            std::size_t y = m_row;
+            UInt8* pixel = rows + i * m_width * 3;
+
+            for (std::size_t x = 0; x < m_width; ++x, pixel += 3)
+            {
+                // A smooth gradient over the whole image
+                int colour[3] = {
+                    int(255 * x / std::max<std::size_t>(m_width - 1, 1)),
+                    int(255 * y / std::max<std::size_t>(m_height - 1, 1)),
+                    int(255 - 255 * (x + y) / std::max<std::size_t>(m_width + m_height - 2, 1))
+                };
+
+                // Some cells of a grid hold a disc of a flat colour, the
+                // higher the entropy the more of them
+                std::uint32_t cell = hashCell(x / m_cellSize, y / m_cellSize);
+
+                if (int(cell % 100) < m_entropy)
+                {
+                    long dx = long(x % m_cellSize) - long(m_cellSize / 2);
+                    long dy = long(y % m_cellSize) - long(m_cellSize / 2);
+
+                    if (std::size_t(dx * dx + dy * dy) <= radius * radius)
+                    {
+                        colour[0] = (cell >> 8) & 0xFF;
+                        colour[1] = (cell >> 16) & 0xFF;
+                        colour[2] = (cell >> 24) & 0xFF;
+                    }
+                }
+
+                for (auto c = 0; c < 3; ++c)
+                {
+                    int noise = noiseAmplitude ? int(nextRandom() % (2 * noiseAmplitude + 1)) - noiseAmplitude : 0;
+                    pixel[c] = UInt8(std::max(0, std::min(colour[c] + noise, 255)));
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Encoder class
+
+    Encoder::Encoder() :
+        Encoder(Settings())
+    {
+    }
+
+    Encoder::Encoder(const Settings& settings) :
+        m_settings{settings},
+        m_isCountingSymbols{false},
+        m_DCPredictor{0, 0, 0},
+        m_bitBuffer{0},
+        m_bitCount{0}
+    {
+        // Scale the Annex K quantization tables the way the IJG encoder does,
+        // so a quality gives the same tables (and file sizes) as libjpeg
+        int quality = std::max(1, std::min(m_settings.quality, 100));
+        int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+
+        for (auto row = 0; row < 8; ++row)
+        {
+            for (auto col = 0; col < 8; ++col)
+            {
+                int zz = matIndicesToZZOrder(row, col);
+                m_zzOrder[row * 8 + col] = zz;
+
+                int luminance = (STD_LUMINANCE_QUANT_TABLE[row * 8 + col] * scale + 50) / 100;
+                int chrominance = (STD_CHROMINANCE_QUANT_TABLE[row * 8 + col] * scale + 50) / 100;
+
+                m_QTables[0][zz] = UInt16(std::max(1, std::min(luminance, 255)));
+                m_QTables[1][zz] = UInt16(std::max(1, std::min(chrominance, 255)));
+            }
+        }
+
+        setStandardHuffmanTables();
+
+        logFile << "Created \'Encoder object\', quality " << quality << std::endl;
+    }
+
+    bool Encoder::encode(ImageSource& source, const std::string& filename)
+    {
+        std::ofstream outFile(filename, std::ios::out | std::ios::binary);
+
+        if (!outFile.is_open())
+        {
+            logFile << "Unable to create JPEG image: \'" + filename + "\'" << std::endl;
+            return false;
+        }
+
+        return encode(source, outFile);
+    }
+
+    bool Encoder::encode(ImageSource& source, std::ostream& out)
+    {
+        const std::size_t width = source.getWidth();
+        const std::size_t height = source.getHeight();
+
+        if (width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF)
+        {
+            logFile << "[ FATAL ] Image size " << width << "x" << height << " can't be encoded as JPEG" << std::endl;
+            return false;
+        }
+
+        logFile << "Encoding " << width << "x" << height << " image..." << std::endl;
+
+        // The luminance sampling factors, the chrominance ones are 1x1
+        const int hFactor = m_settings.sampling == YUV444 ? 1 : 2;
+        const int vFactor = m_settings.sampling == YUV420 ? 2 : 1;
+
+        const std::size_t MCUWidth = 8 * hFactor;
+        const std::size_t MCUHeight = 8 * vFactor;
+        const std::size_t MCUsPerLine = (width + MCUWidth - 1) / MCUWidth;
+        const std::size_t MCURows = (height + MCUHeight - 1) / MCUHeight;
+        const std::size_t paddedWidth = MCUsPerLine * MCUWidth;
+
+        setStandardHuffmanTables();
+        writeHeaders(out, width, height, m_settings.sampling, m_QTables);
+
+        m_DCPredictor[0] = m_DCPredictor[1] = m_DCPredictor[2] = 0;
+        m_bitBuffer = 0;
+        m_bitCount = 0;
+        m_scanData.clear();
+
+        // One band of MCU rows, as RGB & as level-shifted Y, Cb & Cr planes
+        // padded to whole MCUs by repeating the last column & row
+        std::vector<UInt8> rgb(MCUHeight * width * 3);
+        std::vector<float> planes[3];
+        for (auto&& plane : planes)
+            plane.resize(MCUHeight * paddedWidth);
+
+        std::size_t MCUIndex = 0;
+        std::size_t restartCount = 0;
+
+        for (std::size_t MCURow = 0; MCURow < MCURows; ++MCURow)
+        {
+            std::size_t rowCount = std::min(MCUHeight, height - MCURow * MCUHeight);
+
+            if (!source.readRows(rgb.data(), rowCount))
+            {
+                logFile << "[ FATAL ] Unable to read image rows " << MCURow * MCUHeight << "+" << std::endl;
+                return false;
+            }
+
+            for (std::size_t y = 0; y < MCUHeight; ++y)
+            {
+                const UInt8* row = &rgb[std::min(y, rowCount - 1) * width * 3];
+
+                for (std::size_t x = 0; x < paddedWidth; ++x)
+                {
+                    const UInt8* pixel = row + std::min(x, width - 1) * 3;
+                    float R = pixel[0], G = pixel[1], B = pixel[2];
+
+                    std::size_t i = y * paddedWidth + x;
+                    planes[0][i] =  0.299f    * R + 0.587f    * G + 0.114f    * B - 128.0f;
+                    planes[1][i] = -0.168736f * R - 0.331264f * G + 0.5f      * B;
+                    planes[2][i] =  0.5f      * R - 0.418688f * G - 0.081312f * B;
+                }
+            }
+
+            for (std::size_t MCUCol = 0; MCUCol < MCUsPerLine; ++MCUCol, ++MCUIndex)
+            {
+                writeRestartMarker(MCUIndex, restartCount);
+
+                const std::size_t x0 = MCUCol * MCUWidth;
+                float block[64];
+
+                // The luminance blocks of the MCU, left to right, top to bottom
+                for (auto v = 0; v < vFactor; ++v)
+                {
+                    for (auto h = 0; h < hFactor; ++h)
+                    {
+                        for (auto y = 0; y < 8; ++y)
+                            for (auto x = 0; x < 8; ++x)
+                                block[y * 8 + x] = planes[0][(v * 8 + y) * paddedWidth + x0 + h * 8 + x];
+
+                        encodeBlock(block, 0);
+                    }
+                }
+
+                // One block of each chrominance component, averaged over the
+                // samples it covers
+                for (auto compID = 1; compID < 3; ++compID)
+                {
+                    for (auto y = 0; y < 8; ++y)
+                    {
+                        for (auto x = 0; x < 8; ++x)
+                        {
+                            float sum = 0.0f;
+
+                            for (auto v = 0; v < vFactor; ++v)
+                                for (auto h = 0; h < hFactor; ++h)
+                                    sum += planes[compID][(y * vFactor + v) * paddedWidth + x0 + x * hFactor + h];
+
+                            block[y * 8 + x] = sum / (hFactor * vFactor);
+                        }
+                    }
+
+                    encodeBlock(block, compID);
+                }
+            }
+
+            // The scan data is written out a band at a time
+            out.write(reinterpret_cast<const char*>(m_scanData.data()), m_scanData.size());
+            m_scanData.clear();
+        }
+
+        flushBits();
+        out.write(reinterpret_cast<const char*>(m_scanData.data()), m_scanData.size());
+        m_scanData.clear();
+
+        writeMarker(out, JFIF_EOI);
+
+        logFile << "Finished encoding image [OK]" << std::endl;
+
+        return out.good();
+    }
+
+    bool Encoder::encodeCoefficients(const std::size_t width, const std::size_t height,
+                                     const UInt16 (&QTables)[2][64],
+                                     const BlockSource& getBlock, std::ostream& out)
+    {
+        if (width == 0 || height == 0 || width > 0xFFFF || height > 0xFFFF)
+        {
+            logFile << "[ FATAL ] Image size " << width << "x" << height << " can't be encoded as JPEG" << std::endl;
+            return false;
+        }
+
+        logFile << "Encoding " << width << "x" << height << " image from coefficients..." << std::endl;
+
+        const std::size_t blocksPerLine = (width + 7) / 8;
+        const std::size_t blockRows = (height + 7) / 8;
+
+        auto encodeScan = [&]
+        {
+            m_DCPredictor[0] = m_DCPredictor[1] = m_DCPredictor[2] = 0;
+            m_bitBuffer = 0;
+            m_bitCount = 0;
+            m_scanData.clear();
+
+            std::size_t restartCount = 0;
+            int zzOrder[64];
+
+            for (std::size_t blockY = 0; blockY < blockRows; ++blockY)
+            {
+                for (std::size_t blockX = 0; blockX < blocksPerLine; ++blockX)
+                {
+                    writeRestartMarker(blockY * blocksPerLine + blockX, restartCount);
+
+                    for (auto compID = 0; compID < 3; ++compID)
+                    {
+                        getBlock(compID, blockX, blockY, zzOrder);
+                        encodeCoefficientBlock(zzOrder, compID);
+                    }
+                }
+
+                // The scan data is written out a row of MCUs at a time
+                out.write(reinterpret_cast<const char*>(m_scanData.data()), m_scanData.size());
+                m_scanData.clear();
+            }
+
+            flushBits();
+            out.write(reinterpret_cast<const char*>(m_scanData.data()), m_scanData.size());
+            m_scanData.clear();
+        };
+
+        if (m_settings.optimizeHuffmanTables)
+        {
+            std::fill(&m_symbolCounts[0][0][0], &m_symbolCounts[0][0][0] + 2 * 2 * 256, 0);
+
+            m_isCountingSymbols = true;
+            encodeScan();
+            m_isCountingSymbols = false;
+
+            setOptimalHuffmanTables();
+        }
+        else
+            setStandardHuffmanTables();
+
+        writeHeaders(out, width, height, YUV444, QTables);
+        encodeScan();
+
+        writeMarker(out, JFIF_EOI);
+
+        logFile << "Finished encoding image from coefficients [OK]" << std::endl;
+
+        return out.good();
+    }
+
+    void Encoder::writeHeaders(std::ostream& out, const std::size_t width, const std::size_t height,
+                               const Sampling sampling, const UInt16 (&QTables)[2][64])
+    {
+        writeMarker(out, JFIF_SOI);
+
+        // JFIF 1.01, no units, 1:1 pixel aspect ratio, no thumbnail
+        writeMarker(out, JFIF_APP0);
+        writeUInt16(out, 16);
+        out.write("JFIF", 5);
+        out.put(1);
+        out.put(1);
+        out.put(0);
+        writeUInt16(out, 1);
+        writeUInt16(out, 1);
+        out.put(0);
+        out.put(0);
+
+        // Both quantization tables, 8-bit precision
+        writeMarker(out, JFIF_DQT);
+        writeUInt16(out, 2 + 2 * 65);
+        for (auto table = 0; table < 2; ++table)
+        {
+            out.put(char(table));
+            for (auto i = 0; i < 64; ++i)
+                out.put(char(QTables[table][i]));
+        }
+
+        // Y, Cb & Cr, the chrominance uses the second quantization table
+        const int hFactor = sampling == YUV444 ? 1 : 2;
+        const int vFactor = sampling == YUV420 ? 2 : 1;
+
+        writeMarker(out, JFIF_SOF0);
+        writeUInt16(out, 8 + 3 * 3);
+        out.put(8);
+        writeUInt16(out, height);
+        writeUInt16(out, width);
+        out.put(3);
+        out.put(1);
+        out.put(char((hFactor << 4) | vFactor));
+        out.put(0);
+        for (auto compID = 2; compID <= 3; ++compID)
+        {
+            out.put(char(compID));
+            out.put(0x11);
+            out.put(1);
+        }
+
+        // The four Huffman tables, in one segment
+        std::size_t DHTLength = 2;
+        for (auto type = 0; type < 2; ++type)
+            for (auto number = 0; number < 2; ++number)
+                DHTLength += 1 + 16 + m_huffmanValues[type][number].size();
+
+        writeMarker(out, JFIF_DHT);
+        writeUInt16(out, DHTLength);
+        for (auto type = 0; type < 2; ++type)
+        {
+            for (auto number = 0; number < 2; ++number)
+            {
+                out.put(char((type << 4) | number));
+                out.write(reinterpret_cast<const char*>(m_huffmanBits[type][number]), 16);
+                out.write(reinterpret_cast<const char*>(m_huffmanValues[type][number].data()),
+                          m_huffmanValues[type][number].size());
+            }
+        }
+
+        if (m_settings.restartInterval > 0)
+        {
+            writeMarker(out, JFIF_DRI);
+            writeUInt16(out, 4);
+            writeUInt16(out, std::min<std::size_t>(m_settings.restartInterval, 0xFFFF));
+        }
+
+        // A single interleaved scan of all the coefficients
+        writeMarker(out, JFIF_SOS);
+        writeUInt16(out, 6 + 2 * 3);
+        out.put(3);
+        out.put(1);
+        out.put(0x00);
+        for (auto compID = 2; compID <= 3; ++compID)
+        {
+            out.put(char(compID));
+            out.put(0x11);
+        }
+        out.put(0);
+        out.put(63);
+        out.put(0);
+    }
+
+    void Encoder::setStandardHuffmanTables()
+    {
+        for (auto type = 0; type < 2; ++type)
+        {
+            for (auto number = 0; number < 2; ++number)
+            {
+                const UInt8* bits = nullptr;
+                const UInt8* values = nullptr;
+                getStandardHuffmanTable(type, number, bits, values);
+
+                int symbolCount = 0;
+                for (auto i = 0; i < 16; ++i)
+                    symbolCount += bits[i];
+
+                std::copy(bits, bits + 16, m_huffmanBits[type][number]);
+                m_huffmanValues[type][number].assign(values, values + symbolCount);
+            }
+        }
+
+        setHuffmanCodes();
+    }
+
+    void Encoder::setOptimalHuffmanTables()
+    {
+        for (auto type = 0; type < 2; ++type)
+            for (auto number = 0; number < 2; ++number)
+                buildOptimalHuffmanTable(m_symbolCounts[type][number], m_huffmanBits[type][number],
+                                         m_huffmanValues[type][number]);
+
+        setHuffmanCodes();
+    }
+
+    void Encoder::setHuffmanCodes()
+    {
+        // The canonical Huffman codes of the tables (Annex C)
+        for (auto type = 0; type < 2; ++type)
+        {
+            for (auto number = 0; number < 2; ++number)
+            {
+                const UInt8* bits = m_huffmanBits[type][number];
+                const std::vector<UInt8>& values = m_huffmanValues[type][number];
+
+                std::fill(m_huffmanLengths[type][number], m_huffmanLengths[type][number] + 256, 0);
+
+                int code = 0;
+                int index = 0;
+
+                for (auto length = 1; length <= 16; ++length)
+                {
+                    for (auto i = 0; i < bits[length - 1]; ++i, ++code, ++index)
+                    {
+                        m_huffmanCodes[type][number][values[index]] = std::uint16_t(code);
+                        m_huffmanLengths[type][number][values[index]] = UInt8(length);
+                    }
+
+                    code <<= 1;
+                }
+            }
+        }
+    }
+
+    void Encoder::encodeBlock(const float* samples, const int compID)
+    {
+        const int table = compID == 0 ? 0 : 1;
+
+        // Separable forward DCT, first along the rows then along the columns
+        float rowDCT[64];
+
+        for (auto y = 0; y < 8; ++y)
+        {
+            for (auto u = 0; u < 8; ++u)
+            {
+                float sum = 0.0f;
+                for (auto x = 0; x < 8; ++x)
+                    sum += DCT_BASIS.basis[u][x] * samples[y * 8 + x];
+                rowDCT[y * 8 + u] = sum;
+            }
+        }
+
+        int zzOrder[64];
+
+        for (auto v = 0; v < 8; ++v)
+        {
+            for (auto u = 0; u < 8; ++u)
+            {
+                float sum = 0.0f;
+                for (auto y = 0; y < 8; ++y)
+                    sum += DCT_BASIS.basis[v][y] * rowDCT[y * 8 + u];
+
+                int zz = m_zzOrder[v * 8 + u];
+                zzOrder[zz] = int(std::lround(sum / m_QTables[table][zz]));
+            }
+        }
+
+        encodeCoefficientBlock(zzOrder, compID);
+    }
+
+    void Encoder::encodeCoefficientBlock(const int* zzOrder, const int compID)
+    {
+        const int table = compID == 0 ? 0 : 1;
+
+        // The DC coefficient is coded as the difference from the previous
+        // block of the component: its category, then its magnitude bits
+        int diff = zzOrder[0] - m_DCPredictor[compID];
+        m_DCPredictor[compID] = zzOrder[0];
+
+        int category = getCategory(diff);
+        writeSymbol(HT_DC, table, category);
+        writeBits(diff < 0 ? diff - 1 : diff, category);
+
+        // The AC coefficients are coded as runs of zeros & a value
+        int zeroRun = 0;
+
+        for (auto i = 1; i < 64; ++i)
+        {
+            if (zzOrder[i] == 0)
+            {
+                zeroRun++;
+                continue;
+            }
+
+            // ZRL, a run of 16 zeros
+            while (zeroRun > 15)
+            {
+                writeSymbol(HT_AC, table, 0xF0);
+                zeroRun -= 16;
+            }
+
+            // Baseline AC coefficients take at most 10 bits
+            int value = std::max(-1023, std::min(zzOrder[i], 1023));
+            category = getCategory(value);
+
+            int symbol = (zeroRun << 4) | category;
+            writeSymbol(HT_AC, table, symbol);
+            writeBits(value < 0 ? value - 1 : value, category);
+
+            zeroRun = 0;
+        }
+
+        // EOB, the rest of the block is zero
+        if (zeroRun > 0)
+            writeSymbol(HT_AC, table, 0x00);
+    }
+
+    void Encoder::writeSymbol(const int type, const int table, const int symbol)
+    {
+        if (m_isCountingSymbols)
+        {
+            m_symbolCounts[type][table][symbol]++;
+            return;
+        }
+
+        writeBits(m_huffmanCodes[type][table][symbol], m_huffmanLengths[type][table][symbol]);
+    }
+
+    void Encoder::writeRestartMarker(const std::size_t MCUIndex, std::size_t& restartCount)
+    {
+        // Restart markers cycle through RST0-RST7 between intervals,
+        // and every interval starts with fresh DC predictors
+        if (m_settings.restartInterval > 0 && MCUIndex > 0 && MCUIndex % m_settings.restartInterval == 0)
+        {
+            m_DCPredictor[0] = m_DCPredictor[1] = m_DCPredictor[2] = 0;
+
+            if (m_isCountingSymbols)
+                return;
+
+            flushBits();
+            m_scanData.push_back(UInt8(JFIF_BYTE_FF));
+            m_scanData.push_back(UInt8(JFIF_RST0 + (restartCount++ & 7)));
+        }
+    }
+
+    void Encoder::writeBits(const std::uint32_t value, const int count)
+    {
+        if (count == 0 || m_isCountingSymbols)
+            return;
+
+        m_bitBuffer = (m_bitBuffer << count) | (value & ((1u << count) - 1));
+        m_bitCount += count;
+
+        while (m_bitCount >= 8)
+        {
+            UInt8 byte = UInt8(m_bitBuffer >> (m_bitCount - 8));
+            m_scanData.push_back(byte);
+
+            if (byte == JFIF_BYTE_FF)
+                m_scanData.push_back(UInt8(JFIF_BYTE_0));
+
+            m_bitCount -= 8;
+        }
+    }
+
+    void Encoder::flushBits()
+    {
+        if (m_bitCount > 0)
+            writeBits(0x7F, 8 - m_bitCount);
+
+        m_bitBuffer = 0;
+    }
+}
@@ -0,0 +1,200 @@
+// Implementation of the Huffman lookup table module
+
+#include <algorithm>
+
+#include "HuffmanCache.hpp"
+#include "StandardTables.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    constexpr int HuffmanLookupTable::LOOKUP_BITS;
+    const std::size_t HuffmanCache::MAX_TABLES;
+
+    namespace
+    {
+        // The decoding tables of the standard Huffman tables, built by the compiler
+        constexpr HuffmanLookupTable STD_LOOKUP_TABLES[2][2] = {
+            {
+                buildHuffmanLookupTable(STD_DC_LUMINANCE_BITS, STD_DC_LUMINANCE_VALUES),
+                buildHuffmanLookupTable(STD_DC_CHROMINANCE_BITS, STD_DC_CHROMINANCE_VALUES)
+            },
+            {
+                buildHuffmanLookupTable(STD_AC_LUMINANCE_BITS, STD_AC_LUMINANCE_VALUES),
+                buildHuffmanLookupTable(STD_AC_CHROMINANCE_BITS, STD_AC_CHROMINANCE_VALUES)
+            }
+        };
+    }
+
+    int decodeHuffmanSymbol(const HuffmanLookupTable& htable, BitReader& reader)
+    {
+        if (reader.isAtEnd())
+            return -1;
+
+        // Huffman codes are at most 16 bits long
+        int code = reader.peekBits(16);
+
+        // Short codes are resolved with a single lookup of the next bits
+        int entry = htable.lookup[code >> (16 - HuffmanLookupTable::LOOKUP_BITS)];
+
+        if (entry != 0)
+        {
+            reader.skipBits(entry >> 8);
+            return entry & 0xFF;
+        }
+
+        // Longer codes are extended bit by bit
+        for (auto length = HuffmanLookupTable::LOOKUP_BITS + 1; length <= 16; ++length)
+        {
+            int prefix = code >> (16 - length);
+
+            if (prefix <= htable.maxCode[length])
+            {
+                reader.skipBits(length);
+                return htable.values[prefix + htable.valueOffset[length]];
+            }
+        }
+
+        return -1;
+    }
+
+    bool decodeBaselineBlock(const HuffmanLookupTable& DCTable, const HuffmanLookupTable& ACTable,
+                             BitReader& reader, int& DCPredictor, Int16* coeffs)
+    {
+        std::fill(coeffs, coeffs + 64, 0);
+
+        int category = decodeHuffmanSymbol(DCTable, reader);
+
+        if (category < 0)
+            return false;
+
+        DCPredictor += receiveExtend(category, reader);
+        coeffs[0] = DCPredictor;
+
+        for (auto k = 1; k < 64; )
+        {
+            int value = decodeHuffmanSymbol(ACTable, reader);
+
+            if (value < 0)
+                return false;
+
+            // EOB, the rest of the block is zero
+            if (value == 0x00)
+                break;
+
+            // A run of zeros, then a coefficient (ZRL, 0xF0, is 16 zeros)
+            k += value >> 4;
+
+            if (k > 63)
+                break;
+
+            coeffs[k++] = receiveExtend(value & 0x0F, reader);
+        }
+
+        return true;
+    }
+
+    HuffmanCache& HuffmanCache::getInstance()
+    {
+        static HuffmanCache cache;
+        return cache;
+    }
+
+    HuffmanCache::HuffmanCache() :
+        m_tableCount{0}
+    {
+        // DHT segments that carry the standard tables map to the prebuilt ones
+        for (auto type = 0; type < 2; ++type)
+        {
+            for (auto number = 0; number < 2; ++number)
+            {
+                const UInt8* bits = nullptr;
+                const UInt8* values = nullptr;
+                getStandardHuffmanTable(type, number, bits, values);
+
+                Entry entry;
+                entry.contents.assign(bits, bits + 16);
+
+                int symbolCount = 0;
+                for (auto i = 0; i < 16; ++i)
+                    symbolCount += bits[i];
+
+                entry.contents.insert(entry.contents.end(), values, values + symbolCount);
+                entry.table = getStandardTable(type, number);
+
+                std::uint64_t hash = hashTable(entry.contents.data(), entry.contents.size());
+                m_tables[hash].push_back(std::move(entry));
+                m_tableCount++;
+            }
+        }
+    }
+
+    HuffmanCache::TablePtr HuffmanCache::getStandardTable(const int type, const int number)
+    {
+        // The tables live for the whole program, so nothing is freed, and
+        // their pointers are shared, so getting one doesn't allocate
+        static const TablePtr tables[2][2] =
+        {
+            {
+                TablePtr(&STD_LOOKUP_TABLES[0][0], [](const HuffmanLookupTable*) {}),
+                TablePtr(&STD_LOOKUP_TABLES[0][1], [](const HuffmanLookupTable*) {})
+            },
+            {
+                TablePtr(&STD_LOOKUP_TABLES[1][0], [](const HuffmanLookupTable*) {}),
+                TablePtr(&STD_LOOKUP_TABLES[1][1], [](const HuffmanLookupTable*) {})
+            }
+        };
+        
+        return tables[type][number];
+    }
+
+    HuffmanCache::TablePtr HuffmanCache::getTable(const UInt8* data, const std::size_t size)
+    {
+        std::uint64_t hash = hashTable(data, size);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto bucket = m_tables.find(hash);
+
+        if (bucket != m_tables.end())
+        {
+            for (auto&& entry : bucket->second)
+            {
+                if (entry.contents.size() == size && std::equal(data, data + size, entry.contents.begin()))
+                {
+                    logFile << "Found Huffman decoding table in cache" << std::endl;
+                    return entry.table;
+                }
+            }
+        }
+
+        // The symbols follow the 16 code counts
+        TablePtr table = std::make_shared<const HuffmanLookupTable>(buildHuffmanLookupTable(data, data + 16));
+
+        if (m_tableCount >= MAX_TABLES)
+        {
+            logFile << "Huffman table cache is full, not caching the decoding table" << std::endl;
+            return table;
+        }
+
+        m_tables[hash].push_back({ std::vector<UInt8>(data, data + size), table });
+        m_tableCount++;
+
+        logFile << "Built Huffman decoding table, " << std::dec << m_tableCount << " tables in cache" << std::endl;
+
+        return table;
+    }
+
+    std::uint64_t HuffmanCache::hashTable(const UInt8* data, const std::size_t size)
+    {
+        std::uint64_t hash = 0xCBF29CE484222325ULL;
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= data[i];
+            hash *= 0x100000001B3ULL;
+        }
+
+        return hash;
+    }
+}
@@ -1,108 +1,206 @@
-// Image module implementation
-
-#include <arpa/inet.h> // htons
-#include <string>
-#include <cmath>
-
-#include "Utility.hpp" // importing the utility module in include/ directory
-#include "Image.hpp" // importing the image module in include/ directory
-
-namespace kpeg
-{
-    Image::Image() : // constructor invoked
-        width{0},
-        height{0},
-        m_pixelPtr{nullptr}
-    {
-        logFile << "Created new Image object" << std::endl; // for the log to output while execution
-    }
-    
-    void Image::createImageFromMCUs(const std::vector<MCU>& MCUs)
-    {
-        logFile << "Creating Image from MCU vector..." << std::endl; // for the log to output while execution
-        
-        int mcuNum = 0; // the value of the MCU, Minimum Coded Units, which are compressed image tiles that are usually only 8x8 pixels in size
-        
-        int jpegWidth = width % 8 == 0 ? width : width + 8 - (width % 8);
-        // calculating the width of the jpeg image
-        int jpegHeight = height % 8 == 0 ? height : height + 8 - (height % 8);
-        // calculating the height of the jpeg image
-        
-        // Create a pixel pointer of size (Image width) * (Image height)
-        m_pixelPtr = std::make_shared<std::vector<std::vector<Pixel>>>(
-            jpegHeight, std::vector<Pixel>(jpegWidth, Pixel()));
-        
-        // Populate the pixel pointer based on data from the specified MCUs
-        for (int y = 0; y <= jpegHeight - 8; y += 8) // scanning the rows of the jpeg image
-        {
-            for (int x = 0; x <= jpegWidth - 8; x += 8) // scanning the cols of the jpeg image
-            {
-                auto pixelBlock = MCUs[mcuNum].getAllMatrices(); // function to get matrices
-                
-                for (int v = 0; v < 8; ++v) // scanning the MCU row wise
-                {
-                    for (int u = 0; u < 8; ++u) // scanning the MCU column wise
-                    {
-                        (*m_pixelPtr)[y + v][x + u].comp[0] = pixelBlock[0][v][u]; // R component of the pixel
-                        (*m_pixelPtr)[y + v][x + u].comp[1] = pixelBlock[1][v][u]; // G component of the pixel
-                        (*m_pixelPtr)[y + v][x + u].comp[2] = pixelBlock[2][v][u]; // B component of the pixel
-                        /* In the above step, we are equating and decoding the pixel contents in the jepg image(Y, Cb, Cr) into R, G, B */
-                    }
-                }
-            
-                mcuNum++; // going to the next MCU or incrementing the number of MCUs
-            }
-        }
-        
-        // Trim the image width to nearest multiple of 8
-        if (width != jpegWidth)
-        {
-            for (auto&& row : *m_pixelPtr)
-                for (int c = 0; c < 8 - width % 8; ++c)
-                    row.pop_back();
-        }
-        
-        // Trim the image height to nearest multiple of 8
-        if (height != jpegHeight)
-        {
-            for (int c = 0; c < 8 - height % 8; ++c)
-                m_pixelPtr->pop_back();
-        }        
-
-        logFile << "Finished created Image from MCU [OK]" << std::endl; // completion message
-    }
-    
-    const bool Image::dumpRawData(const std::string& filename)
-    {
-        if (m_pixelPtr == nullptr) // in case of error, the pixel pointer is missing
-        {
-            logFile << "Unable to create dump file \'" + filename + "\', Invalid pixel pointer" << std::endl;
-            return false;
-        }
-        
-        std::ofstream dumpFile(filename, std::ios::out);
-        
-        if (!dumpFile.is_open() || !dumpFile.good()) // if the dump file for the output is closed or corrupt, throw error
-        {
-            logFile << "Unable to create dump file \'" + filename + "\'." << std::endl;
-            return false;
-        }
-        
-        dumpFile << "P6" << std::endl;
-        dumpFile << "# PPM dump created using libKPEG: https://github.com/TheIllusionistMirage/libKPEG" << std::endl;
-        dumpFile << width << " " << height << std::endl;
-        dumpFile << 255 << std::endl;
-        
-        for (auto&& row : *m_pixelPtr)
-        {
-            for (auto&& pixel : row)
-                dumpFile << (UInt8)pixel.comp[RGBComponents::RED] // loading the R value in the onject to the dump file
-                         << (UInt8)pixel.comp[RGBComponents::GREEN] // loading the G value in the onject to the dump file
-                         << (UInt8)pixel.comp[RGBComponents::BLUE]; // loading the B value in the onject to the dump file
-        }
-        
-        logFile << "Raw image data dumped to file: \'" + filename + "\'." << std::endl; // message of completion
-        dumpFile.close(); // close the dump file
-        return true; // return with no errors
-    }
-}
+// Image module implementation
+
+#include <arpa/inet.h> // htons
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+#include "Utility.hpp" // importing the utility module in include/ directory
+#include "Image.hpp" // importing the image module in include/ directory
+#include "BufferPool.hpp"
+
+namespace kpeg
+{
+    Image::Image() : // constructor invoked
+        width{0},
+        height{0},
+        m_pixelPtr{nullptr}
+    {
+        logFile << "Created new Image object" << std::endl; // for the log to output while execution
+    }
+    
+    void Image::createImageFromMCUs(const std::vector<MCU>& MCUs,
+                                    const std::size_t MCUsPerLine,
+                                    const std::size_t xOffset,
+                                    const std::size_t yOffset)
+    {
+        createImageFromMCUs(MCUs.data(), MCUs.size(), MCUsPerLine, xOffset, yOffset);
+    }
+    
+    void Image::createImageFromMCUs(const MCU* MCUs,
+                                    const std::size_t MCUCount,
+                                    const std::size_t MCUsPerLine,
+                                    const std::size_t xOffset,
+                                    const std::size_t yOffset,
+                                    const PixelPtr& pixels,
+                                    const Orientation orientation)
+    {
+        logFile << "Creating Image from MCU vector..." << std::endl; // for the log to output while execution
+        
+        // The size of the region of the frame, before it's oriented
+        const long regionWidth = long(width);
+        const long regionHeight = long(height);
+        
+        if (orientation >= Orientation::TRANSPOSE)
+            std::swap(width, height);
+        
+        // Get a pixel pointer of size (Image width) * (Image height), every
+        // pixel is overwritten below, so a reused buffer isn't cleared
+        if (pixels != nullptr)
+        {
+            m_pixelPtr = pixels;
+            resizePixelBuffer(*m_pixelPtr, width, height, width);
+        }
+        else if (m_pixelPtr != nullptr && m_pixelPtr.use_count() == 1)
+            resizePixelBuffer(*m_pixelPtr, width, height, width);
+        else
+            m_pixelPtr = std::make_shared<std::vector<std::vector<Pixel>>>(
+                height, std::vector<Pixel>(width, Pixel()));
+        
+        // Unless too few MCUs are given to cover the region, in which case
+        // the buffer is cleared, so that the pixels they don't cover aren't
+        // those of the image that used it last
+        if (MCUCount < MCUsPerLine * ((yOffset + std::size_t(regionHeight) + 7) / 8))
+        {
+            logFile << "Only " << MCUCount << " MCUs cover the image, clearing it" << std::endl;
+            
+            for (auto&& row : *m_pixelPtr)
+                std::fill(row.begin(), row.end(), Pixel());
+        }
+        
+        if (orientation != Orientation::NORMAL)
+        {
+            // The position of a pixel (x, y) of the region in the oriented
+            // image is (originX + xx * x + xy * y, originY + yx * x + yy * y)
+            long originX = 0, xx = 1, xy = 0;
+            long originY = 0, yx = 0, yy = 1;
+            
+            switch (orientation)
+            {
+                case Orientation::FLIP_HORIZONTAL : originX = regionWidth - 1;  xx = -1; break;
+                case Orientation::ROTATE_180      : originX = regionWidth - 1;  xx = -1; originY = regionHeight - 1; yy = -1; break;
+                case Orientation::FLIP_VERTICAL   : originY = regionHeight - 1; yy = -1; break;
+                case Orientation::TRANSPOSE       : xx = 0; xy = 1;  yx = 1;  yy = 0; break;
+                case Orientation::ROTATE_90       : originX = regionHeight - 1; xx = 0; xy = -1; yx = 1; yy = 0; break;
+                case Orientation::TRANSVERSE      : originX = regionHeight - 1; xx = 0; xy = -1; originY = regionWidth - 1; yx = -1; yy = 0; break;
+                case Orientation::ROTATE_270      : xx = 0; xy = 1; originY = regionWidth - 1; yx = -1; yy = 0; break;
+                default : break;
+            }
+            
+            for (std::size_t mcuNum = 0; mcuNum < MCUCount; ++mcuNum)
+            {
+                const auto& pixelBlock = MCUs[mcuNum].getAllMatrices();
+                
+                long x = long(mcuNum % MCUsPerLine) * 8 - long(xOffset);
+                long y = long(mcuNum / MCUsPerLine) * 8 - long(yOffset);
+                
+                for (long v = std::max(0L, -y); v < 8 && y + v < regionHeight; ++v)
+                {
+                    for (long u = std::max(0L, -x); u < 8 && x + u < regionWidth; ++u)
+                    {
+                        long orientedX = originX + xx * (x + u) + xy * (y + v);
+                        long orientedY = originY + yx * (x + u) + yy * (y + v);
+                        
+                        Pixel& pixel = (*m_pixelPtr)[orientedY][orientedX];
+                        pixel.comp[0] = pixelBlock[0][v][u];
+                        pixel.comp[1] = pixelBlock[1][v][u];
+                        pixel.comp[2] = pixelBlock[2][v][u];
+                    }
+                }
+            }
+            
+            logFile << "Finished created Image from MCU [OK]" << std::endl;
+            return;
+        }
+        
+        // Populate the pixel pointer based on data from the specified MCUs,
+        // the MCUs, which are compressed image tiles that are 8x8 pixels in size,
+        // are clipped against the image bounds
+        for (std::size_t mcuNum = 0; mcuNum < MCUCount; ++mcuNum)
+        {
+            const auto& pixelBlock = MCUs[mcuNum].getAllMatrices(); // function to get matrices
+            
+            // position of the MCU's top-left pixel, relative to the image
+            long x = long(mcuNum % MCUsPerLine) * 8 - long(xOffset);
+            long y = long(mcuNum / MCUsPerLine) * 8 - long(yOffset);
+            
+            for (long v = std::max(0L, -y); v < 8 && y + v < long(height); ++v) // scanning the MCU row wise
+            {
+                auto& row = (*m_pixelPtr)[y + v];
+                
+                for (long u = std::max(0L, -x); u < 8 && x + u < long(width); ++u) // scanning the MCU column wise
+                {
+                    row[x + u].comp[0] = pixelBlock[0][v][u]; // R component of the pixel
+                    row[x + u].comp[1] = pixelBlock[1][v][u]; // G component of the pixel
+                    row[x + u].comp[2] = pixelBlock[2][v][u]; // B component of the pixel
+                }
+            }
+        }
+        
+        logFile << "Finished created Image from MCU [OK]" << std::endl; // completion message
+    }
+    
+    void Image::createImageFromRGB(const UInt8* RGB,
+                                   const std::size_t imageWidth,
+                                   const std::size_t imageHeight)
+    {
+        width = imageWidth;
+        height = imageHeight;
+        
+        if (m_pixelPtr != nullptr && m_pixelPtr.use_count() == 1)
+            resizePixelBuffer(*m_pixelPtr, width, height, width);
+        else
+            m_pixelPtr = std::make_shared<std::vector<std::vector<Pixel>>>(
+                height, std::vector<Pixel>(width, Pixel()));
+        
+        for (auto&& row : *m_pixelPtr)
+        {
+            for (auto&& pixel : row)
+            {
+                pixel.comp[0] = RGB[0];
+                pixel.comp[1] = RGB[1];
+                pixel.comp[2] = RGB[2];
+                RGB += 3;
+            }
+        }
+    }
+    
+    const bool Image::dumpRawData(const std::string& filename) const
+    {
+        if (m_pixelPtr == nullptr) // in case of error, the pixel pointer is missing
+        {
+            logFile << "Unable to create dump file \'" + filename + "\', Invalid pixel pointer" << std::endl;
+            return false;
+        }
+        
+        std::ofstream dumpFile(filename, std::ios::out);
+        
+        if (!dumpFile.is_open() || !dumpFile.good()) // if the dump file for the output is closed or corrupt, throw error
+        {
+            logFile << "Unable to create dump file \'" + filename + "\'." << std::endl;
+            return false;
+        }
+        
+        dumpFile << "P6" << std::endl;
+        dumpFile << "# PPM dump created using libKPEG: https://github.com/TheIllusionistMirage/libKPEG" << std::endl;
+        dumpFile << width << " " << height << std::endl;
+        dumpFile << 255 << std::endl;
+        
+        for (auto&& row : *m_pixelPtr)
+        {
+            for (auto&& pixel : row)
+                dumpFile << (UInt8)pixel.comp[RGBComponents::RED] // loading the R value in the onject to the dump file
+                         << (UInt8)pixel.comp[RGBComponents::GREEN] // loading the G value in the onject to the dump file
+                         << (UInt8)pixel.comp[RGBComponents::BLUE]; // loading the B value in the onject to the dump file
+        }
+        
+        logFile << "Raw image data dumped to file: \'" + filename + "\'." << std::endl; // message of completion
+        dumpFile.close(); // close the dump file
+        return true; // return with no errors
+    }
+    
+    const PixelPtr Image::getPixelPtr() const
+    {
+        return m_pixelPtr;
+    }
+}
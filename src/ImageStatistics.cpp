@@ -0,0 +1,317 @@
+// Implementation of the image statistics module
+
+#include <algorithm>
+#include <cmath>
+
+#include "ImageStatistics.hpp"
+#include "Transform.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        // The size of the luminance transformed by the perceptual hash, & of
+        // the lowest frequencies it keeps
+        const std::size_t HASH_IMAGE_SIZE = 32;
+        const std::size_t HASH_FREQUENCIES = 8;
+
+        // Resize a plane of samples by averaging the area under each new
+        // sample, which also works to enlarge a plane smaller than the new size
+        std::vector<float> resizePlane(const std::vector<float>& plane,
+                                       const std::size_t width, const std::size_t height,
+                                       const std::size_t newWidth, const std::size_t newHeight)
+        {
+            // The weight of each old sample in each new one, along a dimension
+            auto getWeights = [](const std::size_t size, const std::size_t newSize)
+            {
+                std::vector<float> weights(size * newSize, 0.0f);
+                const double step = double(size) / newSize;
+
+                for (std::size_t i = 0; i < newSize; ++i)
+                {
+                    const double start = i * step;
+                    const double end = start + step;
+
+                    for (auto j = std::size_t(start); j < size && j < end; ++j)
+                        weights[i * size + j] = float((std::min(end, j + 1.0) - std::max(start, double(j))) / step);
+                }
+
+                return weights;
+            };
+
+            std::vector<float> columnWeights = getWeights(width, newWidth);
+            std::vector<float> rowWeights = getWeights(height, newHeight);
+
+            // Resize the rows, then the columns
+            std::vector<float> rows(newWidth * height, 0.0f);
+
+            for (std::size_t y = 0; y < height; ++y)
+            {
+                for (std::size_t i = 0; i < newWidth; ++i)
+                {
+                    for (std::size_t x = 0; x < width; ++x)
+                        rows[y * newWidth + i] += columnWeights[i * width + x] * plane[y * width + x];
+                }
+            }
+
+            std::vector<float> resized(newWidth * newHeight, 0.0f);
+
+            for (std::size_t j = 0; j < newHeight; ++j)
+            {
+                for (std::size_t y = 0; y < height; ++y)
+                {
+                    const float weight = rowWeights[j * height + y];
+
+                    if (weight == 0.0f)
+                        continue;
+
+                    for (std::size_t i = 0; i < newWidth; ++i)
+                        resized[j * newWidth + i] += weight * rows[y * newWidth + i];
+                }
+            }
+
+            return resized;
+        }
+    }
+
+    ImageStatistics::ImageStatistics() :
+        width{0},
+        height{0},
+        averageColor{},
+        luminanceHistogram{},
+        perceptualHash{0}
+    {
+    }
+
+    Decoder::ResultCode ImageStatistics::analyze(Decoder& decoder, const int samplesPerBlock)
+    {
+        width = 0;
+        height = 0;
+        averageColor.fill(0.0);
+        luminanceHistogram.fill(0);
+        perceptualHash = 0;
+
+        if (samplesPerBlock != 1 && samplesPerBlock != 2 && samplesPerBlock != 4)
+        {
+            logFile << "[ FATAL ] Unable to take " << samplesPerBlock << " samples per block" << std::endl;
+            return Decoder::ResultCode::ERROR;
+        }
+
+        // The zig-zag orders of the lowest frequencies, row by row
+        int zigZagOrders[16];
+        const std::size_t kept = samplesPerBlock * samplesPerBlock;
+
+        for (std::size_t k = 0; k < kept; ++k)
+            zigZagOrders[k] = matIndicesToZZOrder(int(k) / samplesPerBlock, int(k) % samplesPerBlock);
+
+        for (auto compID = 0; compID < 3; ++compID)
+            m_coefficients[compID].clear();
+
+        decoder.setBlockCallback([this, &zigZagOrders, kept](const int component, const std::size_t blockIndex, const Int16* coeffs)
+        {
+            if (component < 0 || component > 2 || blockIndex * kept != m_coefficients[component].size())
+                return false;
+
+            for (std::size_t k = 0; k < kept; ++k)
+                m_coefficients[component].push_back(coeffs[zigZagOrders[k]]);
+
+            return true;
+        });
+
+        Decoder::ResultCode status = decoder.decodeCoefficients(CoefficientOrder::ZIGZAG);
+
+        decoder.setBlockCallback(nullptr);
+
+        const std::size_t blocksPerLine = decoder.getBlocksPerLine();
+        const std::size_t blockCount = blocksPerLine * decoder.getBlockRows();
+
+        for (auto compID = 0; compID < 3 && status == Decoder::ResultCode::DECODE_DONE; ++compID)
+        {
+            if (m_coefficients[compID].size() != blockCount * kept)
+            {
+                logFile << "[ FATAL ] The coefficients of some blocks are missing" << std::endl;
+                status = Decoder::ResultCode::ERROR;
+            }
+        }
+
+        if (status != Decoder::ResultCode::DECODE_DONE)
+            return status;
+
+        const std::size_t frameWidth = decoder.getFrameWidth();
+        const std::size_t frameHeight = decoder.getFrameHeight();
+
+        // The samples of the plane that overlap the image, & the pixels of each
+        const std::size_t pixelsPerSample = 8 / samplesPerBlock;
+        const std::size_t planeWidth = (frameWidth + pixelsPerSample - 1) / pixelsPerSample;
+        const std::size_t planeHeight = (frameHeight + pixelsPerSample - 1) / pixelsPerSample;
+
+        std::array<UInt16, 64> QTables[3];
+
+        for (auto compID = 0; compID < 3; ++compID)
+            QTables[compID] = decoder.getQuantizationTable(compID);
+
+        m_luminance.assign(planeWidth * planeHeight, 0.0f);
+
+        double colorSums[3] = {};
+
+        for (std::size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+        {
+            const std::size_t blockX = blockIndex % blocksPerLine;
+            const std::size_t blockY = blockIndex / blocksPerLine;
+
+            if (blockX * samplesPerBlock >= planeWidth || blockY * samplesPerBlock >= planeHeight)
+                continue;
+
+            // The samples of the block, not yet level shifted
+            float samples[3][16];
+
+            for (auto compID = 0; compID < 3; ++compID)
+            {
+                const Int16* zigZag = &m_coefficients[compID][blockIndex * kept];
+
+                if (samplesPerBlock == 1)
+                {
+                    samples[compID][0] = zigZag[0] * QTables[compID][0] / 8.0f;
+                    continue;
+                }
+
+                int coeffs[64] = {};
+
+                for (std::size_t k = 0; k < kept; ++k)
+                    coeffs[(k / samplesPerBlock) * 8 + k % samplesPerBlock] = zigZag[k] * QTables[compID][zigZagOrders[k]];
+
+                inverseDCTScaled(coeffs, samples[compID], samplesPerBlock);
+            }
+
+            for (auto v = 0; v < samplesPerBlock; ++v)
+            {
+                const std::size_t sampleY = blockY * samplesPerBlock + v;
+
+                if (sampleY >= planeHeight)
+                    break;
+
+                for (auto u = 0; u < samplesPerBlock; ++u)
+                {
+                    const std::size_t sampleX = blockX * samplesPerBlock + u;
+
+                    if (sampleX >= planeWidth)
+                        break;
+
+                    // The pixels of the image under the sample
+                    const std::size_t pixelCount =
+                        std::min(pixelsPerSample, frameWidth - sampleX * pixelsPerSample) *
+                        std::min(pixelsPerSample, frameHeight - sampleY * pixelsPerSample);
+
+                    const int i = v * samplesPerBlock + u;
+                    const double Y = samples[0][i] + 128.0;
+                    const double Cb = samples[1][i];
+                    const double Cr = samples[2][i];
+
+                    const double RGB[3] =
+                    {
+                        Y + 1.402 * Cr,
+                        Y - 0.344136 * Cb - 0.714136 * Cr,
+                        Y + 1.772 * Cb
+                    };
+
+                    for (auto c = 0; c < 3; ++c)
+                        colorSums[c] += std::max(0.0, std::min(RGB[c], 255.0)) * pixelCount;
+
+                    const int luminance = std::max(0, std::min(int(std::lround(Y)), 255));
+                    luminanceHistogram[luminance] += pixelCount;
+
+                    m_luminance[sampleY * planeWidth + sampleX] = float(Y);
+                }
+            }
+        }
+
+        width = frameWidth;
+        height = frameHeight;
+
+        for (auto c = 0; c < 3; ++c)
+            averageColor[c] = colorSums[c] / (width * height);
+
+        perceptualHash = computePerceptualHash(m_luminance, planeWidth, planeHeight);
+
+        logFile << "Computed the statistics of the image from " << std::dec << planeWidth << "x" << planeHeight
+                << " samples, perceptual hash " << std::hex << perceptualHash << std::dec << std::endl;
+
+        return status;
+    }
+
+    bool ImageStatistics::isEmpty() const
+    {
+        return width == 0;
+    }
+
+    std::uint64_t ImageStatistics::computePerceptualHash(const std::vector<float>& luminance,
+                                                         const std::size_t width, const std::size_t height)
+    {
+        if (width == 0 || height == 0 || luminance.size() < width * height)
+            return 0;
+
+        std::vector<float> resized = resizePlane(luminance, width, height, HASH_IMAGE_SIZE, HASH_IMAGE_SIZE);
+
+        // The cosines of the DCT of the lowest frequencies, the first row &
+        // column included as they're skipped only once transformed
+        const std::size_t frequencies = HASH_FREQUENCIES + 1;
+        std::vector<double> cosines(frequencies * HASH_IMAGE_SIZE);
+
+        for (std::size_t u = 0; u < frequencies; ++u)
+        {
+            for (std::size_t x = 0; x < HASH_IMAGE_SIZE; ++x)
+                cosines[u * HASH_IMAGE_SIZE + x] = std::cos((2 * x + 1) * u * M_PI / (2 * HASH_IMAGE_SIZE));
+        }
+
+        // Transform the rows, then the columns, for the lowest frequencies only
+        std::vector<double> rows(HASH_IMAGE_SIZE * frequencies, 0.0);
+
+        for (std::size_t y = 0; y < HASH_IMAGE_SIZE; ++y)
+        {
+            for (std::size_t u = 0; u < frequencies; ++u)
+            {
+                for (std::size_t x = 0; x < HASH_IMAGE_SIZE; ++x)
+                    rows[y * frequencies + u] += resized[y * HASH_IMAGE_SIZE + x] * cosines[u * HASH_IMAGE_SIZE + x];
+            }
+        }
+
+        std::vector<double> transform;
+
+        for (std::size_t v = 1; v < frequencies; ++v)
+        {
+            for (std::size_t u = 1; u < frequencies; ++u)
+            {
+                double sum = 0.0;
+
+                for (std::size_t y = 0; y < HASH_IMAGE_SIZE; ++y)
+                    sum += rows[y * frequencies + u] * cosines[v * HASH_IMAGE_SIZE + y];
+
+                transform.push_back(sum);
+            }
+        }
+
+        std::vector<double> sorted = transform;
+        std::sort(sorted.begin(), sorted.end());
+        const double median = (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+
+        // The bits of the frequencies row by row, the first one the highest
+        std::uint64_t hash = 0;
+
+        for (auto&& coefficient : transform)
+            hash = (hash << 1) | (coefficient > median ? 1 : 0);
+
+        return hash;
+    }
+
+    int ImageStatistics::getHashDistance(const std::uint64_t hash, const std::uint64_t otherHash)
+    {
+        std::uint64_t difference = hash ^ otherHash;
+        int distance = 0;
+
+        for (; difference != 0; difference &= difference - 1)
+            ++distance;
+
+        return distance;
+    }
+}
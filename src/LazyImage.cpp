@@ -0,0 +1,212 @@
+// Implementation of the lazy image module
+
+#include <algorithm>
+#include <iterator>
+
+#include "LazyImage.hpp"
+#include "BitReader.hpp"
+#include "MCU.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    const std::size_t LazyImage::DEFAULT_MAX_RESIDENT_ROWS;
+
+    LazyImage::LazyImage() :
+        width{0},
+        height{0},
+        m_restartInterval{0},
+        m_IDCTMode{IDCTMode::FLOAT},
+        m_maxResidentRows{DEFAULT_MAX_RESIDENT_ROWS},
+        m_decodedRowCount{0}
+    {
+    }
+
+    void LazyImage::setMaxResidentRows(const std::size_t count)
+    {
+        m_maxResidentRows = std::max(count, std::size_t(1));
+
+        while (m_residentRows.size() > m_maxResidentRows)
+        {
+            m_rowPositions[m_residentRows.back().MCURow] = m_residentRows.end();
+            m_residentRows.pop_back();
+        }
+    }
+
+    Pixel LazyImage::getPixel(const std::size_t x, const std::size_t y)
+    {
+        const Pixel* row = getRow(y);
+
+        if (row == nullptr || x >= width)
+            return Pixel();
+
+        return row[x];
+    }
+
+    const Pixel* LazyImage::getRow(const std::size_t y)
+    {
+        if (y >= height)
+            return nullptr;
+
+        const ResidentRow* row = getMCURow(y / 8);
+
+        if (row == nullptr)
+            return nullptr;
+
+        return row->pixels.data() + (y % 8) * width;
+    }
+
+    bool LazyImage::isEmpty() const
+    {
+        return m_index.checkpoints.empty();
+    }
+
+    std::size_t LazyImage::getDecodedRowCount() const
+    {
+        return m_decodedRowCount;
+    }
+
+    std::size_t LazyImage::getResidentRowCount() const
+    {
+        return m_residentRows.size();
+    }
+
+    std::size_t LazyImage::getMCURowCount() const
+    {
+        return m_index.checkpoints.size();
+    }
+
+    void LazyImage::releaseRows()
+    {
+        m_residentRows.clear();
+        std::fill(m_rowPositions.begin(), m_rowPositions.end(), m_residentRows.end());
+    }
+
+    void LazyImage::clear()
+    {
+        width = 0;
+        height = 0;
+        m_scanData.clear();
+        m_QTables.clear();
+        m_restartInterval = 0;
+        m_index = ScanIndex();
+        m_residentRows.clear();
+        m_rowPositions.clear();
+        m_decodedRowCount = 0;
+
+        for (auto compID = 0; compID < 3; ++compID)
+        {
+            m_DCTables[compID] = nullptr;
+            m_ACTables[compID] = nullptr;
+        }
+    }
+
+    const LazyImage::ResidentRow* LazyImage::getMCURow(const std::size_t MCURow)
+    {
+        if (MCURow >= m_index.checkpoints.size())
+            return nullptr;
+
+        ResidentRowList::iterator position = m_rowPositions[MCURow];
+
+        // A resident row becomes the one read most recently
+        if (position != m_residentRows.end())
+        {
+            if (position != m_residentRows.begin())
+                m_residentRows.splice(m_residentRows.begin(), m_residentRows, position);
+
+            return &m_residentRows.front();
+        }
+
+        // Otherwise the row read least recently is evicted, & its pixels reused
+        if (m_residentRows.size() < m_maxResidentRows)
+            m_residentRows.emplace_front();
+        else
+        {
+            m_rowPositions[m_residentRows.back().MCURow] = m_residentRows.end();
+            m_residentRows.splice(m_residentRows.begin(), m_residentRows, std::prev(m_residentRows.end()));
+        }
+
+        ResidentRow& row = m_residentRows.front();
+        row.pixels.resize(width * 8);
+
+        if (!decodeMCURow(MCURow, row.pixels.data()))
+        {
+            m_residentRows.pop_front();
+            return nullptr;
+        }
+
+        row.MCURow = MCURow;
+        m_rowPositions[MCURow] = m_residentRows.begin();
+        m_decodedRowCount++;
+
+        return &row;
+    }
+
+    bool LazyImage::decodeMCURow(const std::size_t MCURow, Pixel* pixels) const
+    {
+        logFile << "Decoding MCU row " << std::dec << MCURow << " lazily..." << std::endl;
+
+        const std::size_t MCUsPerLine = (width + 7) / 8;
+        const std::size_t firstMCU = MCURow * MCUsPerLine;
+        const ScanCheckpoint& checkpoint = m_index.checkpoints[MCURow];
+
+        BitReader reader;
+        reader.setData(m_scanData.data(), m_scanData.size());
+        reader.setBitPosition(checkpoint.bitPosition);
+
+        int DCPredictors[3];
+        std::copy(checkpoint.DCPredictors, checkpoint.DCPredictors + 3, DCPredictors);
+
+        MCU::m_IDCTMode = m_IDCTMode;
+
+        Int16 coeffs[3][64];
+        MCU block;
+
+        for (std::size_t col = 0; col < MCUsPerLine; ++col)
+        {
+            // The checkpoint is past the restart marker of the row's first
+            // MCU, the other MCUs of the row handle theirs as the decoder does
+            std::size_t i = firstMCU + col;
+
+            if (m_restartInterval > 0 && col > 0 && i % m_restartInterval == 0)
+            {
+                reader.alignToByte();
+                std::fill(DCPredictors, DCPredictors + 3, 0);
+            }
+
+            for (auto compID = 0; compID < 3; ++compID)
+            {
+                if (!decodeBaselineBlock(*m_DCTables[compID], *m_ACTables[compID],
+                                         reader, DCPredictors[compID], coeffs[compID]))
+                {
+                    logFile << "[ FATAL ] Invalid Huffman code in MCU row " << MCURow
+                            << ", possibly corrupt JFIF data stream!" << std::endl;
+                    return false;
+                }
+            }
+
+            block.constructMCU({ { coeffs[0], coeffs[1], coeffs[2] } }, m_QTables);
+
+            // The blocks are clipped against the right edge of the image
+            const CompMatrices& samples = block.getAllMatrices();
+            const std::size_t x = col * 8;
+            const std::size_t blockWidth = std::min(std::size_t(8), width - x);
+
+            for (std::size_t v = 0; v < 8; ++v)
+            {
+                Pixel* pixel = pixels + v * width + x;
+
+                for (std::size_t u = 0; u < blockWidth; ++u, ++pixel)
+                {
+                    pixel->comp[0] = samples[0][v][u];
+                    pixel->comp[1] = samples[1][v][u];
+                    pixel->comp[2] = samples[2][v][u];
+                }
+            }
+        }
+
+        logFile << "Finished decoding MCU row " << MCURow << " [OK]" << std::endl;
+
+        return true;
+    }
+}
@@ -0,0 +1,234 @@
+// Implementation of the lossless transform module
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include "LosslessTransform.hpp"
+#include "Transform.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        // Every operation is a transpose of the image (or none), followed by
+        // mirroring it horizontally and/or vertically
+        struct BlockMapping
+        {
+            bool isTransposed;
+            bool isMirroredX;
+            bool isMirroredY;
+        };
+
+        BlockMapping getBlockMapping(const LosslessOperation operation)
+        {
+            switch (operation)
+            {
+                case LosslessOperation::FLIP_HORIZONTAL : return { false, true,  false };
+                case LosslessOperation::FLIP_VERTICAL   : return { false, false, true  };
+                case LosslessOperation::TRANSPOSE       : return { true,  false, false };
+                case LosslessOperation::TRANSVERSE      : return { true,  true,  true  };
+                case LosslessOperation::ROTATE_90       : return { true,  true,  false };
+                case LosslessOperation::ROTATE_180      : return { false, true,  true  };
+                case LosslessOperation::ROTATE_270      : return { true,  false, true  };
+                default                                 : return { false, false, false };
+            }
+        }
+    }
+
+    bool parseLosslessOperation(const std::string& name, LosslessOperation& operation)
+    {
+        static const std::pair<const char*, LosslessOperation> names[] = {
+            { "none",       LosslessOperation::NONE },
+            { "flip-h",     LosslessOperation::FLIP_HORIZONTAL },
+            { "flip-v",     LosslessOperation::FLIP_VERTICAL },
+            { "transpose",  LosslessOperation::TRANSPOSE },
+            { "transverse", LosslessOperation::TRANSVERSE },
+            { "90",         LosslessOperation::ROTATE_90 },
+            { "180",        LosslessOperation::ROTATE_180 },
+            { "270",        LosslessOperation::ROTATE_270 }
+        };
+
+        for (auto&& entry : names)
+        {
+            if (name == entry.first)
+            {
+                operation = entry.second;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    LosslessTransformer::LosslessTransformer() :
+        m_isOptimizingHuffmanTables{false},
+        m_isCropped{false},
+        m_cropX{0},
+        m_cropY{0},
+        m_cropWidth{0},
+        m_cropHeight{0}
+    {
+    }
+
+    void LosslessTransformer::setCropRegion(const std::size_t x, const std::size_t y,
+                                            const std::size_t width, const std::size_t height)
+    {
+        m_isCropped = true;
+        m_cropX = x;
+        m_cropY = y;
+        m_cropWidth = width;
+        m_cropHeight = height;
+    }
+
+    void LosslessTransformer::setOptimizeHuffmanTables(const bool isOptimizing)
+    {
+        m_isOptimizingHuffmanTables = isOptimizing;
+    }
+
+    bool LosslessTransformer::transform(const UInt8* data, const std::size_t size,
+                                        const LosslessOperation operation, std::ostream& out)
+    {
+        // The coefficients are kept in natural order, so that transposing
+        // a block swaps the row & the column of each coefficient
+        m_decoder.reset();
+
+        bool isDecoded = m_decoder.open(data, size) &&
+                         m_decoder.decodeCoefficients(CoefficientOrder::NATURAL) == Decoder::ResultCode::DECODE_DONE;
+
+        m_decoder.close();
+
+        if (!isDecoded || m_decoder.getCoefficients(0) == nullptr)
+        {
+            logFile << "[ FATAL ] Unable to decode the coefficients of the image to transform" << std::endl;
+            return false;
+        }
+
+        const BlockMapping mapping = getBlockMapping(operation);
+        const std::size_t blocksPerLine = m_decoder.getBlocksPerLine();
+
+        // The size of the transposed image, without the partial blocks that
+        // mirroring would move away from the right & bottom edges
+        std::size_t width = mapping.isTransposed ? m_decoder.getFrameHeight() : m_decoder.getFrameWidth();
+        std::size_t height = mapping.isTransposed ? m_decoder.getFrameWidth() : m_decoder.getFrameHeight();
+
+        if (mapping.isMirroredX)
+            width -= width % 8;
+        if (mapping.isMirroredY)
+            height -= height % 8;
+
+        const std::size_t blocksX = (width + 7) / 8;
+        const std::size_t blocksY = (height + 7) / 8;
+
+        // The crop window starts on a block boundary
+        std::size_t x0 = 0;
+        std::size_t y0 = 0;
+
+        if (m_isCropped)
+        {
+            x0 = std::min(m_cropX / 8 * 8, width);
+            y0 = std::min(m_cropY / 8 * 8, height);
+            width = std::min(m_cropX + m_cropWidth, width) - x0;
+            height = std::min(m_cropY + m_cropHeight, height) - y0;
+        }
+
+        if (width == 0 || height == 0)
+        {
+            logFile << "[ FATAL ] The transformed image is empty, it's smaller than a block or outside the crop window" << std::endl;
+            return false;
+        }
+
+        logFile << "Transforming " << std::dec << m_decoder.getFrameWidth() << "x" << m_decoder.getFrameHeight()
+                << " image to " << width << "x" << height << " losslessly..." << std::endl;
+
+        // The tables of the chrominance components are the same, as the decoder
+        // expects, and are transposed with the coefficients they quantize
+        UInt16 QTables[2][64];
+
+        for (auto table = 0; table < 2; ++table)
+        {
+            std::array<UInt16, 64> QTable = m_decoder.getQuantizationTable(table, CoefficientOrder::NATURAL);
+
+            for (auto v = 0; v < 8; ++v)
+            {
+                for (auto u = 0; u < 8; ++u)
+                    QTables[table][matIndicesToZZOrder(v, u)] = mapping.isTransposed ? QTable[u * 8 + v] : QTable[v * 8 + u];
+            }
+        }
+
+        const Int16* coefficients[3] = {
+            m_decoder.getCoefficients(0),
+            m_decoder.getCoefficients(1),
+            m_decoder.getCoefficients(2)
+        };
+
+        auto getBlock = [&](const int compID, const std::size_t blockX, const std::size_t blockY, int* zzOrder)
+        {
+            // The block of the transposed image, then of the original image
+            std::size_t x = x0 / 8 + blockX;
+            std::size_t y = y0 / 8 + blockY;
+
+            if (mapping.isMirroredX)
+                x = blocksX - 1 - x;
+            if (mapping.isMirroredY)
+                y = blocksY - 1 - y;
+
+            const std::size_t sourceX = mapping.isTransposed ? y : x;
+            const std::size_t sourceY = mapping.isTransposed ? x : y;
+            const Int16* block = coefficients[compID] + (sourceY * blocksPerLine + sourceX) * 64;
+
+            // Mirroring the samples of a block negates its odd frequencies
+            for (auto v = 0; v < 8; ++v)
+            {
+                for (auto u = 0; u < 8; ++u)
+                {
+                    int value = mapping.isTransposed ? block[u * 8 + v] : block[v * 8 + u];
+
+                    if ((mapping.isMirroredX && (u & 1)) != (mapping.isMirroredY && (v & 1)))
+                        value = -value;
+
+                    zzOrder[matIndicesToZZOrder(v, u)] = value;
+                }
+            }
+        };
+
+        // The restart markers of the image are kept, at the same interval
+        Encoder::Settings settings;
+        settings.restartInterval = m_decoder.getRestartInterval();
+        settings.optimizeHuffmanTables = m_isOptimizingHuffmanTables;
+
+        Encoder encoder(settings);
+
+        if (!encoder.encodeCoefficients(width, height, QTables, getBlock, out))
+            return false;
+
+        logFile << "Finished transforming image [OK]" << std::endl;
+
+        return true;
+    }
+
+    bool LosslessTransformer::transform(const std::string& inputFilename, const std::string& outputFilename,
+                                        const LosslessOperation operation)
+    {
+        std::ifstream inputFile(inputFilename, std::ios::in | std::ios::binary);
+
+        if (!inputFile.is_open())
+        {
+            logFile << "Unable to open image: \'" << inputFilename << "\'" << std::endl;
+            return false;
+        }
+
+        std::vector<UInt8> data((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+
+        std::ofstream outputFile(outputFilename, std::ios::out | std::ios::binary);
+
+        if (!outputFile.is_open())
+        {
+            logFile << "Unable to create JPEG image: \'" << outputFilename << "\'" << std::endl;
+            return false;
+        }
+
+        return transform(data.data(), data.size(), operation, outputFile);
+    }
+}
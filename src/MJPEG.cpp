@@ -0,0 +1,297 @@
+// Implementation of the Motion-JPEG module
+
+#include <algorithm>
+#include <cstring>
+
+#include "MJPEG.hpp"
+#include "Markers.hpp"
+#include "StandardTables.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        // Copy the DQT & DHT segments of a frame, markers included, that
+        // precede its first scan
+        void collectTableSegments(const UInt8* frame, const std::size_t size,
+                                  std::vector<UInt8>& DQTSegments, std::vector<UInt8>& DHTSegments)
+        {
+            std::size_t pos = 2; // Skip the SOI marker
+
+            while (pos + 4 <= size && frame[pos] == JFIF_BYTE_FF)
+            {
+                UInt8 marker = frame[pos + 1];
+                std::size_t length = (frame[pos + 2] << 8) | frame[pos + 3];
+
+                if (marker == JFIF_SOS || pos + 2 + length > size)
+                    break;
+
+                if (marker == JFIF_DQT)
+                    DQTSegments.insert(DQTSegments.end(), frame + pos, frame + pos + 2 + length);
+                else if (marker == JFIF_DHT)
+                    DHTSegments.insert(DHTSegments.end(), frame + pos, frame + pos + 2 + length);
+
+                pos += 2 + length;
+            }
+        }
+    }
+
+    std::vector<MJPEGFrame> splitMJPEGFrames(const UInt8* data, const std::size_t size)
+    {
+        std::vector<MJPEGFrame> frames;
+        std::size_t pos = 0;
+
+        while (pos + 1 < size)
+        {
+            // Find the start of the next frame
+            if (data[pos] != JFIF_BYTE_FF || data[pos + 1] != JFIF_SOI)
+            {
+                const void* next = std::memchr(data + pos + 1, JFIF_BYTE_FF, size - pos - 1);
+                pos = next ? static_cast<const UInt8*>(next) - data : size;
+                continue;
+            }
+
+            MJPEGFrame frame = { pos, 0, false, false };
+            bool isInScan = false;
+            bool isComplete = false;
+
+            pos += 2;
+
+            while (pos + 1 < size)
+            {
+                if (isInScan)
+                {
+                    // In entropy-coded data, only the 0xFF bytes need a look
+                    const void* next = std::memchr(data + pos, JFIF_BYTE_FF, size - pos);
+
+                    if (next == nullptr)
+                    {
+                        pos = size;
+                        break;
+                    }
+
+                    pos = static_cast<const UInt8*>(next) - data;
+
+                    if (pos + 1 >= size)
+                        break;
+
+                    UInt8 byte = data[pos + 1];
+
+                    // Stuffed zero bytes, restart markers & fill bytes are part of the scan
+                    if (byte == JFIF_BYTE_0 || (byte >= JFIF_RST0 && byte <= JFIF_RST7))
+                    {
+                        pos += 2;
+                        continue;
+                    }
+
+                    if (byte == JFIF_BYTE_FF)
+                    {
+                        pos++;
+                        continue;
+                    }
+
+                    isInScan = false;
+                    continue;
+                }
+
+                if (data[pos] != JFIF_BYTE_FF || data[pos + 1] == JFIF_BYTE_FF)
+                {
+                    pos++;
+                    continue;
+                }
+
+                UInt8 marker = data[pos + 1];
+
+                if (marker == JFIF_EOI)
+                {
+                    pos += 2;
+                    isComplete = true;
+                    break;
+                }
+
+                // The frame is truncated, the next one starts here
+                if (marker == JFIF_SOI)
+                    break;
+
+                if (pos + 4 > size)
+                {
+                    pos = size;
+                    break;
+                }
+
+                // Skip the marker segment by its length
+                std::size_t length = (data[pos + 2] << 8) | data[pos + 3];
+
+                if (marker == JFIF_DQT)
+                    frame.hasDQT = true;
+                else if (marker == JFIF_DHT)
+                    frame.hasDHT = true;
+                else if (marker == JFIF_SOS)
+                    isInScan = true;
+
+                pos += 2 + length;
+            }
+
+            if (isComplete)
+            {
+                frame.size = pos - frame.offset;
+                frames.push_back(frame);
+            }
+            else
+            {
+                logFile << "Skipped incomplete Motion-JPEG frame at offset " << frame.offset << std::endl;
+            }
+        }
+
+        return frames;
+    }
+
+    MJPEGDecoder::MJPEGDecoder(const std::size_t workerCount) :
+        m_bufferPool{ std::make_shared<BufferPool>(3 * std::max<std::size_t>(workerCount, 1)) },
+        m_isStopping{ false }
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(workerCount, 1); ++i)
+            m_workers.emplace_back(&MJPEGDecoder::workerLoop, this);
+    }
+
+    MJPEGDecoder::~MJPEGDecoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+
+        m_frameQueued.notify_all();
+
+        for (auto&& worker : m_workers)
+            worker.join();
+    }
+
+    std::size_t MJPEGDecoder::decodeStream(const UInt8* data, const std::size_t size,
+                                           const FrameCallback& callback)
+    {
+        std::vector<MJPEGFrame> frames = splitMJPEGFrames(data, size);
+
+        logFile << "Found " << frames.size() << " frames in Motion-JPEG stream" << std::endl;
+
+        // The most recent tables of the stream, inserted into the frames that
+        // leave them out, so every frame can be decoded by any worker. Until
+        // the stream defines Huffman tables, the standard ones apply.
+        std::vector<UInt8> DQTSegments;
+        std::vector<UInt8> DHTSegments = makeStandardDHTSegment();
+
+        // Bound the frames in flight, so the decoded frames waiting to be
+        // handed out in order don't pile up
+        const std::size_t maxPending = 2 * m_workers.size();
+
+        std::size_t nextFrame = 0;
+        std::size_t decodedCount = 0;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (nextFrame < frames.size() || !m_pending.empty())
+        {
+            while (nextFrame < frames.size() && m_pending.size() < maxPending)
+            {
+                const MJPEGFrame& frame = frames[nextFrame];
+                const UInt8* frameData = data + frame.offset;
+
+                auto job = std::make_shared<FrameJob>();
+                job->number = nextFrame++;
+                job->data = frameData;
+                job->size = frame.size;
+                job->isDone = false;
+                job->result = Decoder::ResultCode::ERROR;
+
+                if (frame.hasDQT || frame.hasDHT)
+                {
+                    std::vector<UInt8> frameDQT, frameDHT;
+                    collectTableSegments(frameData, frame.size, frameDQT, frameDHT);
+
+                    if (frame.hasDQT)
+                        DQTSegments.swap(frameDQT);
+                    if (frame.hasDHT)
+                        DHTSegments.swap(frameDHT);
+                }
+
+                if (!frame.hasDQT || !frame.hasDHT)
+                {
+                    std::vector<UInt8>& completed = job->completedData;
+                    completed.reserve(frame.size + DQTSegments.size() + DHTSegments.size());
+
+                    completed.insert(completed.end(), frameData, frameData + 2); // SOI
+                    if (!frame.hasDQT)
+                        completed.insert(completed.end(), DQTSegments.begin(), DQTSegments.end());
+                    if (!frame.hasDHT)
+                        completed.insert(completed.end(), DHTSegments.begin(), DHTSegments.end());
+                    completed.insert(completed.end(), frameData + 2, frameData + frame.size);
+
+                    job->data = completed.data();
+                    job->size = completed.size();
+                }
+
+                m_pending.push_back(job);
+                m_queue.push_back(job);
+                m_frameQueued.notify_one();
+            }
+
+            // Hand out the next frame in stream order once it's decoded
+            m_frameDone.wait(lock, [this] { return m_pending.front()->isDone; });
+
+            std::shared_ptr<FrameJob> job = m_pending.front();
+            m_pending.pop_front();
+
+            lock.unlock();
+
+            if (job->result == Decoder::ResultCode::DECODE_DONE)
+                decodedCount++;
+
+            callback(job->image, job->number, job->result);
+
+            lock.lock();
+        }
+
+        return decodedCount;
+    }
+
+    void MJPEGDecoder::workerLoop()
+    {
+        // Each worker reuses its decoder, and with it the buffers of the
+        // frames, while the lookup tables of the Huffman tables that every
+        // frame repeats are built once & shared through the HuffmanCache
+        Decoder decoder;
+        decoder.setBufferPool(m_bufferPool);
+
+        while (true)
+        {
+            std::shared_ptr<FrameJob> job;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_frameQueued.wait(lock, [this] { return m_isStopping || !m_queue.empty(); });
+
+                if (m_queue.empty())
+                    return;
+
+                job = m_queue.front();
+                m_queue.pop_front();
+            }
+
+            decoder.open(job->data, job->size);
+            job->result = decoder.decodeImageFile();
+
+            if (job->result == Decoder::ResultCode::DECODE_DONE)
+                job->image = decoder.getImage();
+
+            decoder.close();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                job->isDone = true;
+            }
+
+            m_frameDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,152 @@
+// Implementation of the scan data module
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "ScanData.hpp"
+#include "Markers.hpp"
+
+// AVX2 is chosen at run time, the rest of the decoder is built for any x86
+#if defined(__SSE2__) && defined(__GNUC__)
+#define KPEG_HAS_AVX2_SEARCH 1
+#endif
+
+namespace kpeg
+{
+    namespace
+    {
+        typedef const UInt8* (*MarkerSearch)(const UInt8*, const UInt8*);
+
+        const UInt8* findMarkerByteScalar(const UInt8* first, const UInt8* last)
+        {
+            const void* found = std::memchr(first, JFIF_BYTE_FF, std::size_t(last - first));
+            return found == nullptr ? last : static_cast<const UInt8*>(found);
+        }
+
+#if defined(__SSE2__)
+        const UInt8* findMarkerByteSSE2(const UInt8* first, const UInt8* last)
+        {
+            const __m128i markerBytes = _mm_set1_epi8(char(JFIF_BYTE_FF));
+
+            for (; last - first >= 16; first += 16)
+            {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, markerBytes));
+
+                if (mask != 0)
+                    return first + __builtin_ctz(unsigned(mask));
+            }
+
+            return findMarkerByteScalar(first, last);
+        }
+#endif
+
+#if defined(KPEG_HAS_AVX2_SEARCH)
+        __attribute__((target("avx2")))
+        const UInt8* findMarkerByteAVX2(const UInt8* first, const UInt8* last)
+        {
+            const __m256i markerBytes = _mm256_set1_epi8(char(JFIF_BYTE_FF));
+
+            for (; last - first >= 32; first += 32)
+            {
+                const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+                const int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, markerBytes));
+
+                if (mask != 0)
+                    return first + __builtin_ctz(unsigned(mask));
+            }
+
+            return findMarkerByteSSE2(first, last);
+        }
+#endif
+
+        // The search used, & the name of its instructions
+        struct MarkerSearchImplementation
+        {
+            MarkerSearch search;
+            const char* instructions;
+        };
+
+        MarkerSearchImplementation selectMarkerSearch()
+        {
+#if defined(KPEG_HAS_AVX2_SEARCH)
+            if (__builtin_cpu_supports("avx2"))
+                return { findMarkerByteAVX2, "AVX2" };
+#endif
+
+#if defined(__SSE2__)
+            return { findMarkerByteSSE2, "SSE2" };
+#else
+            return { findMarkerByteScalar, "scalar" };
+#endif
+        }
+
+        const MarkerSearchImplementation& getMarkerSearch()
+        {
+            static const MarkerSearchImplementation implementation = selectMarkerSearch();
+            return implementation;
+        }
+    }
+
+    const UInt8* findMarkerByte(const UInt8* first, const UInt8* last)
+    {
+        return getMarkerSearch().search(first, last);
+    }
+
+    const UInt8* extractScanData(const UInt8* first, const UInt8* last,
+                                 UInt8* output, std::size_t& outputSize,
+                                 std::vector<ScanMarker>* markers)
+    {
+        const MarkerSearch search = getMarkerSearch().search;
+        const UInt8* begin = first;
+        UInt8* next = output;
+
+        while (first < last)
+        {
+            const UInt8* found = search(first, last);
+
+            // The bytes up to the 0xFF byte are data
+            std::memcpy(next, first, std::size_t(found - first));
+            next += found - first;
+
+            // A 0xFF byte that ends the data can't start a marker
+            if (last - found < 2)
+            {
+                first = found;
+                break;
+            }
+
+            const UInt8 marker = found[1];
+            const bool isRestartMarker = marker >= JFIF_RST0 && marker <= JFIF_RST7;
+
+            // Any other marker ends the scan data
+            if (marker != JFIF_BYTE_0 && !isRestartMarker)
+            {
+                first = found;
+                break;
+            }
+
+            if (markers != nullptr)
+                markers->push_back({ std::size_t(found - begin), std::size_t(next - output), marker });
+
+            // A stuffed zero byte, the 0xFF is data, while restart markers
+            // are dropped as the data of each interval is byte-aligned
+            if (marker == JFIF_BYTE_0)
+                *next++ = UInt8(JFIF_BYTE_FF);
+
+            first = found + 2;
+        }
+
+        outputSize = std::size_t(next - output);
+
+        return first;
+    }
+
+    const char* getMarkerSearchInstructions()
+    {
+        return getMarkerSearch().instructions;
+    }
+}
@@ -0,0 +1,143 @@
+// Implementation of the scan index module
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+
+#include "ScanIndex.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        // The first bytes of an index file, the last one is the version of its layout
+        const char INDEX_SIGNATURE[4] = { 'K', 'I', 'X', 1 };
+
+        // The values of an index file are big-endian, as those of a JFIF file
+        void writeValue(std::ostream& out, const std::uint64_t value, const int size)
+        {
+            for (auto shift = (size - 1) * 8; shift >= 0; shift -= 8)
+                out.put(char((value >> shift) & 0xFF));
+        }
+
+        std::uint64_t readValue(std::istream& in, const int size)
+        {
+            std::uint64_t value = 0;
+
+            for (auto i = 0; i < size; ++i)
+                value = (value << 8) | UInt8(in.get());
+
+            return value;
+        }
+    }
+
+    ScanIndex::ScanIndex() :
+        frameWidth{0},
+        frameHeight{0},
+        restartInterval{0},
+        scanSize{0},
+        rowInterval{1}
+    {
+    }
+
+    bool ScanIndex::matches(const std::size_t width, const std::size_t height,
+                            const std::size_t restartInterval, const std::size_t scanSize) const
+    {
+        return !checkpoints.empty() &&
+               frameWidth == width && frameHeight == height &&
+               this->restartInterval == restartInterval && this->scanSize == scanSize;
+    }
+
+    const ScanCheckpoint* ScanIndex::findCheckpoint(const std::size_t MCURow) const
+    {
+        auto next = std::upper_bound(checkpoints.begin(), checkpoints.end(), MCURow,
+                                     [](const std::size_t row, const ScanCheckpoint& checkpoint)
+                                     {
+                                         return row < checkpoint.MCURow;
+                                     });
+
+        return next == checkpoints.begin() ? nullptr : &*(next - 1);
+    }
+
+    bool ScanIndex::write(const std::string& filename) const
+    {
+        std::ofstream file(filename, std::ios::out | std::ios::binary);
+
+        if (!file.is_open())
+        {
+            logFile << "Unable to create scan index: \'" << filename << "\'" << std::endl;
+            return false;
+        }
+
+        file.write(INDEX_SIGNATURE, sizeof(INDEX_SIGNATURE));
+        writeValue(file, frameWidth, 4);
+        writeValue(file, frameHeight, 4);
+        writeValue(file, restartInterval, 4);
+        writeValue(file, scanSize, 8);
+        writeValue(file, rowInterval, 4);
+        writeValue(file, checkpoints.size(), 4);
+
+        // The predictors are written as 32-bit two's complement
+        for (auto&& checkpoint : checkpoints)
+        {
+            writeValue(file, checkpoint.MCURow, 4);
+            writeValue(file, checkpoint.bitPosition, 8);
+
+            for (auto compID = 0; compID < 3; ++compID)
+                writeValue(file, std::uint32_t(checkpoint.DCPredictors[compID]), 4);
+        }
+
+        logFile << "Wrote scan index: \'" << filename << "\', " << std::dec << checkpoints.size() << " checkpoints" << std::endl;
+
+        return bool(file);
+    }
+
+    bool ScanIndex::read(const std::string& filename)
+    {
+        std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+        char signature[sizeof(INDEX_SIGNATURE)] = {};
+        file.read(signature, sizeof(signature));
+
+        if (!file || !std::equal(signature, signature + sizeof(signature), INDEX_SIGNATURE))
+        {
+            logFile << "Unable to read scan index: \'" << filename << "\'" << std::endl;
+            return false;
+        }
+
+        frameWidth = readValue(file, 4);
+        frameHeight = readValue(file, 4);
+        restartInterval = readValue(file, 4);
+        scanSize = readValue(file, 8);
+        rowInterval = readValue(file, 4);
+
+        std::size_t count = readValue(file, 4);
+
+        // The count is checked against the data read, not trusted to size the index
+        checkpoints.clear();
+
+        for (std::size_t i = 0; i < count && file; ++i)
+        {
+            ScanCheckpoint checkpoint;
+            checkpoint.MCURow = readValue(file, 4);
+            checkpoint.bitPosition = readValue(file, 8);
+
+            for (auto compID = 0; compID < 3; ++compID)
+                checkpoint.DCPredictors[compID] = std::int32_t(std::uint32_t(readValue(file, 4)));
+
+            checkpoints.push_back(checkpoint);
+        }
+
+        if (!file)
+        {
+            logFile << "Scan index is truncated: \'" << filename << "\'" << std::endl;
+            checkpoints.clear();
+            return false;
+        }
+
+        logFile << "Read scan index: \'" << filename << "\', " << std::dec << checkpoints.size() << " checkpoints" << std::endl;
+
+        return true;
+    }
+}
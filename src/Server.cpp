@@ -0,0 +1,740 @@
+// Implementation of the decode service
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <signal.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+#include "Server.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        // Buffered reader for the lines & raw bytes sent to the service
+        class FdReader
+        {
+            public:
+
+                FdReader(const int fd) :
+                    m_fd{ fd },
+                    m_buffer( 64 * 1024 ),
+                    m_begin{ 0 },
+                    m_end{ 0 }
+                {
+                }
+
+                // Read the next line, without the line break
+                // @return false at the end of the stream, else true
+                bool readLine(std::string& line)
+                {
+                    line.clear();
+
+                    while (true)
+                    {
+                        for ( ; m_begin < m_end; ++m_begin)
+                        {
+                            if (m_buffer[m_begin] == '\n')
+                            {
+                                m_begin++;
+                                return true;
+                            }
+
+                            if (m_buffer[m_begin] != '\r')
+                                line.push_back(m_buffer[m_begin]);
+                        }
+
+                        if (!fill())
+                            return !line.empty();
+                    }
+                }
+
+                // Read exactly the specified number of bytes
+                // @return false if the stream ends before, else true
+                bool readBytes(std::vector<UInt8>& bytes, const std::size_t count)
+                {
+                    bytes.resize(count);
+                    std::size_t copied = 0;
+
+                    while (copied < count)
+                    {
+                        if (m_begin == m_end && !fill())
+                            return false;
+
+                        std::size_t chunk = std::min(count - copied, m_end - m_begin);
+                        std::memcpy(bytes.data() + copied, m_buffer.data() + m_begin, chunk);
+                        m_begin += chunk;
+                        copied += chunk;
+                    }
+
+                    return true;
+                }
+
+            private:
+
+                bool fill()
+                {
+                    ssize_t count;
+
+                    do
+                    {
+                        count = ::read(m_fd, m_buffer.data(), m_buffer.size());
+                    } while (count < 0 && errno == EINTR);
+
+                    m_begin = 0;
+                    m_end = count > 0 ? count : 0;
+                    return count > 0;
+                }
+
+            private:
+
+                int m_fd;
+                std::vector<char> m_buffer;
+                std::size_t m_begin;
+                std::size_t m_end;
+        };
+
+        // Write all the specified bytes to a file descriptor
+        bool writeAll(const int fd, const char* data, std::size_t size)
+        {
+            while (size > 0)
+            {
+                ssize_t count = ::write(fd, data, size);
+
+                if (count < 0 && errno == EINTR)
+                    continue;
+
+                if (count <= 0)
+                    return false;
+
+                data += count;
+                size -= count;
+            }
+
+            return true;
+        }
+
+        // Milliseconds elapsed since the specified time, as text
+        std::string millisecondsSince(const std::chrono::steady_clock::time_point& start)
+        {
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(3) << elapsed.count();
+            return ss.str();
+        }
+
+        // The reason reported to clients for a decode result
+        const char* resultReason(const Decoder::ResultCode code)
+        {
+            switch (code)
+            {
+                case Decoder::ResultCode::TERMINATE         : return "unsupported";
+                case Decoder::ResultCode::DECODE_INCOMPLETE : return "incomplete";
+                case Decoder::ResultCode::ERROR             : return "invalid";
+                case Decoder::ResultCode::CANCELLED         : return "cancelled";
+                default                                     : return "failed";
+            }
+        }
+    }
+
+    struct DecodeServer::Connection
+    {
+        Connection(const int in, const int out, const bool ownsFd, const bool restricted) :
+            inFd{ in },
+            outFd{ out },
+            isOwner{ ownsFd },
+            isRestricted{ restricted },
+            pendingJobs{ 0 },
+            queuedJobs{ 0 },
+            queuedBytes{ 0 }
+        {
+        }
+
+        ~Connection()
+        {
+            if (isOwner)
+                ::close(inFd);
+        }
+
+        // Send a reply line, replies of concurrent jobs are never interleaved
+        //
+        // A client that can't be replied to has gone away, so the jobs it
+        // left are cancelled rather than decoded for no one.
+        void reply(const std::string& line)
+        {
+            std::lock_guard<std::mutex> lock(writeMutex);
+            std::string text = line + "\n";
+
+            if (!writeAll(outFd, text.data(), text.size()))
+                cancellation.cancel();
+        }
+
+        void jobStarted()
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            pendingJobs++;
+        }
+
+        void jobFinished()
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            if (--pendingJobs == 0)
+                jobsDone.notify_all();
+        }
+
+        // Wait until every job of the connection is replied to
+        void waitForJobs()
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobsDone.wait(lock, [this] { return pendingJobs == 0; });
+        }
+
+        int inFd;
+        int outFd;
+        bool isOwner;
+
+        // The files of a socket client's jobs are confined to the service's root
+        bool isRestricted;
+
+        std::mutex writeMutex;
+
+        // Cancels the jobs of the connection once its client is gone
+        CancellationToken cancellation;
+
+        std::mutex jobMutex;
+        std::condition_variable jobsDone;
+        int pendingJobs;
+
+        // The jobs admitted & not yet done, & their bytes, guarded by the
+        // service's job mutex
+        std::size_t queuedJobs;
+        std::size_t queuedBytes;
+    };
+
+    struct DecodeServer::Job
+    {
+        std::shared_ptr<Connection> connection;
+        int number;
+
+        // The input is either a file, or the JFIF data sent with the job
+        std::string inputPath;
+        std::vector<UInt8> data;
+
+        // The bytes of JFIF data the job was admitted with
+        std::size_t size;
+
+        std::string outputPath;
+
+        bool isCropped;
+        std::size_t cropX, cropY, cropWidth, cropHeight;
+
+        // The deadline is counted from when the job was received, so the
+        // time spent queued counts against it
+        std::chrono::steady_clock::time_point received;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    DecodeServer::DecodeServer(const std::size_t workerCount, const ServiceLimits& limits) :
+        m_limits{ limits },
+        m_isStopping{ false },
+        m_queuedJobs{ 0 },
+        m_queuedBytes{ 0 },
+        m_listenFd{ -1 }
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(workerCount, 1); ++i)
+            m_workers.emplace_back(&DecodeServer::workerLoop, this);
+    }
+
+    DecodeServer::~DecodeServer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+            m_isStopping = true;
+        }
+
+        m_jobAvailable.notify_all();
+
+        for (auto&& worker : m_workers)
+            worker.join();
+    }
+
+    void DecodeServer::serveStream(const int inFd, const int outFd)
+    {
+        handleConnection(std::make_shared<Connection>(inFd, outFd, false, false));
+    }
+
+    bool DecodeServer::serveSocket(const std::string& socketPath)
+    {
+        // Clients that go away before their replies are sent must not stop the service
+        signal(SIGPIPE, SIG_IGN);
+
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        if (socketPath.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "Socket path too long: " << socketPath << std::endl;
+            return false;
+        }
+
+        std::strcpy(address.sun_path, socketPath.c_str());
+
+        m_listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        ::unlink(socketPath.c_str());
+
+        if (m_listenFd < 0 ||
+            ::bind(m_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            ::listen(m_listenFd, 16) < 0)
+        {
+            std::cerr << "Unable to listen on socket \'" << socketPath << "\': " << std::strerror(errno) << std::endl;
+            if (m_listenFd >= 0)
+                ::close(m_listenFd);
+            return false;
+        }
+
+        std::mutex connectionMutex;
+        std::condition_variable connectionsDone;
+        int activeConnections = 0;
+
+        while (true)
+        {
+            int fd = ::accept(m_listenFd, nullptr, nullptr);
+
+            if (fd < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break; // The socket is shut down
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_clientMutex);
+                m_clientFds.push_back(fd);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(connectionMutex);
+                activeConnections++;
+            }
+
+            std::thread([&, fd]
+            {
+                if (handleConnection(std::make_shared<Connection>(fd, fd, true, true)))
+                    ::shutdown(m_listenFd, SHUT_RDWR);
+
+                {
+                    std::lock_guard<std::mutex> lock(m_clientMutex);
+                    m_clientFds.erase(std::find(m_clientFds.begin(), m_clientFds.end(), fd));
+                }
+
+                std::lock_guard<std::mutex> lock(connectionMutex);
+                if (--activeConnections == 0)
+                    connectionsDone.notify_all();
+            }).detach();
+        }
+
+        // Wake up the readers of the remaining clients, and let them finish their jobs
+        {
+            std::lock_guard<std::mutex> lock(m_clientMutex);
+            for (auto&& fd : m_clientFds)
+                ::shutdown(fd, SHUT_RD);
+        }
+
+        std::unique_lock<std::mutex> lock(connectionMutex);
+        connectionsDone.wait(lock, [&] { return activeConnections == 0; });
+
+        ::close(m_listenFd);
+        ::unlink(socketPath.c_str());
+        m_listenFd = -1;
+
+        return true;
+    }
+
+    bool DecodeServer::handleConnection(const std::shared_ptr<Connection>& connection)
+    {
+        FdReader reader(connection->inFd);
+        std::string line;
+        int jobCount = 0;
+        bool isShutdown = false;
+
+        while (reader.readLine(line))
+        {
+            std::istringstream request(line);
+            std::string command;
+            request >> command;
+
+            if (command.empty())
+                continue;
+
+            if (command == "ping")
+            {
+                connection->reply("PONG");
+                continue;
+            }
+
+            if (command == "quit")
+                break;
+
+            if (command == "shutdown")
+            {
+                isShutdown = true;
+                break;
+            }
+
+            if (command != "decode" && command != "decode-buffer")
+            {
+                connection->reply("ERROR unknown-command " + command);
+                continue;
+            }
+
+            std::unique_ptr<Job> job(new Job());
+            job->connection = connection;
+            job->number = ++jobCount;
+            job->received = std::chrono::steady_clock::now();
+            job->isCropped = false;
+            job->deadline = std::chrono::steady_clock::time_point::max();
+
+            job->size = 0;
+
+            if (command == "decode")
+                request >> job->inputPath >> job->outputPath;
+            else
+                request >> job->size >> job->outputPath;
+
+            if (request.fail())
+            {
+                connection->reply(std::to_string(job->number) + " ERROR bad-request 0.000 0.000");
+
+                // Without a size, the data that follows can't be skipped
+                if (command == "decode-buffer")
+                    break;
+                continue;
+            }
+
+            // The data of a request over the limit isn't read, so the
+            // connection can't go on past it
+            if (command == "decode-buffer" && job->size > m_limits.maxRequestSize)
+            {
+                connection->reply(std::to_string(job->number) + " ERROR request-too-large 0.000 0.000");
+                break;
+            }
+
+            // Nothing more is read from a connection over its share of the
+            // queue, until enough of its jobs are done
+            admitJob(*connection, job->size);
+
+            if (command == "decode-buffer")
+            {
+                job->data = acquireBuffer();
+
+                if (!reader.readBytes(job->data, job->size))
+                {
+                    connection->reply(std::to_string(job->number) + " ERROR truncated-buffer 0.000 0.000");
+                    releaseBuffer(std::move(job->data));
+                    releaseJob(*connection, job->size);
+                    break;
+                }
+            }
+
+            std::string option;
+            bool isValid = true;
+
+            while (isValid && request >> option)
+            {
+                std::size_t milliseconds = 0;
+
+                if (option == "crop" && request >> job->cropX >> job->cropY >> job->cropWidth >> job->cropHeight)
+                    job->isCropped = true;
+                else if (option == "deadline" && request >> milliseconds)
+                    job->deadline = job->received + std::chrono::milliseconds(milliseconds);
+                else
+                    isValid = false;
+            }
+
+            // The files of a socket client's job must be under the root
+            bool isAllowed = !connection->isRestricted ||
+                             ((job->inputPath.empty() || resolveClientPath(job->inputPath, false, job->inputPath)) &&
+                              (job->outputPath == "-" || resolveClientPath(job->outputPath, true, job->outputPath)));
+
+            if (!isValid || !isAllowed)
+            {
+                connection->reply(std::to_string(job->number) + (isValid ? " ERROR forbidden" : " ERROR bad-request") + " 0.000 0.000");
+                releaseBuffer(std::move(job->data));
+                releaseJob(*connection, job->size);
+                continue;
+            }
+
+            connection->jobStarted();
+
+            {
+                std::lock_guard<std::mutex> lock(m_jobMutex);
+                m_jobs.push_back(std::move(job));
+            }
+
+            m_jobAvailable.notify_one();
+        }
+
+        connection->waitForJobs();
+
+        return isShutdown;
+    }
+
+    void DecodeServer::admitJob(Connection& connection, const std::size_t size)
+    {
+        std::unique_lock<std::mutex> lock(m_jobMutex);
+
+        m_jobReleased.wait(lock, [&]
+        {
+            bool isConnectionFree = connection.queuedJobs == 0 ||
+                                    (connection.queuedJobs < m_limits.maxConnectionJobs &&
+                                     connection.queuedBytes + size <= m_limits.maxConnectionBytes);
+
+            bool isServiceFree = m_queuedJobs == 0 ||
+                                 (m_queuedJobs < m_limits.maxQueuedJobs &&
+                                  m_queuedBytes + size <= m_limits.maxQueuedBytes);
+
+            return isConnectionFree && isServiceFree;
+        });
+
+        connection.queuedJobs++;
+        connection.queuedBytes += size;
+        m_queuedJobs++;
+        m_queuedBytes += size;
+    }
+
+    void DecodeServer::releaseJob(Connection& connection, const std::size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_jobMutex);
+
+            connection.queuedJobs--;
+            connection.queuedBytes -= size;
+            m_queuedJobs--;
+            m_queuedBytes -= size;
+        }
+
+        // Connections wait on the limits of the whole service too
+        m_jobReleased.notify_all();
+    }
+
+    bool DecodeServer::resolveClientPath(const std::string& path, const bool isOutput, std::string& resolved) const
+    {
+        if (m_limits.rootDirectory.empty() || path.empty())
+            return false;
+
+        char* rootPath = ::realpath(m_limits.rootDirectory.c_str(), nullptr);
+
+        if (rootPath == nullptr)
+            return false;
+
+        std::string root = rootPath;
+        std::free(rootPath);
+
+        std::string fullPath = path[0] == '/' ? path : root + "/" + path;
+
+        // An output may not exist yet, so its directory is resolved, & if
+        // it does, it must be a file, not a link to anywhere else
+        std::string name;
+
+        if (isOutput)
+        {
+            std::size_t slash = fullPath.find_last_of('/');
+            name = fullPath.substr(slash + 1);
+            fullPath = slash == 0 ? "/" : fullPath.substr(0, slash);
+
+            struct stat status;
+
+            if (name.empty() || name == "." || name == ".." ||
+                (::lstat((fullPath + "/" + name).c_str(), &status) == 0 && !S_ISREG(status.st_mode)))
+                return false;
+        }
+
+        char* realPath = ::realpath(fullPath.c_str(), nullptr);
+
+        if (realPath == nullptr)
+            return false;
+
+        resolved = realPath;
+        std::free(realPath);
+
+        if (isOutput)
+            resolved += (resolved == "/" ? "" : "/") + name;
+
+        // Under the root, not merely starting with its name
+        return root == "/" ||
+               (resolved.compare(0, root.size(), root) == 0 && resolved.size() > root.size() && resolved[root.size()] == '/');
+    }
+
+    void DecodeServer::workerLoop()
+    {
+        // The decoder, and the buffers it owns, are reused across jobs
+        Decoder decoder;
+
+        while (true)
+        {
+            std::unique_ptr<Job> job;
+
+            {
+                std::unique_lock<std::mutex> lock(m_jobMutex);
+                m_jobAvailable.wait(lock, [this] { return m_isStopping || !m_jobs.empty(); });
+
+                if (m_jobs.empty())
+                    return;
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            runJob(*job, decoder);
+        }
+    }
+
+    void DecodeServer::runJob(Job& job, Decoder& decoder)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::string status;
+
+        // The decoder is shared by the jobs of every client, so nothing of
+        // one job (e.g., its tables) may be used by the next
+        decoder.reset();
+        decoder.setMaxPixels(m_limits.maxPixels);
+        decoder.setCancellationToken(&job.connection->cancellation);
+        decoder.setDeadline(job.deadline);
+
+        // A job that fails in any way is answered, and the worker goes on
+        try
+        {
+            status = decodeJob(job, decoder);
+        }
+        catch (const std::bad_alloc&)
+        {
+            status = "ERROR out-of-memory";
+        }
+        catch (const std::exception&)
+        {
+            status = "ERROR failed";
+        }
+
+        decoder.close();
+        decoder.setCancellationToken(nullptr);
+        decoder.setDeadline(std::chrono::steady_clock::time_point::max());
+
+        std::string decodeTime = millisecondsSince(start);
+        std::string totalTime = millisecondsSince(job.received);
+
+        job.connection->reply(std::to_string(job.number) + " " + status + " " + decodeTime + " " + totalTime);
+
+        releaseBuffer(std::move(job.data));
+        releaseJob(*job.connection, job.size);
+        job.connection->jobFinished();
+    }
+
+    std::string DecodeServer::decodeJob(Job& job, Decoder& decoder)
+    {
+        bool isOpen = job.inputPath.empty() ? decoder.open(job.data.data(), job.data.size())
+                                            : decoder.open(job.inputPath);
+
+        if (!isOpen)
+            return "ERROR open-failed";
+
+        if (job.isCropped)
+            decoder.setCropRegion(job.cropX, job.cropY, job.cropWidth, job.cropHeight);
+
+        Decoder::ResultCode result = decoder.decodeImageFile();
+
+        if (result == Decoder::ResultCode::CANCELLED && std::chrono::steady_clock::now() >= job.deadline)
+            return "ERROR deadline-exceeded";
+        else if (result != Decoder::ResultCode::DECODE_DONE)
+            return std::string("ERROR ") + resultReason(result);
+        else if (job.outputPath != "-" && !decoder.dumpRawData(job.outputPath))
+            return "ERROR write-failed";
+
+        return "OK " + std::to_string(decoder.getImage().width) + "x" + std::to_string(decoder.getImage().height);
+    }
+
+    std::vector<UInt8> DecodeServer::acquireBuffer()
+    {
+        std::lock_guard<std::mutex> lock(m_bufferMutex);
+
+        if (m_bufferPool.empty())
+            return {};
+
+        std::vector<UInt8> buffer = std::move(m_bufferPool.back());
+        m_bufferPool.pop_back();
+        return buffer;
+    }
+
+    void DecodeServer::releaseBuffer(std::vector<UInt8>&& buffer)
+    {
+        if (buffer.capacity() == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock(m_bufferMutex);
+        m_bufferPool.push_back(std::move(buffer));
+    }
+
+    bool runDecodeClient(const std::string& socketPath)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        if (socketPath.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "Socket path too long: " << socketPath << std::endl;
+            return false;
+        }
+
+        std::strcpy(address.sun_path, socketPath.c_str());
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+        {
+            std::cerr << "Unable to connect to \'" << socketPath << "\': " << std::strerror(errno) << std::endl;
+            if (fd >= 0)
+                ::close(fd);
+            return false;
+        }
+
+        // Send the jobs while the replies are printed as they arrive
+        std::thread sender([fd]
+        {
+            std::vector<char> buffer(64 * 1024);
+            ssize_t count;
+
+            while ((count = ::read(STDIN_FILENO, buffer.data(), buffer.size())) > 0)
+            {
+                if (!writeAll(fd, buffer.data(), count))
+                    break;
+            }
+
+            ::shutdown(fd, SHUT_WR);
+        });
+
+        std::vector<char> buffer(64 * 1024);
+        ssize_t count;
+
+        while ((count = ::read(fd, buffer.data(), buffer.size())) > 0)
+            writeAll(STDOUT_FILENO, buffer.data(), count);
+
+        sender.join();
+        ::close(fd);
+
+        return true;
+    }
+}
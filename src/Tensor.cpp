@@ -0,0 +1,302 @@
+// Implementation of the tensor module
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "Tensor.hpp"
+#include "Decoder.hpp"
+#include "Utility.hpp"
+
+namespace kpeg
+{
+    namespace
+    {
+        void storeElement(float* tensor, const std::size_t index, const float value)
+        {
+            tensor[index] = value;
+        }
+
+        void storeElement(UInt16* tensor, const std::size_t index, const float value)
+        {
+            tensor[index] = floatToHalf(value);
+        }
+
+        // The source coordinates & the weight of the second one, for
+        // bilinear filtering along one axis
+        struct SamplePosition
+        {
+            std::size_t first;
+            std::size_t second;
+            float weight;
+        };
+
+        // Map the center of an output sample onto the image, as the resizing
+        // of the usual ML frameworks does (i.e., without aligning the corners)
+        SamplePosition getSamplePosition(const std::size_t index, const float ratio, const std::size_t size)
+        {
+            float position = std::max((index + 0.5f) * ratio - 0.5f, 0.0f);
+
+            SamplePosition sample;
+            sample.first = std::min(std::size_t(position), size - 1);
+            sample.second = std::min(sample.first + 1, size - 1);
+            sample.weight = position - sample.first;
+
+            return sample;
+        }
+
+        template<typename T>
+        void writeTensor(const MCU* MCUs,
+                         const std::size_t MCUsPerLine,
+                         const std::size_t xOffset,
+                         const std::size_t yOffset,
+                         const std::size_t imageWidth,
+                         const std::size_t imageHeight,
+                         const std::size_t width,
+                         const std::size_t height,
+                         const float scale[3],
+                         const float bias[3],
+                         T* tensor)
+        {
+            const std::size_t planeSize = width * height;
+
+            // The samples of the image are read from the MCUs directly
+            auto getBlocks = [&](const std::size_t x, const std::size_t y) -> const CompMatrices&
+            {
+                return MCUs[((y + yOffset) / 8) * MCUsPerLine + (x + xOffset) / 8].getAllMatrices();
+            };
+
+            if (width == imageWidth && height == imageHeight)
+            {
+                for (std::size_t y = 0; y < height; ++y)
+                {
+                    const std::size_t v = (y + yOffset) % 8;
+
+                    for (std::size_t x = 0; x < width; ++x)
+                    {
+                        const CompMatrices& blocks = getBlocks(x, y);
+                        const std::size_t u = (x + xOffset) % 8;
+
+                        for (int c = 0; c < 3; ++c)
+                            storeElement(tensor + c * planeSize, y * width + x, blocks[c][v][u] * scale[c] + bias[c]);
+                    }
+                }
+
+                return;
+            }
+
+            const float xRatio = float(imageWidth) / width;
+            const float yRatio = float(imageHeight) / height;
+
+            // The columns sampled by every row, as indices of the MCUs in
+            // their row & of the samples in the blocks
+            struct ColumnSample
+            {
+                std::size_t MCUs[2];
+                std::size_t u[2];
+                float weight;
+            };
+
+            std::vector<ColumnSample> columns(width);
+
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                SamplePosition sx = getSamplePosition(x, xRatio, imageWidth);
+
+                columns[x].MCUs[0] = (sx.first + xOffset) / 8;
+                columns[x].MCUs[1] = (sx.second + xOffset) / 8;
+                columns[x].u[0] = (sx.first + xOffset) % 8;
+                columns[x].u[1] = (sx.second + xOffset) % 8;
+                columns[x].weight = sx.weight;
+            }
+
+            for (std::size_t y = 0; y < height; ++y)
+            {
+                SamplePosition sy = getSamplePosition(y, yRatio, imageHeight);
+
+                const MCU* topMCUs = MCUs + ((sy.first + yOffset) / 8) * MCUsPerLine;
+                const MCU* bottomMCUs = MCUs + ((sy.second + yOffset) / 8) * MCUsPerLine;
+                const std::size_t v0 = (sy.first + yOffset) % 8;
+                const std::size_t v1 = (sy.second + yOffset) % 8;
+
+                for (std::size_t x = 0; x < width; ++x)
+                {
+                    const ColumnSample& sx = columns[x];
+
+                    const CompMatrices& topLeft = topMCUs[sx.MCUs[0]].getAllMatrices();
+                    const CompMatrices& topRight = topMCUs[sx.MCUs[1]].getAllMatrices();
+                    const CompMatrices& bottomLeft = bottomMCUs[sx.MCUs[0]].getAllMatrices();
+                    const CompMatrices& bottomRight = bottomMCUs[sx.MCUs[1]].getAllMatrices();
+
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        float top = topLeft[c][v0][sx.u[0]] + sx.weight * (topRight[c][v0][sx.u[1]] - topLeft[c][v0][sx.u[0]]);
+                        float bottom = bottomLeft[c][v1][sx.u[0]] + sx.weight * (bottomRight[c][v1][sx.u[1]] - bottomLeft[c][v1][sx.u[0]]);
+                        float sample = top + sy.weight * (bottom - top);
+
+                        storeElement(tensor + c * planeSize, y * width + x, sample * scale[c] + bias[c]);
+                    }
+                }
+            }
+        }
+    }
+
+    TensorOptions::TensorOptions() :
+        width{0},
+        height{0},
+        mean{0.0f, 0.0f, 0.0f},
+        standardDeviation{1.0f, 1.0f, 1.0f},
+        type{TensorType::FLOAT32}
+    {
+    }
+
+    std::size_t getTensorSize(const TensorOptions& options,
+                              const std::size_t imageWidth,
+                              const std::size_t imageHeight)
+    {
+        std::size_t width = options.width != 0 ? options.width : imageWidth;
+        std::size_t height = options.height != 0 ? options.height : imageHeight;
+        std::size_t elementSize = options.type == TensorType::FLOAT16 ? sizeof(UInt16) : sizeof(float);
+
+        return 3 * width * height * elementSize;
+    }
+
+    UInt16 floatToHalf(const float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const std::uint32_t sign = (bits >> 16) & 0x8000;
+        const std::uint32_t magnitude = bits & 0x7FFFFFFF;
+
+        // Infinity & NaN
+        if (magnitude >= 0x7F800000)
+            return UInt16(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0));
+
+        // Rounds to 65520 or more, beyond the largest half
+        if (magnitude >= 0x477FF000)
+            return UInt16(sign | 0x7C00);
+
+        std::uint32_t half;
+        std::uint32_t remainder;
+        std::uint32_t halfway;
+
+        if (magnitude < 0x38800000)
+        {
+            // Below 2^-14, a subnormal half, or zero below 2^-25
+            if (magnitude < 0x33000000)
+                return UInt16(sign);
+
+            const std::uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+            const int shift = 126 - int(magnitude >> 23);
+
+            half = mantissa >> shift;
+            remainder = mantissa & ((1u << shift) - 1);
+            halfway = 1u << (shift - 1);
+        }
+        else
+        {
+            // Rebias the exponent from 127 to 15 & drop 13 mantissa bits
+            half = (magnitude - 0x38000000) >> 13;
+            remainder = magnitude & 0x1FFF;
+            halfway = 0x1000;
+        }
+
+        // Round to nearest, ties to even, a carry into the exponent is correct
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            half++;
+
+        return UInt16(sign | half);
+    }
+
+    bool writeTensorFromMCUs(const MCU* MCUs,
+                             const std::size_t MCUCount,
+                             const std::size_t MCUsPerLine,
+                             const std::size_t xOffset,
+                             const std::size_t yOffset,
+                             const std::size_t imageWidth,
+                             const std::size_t imageHeight,
+                             const TensorOptions& options,
+                             void* output)
+    {
+        std::size_t width = options.width != 0 ? options.width : imageWidth;
+        std::size_t height = options.height != 0 ? options.height : imageHeight;
+
+        if (imageWidth == 0 || imageHeight == 0 || width == 0 || height == 0)
+            return false;
+
+        // The tensor is sampled from anywhere in the image, so every MCU
+        // under it has to be there
+        if (MCUCount < MCUsPerLine * ((yOffset + imageHeight + 7) / 8))
+        {
+            logFile << "[ FATAL ] Only " << std::dec << MCUCount << " MCUs cover the image of the tensor" << std::endl;
+            return false;
+        }
+
+        logFile << "Writing " << std::dec << width << "x" << height << " tensor from MCUs..." << std::endl;
+
+        // The normalization of each channel, as a multiply-add of the sample
+        float scale[3];
+        float bias[3];
+
+        for (int c = 0; c < 3; ++c)
+        {
+            scale[c] = 1.0f / (255.0f * options.standardDeviation[c]);
+            bias[c] = -options.mean[c] / options.standardDeviation[c];
+        }
+
+        if (options.type == TensorType::FLOAT16)
+            writeTensor(MCUs, MCUsPerLine, xOffset, yOffset, imageWidth, imageHeight,
+                        width, height, scale, bias, static_cast<UInt16*>(output));
+        else
+            writeTensor(MCUs, MCUsPerLine, xOffset, yOffset, imageWidth, imageHeight,
+                        width, height, scale, bias, static_cast<float*>(output));
+
+        logFile << "Finished writing tensor [OK]" << std::endl;
+
+        return true;
+    }
+
+    std::size_t decodeTensorBatch(Decoder& decoder,
+                                  const std::vector<std::pair<const UInt8*, std::size_t>>& images,
+                                  const TensorOptions& options,
+                                  void* batch)
+    {
+        if (options.width == 0 || options.height == 0)
+        {
+            logFile << "[ FATAL ] The tensors of a batch need a size" << std::endl;
+            return 0;
+        }
+
+        const std::size_t tensorSize = getTensorSize(options, 0, 0);
+        UInt8* tensor = static_cast<UInt8*>(batch);
+
+        std::size_t decodedCount = 0;
+
+        for (auto&& image : images)
+        {
+            decoder.reset();
+
+            bool isDecoded = false;
+
+            if (decoder.open(image.first, image.second))
+            {
+                decoder.setTensorOutput(tensor, options);
+                isDecoded = decoder.decodeImageFile() == Decoder::ResultCode::DECODE_DONE;
+            }
+
+            decoder.close();
+
+            if (isDecoded)
+                decodedCount++;
+            else
+                std::memset(tensor, 0, tensorSize);
+
+            tensor += tensorSize;
+        }
+
+        logFile << "Decoded " << std::dec << decodedCount << " of " << images.size() << " images into tensor batch" << std::endl;
+
+        return decodedCount;
+    }
+}
@@ -1,79 +1,442 @@
-/* 
-Transform module implementation
-
-Used functions:
-* matIndicesToZZOrder: converts a matrix index, (i,j), to its corresponding order, in zig-zag ordering
-* zzOrderToMatIndices: converts a zig-zag order, to its corresponding matrix index, (i,j)
-* bitStringToValue: convert a bit string representation to its corresponding value
-* getValueCategory: get the category of a value
-*/
-#include <cmath>
-
-#include "Transform.hpp" // The library defined in the include/ directory
-using namespace std;
-
-namespace kpeg {
-
-    // This converts a zig zag order to its matrix string
-    const std::pair<const int, const int> zzOrderToMatIndices( const int zzindex ) { 
-        static const std::pair<const int, const int> zzorder[64] = {
-            {0,0},
-            {0,1}, {1,0},         
-            {2,0}, {1,1}, {0,2},
-            {0,3}, {1,2}, {2,1}, {3,0},
-            {4,0}, {3,1}, {2,2}, {1,3}, {0,4},
-            {0,5}, {1,4}, {2,3}, {3,2}, {4,1}, {5,0},
-            {6,0}, {5,1}, {4,2}, {3,3}, {2,4}, {1,5}, {0,6},
-            {0,7}, {1,6}, {2,5}, {3,4}, {4,3}, {5,2}, {6,1}, {7,0},
-            {7,1}, {6,2}, {5,3}, {4,4}, {3,5}, {2,6}, {1,7},
-            {2,7}, {3,6}, {4,5}, {5,4}, {6,3}, {7,2},
-            {7,3}, {6,4}, {5,5}, {4,6}, {3,7},
-            {4,7}, {5,6}, {6,5}, {7,4},
-            {7,5}, {6,6}, {5,7},
-            {6,7}, {7,6},
-            {7,7}
-        };
-        
-        return zzorder[zzindex];
-    }
-    
-    // This converts a matrix string to its zig zag order
-    const int matIndicesToZZOrder( const int row, const int column ) { 
-        static const int matOrder[8][8] =  {
-            {  0,  1,  5,  6, 14, 15, 27, 28 },
-            {  2,  4,  7, 13, 16, 26, 29, 42 },
-            {  3,  8, 12, 17, 25, 30, 41, 43 },
-            {  9, 11, 18, 24, 31, 40, 44, 53 },
-            { 10, 19, 23, 32, 39, 45, 52, 54 },
-            { 20, 22, 33, 38, 46, 51, 55, 60 },
-            { 21, 34, 37, 47, 50, 56, 59, 61 },
-            { 35, 36, 48, 49, 57, 58, 62, 63 }
-        };
-        
-        return matOrder[row][column];
-    }
-
-    // bitStr defined in Types module, return value of type Int16
-    const Int16 bitStringtoValue(const std::string& bitStr) { 
-        if (bitStr == "")
-            return 0x0000;
-        
-        Int16 value = 0x0000;
-        
-        char sign = bitStr[0];
-        int factor = sign == '0' ? -1 : 1;
-            
-        for (auto i = 0; i < bitStr.size(); ++i) {
-            if (bitStr[i] == sign)
-                value += Int16(std::pow(2, bitStr.size() - 1 - i));
-        }
-        
-        return factor * value;
-    }
-    
-    const Int16 getValueCategory(const Int16 value) {
-        if (value == 0x0000)
-            return 0;
-        return std::log2(std::abs(value)) + 1;
-    }
-}
+/* 
+Transform module implementation
+
+Used functions:
+* matIndicesToZZOrder: converts a matrix index, (i,j), to its corresponding order, in zig-zag ordering
+* zzOrderToMatIndices: converts a zig-zag order, to its corresponding matrix index, (i,j)
+* bitStringToValue: convert a bit string representation to its corresponding value
+* getValueCategory: get the category of a value
+* zigZagToNatural: reorder the coefficients of a block from zig-zag to natural order
+* getDequantizationTables: get the quantization tables, with the scale factors of an IDCT folded in
+* inverseDCT: compute the 2D IDCT of an 8x8 block, with one of idctFloat, idctAccurateInteger or idctFastInteger
+* inverseDCTScaled: compute the size-point IDCT of the lowest frequencies of an 8x8 block
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Transform.hpp" // The library defined in the include/ directory
+using namespace std;
+
+namespace kpeg {
+
+    // This converts a zig zag order to its matrix string
+    const std::pair<const int, const int> zzOrderToMatIndices( const int zzindex ) { 
+        static const std::pair<const int, const int> zzorder[64] = {
+            {0,0},
+            {0,1}, {1,0},         
+            {2,0}, {1,1}, {0,2},
+            {0,3}, {1,2}, {2,1}, {3,0},
+            {4,0}, {3,1}, {2,2}, {1,3}, {0,4},
+            {0,5}, {1,4}, {2,3}, {3,2}, {4,1}, {5,0},
+            {6,0}, {5,1}, {4,2}, {3,3}, {2,4}, {1,5}, {0,6},
+            {0,7}, {1,6}, {2,5}, {3,4}, {4,3}, {5,2}, {6,1}, {7,0},
+            {7,1}, {6,2}, {5,3}, {4,4}, {3,5}, {2,6}, {1,7},
+            {2,7}, {3,6}, {4,5}, {5,4}, {6,3}, {7,2},
+            {7,3}, {6,4}, {5,5}, {4,6}, {3,7},
+            {4,7}, {5,6}, {6,5}, {7,4},
+            {7,5}, {6,6}, {5,7},
+            {6,7}, {7,6},
+            {7,7}
+        };
+        
+        return zzorder[zzindex];
+    }
+    
+    // This converts a matrix string to its zig zag order
+    const int matIndicesToZZOrder( const int row, const int column ) { 
+        static const int matOrder[8][8] =  {
+            {  0,  1,  5,  6, 14, 15, 27, 28 },
+            {  2,  4,  7, 13, 16, 26, 29, 42 },
+            {  3,  8, 12, 17, 25, 30, 41, 43 },
+            {  9, 11, 18, 24, 31, 40, 44, 53 },
+            { 10, 19, 23, 32, 39, 45, 52, 54 },
+            { 20, 22, 33, 38, 46, 51, 55, 60 },
+            { 21, 34, 37, 47, 50, 56, 59, 61 },
+            { 35, 36, 48, 49, 57, 58, 62, 63 }
+        };
+        
+        return matOrder[row][column];
+    }
+
+    // bitStr defined in Types module, return value of type Int16
+    const Int16 bitStringtoValue(const std::string& bitStr) { 
+        if (bitStr == "")
+            return 0x0000;
+        
+        Int16 value = 0x0000;
+        
+        char sign = bitStr[0];
+        int factor = sign == '0' ? -1 : 1;
+            
+        for (auto i = 0; i < bitStr.size(); ++i) {
+            if (bitStr[i] == sign)
+                value += Int16(std::pow(2, bitStr.size() - 1 - i));
+        }
+        
+        return factor * value;
+    }
+    
+    const Int16 getValueCategory(const Int16 value) {
+        if (value == 0x0000)
+            return 0;
+        return std::log2(std::abs(value)) + 1;
+    }
+
+    void zigZagToNatural(Int16* block) {
+        // The natural index of each zig-zag index
+        static const struct NaturalOrder {
+            int index[64];
+
+            NaturalOrder() {
+                for (int i = 0; i < 64; ++i)
+                    index[i] = zzOrderToMatIndices(i).first * 8 + zzOrderToMatIndices(i).second;
+            }
+        } naturalOrder;
+
+        Int16 zigZag[64];
+        std::copy(block, block + 64, zigZag);
+
+        for (int i = 0; i < 64; ++i)
+            block[naturalOrder.index[i]] = zigZag[i];
+    }
+
+    namespace {
+        // The reference IDCT: the double sum of the IDCT's definition for every sample
+        void idctFloat(const int* coeffs, float* samples) {
+            // The cosines of the definition, indexed by [sample][frequency]
+            static const struct CosineTable {
+                double value[8][8];
+
+                CosineTable() {
+                    for (int x = 0; x < 8; ++x)
+                        for (int u = 0; u < 8; ++u)
+                            value[x][u] = std::cos((2 * x + 1) * u * M_PI / 16.0);
+                }
+            } cosine;
+
+            const float C0 = 1.0 / std::sqrt(2.0);
+
+            for (int y = 0; y < 8; ++y) {
+                for (int x = 0; x < 8; ++x) {
+                    float sum = 0.0;
+
+                    for (int u = 0; u < 8; ++u) {
+                        for (int v = 0; v < 8; ++v) {
+                            float Cu = u == 0 ? C0 : 1.0;
+                            float Cv = v == 0 ? C0 : 1.0;
+
+                            sum += Cu * Cv * coeffs[u * 8 + v] * cosine.value[x][u] * cosine.value[y][v];
+                        }
+                    }
+
+                    samples[x * 8 + y] = 0.25 * sum;
+                }
+            }
+        }
+
+        // The accurate integer IDCT, after the Loeffler-Ligtenberg-Moschytz
+        // algorithm as used by the IJG's "islow" IDCT: 12 multiplies per 1D
+        // IDCT with 13-bit constants, and 2 extra bits kept between the passes
+        const int ISLOW_CONST_BITS = 13;
+        const int ISLOW_PASS1_BITS = 2;
+
+        // The constants, FIX(x) = x * 2^13, rounded
+        const std::int64_t FIX_0_298631336 = 2446;
+        const std::int64_t FIX_0_390180644 = 3196;
+        const std::int64_t FIX_0_541196100 = 4433;
+        const std::int64_t FIX_0_765366865 = 6270;
+        const std::int64_t FIX_0_899976223 = 7373;
+        const std::int64_t FIX_1_175875602 = 9633;
+        const std::int64_t FIX_1_501321110 = 12299;
+        const std::int64_t FIX_1_847759065 = 15137;
+        const std::int64_t FIX_1_961570560 = 16069;
+        const std::int64_t FIX_2_053119869 = 16819;
+        const std::int64_t FIX_2_562915447 = 20995;
+        const std::int64_t FIX_3_072711026 = 25172;
+
+        // Divide by 2^n, rounding to the nearest
+        inline std::int64_t descale(const std::int64_t x, const int n) {
+            return (x + (std::int64_t(1) << (n - 1))) >> n;
+        }
+
+        // One 1D pass of the accurate integer IDCT over 8 values, stride apart
+        // @param out receives the output values, scaled down by 2^outShift
+        template<typename In, typename Out>
+        inline void islow1D(const In* in, Out* out, const int stride, const int outShift) {
+            // Even part
+            std::int64_t z2 = in[2 * stride];
+            std::int64_t z3 = in[6 * stride];
+
+            std::int64_t z1 = (z2 + z3) * FIX_0_541196100;
+            std::int64_t tmp2 = z1 - z3 * FIX_1_847759065;
+            std::int64_t tmp3 = z1 + z2 * FIX_0_765366865;
+
+            z2 = in[0];
+            z3 = in[4 * stride];
+
+            std::int64_t tmp0 = (z2 + z3) * (std::int64_t(1) << ISLOW_CONST_BITS);
+            std::int64_t tmp1 = (z2 - z3) * (std::int64_t(1) << ISLOW_CONST_BITS);
+
+            std::int64_t tmp10 = tmp0 + tmp3;
+            std::int64_t tmp13 = tmp0 - tmp3;
+            std::int64_t tmp11 = tmp1 + tmp2;
+            std::int64_t tmp12 = tmp1 - tmp2;
+
+            // Odd part
+            tmp0 = in[7 * stride];
+            tmp1 = in[5 * stride];
+            tmp2 = in[3 * stride];
+            tmp3 = in[1 * stride];
+
+            z1 = tmp0 + tmp3;
+            z2 = tmp1 + tmp2;
+            z3 = tmp0 + tmp2;
+            std::int64_t z4 = tmp1 + tmp3;
+            std::int64_t z5 = (z3 + z4) * FIX_1_175875602;
+
+            tmp0 *= FIX_0_298631336;
+            tmp1 *= FIX_2_053119869;
+            tmp2 *= FIX_3_072711026;
+            tmp3 *= FIX_1_501321110;
+            z1 *= -FIX_0_899976223;
+            z2 *= -FIX_2_562915447;
+            z3 = z3 * -FIX_1_961570560 + z5;
+            z4 = z4 * -FIX_0_390180644 + z5;
+
+            tmp0 += z1 + z3;
+            tmp1 += z2 + z4;
+            tmp2 += z2 + z3;
+            tmp3 += z1 + z4;
+
+            out[0] = Out(descale(tmp10 + tmp3, outShift));
+            out[7 * stride] = Out(descale(tmp10 - tmp3, outShift));
+            out[1 * stride] = Out(descale(tmp11 + tmp2, outShift));
+            out[6 * stride] = Out(descale(tmp11 - tmp2, outShift));
+            out[2 * stride] = Out(descale(tmp12 + tmp1, outShift));
+            out[5 * stride] = Out(descale(tmp12 - tmp1, outShift));
+            out[3 * stride] = Out(descale(tmp13 + tmp0, outShift));
+            out[4 * stride] = Out(descale(tmp13 - tmp0, outShift));
+        }
+
+        void idctAccurateInteger(const int* coeffs, float* samples) {
+            std::int64_t workspace[64];
+
+            // Pass 1: the columns, keeping ISLOW_PASS1_BITS extra bits
+            for (int col = 0; col < 8; ++col) {
+                const int* in = coeffs + col;
+
+                // Most columns of a typical block only have a DC coefficient
+                if (in[8] == 0 && in[16] == 0 && in[24] == 0 && in[32] == 0 &&
+                    in[40] == 0 && in[48] == 0 && in[56] == 0) {
+                    std::int64_t dc = std::int64_t(in[0]) * (1 << ISLOW_PASS1_BITS);
+
+                    for (int row = 0; row < 8; ++row)
+                        workspace[row * 8 + col] = dc;
+
+                    continue;
+                }
+
+                islow1D(in, workspace + col, 8, ISLOW_CONST_BITS - ISLOW_PASS1_BITS);
+            }
+
+            // Pass 2: the rows, removing the extra bits & the 1/8 scale of the 2D IDCT
+            for (int row = 0; row < 8; ++row) {
+                std::int64_t out[8];
+                islow1D(workspace + row * 8, out, 1, ISLOW_CONST_BITS + ISLOW_PASS1_BITS + 3);
+
+                for (int col = 0; col < 8; ++col)
+                    samples[row * 8 + col] = float(out[col]);
+            }
+        }
+
+        // The fast integer IDCT, after the Arai-Agui-Nakajima algorithm as used
+        // by the IJG's "ifast" IDCT: 5 multiplies per 1D IDCT with 8-bit
+        // constants, the other scale factors are folded into the de-quantization
+        // tables, see getDequantizationTables()
+        const int IFAST_CONST_BITS = 8;
+        const int IFAST_PASS1_BITS = 2;
+
+        // The constants, FIX(x) = x * 2^8, rounded
+        const int FIX_1_082392200 = 277;
+        const int FIX_1_414213562 = 362;
+        const int FIX_1_847759065_8 = 473;
+        const int FIX_2_613125930 = 669;
+
+        // The AAN scale factors, 2^14 * cos(k*PI/16) * sqrt(2) per row & column
+        // (1 for k = 0), in raster order
+        const int AAN_SCALES[64] = {
+            16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+            22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
+            21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
+            19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
+            16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+            12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
+             8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
+             4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247
+        };
+
+        inline int multiplyFast(const int x, const int c) {
+            return (x * c) >> IFAST_CONST_BITS;
+        }
+
+        // One 1D pass of the fast integer IDCT over 8 values, stride apart
+        inline void ifast1D(const int* in, int* out, const int stride) {
+            // Even part
+            int tmp0 = in[0];
+            int tmp1 = in[2 * stride];
+            int tmp2 = in[4 * stride];
+            int tmp3 = in[6 * stride];
+
+            int tmp10 = tmp0 + tmp2;
+            int tmp11 = tmp0 - tmp2;
+            int tmp13 = tmp1 + tmp3;
+            int tmp12 = multiplyFast(tmp1 - tmp3, FIX_1_414213562) - tmp13;
+
+            tmp0 = tmp10 + tmp13;
+            tmp3 = tmp10 - tmp13;
+            tmp1 = tmp11 + tmp12;
+            tmp2 = tmp11 - tmp12;
+
+            // Odd part
+            int tmp4 = in[1 * stride];
+            int tmp5 = in[3 * stride];
+            int tmp6 = in[5 * stride];
+            int tmp7 = in[7 * stride];
+
+            int z13 = tmp6 + tmp5;
+            int z10 = tmp6 - tmp5;
+            int z11 = tmp4 + tmp7;
+            int z12 = tmp4 - tmp7;
+
+            tmp7 = z11 + z13;
+            tmp11 = multiplyFast(z11 - z13, FIX_1_414213562);
+
+            int z5 = multiplyFast(z10 + z12, FIX_1_847759065_8);
+            tmp10 = multiplyFast(z12, FIX_1_082392200) - z5;
+            tmp12 = multiplyFast(z10, -FIX_2_613125930) + z5;
+
+            tmp6 = tmp12 - tmp7;
+            tmp5 = tmp11 - tmp6;
+            tmp4 = tmp10 + tmp5;
+
+            out[0] = tmp0 + tmp7;
+            out[7 * stride] = tmp0 - tmp7;
+            out[1 * stride] = tmp1 + tmp6;
+            out[6 * stride] = tmp1 - tmp6;
+            out[2 * stride] = tmp2 + tmp5;
+            out[5 * stride] = tmp2 - tmp5;
+            out[4 * stride] = tmp3 + tmp4;
+            out[3 * stride] = tmp3 - tmp4;
+        }
+
+        void idctFastInteger(const int* coeffs, float* samples) {
+            int workspace[64];
+
+            // Pass 1: the columns, of coefficients already scaled by their AAN
+            // scale factors, with IFAST_PASS1_BITS extra bits. Unlike the
+            // accurate IDCT, no column is skipped, so that the compiler can
+            // compute several columns at once with vector instructions
+            for (int col = 0; col < 8; ++col)
+                ifast1D(coeffs + col, workspace + col, 8);
+
+            // Pass 2: the rows, then removing the extra bits & the 1/8 scale of
+            // the 2D IDCT from all the samples at once
+            const int shift = IFAST_PASS1_BITS + 3;
+            int out[64];
+
+            for (int row = 0; row < 8; ++row)
+                ifast1D(workspace + row * 8, out + row * 8, 1);
+
+            for (int i = 0; i < 64; ++i)
+                samples[i] = float((out[i] + (1 << (shift - 1))) >> shift);
+        }
+    }
+
+    void getDequantizationTables(const std::vector<std::vector<UInt16>>& QTables,
+                                 std::vector<std::vector<UInt16>>& tables, const IDCTMode mode) {
+        tables = QTables;
+
+        if (mode != IDCTMode::FAST_INTEGER)
+            return;
+
+        // Each step times its AAN scale factor, keeping IFAST_PASS1_BITS extra
+        // bits, which fits 16 bits for 8-bit steps
+        for (auto&& table : tables) {
+            for (std::size_t i = 0; i < table.size() && i < 64; ++i) {
+                auto coords = zzOrderToMatIndices(int(i));
+                int scale = AAN_SCALES[coords.first * 8 + coords.second];
+
+                table[i] = UInt16(std::min((int(table[i]) * scale + (1 << (13 - IFAST_PASS1_BITS))) >> (14 - IFAST_PASS1_BITS), 0xFFFF));
+            }
+        }
+    }
+
+    void inverseDCT(const int* coeffs, float* samples, const IDCTMode mode) {
+        switch (mode) {
+            case IDCTMode::ACCURATE_INTEGER:
+                idctAccurateInteger(coeffs, samples);
+                break;
+
+            case IDCTMode::FAST_INTEGER:
+                idctFastInteger(coeffs, samples);
+                break;
+
+            default:
+                idctFloat(coeffs, samples);
+                break;
+        }
+    }
+
+    void inverseDCTScaled(const int* coeffs, float* samples, const int size) {
+        // The DC coefficient is 8 times the average of the block
+        if (size == 1) {
+            samples[0] = coeffs[0] / 8.0f;
+            return;
+        }
+
+        // The cosines of the size-point IDCT, indexed by [log2(size) - 1][sample][frequency],
+        // with the normalization of the frequency folded in
+        static const struct CosineTable {
+            float value[2][4][4];
+
+            CosineTable() {
+                for (int n = 0; n < 2; ++n) {
+                    const int points = 2 << n;
+
+                    for (int x = 0; x < points; ++x)
+                        for (int u = 0; u < points; ++u)
+                            value[n][x][u] = (u == 0 ? 1.0 / std::sqrt(2.0) : 1.0) *
+                                             std::cos((2 * x + 1) * u * M_PI / (2.0 * points));
+                }
+            }
+        } cosine;
+
+        const auto& table = cosine.value[size == 4 ? 1 : 0];
+
+        // The rows, then the columns, of the low frequencies
+        float rows[4][4];
+
+        for (int v = 0; v < size; ++v) {
+            for (int x = 0; x < size; ++x) {
+                float sum = 0.0f;
+
+                for (int u = 0; u < size; ++u)
+                    sum += coeffs[v * 8 + u] * table[x][u];
+
+                rows[v][x] = sum;
+            }
+        }
+
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                float sum = 0.0f;
+
+                for (int v = 0; v < size; ++v)
+                    sum += rows[v][x] * table[y][v];
+
+                samples[y * size + x] = 0.25f * sum;
+            }
+        }
+    }
+}
@@ -1,3 +1,67 @@
-#include "Utility.hpp"
-
-std::ofstream logFile("kpeg.log", std::ios::out);
+#include "Utility.hpp"
+
+kpeg::utils::LogStream logFile("kpeg.log");
+
+namespace kpeg
+{
+    namespace utils
+    {
+        namespace
+        {
+            // Whether the calling thread logs, & the line it's formatting
+            thread_local bool t_isLogging = false;
+            thread_local std::ostringstream t_logLine;
+        }
+        
+        LogStream::LogStream( const std::string& filename ) :
+            m_filename{ filename }
+        {
+        }
+        
+        void LogStream::setEnabled( const bool isEnabled )
+        {
+            t_isLogging = isEnabled;
+        }
+        
+        bool LogStream::isEnabled() const
+        {
+            return t_isLogging;
+        }
+        
+        LogStream& LogStream::operator<<( std::ostream& ( *manipulator )( std::ostream& ) )
+        {
+            if ( !isEnabled() )
+                return *this;
+            
+            std::ostringstream& line = getLine();
+            manipulator( line );
+            
+            // Only std::endl, std::flush & std::ends are such manipulators,
+            // each ends what was formatted so far
+            std::lock_guard<std::mutex> lock( m_fileMutex );
+            
+            if ( !m_file.is_open() )
+                m_file.open( m_filename, std::ios::out );
+            
+            m_file << line.str();
+            m_file.flush();
+            
+            line.str( "" );
+            
+            return *this;
+        }
+        
+        LogStream& LogStream::operator<<( std::ios_base& ( *manipulator )( std::ios_base& ) )
+        {
+            if ( isEnabled() )
+                manipulator( getLine() );
+            
+            return *this;
+        }
+        
+        std::ostringstream& LogStream::getLine()
+        {
+            return t_logLine;
+        }
+    }
+}